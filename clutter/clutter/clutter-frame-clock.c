@@ -467,6 +467,38 @@ clutter_frame_clock_compute_max_render_time_us (ClutterFrameClock *frame_clock)
   return max_render_time_us;
 }
 
+/**
+ * clutter_frame_clock_predict_next_update_time: (skip)
+ * @frame_clock: a #ClutterFrameClock
+ * @frame: the #ClutterFrame that was just dispatched
+ * @out_update_time_us: (out): return location for the predicted time
+ *
+ * Predicts when the frame following @frame will start being updated,
+ * assuming @frame makes its target presentation time. Content that is
+ * ready before this time can make it into that frame.
+ *
+ * Returns: %TRUE if a prediction could be made
+ */
+gboolean
+clutter_frame_clock_predict_next_update_time (ClutterFrameClock *frame_clock,
+                                              ClutterFrame      *frame,
+                                              int64_t           *out_update_time_us)
+{
+  int64_t next_presentation_time_us;
+
+  if (!frame->has_target_presentation_time)
+    return FALSE;
+
+  next_presentation_time_us = frame->target_presentation_time_us +
+                              frame_clock->refresh_interval_us;
+
+  *out_update_time_us =
+    next_presentation_time_us -
+    clutter_frame_clock_compute_max_render_time_us (frame_clock);
+
+  return TRUE;
+}
+
 static void
 calculate_next_update_time_us (ClutterFrameClock *frame_clock,
                                int64_t           *out_next_update_time_us,
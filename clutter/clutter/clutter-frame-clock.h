@@ -92,6 +92,11 @@ void clutter_frame_clock_remove_timeline (ClutterFrameClock *frame_clock,
 CLUTTER_EXPORT
 float clutter_frame_clock_get_refresh_rate (ClutterFrameClock *frame_clock);
 
+CLUTTER_EXPORT
+gboolean clutter_frame_clock_predict_next_update_time (ClutterFrameClock *frame_clock,
+                                                       ClutterFrame      *frame,
+                                                       int64_t           *out_update_time_us);
+
 void clutter_frame_clock_record_flip_time (ClutterFrameClock *frame_clock,
                                            int64_t            flip_time_us);
 
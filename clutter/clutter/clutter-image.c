@@ -51,6 +51,7 @@ typedef struct
   CoglTexture *texture;
   gint width;
   gint height;
+  gboolean batchable;
 } ClutterImagePrivate;
 
 static void clutter_content_iface_init (ClutterContentInterface *iface);
@@ -66,12 +67,32 @@ create_texture_from_data (unsigned int      width,
                           CoglPixelFormat   pixel_format,
                           unsigned int      row_stride,
                           const uint8_t    *data,
+                          gboolean          batchable,
                           GError          **error)
 {
   CoglContext *ctx =
     clutter_backend_get_cogl_context (clutter_get_default_backend ());
   CoglTexture2D *texture_2d;
 
+  if (batchable)
+    {
+      CoglAtlasTexture *atlas_tex;
+
+      /* Textures sharing an atlas share a GL texture, so the journal can
+       * draw consecutive images with a single draw call. Images that
+       * don't fit in an atlas, or that use a format the atlas can't
+       * hold, silently fall back to a texture of their own. */
+      atlas_tex = cogl_atlas_texture_new_from_data (ctx,
+                                                    width,
+                                                    height,
+                                                    pixel_format,
+                                                    row_stride,
+                                                    data,
+                                                    NULL);
+      if (atlas_tex)
+        return COGL_TEXTURE (atlas_tex);
+    }
+
   texture_2d = cogl_texture_2d_new_from_data (ctx,
                                               width,
                                               height,
@@ -259,6 +280,7 @@ clutter_image_set_data (ClutterImage     *image,
                                             pixel_format,
                                             row_stride,
                                             data,
+                                            priv->batchable,
                                             error);
 
   if (priv->texture == NULL)
@@ -317,6 +339,7 @@ clutter_image_set_bytes (ClutterImage     *image,
                                             pixel_format,
                                             row_stride,
                                             g_bytes_get_data (data, NULL),
+                                            priv->batchable,
                                             error);
 
   if (priv->texture == NULL)
@@ -378,6 +401,7 @@ clutter_image_set_area (ClutterImage                 *image,
                                                 pixel_format,
                                                 row_stride,
                                                 data,
+                                                priv->batchable,
                                                 error);
     }
   else
@@ -431,3 +455,49 @@ clutter_image_get_texture (ClutterImage *image)
   priv = clutter_image_get_instance_private (image);
   return priv->texture;
 }
+
+/**
+ * clutter_image_set_batchable:
+ * @image: a #ClutterImage
+ * @batchable: whether the image data may share a texture with other images
+ *
+ * Sets whether image data set on @image after this call may be packed
+ * into a texture atlas shared with other batchable images.
+ *
+ * Images that share a texture can be drawn together in a single draw
+ * call, which makes painting many small images, like icon grids, a lot
+ * cheaper. Large images, and images using pixel formats the atlas can't
+ * store, keep using a texture of their own.
+ *
+ * Batching is disabled by default.
+ */
+void
+clutter_image_set_batchable (ClutterImage *image,
+                             gboolean      batchable)
+{
+  ClutterImagePrivate *priv;
+
+  g_return_if_fail (CLUTTER_IS_IMAGE (image));
+
+  priv = clutter_image_get_instance_private (image);
+  priv->batchable = !!batchable;
+}
+
+/**
+ * clutter_image_get_batchable:
+ * @image: a #ClutterImage
+ *
+ * Retrieves whether @image may share a texture with other images.
+ *
+ * Return value: %TRUE if the image is batchable
+ */
+gboolean
+clutter_image_get_batchable (ClutterImage *image)
+{
+  ClutterImagePrivate *priv;
+
+  g_return_val_if_fail (CLUTTER_IS_IMAGE (image), FALSE);
+
+  priv = clutter_image_get_instance_private (image);
+  return priv->batchable;
+}
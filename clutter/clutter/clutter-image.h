@@ -80,6 +80,12 @@ gboolean                clutter_image_set_bytes         (ClutterImage
 CLUTTER_EXPORT
 CoglTexture *           clutter_image_get_texture       (ClutterImage                 *image);
 
+CLUTTER_EXPORT
+void                    clutter_image_set_batchable     (ClutterImage                 *image,
+                                                         gboolean                      batchable);
+CLUTTER_EXPORT
+gboolean                clutter_image_get_batchable     (ClutterImage                 *image);
+
 G_END_DECLS
 
 #endif /* __CLUTTER_IMAGE_H__ */
@@ -75,6 +75,14 @@ _cogl_atlas_texture_remove_reorganize_callback (CoglContext *ctx,
                                                 GHookFunc callback,
                                                 void *user_data);
 
+/* Number of rectangles that may be moved around in the shared atlases
+   each frame to reclaim the space left behind by removed textures */
+#define COGL_ATLAS_TEXTURE_MAX_DEFRAGMENT_MOVES_PER_FRAME 4
+
+COGL_EXPORT_TEST void
+_cogl_atlas_texture_defragment_atlases (CoglContext  *ctx,
+                                        unsigned int  max_moves);
+
 gboolean
 _cogl_is_atlas_texture (void *object);
 
@@ -1003,6 +1003,16 @@ _cogl_atlas_texture_remove_reorganize_callback (CoglContext *ctx,
     g_hook_destroy_link (&ctx->atlas_reorganize_callbacks, hook);
 }
 
+void
+_cogl_atlas_texture_defragment_atlases (CoglContext  *ctx,
+                                        unsigned int  max_moves)
+{
+  GSList *l;
+
+  for (l = ctx->atlases; l && max_moves > 0; l = l->next)
+    max_moves -= _cogl_atlas_defragment (l->data, max_moves);
+}
+
 static const CoglTextureVtable
 cogl_atlas_texture_vtable =
   {
@@ -61,6 +61,14 @@ _cogl_atlas_new (CoglPixelFormat texture_format,
   atlas->texture = NULL;
   atlas->flags = flags;
   atlas->texture_format = texture_format;
+  atlas->needs_defragment = FALSE;
+  atlas->defragment_textures = NULL;
+  atlas->n_defragment_textures = 0;
+  atlas->next_defragment_texture = 0;
+  atlas->n_migrations = 0;
+  atlas->total_migration_time_us = 0;
+  atlas->max_migration_time_us = 0;
+  atlas->n_defragment_moves = 0;
   g_hook_list_init (&atlas->pre_reorganize_callbacks, sizeof (GHook));
   g_hook_list_init (&atlas->post_reorganize_callbacks, sizeof (GHook));
 
@@ -76,6 +84,7 @@ _cogl_atlas_free (CoglAtlas *atlas)
     cogl_object_unref (atlas->texture);
   if (atlas->map)
     _cogl_rectangle_map_free (atlas->map);
+  g_free (atlas->defragment_textures);
 
   g_hook_list_clear (&atlas->pre_reorganize_callbacks);
   g_hook_list_clear (&atlas->post_reorganize_callbacks);
@@ -157,6 +166,14 @@ _cogl_atlas_get_rectangles_cb (const CoglRectangleMapEntry *rectangle,
   data->textures[data->n_textures++].user_data = rect_data;
 }
 
+static void
+_cogl_atlas_end_defragment_pass (CoglAtlas *atlas)
+{
+  g_clear_pointer (&atlas->defragment_textures, g_free);
+  atlas->n_defragment_textures = 0;
+  atlas->next_defragment_texture = 0;
+}
+
 static void
 _cogl_atlas_get_next_size (unsigned int *map_width,
                            unsigned int *map_height)
@@ -380,6 +397,8 @@ _cogl_atlas_reserve_space (CoglAtlas             *atlas,
   unsigned int map_width = 0, map_height = 0;
   gboolean ret;
   CoglRectangleMapEntry new_position;
+  int64_t start_time_us;
+  int64_t migration_time_us;
 
   /* Check if we can fit the rectangle into the existing map */
   if (atlas->map &&
@@ -410,6 +429,8 @@ _cogl_atlas_reserve_space (CoglAtlas             *atlas,
      storage has changed and cause a flush */
   _cogl_atlas_notify_pre_reorganize (atlas);
 
+  start_time_us = g_get_monotonic_time ();
+
   /* Get an array of all the textures currently in the atlas. */
   data.n_textures = 0;
   if (atlas->map == NULL)
@@ -517,6 +538,8 @@ _cogl_atlas_reserve_space (CoglAtlas             *atlas,
 
       atlas->map = new_map;
       atlas->texture = COGL_TEXTURE (new_tex);
+      atlas->needs_defragment = FALSE;
+      _cogl_atlas_end_defragment_pass (atlas);
 
       waste = (_cogl_rectangle_map_get_remaining_space (atlas->map) *
                100 / (_cogl_rectangle_map_get_width (atlas->map) *
@@ -534,6 +557,15 @@ _cogl_atlas_reserve_space (CoglAtlas             *atlas,
 
   g_free (data.textures);
 
+  migration_time_us = g_get_monotonic_time () - start_time_us;
+  atlas->n_migrations++;
+  atlas->total_migration_time_us += migration_time_us;
+  atlas->max_migration_time_us = MAX (atlas->max_migration_time_us,
+                                      migration_time_us);
+
+  COGL_NOTE (ATLAS, "%p: Reorganization took %" G_GINT64_FORMAT " us",
+             atlas, migration_time_us);
+
   _cogl_atlas_notify_post_reorganize (atlas);
 
   return ret;
@@ -545,6 +577,9 @@ _cogl_atlas_remove (CoglAtlas *atlas,
 {
   _cogl_rectangle_map_remove (atlas->map, rectangle);
 
+  atlas->needs_defragment = TRUE;
+  _cogl_atlas_end_defragment_pass (atlas);
+
   COGL_NOTE (ATLAS, "%p: Removed rectangle sized %ix%i",
              atlas,
              rectangle->width,
@@ -557,7 +592,7 @@ _cogl_atlas_remove (CoglAtlas *atlas,
              _cogl_rectangle_map_get_remaining_space (atlas->map) *
              100 / (_cogl_rectangle_map_get_width (atlas->map) *
                     _cogl_rectangle_map_get_height (atlas->map)));
-};
+}
 
 static CoglTexture *
 create_migration_texture (CoglContext *ctx,
@@ -637,6 +672,224 @@ _cogl_atlas_copy_rectangle (CoglAtlas *atlas,
   return tex;
 }
 
+static int
+_cogl_atlas_compare_bottom_cb (const void *a,
+                               const void *b)
+{
+  const CoglAtlasRepositionData *ta = a;
+  const CoglAtlasRepositionData *tb = b;
+  unsigned int a_bottom, b_bottom;
+
+  a_bottom = ta->old_position.y + ta->old_position.height;
+  b_bottom = tb->old_position.y + tb->old_position.height;
+
+  return a_bottom < b_bottom ? 1 : a_bottom > b_bottom ? -1 : 0;
+}
+
+static gboolean
+_cogl_atlas_move_rectangle (CoglAtlas                     *atlas,
+                            const CoglAtlasRepositionData *texture)
+{
+  const CoglRectangleMapEntry *old_position = &texture->old_position;
+  const CoglRectangleMapEntry *new_position = &texture->new_position;
+  CoglTexture *tmp_tex;
+  CoglBlitData blit_data;
+
+  /* The data is bounced through a temporary texture rather than
+     blitting the atlas onto itself */
+  tmp_tex = _cogl_atlas_copy_rectangle (atlas,
+                                        old_position->x,
+                                        old_position->y,
+                                        old_position->width,
+                                        old_position->height,
+                                        atlas->texture_format);
+  if (!tmp_tex)
+    return FALSE;
+
+  _cogl_blit_begin (&blit_data, atlas->texture, tmp_tex);
+  _cogl_blit (&blit_data,
+              0, 0,
+              new_position->x,
+              new_position->y,
+              new_position->width,
+              new_position->height);
+  _cogl_blit_end (&blit_data);
+
+  cogl_object_unref (tmp_tex);
+
+  atlas->update_position_cb (texture->user_data,
+                             atlas->texture,
+                             new_position);
+
+  return TRUE;
+}
+
+static void
+_cogl_atlas_begin_defragment_pass (CoglAtlas *atlas)
+{
+  CoglAtlasGetRectanglesData data;
+
+  /* Merge the space freed by removals once per pass rather than for
+     every rectangle that is moved. Space freed by the moves themselves
+     is only merged at the start of the next pass. */
+  _cogl_rectangle_map_merge_free_space (atlas->map);
+
+  data.textures =
+    g_new (CoglAtlasRepositionData,
+           _cogl_rectangle_map_get_n_rectangles (atlas->map));
+  data.n_textures = 0;
+  _cogl_rectangle_map_foreach (atlas->map,
+                               _cogl_atlas_get_rectangles_cb,
+                               &data);
+
+  qsort (data.textures, data.n_textures,
+         sizeof (CoglAtlasRepositionData),
+         _cogl_atlas_compare_bottom_cb);
+
+  atlas->defragment_textures = data.textures;
+  atlas->n_defragment_textures = data.n_textures;
+  atlas->next_defragment_texture = 0;
+}
+
+/* Moves at most max_moves rectangles closer to the origin of the
+ * atlas, starting with the ones that extend the furthest. Unlike a
+ * migration this never reallocates the atlas texture, so calling it
+ * with a small budget once per frame gradually turns the holes left
+ * by removed rectangles into contiguous free space without stalling
+ * a single frame. A pass over the rectangles is carried over from one
+ * call to the next until it is done. Returns the number of rectangles
+ * that were moved.
+ */
+unsigned int
+_cogl_atlas_defragment (CoglAtlas    *atlas,
+                        unsigned int  max_moves)
+{
+  unsigned int n_moves = 0;
+  gboolean reorganizing = FALSE;
+
+  if (!atlas->needs_defragment || !atlas->map || max_moves == 0)
+    return 0;
+
+  /* Glyph atlases can't copy their contents around, and they never
+     remove rectangles anyway */
+  if ((atlas->flags & COGL_ATLAS_DISABLE_MIGRATION))
+    return 0;
+
+  if (_cogl_rectangle_map_get_n_rectangles (atlas->map) == 0)
+    {
+      atlas->needs_defragment = FALSE;
+      return 0;
+    }
+
+  if (!atlas->defragment_textures)
+    _cogl_atlas_begin_defragment_pass (atlas);
+
+  while (n_moves < max_moves)
+    {
+      CoglAtlasRepositionData *texture;
+      CoglRectangleMapEntry *old_position;
+      CoglRectangleMapEntry *new_position;
+      gboolean found;
+
+      if (atlas->next_defragment_texture == atlas->n_defragment_textures)
+        {
+          _cogl_atlas_end_defragment_pass (atlas);
+          break;
+        }
+
+      texture = &atlas->defragment_textures[atlas->next_defragment_texture];
+      old_position = &texture->old_position;
+      new_position = &texture->new_position;
+
+      found = _cogl_rectangle_map_find_compact_position (atlas->map,
+                                                         old_position->width,
+                                                         old_position->height,
+                                                         new_position);
+
+      if (!found ||
+          new_position->y + new_position->height >=
+          old_position->y + old_position->height)
+        {
+          /* The rectangles are sorted by how far they extend, so if
+             the furthest one can't be improved there is not enough
+             contiguous space to be gained yet */
+          if (atlas->next_defragment_texture == 0)
+            atlas->needs_defragment = FALSE;
+
+          _cogl_atlas_end_defragment_pass (atlas);
+          break;
+        }
+
+      if (!reorganizing)
+        {
+          _cogl_atlas_notify_pre_reorganize (atlas);
+          reorganizing = TRUE;
+        }
+
+      /* Leave the rectangle where it is if its data can't be copied,
+         and don't try again until rectangles are removed */
+      if (!_cogl_atlas_move_rectangle (atlas, texture))
+        {
+          COGL_NOTE (ATLAS, "%p: Could not move a rectangle sized %ix%i",
+                     atlas, old_position->width, old_position->height);
+
+          atlas->needs_defragment = FALSE;
+          _cogl_atlas_end_defragment_pass (atlas);
+          break;
+        }
+
+      _cogl_rectangle_map_remove (atlas->map, old_position);
+      _cogl_rectangle_map_add_at (atlas->map,
+                                  new_position,
+                                  texture->user_data);
+
+      atlas->next_defragment_texture++;
+      n_moves++;
+    }
+
+  if (n_moves > 0)
+    {
+      atlas->n_defragment_moves += n_moves;
+
+      COGL_NOTE (ATLAS, "%p: Defragmentation moved %u rectangles",
+                 atlas, n_moves);
+    }
+
+  if (reorganizing)
+    _cogl_atlas_notify_post_reorganize (atlas);
+
+  return n_moves;
+}
+
+void
+_cogl_atlas_get_stats (CoglAtlas      *atlas,
+                       CoglAtlasStats *stats)
+{
+  if (atlas->map)
+    {
+      unsigned int width = _cogl_rectangle_map_get_width (atlas->map);
+      unsigned int height = _cogl_rectangle_map_get_height (atlas->map);
+
+      stats->width = width;
+      stats->height = height;
+      stats->n_rectangles = _cogl_rectangle_map_get_n_rectangles (atlas->map);
+      stats->used_space =
+        width * height - _cogl_rectangle_map_get_remaining_space (atlas->map);
+    }
+  else
+    {
+      stats->width = 0;
+      stats->height = 0;
+      stats->n_rectangles = 0;
+      stats->used_space = 0;
+    }
+
+  stats->n_migrations = atlas->n_migrations;
+  stats->total_migration_time_us = atlas->total_migration_time_us;
+  stats->max_migration_time_us = atlas->max_migration_time_us;
+  stats->n_defragment_moves = atlas->n_defragment_moves;
+}
+
 void
 _cogl_atlas_add_reorganize_callback (CoglAtlas            *atlas,
                                      GHookFunc             pre_callback,
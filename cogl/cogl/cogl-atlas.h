@@ -46,6 +46,24 @@ typedef enum
 
 typedef struct _CoglAtlas CoglAtlas;
 
+typedef struct _CoglAtlasStats
+{
+  unsigned int width;
+  unsigned int height;
+  unsigned int n_rectangles;
+  /* Number of pixels covered by rectangles */
+  unsigned int used_space;
+
+  /* Number of times the atlas had to be reorganized or resized to fit
+     a new rectangle, and the time spent doing it */
+  unsigned int n_migrations;
+  int64_t total_migration_time_us;
+  int64_t max_migration_time_us;
+
+  /* Number of rectangles moved by incremental defragmentation */
+  unsigned int n_defragment_moves;
+} CoglAtlasStats;
+
 #define COGL_ATLAS(object) ((CoglAtlas *) object)
 
 struct _CoglAtlas
@@ -62,6 +80,22 @@ struct _CoglAtlas
 
   GHookList pre_reorganize_callbacks;
   GHookList post_reorganize_callbacks;
+
+  /* Set when rectangles have been removed since the last
+     defragmentation pass found nothing to move */
+  gboolean needs_defragment;
+
+  /* Rectangles of the current defragmentation pass, sorted by how far
+     they extend, and the next one to try to move. The pass is dropped
+     whenever rectangles are removed or migrated. */
+  struct _CoglAtlasRepositionData *defragment_textures;
+  unsigned int n_defragment_textures;
+  unsigned int next_defragment_texture;
+
+  unsigned int n_migrations;
+  int64_t total_migration_time_us;
+  int64_t max_migration_time_us;
+  unsigned int n_defragment_moves;
 };
 
 COGL_EXPORT CoglAtlas *
@@ -87,6 +121,14 @@ _cogl_atlas_copy_rectangle (CoglAtlas *atlas,
                             int height,
                             CoglPixelFormat format);
 
+COGL_EXPORT_TEST unsigned int
+_cogl_atlas_defragment (CoglAtlas    *atlas,
+                        unsigned int  max_moves);
+
+COGL_EXPORT_TEST void
+_cogl_atlas_get_stats (CoglAtlas      *atlas,
+                       CoglAtlasStats *stats);
+
 COGL_EXPORT void
 _cogl_atlas_add_reorganize_callback (CoglAtlas            *atlas,
                                      GHookFunc             pre_callback,
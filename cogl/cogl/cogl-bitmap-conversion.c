@@ -129,103 +129,109 @@ _cogl_premult_alpha_first (uint8_t *dst)
 
 #undef MULT
 
-/* Use the SSE optimized version to premult four pixels at once when
-   it is available. The same assembler code works for x86 and x86-64
-   because it doesn't refer to any non-SSE registers directly */
+/* Use the SSE2 optimized version to premult four pixels at once when
+   it is available. SSE2 is part of the x86-64 baseline, so this is
+   decided at compile time. The SSSE3 byte shuffle used for swizzling
+   is not, so that one is picked at runtime instead. */
 #if defined(__SSE2__) && defined(__GNUC__) \
   && (defined(__x86_64) || defined(__i386))
 #define COGL_USE_PREMULT_SSE2
 #endif
 
+#if defined(__GNUC__) && (defined(__x86_64) || defined(__i386))
+#define COGL_USE_SWIZZLE_SSSE3
+#endif
+
+#ifdef COGL_USE_PREMULT_SSE2
+#include <emmintrin.h>
+#endif
+
+#ifdef COGL_USE_SWIZZLE_SSSE3
+#include <tmmintrin.h>
+#endif
+
+/* The fast paths below are required to give bit-exact results
+   compared to the generic unpack/convert/pack code. This can be
+   disabled so that tests can check that this actually holds. */
+static gboolean fast_paths_enabled = TRUE;
+
+void
+_cogl_bitmap_set_conversion_fast_paths_enabled (gboolean enabled)
+{
+  fast_paths_enabled = enabled;
+}
+
 #ifdef COGL_USE_PREMULT_SSE2
 
 inline static void
-_cogl_premult_alpha_last_four_pixels_sse2 (uint8_t *p)
+_cogl_premult_four_pixels_sse2 (uint8_t  *p,
+                                gboolean  alpha_first)
 {
-  /* 8 copies of 128 used below */
-  static const int16_t eight_halves[8] __attribute__ ((aligned (16))) =
-    { 128, 128, 128, 128, 128, 128, 128, 128 };
-  /* Mask of the rgb components of the four pixels */
-  static const int8_t just_rgb[16] __attribute__ ((aligned (16))) =
-    { 0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00,
-      0xff, 0xff, 0xff, 0x00, 0xff, 0xff, 0xff, 0x00 };
+  const __m128i zero = _mm_setzero_si128 ();
+  const __m128i eight_halves = _mm_set1_epi16 (128);
+  __m128i alpha_mask;
+  __m128i pixels;
+  __m128i lo, hi;
+  __m128i alpha_lo, alpha_hi;
+  __m128i result;
+
+  pixels = _mm_loadu_si128 ((const __m128i *) p);
+
   /* Each SSE register only holds two pixels because we need to work
-     with 16-bit intermediate values. We still do four pixels by
-     interleaving two registers in the hope that it will pipeline
-     better */
-  asm (/* Load eight_halves into xmm5 for later */
-       "movdqa (%1), %%xmm5\n"
-       /* Clear xmm3 */
-       "pxor %%xmm3, %%xmm3\n"
-       /* Load two pixels from p into the low half of xmm0 */
-       "movlps (%0), %%xmm0\n"
-       /* Load the next set of two pixels from p into the low half of xmm1 */
-       "movlps 8(%0), %%xmm1\n"
-       /* Unpack 8 bytes from the low quad-words in each register to 8
-          16-bit values */
-       "punpcklbw %%xmm3, %%xmm0\n"
-       "punpcklbw %%xmm3, %%xmm1\n"
-       /* Copy alpha values of the first pixel in xmm0 to all
-          components of the first pixel in xmm2 */
-       "pshuflw $255, %%xmm0, %%xmm2\n"
-       /* same for xmm1 and xmm3 */
-       "pshuflw $255, %%xmm1, %%xmm3\n"
-       /* The above also copies the second pixel directly so we now
-          want to replace the RGB components with copies of the alpha
-          components */
-       "pshufhw $255, %%xmm2, %%xmm2\n"
-       "pshufhw $255, %%xmm3, %%xmm3\n"
-       /* Multiply the rgb components by the alpha */
-       "pmullw %%xmm2, %%xmm0\n"
-       "pmullw %%xmm3, %%xmm1\n"
-       /* Add 128 to each component */
-       "paddw %%xmm5, %%xmm0\n"
-       "paddw %%xmm5, %%xmm1\n"
-       /* Copy the results to temporary registers xmm4 and xmm5 */
-       "movdqa %%xmm0, %%xmm4\n"
-       "movdqa %%xmm1, %%xmm5\n"
-       /* Divide the results by 256 */
-       "psrlw $8, %%xmm0\n"
-       "psrlw $8, %%xmm1\n"
-       /* Add the temporaries back in */
-       "paddw %%xmm4, %%xmm0\n"
-       "paddw %%xmm5, %%xmm1\n"
-       /* Divide again */
-       "psrlw $8, %%xmm0\n"
-       "psrlw $8, %%xmm1\n"
-       /* Pack the results back as bytes */
-       "packuswb %%xmm1, %%xmm0\n"
-       /* Load just_rgb into xmm3 for later */
-       "movdqa (%2), %%xmm3\n"
-       /* Reload all four pixels into xmm2 */
-       "movups (%0), %%xmm2\n"
-       /* Mask out the alpha from the results */
-       "andps %%xmm3, %%xmm0\n"
-       /* Mask out the RGB from the original four pixels */
-       "andnps %%xmm2, %%xmm3\n"
-       /* Combine the two to get the right alpha values */
-       "orps %%xmm3, %%xmm0\n"
-       /* Write to memory */
-       "movdqu %%xmm0, (%0)\n"
-       : /* no outputs */
-       : "r" (p), "r" (eight_halves), "r" (just_rgb)
-       : "xmm0", "xmm1", "xmm2", "xmm3", "xmm4", "xmm5");
+     with 16-bit intermediate values */
+  lo = _mm_unpacklo_epi8 (pixels, zero);
+  hi = _mm_unpackhi_epi8 (pixels, zero);
+
+  /* Copy the alpha value of each pixel to all of its components */
+  if (alpha_first)
+    {
+      alpha_mask = _mm_set1_epi32 (0x000000ff);
+      alpha_lo = _mm_shufflelo_epi16 (lo, _MM_SHUFFLE (0, 0, 0, 0));
+      alpha_lo = _mm_shufflehi_epi16 (alpha_lo, _MM_SHUFFLE (0, 0, 0, 0));
+      alpha_hi = _mm_shufflelo_epi16 (hi, _MM_SHUFFLE (0, 0, 0, 0));
+      alpha_hi = _mm_shufflehi_epi16 (alpha_hi, _MM_SHUFFLE (0, 0, 0, 0));
+    }
+  else
+    {
+      alpha_mask = _mm_set1_epi32 ((int) 0xff000000);
+      alpha_lo = _mm_shufflelo_epi16 (lo, _MM_SHUFFLE (3, 3, 3, 3));
+      alpha_lo = _mm_shufflehi_epi16 (alpha_lo, _MM_SHUFFLE (3, 3, 3, 3));
+      alpha_hi = _mm_shufflelo_epi16 (hi, _MM_SHUFFLE (3, 3, 3, 3));
+      alpha_hi = _mm_shufflehi_epi16 (alpha_hi, _MM_SHUFFLE (3, 3, 3, 3));
+    }
+
+  /* Same as MULT(): t = c * a + 128; c = ((t >> 8) + t) >> 8 */
+  lo = _mm_add_epi16 (_mm_mullo_epi16 (lo, alpha_lo), eight_halves);
+  hi = _mm_add_epi16 (_mm_mullo_epi16 (hi, alpha_hi), eight_halves);
+  lo = _mm_srli_epi16 (_mm_add_epi16 (_mm_srli_epi16 (lo, 8), lo), 8);
+  hi = _mm_srli_epi16 (_mm_add_epi16 (_mm_srli_epi16 (hi, 8), hi), 8);
+
+  /* Pack the results back as bytes and put the original alpha back */
+  result = _mm_packus_epi16 (lo, hi);
+  result = _mm_or_si128 (_mm_andnot_si128 (alpha_mask, result),
+                         _mm_and_si128 (alpha_mask, pixels));
+
+  _mm_storeu_si128 ((__m128i *) p, result);
 }
 
 #endif /* COGL_USE_PREMULT_SSE2 */
 
 static void
-_cogl_bitmap_premult_unpacked_span_8 (uint8_t *data,
-                                      int width)
+_cogl_bitmap_premult_span_8888 (uint8_t  *data,
+                                int       width,
+                                gboolean  alpha_first)
 {
 #ifdef COGL_USE_PREMULT_SSE2
 
   /* Process 4 pixels at a time */
-  while (width >= 4)
+  if (fast_paths_enabled)
     {
-      _cogl_premult_alpha_last_four_pixels_sse2 (data);
-      data += 4 * 4;
-      width -= 4;
+      while (width >= 4)
+        {
+          _cogl_premult_four_pixels_sse2 (data, alpha_first);
+          data += 4 * 4;
+          width -= 4;
+        }
     }
 
   /* If there are any pixels left we will fall through and
@@ -235,27 +241,109 @@ _cogl_bitmap_premult_unpacked_span_8 (uint8_t *data,
 
   while (width-- > 0)
     {
-      _cogl_premult_alpha_last (data);
+      if (alpha_first)
+        _cogl_premult_alpha_first (data);
+      else
+        _cogl_premult_alpha_last (data);
       data += 4;
     }
 }
 
 static void
-_cogl_bitmap_unpremult_unpacked_span_8 (uint8_t *data,
-                                        int width)
+_cogl_bitmap_premult_unpacked_span_8 (uint8_t *data,
+                                      int width)
+{
+  _cogl_bitmap_premult_span_8888 (data, width, FALSE);
+}
+
+/* Reciprocals for replacing the division by alpha when
+   unpremultiplying. (c * 255 * recip[a]) >> 24 gives exactly the same
+   result as (c * 255) / a for all 8-bit c and a. */
+static const uint32_t *
+get_unpremult_reciprocals (void)
 {
-  int x;
+  static uint32_t reciprocals[256];
+  static gsize initialized = 0;
 
-  for (x = 0; x < width; x++)
+  if (g_once_init_enter (&initialized))
     {
-      if (data[3] == 0)
-        _cogl_unpremult_alpha_0 (data);
-      else
-        _cogl_unpremult_alpha_last (data);
+      int a;
+
+      reciprocals[0] = 0;
+      for (a = 1; a < 256; a++)
+        reciprocals[a] = ((1 << 24) + a - 1) / a;
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return reciprocals;
+}
+
+inline static uint8_t
+unpremult_component (uint8_t  c,
+                     uint32_t reciprocal)
+{
+  return (uint8_t) (((uint64_t) (c * 255) * reciprocal) >> 24);
+}
+
+static void
+_cogl_bitmap_unpremult_span_8888 (uint8_t  *data,
+                                  int       width,
+                                  gboolean  alpha_first)
+{
+  const uint32_t *reciprocals;
+  int a_offset = alpha_first ? 0 : 3;
+  int c_offset = alpha_first ? 1 : 0;
+
+  if (!fast_paths_enabled)
+    {
+      while (width-- > 0)
+        {
+          if (data[a_offset] == 0)
+            _cogl_unpremult_alpha_0 (data);
+          else if (alpha_first)
+            _cogl_unpremult_alpha_first (data);
+          else
+            _cogl_unpremult_alpha_last (data);
+          data += 4;
+        }
+
+      return;
+    }
+
+  reciprocals = get_unpremult_reciprocals ();
+
+  while (width-- > 0)
+    {
+      uint8_t alpha = data[a_offset];
+
+      if (alpha == 0)
+        {
+          _cogl_unpremult_alpha_0 (data);
+        }
+      else if (alpha != 255)
+        {
+          uint32_t reciprocal = reciprocals[alpha];
+
+          data[c_offset + 0] = unpremult_component (data[c_offset + 0],
+                                                    reciprocal);
+          data[c_offset + 1] = unpremult_component (data[c_offset + 1],
+                                                    reciprocal);
+          data[c_offset + 2] = unpremult_component (data[c_offset + 2],
+                                                    reciprocal);
+        }
+
       data += 4;
     }
 }
 
+static void
+_cogl_bitmap_unpremult_unpacked_span_8 (uint8_t *data,
+                                        int width)
+{
+  _cogl_bitmap_unpremult_span_8888 (data, width, FALSE);
+}
+
 static void
 _cogl_bitmap_unpremult_unpacked_span_16 (uint16_t *data,
                                          int width)
@@ -272,6 +360,7 @@ _cogl_bitmap_unpremult_unpacked_span_16 (uint16_t *data,
           data[1] = (data[1] * 65535) / alpha;
           data[2] = (data[2] * 65535) / alpha;
         }
+      data += 4;
     }
 }
 
@@ -286,6 +375,196 @@ _cogl_bitmap_premult_unpacked_span_16 (uint16_t *data,
       data[0] = (data[0] * alpha) / 65535;
       data[1] = (data[1] * alpha) / 65535;
       data[2] = (data[2] * alpha) / 65535;
+      data += 4;
+    }
+}
+
+/* Swizzling between the 32-bit 8888 formats */
+
+typedef void (* CoglSwizzleSpanFunc) (const uint8_t *src,
+                                      uint8_t       *dst,
+                                      const uint8_t  swizzle[4],
+                                      int            width);
+
+static void
+get_8888_component_offsets (CoglPixelFormat  format,
+                            uint8_t          offsets[4])
+{
+  /* Byte offsets of the R, G, B and A components */
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGBA_8888:
+      offsets[0] = 0; offsets[1] = 1; offsets[2] = 2; offsets[3] = 3;
+      return;
+    case COGL_PIXEL_FORMAT_BGRA_8888:
+      offsets[0] = 2; offsets[1] = 1; offsets[2] = 0; offsets[3] = 3;
+      return;
+    case COGL_PIXEL_FORMAT_ARGB_8888:
+      offsets[0] = 1; offsets[1] = 2; offsets[2] = 3; offsets[3] = 0;
+      return;
+    case COGL_PIXEL_FORMAT_ABGR_8888:
+      offsets[0] = 3; offsets[1] = 2; offsets[2] = 1; offsets[3] = 0;
+      return;
+    default:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+_cogl_swizzle_span_8888 (const uint8_t *src,
+                         uint8_t       *dst,
+                         const uint8_t  swizzle[4],
+                         int            width)
+{
+  while (width-- > 0)
+    {
+      dst[0] = src[swizzle[0]];
+      dst[1] = src[swizzle[1]];
+      dst[2] = src[swizzle[2]];
+      dst[3] = src[swizzle[3]];
+      src += 4;
+      dst += 4;
+    }
+}
+
+#ifdef COGL_USE_SWIZZLE_SSSE3
+
+__attribute__ ((target ("ssse3")))
+static void
+_cogl_swizzle_span_8888_ssse3 (const uint8_t *src,
+                               uint8_t       *dst,
+                               const uint8_t  swizzle[4],
+                               int            width)
+{
+  __m128i mask;
+
+  mask = _mm_setr_epi8 (swizzle[0], swizzle[1],
+                        swizzle[2], swizzle[3],
+                        swizzle[0] + 4, swizzle[1] + 4,
+                        swizzle[2] + 4, swizzle[3] + 4,
+                        swizzle[0] + 8, swizzle[1] + 8,
+                        swizzle[2] + 8, swizzle[3] + 8,
+                        swizzle[0] + 12, swizzle[1] + 12,
+                        swizzle[2] + 12, swizzle[3] + 12);
+
+  while (width >= 4)
+    {
+      __m128i pixels;
+
+      pixels = _mm_loadu_si128 ((const __m128i *) src);
+      _mm_storeu_si128 ((__m128i *) dst, _mm_shuffle_epi8 (pixels, mask));
+      src += 4 * 4;
+      dst += 4 * 4;
+      width -= 4;
+    }
+
+  _cogl_swizzle_span_8888 (src, dst, swizzle, width);
+}
+
+#endif /* COGL_USE_SWIZZLE_SSSE3 */
+
+static CoglSwizzleSpanFunc
+get_swizzle_span_func (void)
+{
+  static gsize swizzle_span_func = 0;
+
+  if (g_once_init_enter (&swizzle_span_func))
+    {
+      CoglSwizzleSpanFunc func = _cogl_swizzle_span_8888;
+
+#ifdef COGL_USE_SWIZZLE_SSSE3
+      __builtin_cpu_init ();
+      if (__builtin_cpu_supports ("ssse3"))
+        func = _cogl_swizzle_span_8888_ssse3;
+#endif
+
+      g_once_init_leave (&swizzle_span_func, (gsize) func);
+    }
+
+  return (CoglSwizzleSpanFunc) swizzle_span_func;
+}
+
+/* Unpacking 10 bits per component formats straight to 8 bits per
+   component. This gives the same result as _cogl_unpack_8() but uses a
+   lookup table instead of a division per component. */
+
+static const uint8_t *
+get_10_to_8_table (void)
+{
+  static uint8_t table[1 << 10];
+  static gsize initialized = 0;
+
+  if (g_once_init_enter (&initialized))
+    {
+      int i;
+
+      for (i = 0; i < (1 << 10); i++)
+        table[i] = (i * 255 + 0x1ff) / 0x3ff;
+
+      g_once_init_leave (&initialized, 1);
+    }
+
+  return table;
+}
+
+static gboolean
+_cogl_bitmap_can_fast_unpack_10_to_8 (CoglPixelFormat format)
+{
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGBA_1010102:
+    case COGL_PIXEL_FORMAT_BGRA_1010102:
+    case COGL_PIXEL_FORMAT_XRGB_2101010:
+    case COGL_PIXEL_FORMAT_ARGB_2101010:
+    case COGL_PIXEL_FORMAT_XBGR_2101010:
+    case COGL_PIXEL_FORMAT_ABGR_2101010:
+      return TRUE;
+
+    default:
+      return FALSE;
+    }
+}
+
+static void
+_cogl_unpack_10_to_8 (CoglPixelFormat  format,
+                      const uint8_t   *src,
+                      uint8_t         *dst,
+                      int              width)
+{
+  static const uint8_t alpha_2_to_8[4] = { 0, 85, 170, 255 };
+  const uint8_t *table = get_10_to_8_table ();
+  int r_shift, g_shift, b_shift, a_shift;
+
+  switch (format & ~COGL_PREMULT_BIT)
+    {
+    case COGL_PIXEL_FORMAT_RGBA_1010102:
+      r_shift = 22; g_shift = 12; b_shift = 2; a_shift = 0;
+      break;
+    case COGL_PIXEL_FORMAT_BGRA_1010102:
+      r_shift = 2; g_shift = 12; b_shift = 22; a_shift = 0;
+      break;
+    case COGL_PIXEL_FORMAT_XRGB_2101010:
+    case COGL_PIXEL_FORMAT_ARGB_2101010:
+      r_shift = 20; g_shift = 10; b_shift = 0; a_shift = 30;
+      break;
+    case COGL_PIXEL_FORMAT_XBGR_2101010:
+    case COGL_PIXEL_FORMAT_ABGR_2101010:
+      r_shift = 0; g_shift = 10; b_shift = 20; a_shift = 30;
+      break;
+    default:
+      g_assert_not_reached ();
+    }
+
+  while (width-- > 0)
+    {
+      uint32_t v = *(const uint32_t *) src;
+
+      dst[0] = table[(v >> r_shift) & 0x3ff];
+      dst[1] = table[(v >> g_shift) & 0x3ff];
+      dst[2] = table[(v >> b_shift) & 0x3ff];
+      dst[3] = alpha_2_to_8[(v >> a_shift) & 0x3];
+      src += 4;
+      dst += 4;
     }
 }
 
@@ -387,6 +666,7 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
   CoglPixelFormat src_format;
   CoglPixelFormat dst_format;
   gboolean use_16;
+  gboolean use_10_to_8;
   gboolean need_premult;
 
   src_format = cogl_bitmap_get_format (src_bmp);
@@ -447,13 +727,56 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
       return FALSE;
     }
 
+  /* Conversions between the 8888 formats are only a swizzle, which
+     can be done straight into the destination without going through
+     a temporary RGBA row */
+  if (fast_paths_enabled &&
+      _cogl_bitmap_can_fast_premult (src_format) &&
+      _cogl_bitmap_can_fast_premult (dst_format))
+    {
+      CoglSwizzleSpanFunc swizzle_span = get_swizzle_span_func ();
+      gboolean dst_alpha_first = !!(dst_format & COGL_AFIRST_BIT);
+      uint8_t src_offsets[4];
+      uint8_t dst_offsets[4];
+      uint8_t swizzle[4];
+      int i;
+
+      get_8888_component_offsets (src_format, src_offsets);
+      get_8888_component_offsets (dst_format, dst_offsets);
+      for (i = 0; i < 4; i++)
+        swizzle[dst_offsets[i]] = src_offsets[i];
+
+      for (y = 0; y < height; y++)
+        {
+          src = src_data + y * src_rowstride;
+          dst = dst_data + y * dst_rowstride;
+
+          swizzle_span (src, dst, swizzle, width);
+
+          if (need_premult)
+            {
+              if (dst_format & COGL_PREMULT_BIT)
+                _cogl_bitmap_premult_span_8888 (dst, width, dst_alpha_first);
+              else
+                _cogl_bitmap_unpremult_span_8888 (dst, width, dst_alpha_first);
+            }
+        }
+
+      _cogl_bitmap_unmap (src_bmp);
+      _cogl_bitmap_unmap (dst_bmp);
+
+      return TRUE;
+    }
+
   use_16 = _cogl_bitmap_needs_short_temp_buffer (dst_format);
+  use_10_to_8 = (!use_16 &&
+                 fast_paths_enabled &&
+                 _cogl_bitmap_can_fast_unpack_10_to_8 (src_format));
 
   /* Allocate a buffer to hold a temporary RGBA row */
   tmp_row = g_malloc (width *
                       (use_16 ? sizeof (uint16_t) : sizeof (uint8_t)) * 4);
 
-  /* FIXME: Optimize */
   for (y = 0; y < height; y++)
     {
       src = src_data + y * src_rowstride;
@@ -461,6 +784,8 @@ _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
 
       if (use_16)
         _cogl_unpack_16 (src_format, src, tmp_row, width);
+      else if (use_10_to_8)
+        _cogl_unpack_10_to_8 (src_format, src, tmp_row, width);
       else
         _cogl_unpack_8 (src_format, src, tmp_row, width);
 
@@ -632,7 +957,7 @@ _cogl_bitmap_unpremult (CoglBitmap *bmp,
 {
   uint8_t *p, *data;
   uint16_t *tmp_row;
-  int x,y;
+  int y;
   CoglPixelFormat format;
   int width, height;
   int rowstride;
@@ -669,19 +994,8 @@ _cogl_bitmap_unpremult (CoglBitmap *bmp,
         }
       else
         {
-          if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  if (p[0] == 0)
-                    _cogl_unpremult_alpha_0 (p);
-                  else
-                    _cogl_unpremult_alpha_first (p);
-                  p += 4;
-                }
-            }
-          else
-            _cogl_bitmap_unpremult_unpacked_span_8 (p, width);
+          _cogl_bitmap_unpremult_span_8888 (p, width,
+                                            !!(format & COGL_AFIRST_BIT));
         }
     }
 
@@ -700,7 +1014,7 @@ _cogl_bitmap_premult (CoglBitmap *bmp,
 {
   uint8_t *p, *data;
   uint16_t *tmp_row;
-  int x,y;
+  int y;
   CoglPixelFormat format;
   int width, height;
   int rowstride;
@@ -736,16 +1050,8 @@ _cogl_bitmap_premult (CoglBitmap *bmp,
         }
       else
         {
-          if (format & COGL_AFIRST_BIT)
-            {
-              for (x = 0; x < width; x++)
-                {
-                  _cogl_premult_alpha_first (p);
-                  p += 4;
-                }
-            }
-          else
-            _cogl_bitmap_premult_unpacked_span_8 (p, width);
+          _cogl_bitmap_premult_span_8888 (p, width,
+                                          !!(format & COGL_AFIRST_BIT));
         }
     }
 
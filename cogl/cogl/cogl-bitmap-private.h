@@ -109,7 +109,7 @@ _cogl_bitmap_convert_for_upload (CoglBitmap *src_bmp,
                                  gboolean can_convert_in_place,
                                  GError **error);
 
-gboolean
+COGL_EXPORT_TEST gboolean
 _cogl_bitmap_convert_into_bitmap (CoglBitmap *src_bmp,
                                   CoglBitmap *dst_bmp,
                                   GError **error);
@@ -127,11 +127,23 @@ gboolean
 _cogl_bitmap_premult (CoglBitmap *dst_bmp,
                       GError **error);
 
-gboolean
+COGL_EXPORT_TEST gboolean
 _cogl_bitmap_convert_premult_status (CoglBitmap *bmp,
                                      CoglPixelFormat dst_format,
                                      GError **error);
 
+/*
+ * _cogl_bitmap_set_conversion_fast_paths_enabled:
+ * @enabled: whether to use the optimized conversion paths
+ *
+ * Enables or disables the swizzle, SIMD and lookup table based fast
+ * paths used for format conversion and (un)premultiplication. These
+ * are enabled by default; disabling them is only useful to check
+ * their results against the generic code.
+ */
+COGL_EXPORT_TEST void
+_cogl_bitmap_set_conversion_fast_paths_enabled (gboolean enabled);
+
 gboolean
 _cogl_bitmap_copy_subregion (CoglBitmap *src,
                              CoglBitmap *dst,
@@ -148,6 +160,11 @@ CoglBitmap *
 _cogl_bitmap_copy (CoglBitmap *src_bmp,
                    GError **error);
 
+/* Reverses the order of the rows of the bitmap in-place */
+gboolean
+_cogl_bitmap_flip_vertically (CoglBitmap *bitmap,
+                              GError **error);
+
 gboolean
 _cogl_bitmap_get_size_from_file (const char *filename,
                                  int        *width,
@@ -67,6 +67,40 @@ struct _CoglTimestampQuery
   unsigned int id;
 };
 
+/* Groups of GL state that are shadowed by the context so that
+ * redundant calls can be skipped. Each group counts how many state
+ * changes were sent to GL and how many were skipped because GL was
+ * already in the requested state. */
+typedef enum
+{
+  COGL_GL_STATE_PROGRAM,
+  COGL_GL_STATE_TEXTURE,
+  COGL_GL_STATE_SAMPLER,
+  COGL_GL_STATE_BLEND,
+  COGL_GL_STATE_DEPTH,
+  COGL_GL_STATE_CULL_FACE,
+  COGL_GL_STATE_SCISSOR,
+  COGL_GL_STATE_STENCIL,
+  COGL_GL_STATE_VIEWPORT,
+  COGL_GL_STATE_ATTRIBUTES,
+
+  COGL_GL_STATE_N_GROUPS
+} CoglGLStateGroup;
+
+typedef struct
+{
+  unsigned int n_issued[COGL_GL_STATE_N_GROUPS];
+  unsigned int n_skipped[COGL_GL_STATE_N_GROUPS];
+  /* glDrawArrays/glDrawElements calls, i.e. the number of journal
+   * batches and primitives actually submitted */
+  unsigned int n_draws;
+} CoglGLStateCounters;
+
+#define COGL_GL_STATE_ISSUED(ctx, group) \
+  ((ctx)->gl_state_counters.n_issued[COGL_GL_STATE_##group]++)
+#define COGL_GL_STATE_SKIPPED(ctx, group) \
+  ((ctx)->gl_state_counters.n_skipped[COGL_GL_STATE_##group]++)
+
 struct _CoglContext
 {
   CoglObject _parent;
@@ -154,6 +188,33 @@ struct _CoglContext
 
   gboolean          gl_blend_enable_cache;
 
+  /* The blend equation, factors and constant last sent to GL. These
+   * are only valid if gl_blend_state_cache_valid is TRUE */
+  gboolean          gl_blend_state_cache_valid;
+  GLenum            gl_blend_equation_rgb_cache;
+  GLenum            gl_blend_equation_alpha_cache;
+  GLint             gl_blend_src_factor_rgb_cache;
+  GLint             gl_blend_dst_factor_rgb_cache;
+  GLint             gl_blend_src_factor_alpha_cache;
+  GLint             gl_blend_dst_factor_alpha_cache;
+  gboolean          gl_blend_color_cache_valid;
+  float             gl_blend_color_cache[4];
+
+  /* Face culling state, valid if gl_cull_face_cache_valid is TRUE */
+  gboolean          gl_cull_face_cache_valid;
+  gboolean          gl_cull_face_enabled_cache;
+  GLenum            gl_cull_face_mode_cache;
+  GLenum            gl_front_face_cache;
+
+  /* Scissor, stencil test and viewport state last sent to GL. A
+   * negative width means the rectangle isn't known */
+  gboolean          gl_scissor_test_enabled_cache;
+  int               gl_scissor_cache[4];
+  gboolean          gl_stencil_test_enabled_cache;
+  float             gl_viewport_cache[4];
+
+  CoglGLStateCounters gl_state_counters;
+
   gboolean              depth_test_enabled_cache;
   CoglDepthTestFunction depth_test_function_cache;
   gboolean              depth_writing_enabled_cache;
@@ -313,4 +374,9 @@ void
 _cogl_context_set_current_modelview_entry (CoglContext *context,
                                            CoglMatrixEntry *entry);
 
+/* Reports the GL state counters accumulated since the last call
+ * as a trace mark and resets them */
+void
+_cogl_context_flush_gl_state_counters (CoglContext *context);
+
 #endif /* __COGL_CONTEXT_PRIVATE_H */
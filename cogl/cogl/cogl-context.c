@@ -47,6 +47,7 @@
 #include "cogl-attribute-private.h"
 #include "cogl1-context.h"
 #include "cogl-gtype-private.h"
+#include "cogl-trace.h"
 #include "winsys/cogl-winsys-private.h"
 
 #include <gio/gio.h>
@@ -275,6 +276,16 @@ cogl_context_new (CoglDisplay *display,
   context->depth_range_near_cache = 0;
   context->depth_range_far_cache = 1;
 
+  context->gl_blend_state_cache_valid = FALSE;
+  context->gl_blend_color_cache_valid = FALSE;
+  context->gl_cull_face_cache_valid = FALSE;
+  context->gl_scissor_test_enabled_cache = FALSE;
+  context->gl_scissor_cache[2] = -1;
+  context->gl_stencil_test_enabled_cache = FALSE;
+  context->gl_viewport_cache[2] = -1;
+  memset (&context->gl_state_counters, 0,
+          sizeof (context->gl_state_counters));
+
   context->pipeline_cache = _cogl_pipeline_cache_new ();
 
   for (i = 0; i < COGL_BUFFER_BIND_TARGET_COUNT; i++)
@@ -458,6 +469,61 @@ _cogl_context_set_current_modelview_entry (CoglContext *context,
   context->current_modelview_entry = entry;
 }
 
+void
+_cogl_context_flush_gl_state_counters (CoglContext *context)
+{
+  CoglGLStateCounters *counters = &context->gl_state_counters;
+
+#ifdef COGL_HAS_TRACING
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      static const char *group_names[] = {
+        "program",
+        "texture",
+        "sampler",
+        "blend",
+        "depth",
+        "cull-face",
+        "scissor",
+        "stencil",
+        "viewport",
+        "attributes",
+      };
+      g_autoptr (GString) description = NULL;
+      unsigned int n_issued = 0;
+      unsigned int n_skipped = 0;
+      int i;
+
+      G_STATIC_ASSERT (G_N_ELEMENTS (group_names) == COGL_GL_STATE_N_GROUPS);
+
+      COGL_TRACE_BEGIN_SCOPED (CoglGLStateChanges, "GL state changes");
+
+      description = g_string_new ("issued/skipped");
+
+      for (i = 0; i < COGL_GL_STATE_N_GROUPS; i++)
+        {
+          n_issued += counters->n_issued[i];
+          n_skipped += counters->n_skipped[i];
+
+          if (counters->n_issued[i] == 0 && counters->n_skipped[i] == 0)
+            continue;
+
+          g_string_append_printf (description, ", %s: %u/%u",
+                                  group_names[i],
+                                  counters->n_issued[i],
+                                  counters->n_skipped[i]);
+        }
+
+      g_string_append_printf (description, ", total: %u/%u, draws: %u",
+                              n_issued, n_skipped, counters->n_draws);
+
+      COGL_TRACE_DESCRIBE (CoglGLStateChanges, description->str);
+    }
+#endif
+
+  memset (counters, 0, sizeof (*counters));
+}
+
 CoglGraphicsResetStatus
 cogl_get_graphics_reset_status (CoglContext *context)
 {
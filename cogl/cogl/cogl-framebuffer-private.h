@@ -103,7 +103,13 @@ typedef enum
      for GL's upside-down coordinate system but instead will be left
      in whatever order GL gives us (which will depend on whether the
      framebuffer is offscreen or not) */
-  COGL_READ_PIXELS_NO_FLIP = 1L << 30
+  COGL_READ_PIXELS_NO_FLIP = 1L << 30,
+  /* If this is set then the driver must read straight into the
+     destination bitmap. If that isn't possible because the format
+     needs converting through a temporary buffer then the read fails
+     with COGL_SYSTEM_ERROR_UNSUPPORTED instead of doing a blocking
+     CPU conversion */
+  COGL_READ_PIXELS_NO_CONVERSION = 1L << 29
 } CoglPrivateReadPixelsFlags;
 
 typedef struct _CoglFramebufferBits
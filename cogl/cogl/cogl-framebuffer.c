@@ -44,6 +44,7 @@
 #include "cogl-onscreen-template-private.h"
 #include "cogl-clip-stack.h"
 #include "cogl-journal-private.h"
+#include "cogl-fence.h"
 #include "cogl-pipeline-state-private.h"
 #include "cogl-primitive-private.h"
 #include "cogl-offscreen.h"
@@ -1540,6 +1541,171 @@ cogl_framebuffer_read_pixels_into_bitmap (CoglFramebuffer *framebuffer,
   return status;
 }
 
+typedef struct
+{
+  CoglFramebuffer *framebuffer;
+  CoglBitmap *bitmap;
+  CoglBitmap *read_bmp;
+  gboolean needs_flip;
+  CoglReadPixelsCallback callback;
+  void *user_data;
+} CoglReadPixelsClosure;
+
+static void
+read_pixels_fence_cb (CoglFence *fence,
+                      void      *user_data)
+{
+  CoglReadPixelsClosure *closure = user_data;
+  GError *error = NULL;
+  gboolean success;
+
+  /* The GPU has finished writing into the pixel buffer so mapping it
+   * to do the fixups that were skipped when the read was issued
+   * won't stall */
+  success =
+    _cogl_bitmap_convert_premult_status (closure->read_bmp,
+                                         cogl_bitmap_get_format (closure->bitmap),
+                                         &error);
+  if (success && closure->needs_flip)
+    success = _cogl_bitmap_flip_vertically (closure->bitmap, &error);
+
+  if (error)
+    {
+      g_warning ("Failed to finish reading pixels: %s", error->message);
+      g_error_free (error);
+    }
+
+  closure->callback (closure->framebuffer,
+                     closure->bitmap,
+                     success,
+                     closure->user_data);
+
+  cogl_object_unref (closure->read_bmp);
+  cogl_object_unref (closure->bitmap);
+  g_object_unref (closure->framebuffer);
+  g_free (closure);
+}
+
+gboolean
+cogl_framebuffer_read_pixels_into_bitmap_async (CoglFramebuffer         *framebuffer,
+                                                int                      x,
+                                                int                      y,
+                                                CoglReadPixelsFlags      source,
+                                                CoglBitmap              *bitmap,
+                                                CoglReadPixelsCallback   callback,
+                                                void                    *user_data,
+                                                GError                 **error)
+{
+  CoglFramebufferPrivate *priv =
+    cogl_framebuffer_get_instance_private (framebuffer);
+  CoglContext *ctx = priv->context;
+  CoglPixelFormat format;
+  CoglPixelFormat read_format;
+  CoglReadPixelsClosure *closure;
+  CoglBitmap *read_bmp;
+  CoglReadPixelsFlags read_flags;
+  gboolean needs_flip;
+  GError *internal_error = NULL;
+
+  g_return_val_if_fail (source & COGL_READ_PIXELS_COLOR_BUFFER, FALSE);
+  g_return_val_if_fail (cogl_is_framebuffer (framebuffer), FALSE);
+  g_return_val_if_fail (callback != NULL, FALSE);
+
+  if (!cogl_framebuffer_allocate (framebuffer, error))
+    return FALSE;
+
+  format = cogl_bitmap_get_format (bitmap);
+
+  if (!cogl_has_feature (ctx, COGL_FEATURE_ID_FENCE) ||
+      !cogl_bitmap_get_buffer (bitmap) ||
+      cogl_pixel_format_get_n_planes (format) != 1)
+    goto fallback;
+
+  /* Read the pixels with the premultiplied state of the framebuffer
+   * and without flipping them on the CPU so that the driver doesn't
+   * need to map the buffer. Both fixups are done once the fence has
+   * been reached instead. */
+  if (COGL_PIXEL_FORMAT_CAN_HAVE_PREMULT (format))
+    {
+      CoglPixelFormat internal_format =
+        cogl_framebuffer_get_internal_format (framebuffer);
+
+      read_format = ((format & ~COGL_PREMULT_BIT) |
+                     (internal_format & COGL_PREMULT_BIT));
+    }
+  else
+    {
+      read_format = format;
+    }
+
+  if (read_format != format)
+    read_bmp = _cogl_bitmap_new_shared (bitmap,
+                                        read_format,
+                                        cogl_bitmap_get_width (bitmap),
+                                        cogl_bitmap_get_height (bitmap),
+                                        cogl_bitmap_get_rowstride (bitmap));
+  else
+    read_bmp = cogl_object_ref (bitmap);
+
+  read_flags = source | COGL_READ_PIXELS_NO_CONVERSION;
+
+  /* If the driver can flip the rows while packing them then let it,
+   * otherwise flip them later */
+  needs_flip =
+    !cogl_framebuffer_is_y_flipped (framebuffer) &&
+    !_cogl_has_private_feature (ctx, COGL_PRIVATE_FEATURE_MESA_PACK_INVERT);
+  if (needs_flip)
+    read_flags |= COGL_READ_PIXELS_NO_FLIP;
+
+  _cogl_framebuffer_flush_journal (framebuffer);
+
+  if (!cogl_framebuffer_driver_read_pixels_into_bitmap (priv->driver,
+                                                        x, y,
+                                                        read_flags,
+                                                        read_bmp,
+                                                        &internal_error))
+    {
+      cogl_object_unref (read_bmp);
+
+      if (g_error_matches (internal_error,
+                           COGL_SYSTEM_ERROR,
+                           COGL_SYSTEM_ERROR_UNSUPPORTED))
+        {
+          g_error_free (internal_error);
+          goto fallback;
+        }
+
+      g_propagate_error (error, internal_error);
+      return FALSE;
+    }
+
+  closure = g_new0 (CoglReadPixelsClosure, 1);
+  closure->framebuffer = g_object_ref (framebuffer);
+  closure->bitmap = cogl_object_ref (bitmap);
+  closure->read_bmp = read_bmp;
+  closure->needs_flip = needs_flip;
+  closure->callback = callback;
+  closure->user_data = user_data;
+
+  cogl_framebuffer_add_fence_callback (framebuffer,
+                                       read_pixels_fence_cb,
+                                       closure);
+
+  return TRUE;
+
+fallback:
+  if (!_cogl_framebuffer_read_pixels_into_bitmap (framebuffer,
+                                                  x, y,
+                                                  source,
+                                                  bitmap,
+                                                  error))
+    return FALSE;
+
+  callback (framebuffer, bitmap, TRUE, user_data);
+
+  return TRUE;
+}
+
 gboolean
 cogl_framebuffer_read_pixels (CoglFramebuffer *framebuffer,
                               int x,
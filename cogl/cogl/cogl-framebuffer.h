@@ -1220,6 +1220,64 @@ cogl_framebuffer_read_pixels_into_bitmap (CoglFramebuffer *framebuffer,
                                           CoglReadPixelsFlags source,
                                           CoglBitmap *bitmap);
 
+/**
+ * CoglReadPixelsCallback:
+ * @framebuffer: The #CoglFramebuffer that was read from
+ * @bitmap: The #CoglBitmap passed to
+ *   cogl_framebuffer_read_pixels_into_bitmap_async()
+ * @success: %TRUE if @bitmap now contains the pixels
+ * @user_data: The private data passed to
+ *   cogl_framebuffer_read_pixels_into_bitmap_async()
+ *
+ * The callback prototype used with
+ * cogl_framebuffer_read_pixels_into_bitmap_async() for notification
+ * that the pixels have been read.
+ */
+typedef void (* CoglReadPixelsCallback) (CoglFramebuffer *framebuffer,
+                                         CoglBitmap      *bitmap,
+                                         gboolean         success,
+                                         void            *user_data);
+
+/**
+ * cogl_framebuffer_read_pixels_into_bitmap_async:
+ * @framebuffer: A #CoglFramebuffer
+ * @x: The x position to read from
+ * @y: The y position to read from
+ * @source: Identifies which auxiliary buffer you want to read
+ *          (only COGL_READ_PIXELS_COLOR_BUFFER supported currently)
+ * @bitmap: The bitmap to store the results in.
+ * @callback: (scope async): A #CoglReadPixelsCallback to call once
+ *   the pixels are available
+ * @user_data: (closure): Private data to pass to @callback
+ * @error: Return location for a #GError
+ *
+ * Starts reading a rectangle of pixels from the given framebuffer in
+ * the same way as cogl_framebuffer_read_pixels_into_bitmap() but
+ * without waiting for the GPU to finish rendering.
+ *
+ * If @bitmap is backed by a #CoglPixelBuffer, for example because it
+ * was created with cogl_bitmap_new_with_size(), and the driver supports
+ * %COGL_FEATURE_ID_FENCE, the pixels are copied into the buffer by the
+ * GPU and @callback is invoked from the main loop once the copy has
+ * completed. The buffer can then be mapped without stalling.
+ *
+ * Otherwise the pixels are read synchronously and @callback is invoked
+ * before this function returns.
+ *
+ * Return value: %TRUE if the read was started, in which case @callback
+ *   will be invoked exactly once, or %FALSE if it failed, in which case
+ *   @callback will not be invoked.
+ */
+COGL_EXPORT gboolean
+cogl_framebuffer_read_pixels_into_bitmap_async (CoglFramebuffer         *framebuffer,
+                                                int                      x,
+                                                int                      y,
+                                                CoglReadPixelsFlags      source,
+                                                CoglBitmap              *bitmap,
+                                                CoglReadPixelsCallback   callback,
+                                                void                    *user_data,
+                                                GError                 **error);
+
 /**
  * cogl_framebuffer_read_pixels:
  * @framebuffer: A #CoglFramebuffer
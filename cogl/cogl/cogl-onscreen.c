@@ -33,6 +33,7 @@
 #include <gio/gio.h>
 
 #include "cogl-util.h"
+#include "cogl-atlas-texture-private.h"
 #include "cogl-onscreen-private.h"
 #include "cogl-frame-info-private.h"
 #include "cogl-framebuffer-private.h"
@@ -344,6 +345,13 @@ cogl_onscreen_swap_buffers_with_damage (CoglOnscreen *onscreen,
                                    info,
                                    user_data);
 
+  _cogl_atlas_texture_defragment_atlases (
+    cogl_framebuffer_get_context (framebuffer),
+    COGL_ATLAS_TEXTURE_MAX_DEFRAGMENT_MOVES_PER_FRAME);
+
+  _cogl_context_flush_gl_state_counters (
+    cogl_framebuffer_get_context (framebuffer));
+
   if (!_cogl_winsys_has_feature (COGL_WINSYS_FEATURE_SYNC_AND_COMPLETE_EVENT))
     {
       CoglFrameInfo *info;
@@ -404,6 +412,13 @@ cogl_onscreen_swap_region (CoglOnscreen *onscreen,
                       info,
                       user_data);
 
+  _cogl_atlas_texture_defragment_atlases (
+    cogl_framebuffer_get_context (framebuffer),
+    COGL_ATLAS_TEXTURE_MAX_DEFRAGMENT_MOVES_PER_FRAME);
+
+  _cogl_context_flush_gl_state_counters (
+    cogl_framebuffer_get_context (framebuffer));
+
   if (!_cogl_winsys_has_feature (COGL_WINSYS_FEATURE_SYNC_AND_COMPLETE_EVENT))
     {
       CoglFrameInfo *info;
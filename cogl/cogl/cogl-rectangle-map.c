@@ -31,6 +31,7 @@
  *  Neil Roberts   <neil@linux.intel.com>
  */
 
+
 #include "cogl-config.h"
 
 #include <glib.h>
@@ -40,84 +41,78 @@
 #include "cogl-debug.h"
 
 /* Implements a data structure which keeps track of unused
-   sub-rectangles within a larger rectangle using a binary tree
-   structure. The algorithm for this is based on the description here:
-
-   http://www.blackpawn.com/texts/lightmaps/default.html
+   sub-rectangles within a larger rectangle using the MaxRects
+   algorithm. The free space is described as a list of possibly
+   overlapping free rectangles which are each as large as they can be,
+   and new rectangles are put in the free rectangle that leaves the
+   shortest leftover side. The algorithm is described here:
+
+   http://clb.demon.fi/files/RectangleBinPack.pdf
+
+   Removing a rectangle just adds it back as a free rectangle, which
+   leaves the free list valid but no longer maximal. The maximal list
+   is only rebuilt from the used rectangles when an addition fails or
+   when explicitly merging the free space before compacting, so
+   removals stay cheap.
 */
 
-typedef struct _CoglRectangleMapNode       CoglRectangleMapNode;
-typedef struct _CoglRectangleMapStackEntry CoglRectangleMapStackEntry;
-
-typedef void (* CoglRectangleMapInternalForeachCb) (CoglRectangleMapNode *node,
-                                                    void *data);
-
-typedef enum
-{
-  COGL_RECTANGLE_MAP_BRANCH,
-  COGL_RECTANGLE_MAP_FILLED_LEAF,
-  COGL_RECTANGLE_MAP_EMPTY_LEAF
-} CoglRectangleMapNodeType;
+typedef struct _CoglRectangleMapRectangle CoglRectangleMapRectangle;
 
-struct _CoglRectangleMap
+struct _CoglRectangleMapRectangle
 {
-  CoglRectangleMapNode *root;
-
-  unsigned int n_rectangles;
+  CoglRectangleMapEntry entry;
 
-  unsigned int space_remaining;
-
-  GDestroyNotify value_destroy_func;
-
-  /* Stack used for walking the structure. This is only used during
-     the lifetime of a single function call but it is kept here as an
-     optimisation to avoid reallocating it every time it is needed */
-  GArray *stack;
+  void *data;
 };
 
-struct _CoglRectangleMapNode
+struct _CoglRectangleMap
 {
-  CoglRectangleMapNodeType type;
+  unsigned int width;
+  unsigned int height;
 
-  CoglRectangleMapEntry rectangle;
+  /* Array of CoglRectangleMapRectangle */
+  GArray *rectangles;
 
-  unsigned int largest_gap;
+  /* Array of CoglRectangleMapEntry describing the free space */
+  GArray *free_rectangles;
 
-  CoglRectangleMapNode *parent;
+  /* Whether rectangles have been removed since the free rectangles
+     were last made maximal */
+  gboolean free_rectangles_fragmented;
 
-  union
-  {
-    /* Fields used when this is a branch */
-    struct
-    {
-      CoglRectangleMapNode *left;
-      CoglRectangleMapNode *right;
-    } branch;
+  unsigned int space_remaining;
 
-    /* Field used when this is a filled leaf */
-    void *data;
-  } d;
+  GDestroyNotify value_destroy_func;
 };
 
-struct _CoglRectangleMapStackEntry
+static inline gboolean
+entries_intersect (const CoglRectangleMapEntry *a,
+                   const CoglRectangleMapEntry *b)
 {
-  /* The node to search */
-  CoglRectangleMapNode *node;
-  /* Index of next branch of this node to explore. Basically either 0
-     to go left or 1 to go right */
-  gboolean next_index;
-};
+  return (a->x < b->x + b->width &&
+          b->x < a->x + a->width &&
+          a->y < b->y + b->height &&
+          b->y < a->y + a->height);
+}
 
-static CoglRectangleMapNode *
-_cogl_rectangle_map_node_new (void)
+static inline gboolean
+entry_contains (const CoglRectangleMapEntry *outer,
+                const CoglRectangleMapEntry *inner)
 {
-  return g_new0 (CoglRectangleMapNode, 1);
+  return (inner->x >= outer->x &&
+          inner->y >= outer->y &&
+          inner->x + inner->width <= outer->x + outer->width &&
+          inner->y + inner->height <= outer->y + outer->height);
 }
 
 static void
-_cogl_rectangle_map_node_free (CoglRectangleMapNode *node)
+reset_free_rectangles (CoglRectangleMap *map)
 {
-  g_free (node);
+  CoglRectangleMapEntry all = { 0, 0, map->width, map->height };
+
+  g_array_set_size (map->free_rectangles, 0);
+  g_array_append_val (map->free_rectangles, all);
+  map->free_rectangles_fragmented = FALSE;
 }
 
 CoglRectangleMap *
@@ -126,137 +121,197 @@ _cogl_rectangle_map_new (unsigned int width,
                          GDestroyNotify value_destroy_func)
 {
   CoglRectangleMap *map = g_new (CoglRectangleMap, 1);
-  CoglRectangleMapNode *root = _cogl_rectangle_map_node_new ();
-
-  root->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-  root->parent = NULL;
-  root->rectangle.x = 0;
-  root->rectangle.y = 0;
-  root->rectangle.width = width;
-  root->rectangle.height = height;
-  root->largest_gap = width * height;
-
-  map->root = root;
-  map->n_rectangles = 0;
+
+  map->width = width;
+  map->height = height;
+  map->rectangles = g_array_new (FALSE, FALSE,
+                                 sizeof (CoglRectangleMapRectangle));
+  map->free_rectangles = g_array_new (FALSE, FALSE,
+                                      sizeof (CoglRectangleMapEntry));
   map->value_destroy_func = value_destroy_func;
   map->space_remaining = width * height;
 
-  map->stack = g_array_new (FALSE, FALSE, sizeof (CoglRectangleMapStackEntry));
+  reset_free_rectangles (map);
 
   return map;
 }
 
 static void
-_cogl_rectangle_map_stack_push (GArray *stack,
-                                CoglRectangleMapNode *node,
-                                gboolean next_index)
+prune_free_rectangles (CoglRectangleMap *map,
+                       unsigned int      first_new)
 {
-  CoglRectangleMapStackEntry *new_entry;
+  GArray *free_rectangles = map->free_rectangles;
+  unsigned int i, j;
+
+  /* Remove any new free rectangle that is contained in another one
+     so that the list only contains maximal rectangles. The entries
+     before first_new were already maximal and each new piece is a
+     part of a rectangle that was maximal, so none of the old entries
+     can be contained in a new one. */
+  for (i = first_new; i < free_rectangles->len; i++)
+    {
+      CoglRectangleMapEntry *piece =
+        &g_array_index (free_rectangles, CoglRectangleMapEntry, i);
 
-  g_array_set_size (stack, stack->len + 1);
+      for (j = 0; j < free_rectangles->len; j++)
+        {
+          CoglRectangleMapEntry *other =
+            &g_array_index (free_rectangles, CoglRectangleMapEntry, j);
 
-  new_entry = &g_array_index (stack, CoglRectangleMapStackEntry,
-                              stack->len - 1);
+          if (i == j || !entry_contains (other, piece))
+            continue;
 
-  new_entry->node = node;
-  new_entry->next_index = next_index;
+          /* Only drop one of two identical pieces */
+          if (j > i && entry_contains (piece, other))
+            continue;
+
+          g_array_remove_index_fast (free_rectangles, i);
+          i--;
+          break;
+        }
+    }
 }
 
 static void
-_cogl_rectangle_map_stack_pop (GArray *stack)
+split_free_rectangles (CoglRectangleMap            *map,
+                       const CoglRectangleMapEntry *used)
 {
-  g_array_set_size (stack, stack->len - 1);
+  GArray *free_rectangles = map->free_rectangles;
+  unsigned int n_free_rectangles = free_rectangles->len;
+  unsigned int i;
+
+  /* Replace every free rectangle that intersects the used rectangle
+     with the (up to four) maximal pieces of it that remain free. The
+     new pieces are appended so only the original entries need to be
+     visited. */
+  for (i = 0; i < n_free_rectangles; i++)
+    {
+      CoglRectangleMapEntry free_rect =
+        g_array_index (free_rectangles, CoglRectangleMapEntry, i);
+      CoglRectangleMapEntry piece;
+
+      if (!entries_intersect (&free_rect, used))
+        continue;
+
+      if (used->x > free_rect.x)
+        {
+          piece = free_rect;
+          piece.width = used->x - free_rect.x;
+          g_array_append_val (free_rectangles, piece);
+        }
+
+      if (used->x + used->width < free_rect.x + free_rect.width)
+        {
+          piece = free_rect;
+          piece.x = used->x + used->width;
+          piece.width = free_rect.x + free_rect.width - piece.x;
+          g_array_append_val (free_rectangles, piece);
+        }
+
+      if (used->y > free_rect.y)
+        {
+          piece = free_rect;
+          piece.height = used->y - free_rect.y;
+          g_array_append_val (free_rectangles, piece);
+        }
+
+      if (used->y + used->height < free_rect.y + free_rect.height)
+        {
+          piece = free_rect;
+          piece.y = used->y + used->height;
+          piece.height = free_rect.y + free_rect.height - piece.y;
+          g_array_append_val (free_rectangles, piece);
+        }
+
+      /* Move the last original entry into this slot so that the
+         entries still to visit stay in front of the new pieces */
+      n_free_rectangles--;
+      g_array_index (free_rectangles, CoglRectangleMapEntry, i) =
+        g_array_index (free_rectangles, CoglRectangleMapEntry,
+                       n_free_rectangles);
+      g_array_remove_index_fast (free_rectangles, n_free_rectangles);
+      i--;
+    }
+
+  prune_free_rectangles (map, n_free_rectangles);
 }
 
-static CoglRectangleMapStackEntry *
-_cogl_rectangle_map_stack_get_top (GArray *stack)
+static void
+defragment_free_rectangles (CoglRectangleMap *map)
 {
-  return &g_array_index (stack, CoglRectangleMapStackEntry,
-                         stack->len - 1);
+  unsigned int i;
+
+  if (!map->free_rectangles_fragmented)
+    return;
+
+  reset_free_rectangles (map);
+
+  for (i = 0; i < map->rectangles->len; i++)
+    {
+      CoglRectangleMapRectangle *rectangle =
+        &g_array_index (map->rectangles, CoglRectangleMapRectangle, i);
+
+      split_free_rectangles (map, &rectangle->entry);
+    }
 }
 
-static CoglRectangleMapNode *
-_cogl_rectangle_map_node_split_horizontally (CoglRectangleMapNode *node,
-                                             unsigned int left_width)
+static gboolean
+find_best_short_side_fit (CoglRectangleMap      *map,
+                          unsigned int           width,
+                          unsigned int           height,
+                          CoglRectangleMapEntry *rectangle)
 {
-  /* Splits the node horizontally (according to emacs' definition, not
-     vim) by converting it to a branch and adding two new leaf
-     nodes. The leftmost branch will have the width left_width and
-     will be returned. If the node is already just the right size it
-     won't do anything */
-
-  CoglRectangleMapNode *left_node, *right_node;
-
-  if (node->rectangle.width == left_width)
-    return node;
-
-  left_node = _cogl_rectangle_map_node_new ();
-  left_node->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-  left_node->parent = node;
-  left_node->rectangle.x = node->rectangle.x;
-  left_node->rectangle.y = node->rectangle.y;
-  left_node->rectangle.width = left_width;
-  left_node->rectangle.height = node->rectangle.height;
-  left_node->largest_gap = (left_node->rectangle.width *
-                            left_node->rectangle.height);
-  node->d.branch.left = left_node;
-
-  right_node = _cogl_rectangle_map_node_new ();
-  right_node->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-  right_node->parent = node;
-  right_node->rectangle.x = node->rectangle.x + left_width;
-  right_node->rectangle.y = node->rectangle.y;
-  right_node->rectangle.width = node->rectangle.width - left_width;
-  right_node->rectangle.height = node->rectangle.height;
-  right_node->largest_gap = (right_node->rectangle.width *
-                             right_node->rectangle.height);
-  node->d.branch.right = right_node;
-
-  node->type = COGL_RECTANGLE_MAP_BRANCH;
-
-  return left_node;
+  unsigned int best_short_side = G_MAXUINT;
+  unsigned int best_long_side = G_MAXUINT;
+  gboolean found = FALSE;
+  unsigned int i;
+
+  for (i = 0; i < map->free_rectangles->len; i++)
+    {
+      CoglRectangleMapEntry *free_rect =
+        &g_array_index (map->free_rectangles, CoglRectangleMapEntry, i);
+      unsigned int leftover_width, leftover_height;
+      unsigned int short_side, long_side;
+
+      if (free_rect->width < width || free_rect->height < height)
+        continue;
+
+      leftover_width = free_rect->width - width;
+      leftover_height = free_rect->height - height;
+      short_side = MIN (leftover_width, leftover_height);
+      long_side = MAX (leftover_width, leftover_height);
+
+      if (short_side < best_short_side ||
+          (short_side == best_short_side && long_side < best_long_side))
+        {
+          rectangle->x = free_rect->x;
+          rectangle->y = free_rect->y;
+          best_short_side = short_side;
+          best_long_side = long_side;
+          found = TRUE;
+        }
+    }
+
+  rectangle->width = width;
+  rectangle->height = height;
+
+  return found;
 }
 
-static CoglRectangleMapNode *
-_cogl_rectangle_map_node_split_vertically (CoglRectangleMapNode *node,
-                                           unsigned int top_height)
+static void
+insert_rectangle (CoglRectangleMap            *map,
+                  const CoglRectangleMapEntry *entry,
+                  void                        *data)
 {
-  /* Splits the node vertically (according to emacs' definition, not
-     vim) by converting it to a branch and adding two new leaf
-     nodes. The topmost branch will have the height top_height and
-     will be returned. If the node is already just the right size it
-     won't do anything */
-
-  CoglRectangleMapNode *top_node, *bottom_node;
-
-  if (node->rectangle.height == top_height)
-    return node;
-
-  top_node = _cogl_rectangle_map_node_new ();
-  top_node->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-  top_node->parent = node;
-  top_node->rectangle.x = node->rectangle.x;
-  top_node->rectangle.y = node->rectangle.y;
-  top_node->rectangle.width = node->rectangle.width;
-  top_node->rectangle.height = top_height;
-  top_node->largest_gap = (top_node->rectangle.width *
-                           top_node->rectangle.height);
-  node->d.branch.left = top_node;
-
-  bottom_node = _cogl_rectangle_map_node_new ();
-  bottom_node->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-  bottom_node->parent = node;
-  bottom_node->rectangle.x = node->rectangle.x;
-  bottom_node->rectangle.y = node->rectangle.y + top_height;
-  bottom_node->rectangle.width = node->rectangle.width;
-  bottom_node->rectangle.height = node->rectangle.height - top_height;
-  bottom_node->largest_gap = (bottom_node->rectangle.width *
-                              bottom_node->rectangle.height);
-  node->d.branch.right = bottom_node;
-
-  node->type = COGL_RECTANGLE_MAP_BRANCH;
-
-  return top_node;
+  CoglRectangleMapRectangle rectangle;
+
+  rectangle.entry = *entry;
+  rectangle.data = data;
+  g_array_append_val (map->rectangles, rectangle);
+
+  split_free_rectangles (map, entry);
+
+  map->space_remaining -= entry->width * entry->height;
 }
 
 gboolean
@@ -266,204 +321,167 @@ _cogl_rectangle_map_add (CoglRectangleMap *map,
                          void *data,
                          CoglRectangleMapEntry *rectangle)
 {
-  unsigned int rectangle_size = width * height;
-  /* Stack of nodes to search in */
-  GArray *stack = map->stack;
-  CoglRectangleMapNode *found_node = NULL;
+  CoglRectangleMapEntry new_rectangle;
 
-  /* Zero-sized rectangles break the algorithm for removing rectangles
-     so we'll disallow them */
+  /* Zero-sized rectangles can't be told apart when removing them so
+     we'll disallow them */
   g_return_val_if_fail (width > 0 && height > 0, FALSE);
 
-  /* Start with the root node */
-  g_array_set_size (stack, 0);
-  _cogl_rectangle_map_stack_push (stack, map->root, FALSE);
+  if (width * height > map->space_remaining)
+    return FALSE;
 
-  /* Depth-first search for an empty node that is big enough */
-  while (stack->len > 0)
+  if (!find_best_short_side_fit (map, width, height, &new_rectangle))
     {
-      CoglRectangleMapStackEntry *stack_top;
-      CoglRectangleMapNode *node;
-      int next_index;
-
-      /* Pop an entry off the stack */
-      stack_top = _cogl_rectangle_map_stack_get_top (stack);
-      node = stack_top->node;
-      next_index = stack_top->next_index;
-      _cogl_rectangle_map_stack_pop (stack);
-
-      /* Regardless of the type of the node, there's no point
-         descending any further if the new rectangle won't fit within
-         it */
-      if (node->rectangle.width >= width &&
-          node->rectangle.height >= height &&
-          node->largest_gap >= rectangle_size)
-        {
-          if (node->type == COGL_RECTANGLE_MAP_EMPTY_LEAF)
-            {
-              /* We've found a node we can use */
-              found_node = node;
-              break;
-            }
-          else if (node->type == COGL_RECTANGLE_MAP_BRANCH)
-            {
-              if (next_index)
-                /* Try the right branch */
-                _cogl_rectangle_map_stack_push (stack,
-                                                node->d.branch.right,
-                                                0);
-              else
-                {
-                  /* Make sure we remember to try the right branch once
-                     we've finished descending the left branch */
-                  _cogl_rectangle_map_stack_push (stack,
-                                                  node,
-                                                  1);
-                  /* Try the left branch */
-                  _cogl_rectangle_map_stack_push (stack,
-                                                  node->d.branch.left,
-                                                  0);
-                }
-            }
-        }
+      /* The free space might just be split up by earlier removals */
+      if (!map->free_rectangles_fragmented)
+        return FALSE;
+
+      defragment_free_rectangles (map);
+
+      if (!find_best_short_side_fit (map, width, height, &new_rectangle))
+        return FALSE;
+    }
+
+  insert_rectangle (map, &new_rectangle, data);
+
+  if (rectangle)
+    *rectangle = new_rectangle;
+
+  return TRUE;
+}
+
+gboolean
+_cogl_rectangle_map_add_at (CoglRectangleMap            *map,
+                            const CoglRectangleMapEntry *rectangle,
+                            void                        *data)
+{
+  unsigned int i;
+
+  g_return_val_if_fail (rectangle->width > 0 && rectangle->height > 0, FALSE);
+
+  if (rectangle->x + rectangle->width > map->width ||
+      rectangle->y + rectangle->height > map->height)
+    return FALSE;
+
+  for (i = 0; i < map->rectangles->len; i++)
+    {
+      CoglRectangleMapRectangle *other =
+        &g_array_index (map->rectangles, CoglRectangleMapRectangle, i);
+
+      if (entries_intersect (&other->entry, rectangle))
+        return FALSE;
     }
 
-  if (found_node)
+  insert_rectangle (map, rectangle, data);
+
+  return TRUE;
+}
+
+void
+_cogl_rectangle_map_merge_free_space (CoglRectangleMap *map)
+{
+  defragment_free_rectangles (map);
+}
+
+/* Space freed by removals since the free space was last merged is
+   only considered rectangle by rectangle, so the caller decides how
+   often to pay for merging it */
+gboolean
+_cogl_rectangle_map_find_compact_position (CoglRectangleMap      *map,
+                                           unsigned int           width,
+                                           unsigned int           height,
+                                           CoglRectangleMapEntry *rectangle)
+{
+  unsigned int best_bottom = G_MAXUINT;
+  unsigned int best_x = G_MAXUINT;
+  gboolean found = FALSE;
+  unsigned int i;
+
+  g_return_val_if_fail (width > 0 && height > 0, FALSE);
+
+  /* Bottom-left rule, packing towards the origin */
+  for (i = 0; i < map->free_rectangles->len; i++)
     {
-      CoglRectangleMapNode *node;
+      CoglRectangleMapEntry *free_rect =
+        &g_array_index (map->free_rectangles, CoglRectangleMapEntry, i);
+      unsigned int bottom;
 
-      /* Split according to whichever axis will leave us with the
-         largest space */
-      if (found_node->rectangle.width - width >
-          found_node->rectangle.height - height)
-        {
-          found_node =
-            _cogl_rectangle_map_node_split_horizontally (found_node, width);
-          found_node =
-            _cogl_rectangle_map_node_split_vertically (found_node, height);
-        }
-      else
-        {
-          found_node =
-            _cogl_rectangle_map_node_split_vertically (found_node, height);
-          found_node =
-            _cogl_rectangle_map_node_split_horizontally (found_node, width);
-        }
+      if (free_rect->width < width || free_rect->height < height)
+        continue;
 
-      found_node->type = COGL_RECTANGLE_MAP_FILLED_LEAF;
-      found_node->d.data = data;
-      found_node->largest_gap = 0;
-      if (rectangle)
-        *rectangle = found_node->rectangle;
+      bottom = free_rect->y + height;
 
-      /* Walk back up the tree and update the stored largest gap for
-         the node's sub tree */
-      for (node = found_node->parent; node; node = node->parent)
+      if (bottom < best_bottom ||
+          (bottom == best_bottom && free_rect->x < best_x))
         {
-          /* This node is a parent so it should always be a branch */
-          g_assert (node->type == COGL_RECTANGLE_MAP_BRANCH);
-
-          node->largest_gap = MAX (node->d.branch.left->largest_gap,
-                                   node->d.branch.right->largest_gap);
+          rectangle->x = free_rect->x;
+          rectangle->y = free_rect->y;
+          best_bottom = bottom;
+          best_x = free_rect->x;
+          found = TRUE;
         }
+    }
 
-      /* There is now an extra rectangle in the map */
-      map->n_rectangles++;
-      /* and less space */
-      map->space_remaining -= rectangle_size;
+  rectangle->width = width;
+  rectangle->height = height;
 
-      return TRUE;
-    }
-  else
-    return FALSE;
+  return found;
 }
 
 void
 _cogl_rectangle_map_remove (CoglRectangleMap *map,
                             const CoglRectangleMapEntry *rectangle)
 {
-  CoglRectangleMapNode *node = map->root;
-  unsigned int rectangle_size = rectangle->width * rectangle->height;
+  unsigned int i;
 
-  /* We can do a binary-chop down the search tree to find the rectangle */
-  while (node->type == COGL_RECTANGLE_MAP_BRANCH)
+  for (i = 0; i < map->rectangles->len; i++)
     {
-      CoglRectangleMapNode *left_node = node->d.branch.left;
-
-      /* If and only if the rectangle is in the left node then the x,y
-         position of the rectangle will be within the node's
-         rectangle */
-      if (rectangle->x < left_node->rectangle.x + left_node->rectangle.width &&
-          rectangle->y < left_node->rectangle.y + left_node->rectangle.height)
-        /* Go left */
-        node = left_node;
-      else
-        /* Go right */
-        node = node->d.branch.right;
-    }
+      CoglRectangleMapRectangle *candidate =
+        &g_array_index (map->rectangles, CoglRectangleMapRectangle, i);
 
-  /* Make sure we found the right node */
-  if (node->type != COGL_RECTANGLE_MAP_FILLED_LEAF ||
-      node->rectangle.x != rectangle->x ||
-      node->rectangle.y != rectangle->y ||
-      node->rectangle.width != rectangle->width ||
-      node->rectangle.height != rectangle->height)
-    /* This should only happen if someone tried to remove a rectangle
-       that was not in the map so something has gone wrong */
-    g_return_if_reached ();
-  else
-    {
-      /* Convert the node back to an empty node */
-      if (map->value_destroy_func)
-        map->value_destroy_func (node->d.data);
-      node->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-      node->largest_gap = rectangle_size;
-
-      /* Walk back up the tree combining branch nodes that have two
-         empty leaves back into a single empty leaf */
-      for (node = node->parent; node; node = node->parent)
+      if (candidate->entry.x == rectangle->x &&
+          candidate->entry.y == rectangle->y &&
+          candidate->entry.width == rectangle->width &&
+          candidate->entry.height == rectangle->height)
         {
-          /* This node is a parent so it should always be a branch */
-          g_assert (node->type == COGL_RECTANGLE_MAP_BRANCH);
-
-          if (node->d.branch.left->type == COGL_RECTANGLE_MAP_EMPTY_LEAF &&
-              node->d.branch.right->type == COGL_RECTANGLE_MAP_EMPTY_LEAF)
-            {
-              _cogl_rectangle_map_node_free (node->d.branch.left);
-              _cogl_rectangle_map_node_free (node->d.branch.right);
-              node->type = COGL_RECTANGLE_MAP_EMPTY_LEAF;
-
-              node->largest_gap = (node->rectangle.width *
-                                   node->rectangle.height);
-            }
-          else
-            break;
-        }
+          CoglRectangleMapEntry freed = candidate->entry;
+
+          if (map->value_destroy_func)
+            map->value_destroy_func (candidate->data);
+
+          g_array_remove_index_fast (map->rectangles, i);
+
+          /* The freed area can't overlap any other free rectangle so
+             it can be added as is. Merging it with its neighbours is
+             left until the free space is defragmented. */
+          g_array_append_val (map->free_rectangles, freed);
+          map->free_rectangles_fragmented = TRUE;
 
-      /* Reduce the amount of space remaining in all of the parents
-         further up the chain */
-      for (; node; node = node->parent)
-        node->largest_gap = MAX (node->d.branch.left->largest_gap,
-                                 node->d.branch.right->largest_gap);
-
-      /* There is now one less rectangle */
-      g_assert (map->n_rectangles > 0);
-      map->n_rectangles--;
-      /* and more space */
-      map->space_remaining += rectangle_size;
+          /* and more space */
+          map->space_remaining += freed.width * freed.height;
+
+          if (map->rectangles->len == 0)
+            reset_free_rectangles (map);
+
+          return;
+        }
     }
+
+  /* This should only happen if someone tried to remove a rectangle
+     that was not in the map so something has gone wrong */
+  g_return_if_reached ();
 }
 
 unsigned int
 _cogl_rectangle_map_get_width (CoglRectangleMap *map)
 {
-  return map->root->rectangle.width;
+  return map->width;
 }
 
 unsigned int
 _cogl_rectangle_map_get_height (CoglRectangleMap *map)
 {
-  return map->root->rectangle.height;
+  return map->height;
 }
 
 unsigned int
@@ -475,84 +493,7 @@ _cogl_rectangle_map_get_remaining_space (CoglRectangleMap *map)
 unsigned int
 _cogl_rectangle_map_get_n_rectangles (CoglRectangleMap *map)
 {
-  return map->n_rectangles;
-}
-
-static void
-_cogl_rectangle_map_internal_foreach (CoglRectangleMap *map,
-                                      CoglRectangleMapInternalForeachCb func,
-                                      void *data)
-{
-  /* Stack of nodes to search in */
-  GArray *stack = map->stack;
-
-  /* Start with the root node */
-  g_array_set_size (stack, 0);
-  _cogl_rectangle_map_stack_push (stack, map->root, 0);
-
-  /* Iterate all nodes depth-first */
-  while (stack->len > 0)
-    {
-      CoglRectangleMapStackEntry *stack_top =
-        _cogl_rectangle_map_stack_get_top (stack);
-      CoglRectangleMapNode *node = stack_top->node;
-
-      switch (node->type)
-        {
-        case COGL_RECTANGLE_MAP_BRANCH:
-          if (stack_top->next_index == 0)
-            {
-              /* Next time we come back to this node, go to the right */
-              stack_top->next_index = 1;
-
-              /* Explore the left branch next */
-              _cogl_rectangle_map_stack_push (stack,
-                                              node->d.branch.left,
-                                              0);
-            }
-          else if (stack_top->next_index == 1)
-            {
-              /* Next time we come back to this node, stop processing it */
-              stack_top->next_index = 2;
-
-              /* Explore the right branch next */
-              _cogl_rectangle_map_stack_push (stack,
-                                              node->d.branch.right,
-                                              0);
-            }
-          else
-            {
-              /* We're finished with this node so we can call the callback */
-              func (node, data);
-              _cogl_rectangle_map_stack_pop (stack);
-            }
-          break;
-
-        default:
-          /* Some sort of leaf node, just call the callback */
-          func (node, data);
-          _cogl_rectangle_map_stack_pop (stack);
-          break;
-        }
-    }
-
-  /* The stack should now be empty */
-  g_assert (stack->len == 0);
-}
-
-typedef struct _CoglRectangleMapForeachClosure
-{
-  CoglRectangleMapCallback callback;
-  void *data;
-} CoglRectangleMapForeachClosure;
-
-static void
-_cogl_rectangle_map_foreach_cb (CoglRectangleMapNode *node, void *data)
-{
-  CoglRectangleMapForeachClosure *closure = data;
-
-  if (node->type == COGL_RECTANGLE_MAP_FILLED_LEAF)
-    closure->callback (&node->rectangle, node->d.data, closure->data);
+  return map->rectangles->len;
 }
 
 void
@@ -560,35 +501,35 @@ _cogl_rectangle_map_foreach (CoglRectangleMap *map,
                              CoglRectangleMapCallback callback,
                              void *data)
 {
-  CoglRectangleMapForeachClosure closure;
-
-  closure.callback = callback;
-  closure.data = data;
-
-  _cogl_rectangle_map_internal_foreach (map,
-                                        _cogl_rectangle_map_foreach_cb,
-                                        &closure);
-}
-
-static void
-_cogl_rectangle_map_free_cb (CoglRectangleMapNode *node, void *data)
-{
-  CoglRectangleMap *map = data;
+  unsigned int i;
 
-  if (node->type == COGL_RECTANGLE_MAP_FILLED_LEAF && map->value_destroy_func)
-    map->value_destroy_func (node->d.data);
+  for (i = 0; i < map->rectangles->len; i++)
+    {
+      CoglRectangleMapRectangle *rectangle =
+        &g_array_index (map->rectangles, CoglRectangleMapRectangle, i);
 
-  _cogl_rectangle_map_node_free (node);
+      callback (&rectangle->entry, rectangle->data, data);
+    }
 }
 
 void
 _cogl_rectangle_map_free (CoglRectangleMap *map)
 {
-  _cogl_rectangle_map_internal_foreach (map,
-                                        _cogl_rectangle_map_free_cb,
-                                        map);
+  unsigned int i;
+
+  if (map->value_destroy_func)
+    {
+      for (i = 0; i < map->rectangles->len; i++)
+        {
+          CoglRectangleMapRectangle *rectangle =
+            &g_array_index (map->rectangles, CoglRectangleMapRectangle, i);
+
+          map->value_destroy_func (rectangle->data);
+        }
+    }
 
-  g_array_free (map->stack, TRUE);
+  g_array_free (map->rectangles, TRUE);
+  g_array_free (map->free_rectangles, TRUE);
 
   g_free (map);
 }
@@ -45,19 +45,33 @@ struct _CoglRectangleMapEntry
   unsigned int width, height;
 };
 
-CoglRectangleMap *
+COGL_EXPORT_TEST CoglRectangleMap *
 _cogl_rectangle_map_new (unsigned int width,
                          unsigned int height,
                          GDestroyNotify value_destroy_func);
 
-gboolean
+COGL_EXPORT_TEST gboolean
 _cogl_rectangle_map_add (CoglRectangleMap *map,
                          unsigned int width,
                          unsigned int height,
                          void *data,
                          CoglRectangleMapEntry *rectangle);
 
-void
+COGL_EXPORT_TEST gboolean
+_cogl_rectangle_map_add_at (CoglRectangleMap *map,
+                            const CoglRectangleMapEntry *rectangle,
+                            void *data);
+
+COGL_EXPORT_TEST void
+_cogl_rectangle_map_merge_free_space (CoglRectangleMap *map);
+
+COGL_EXPORT_TEST gboolean
+_cogl_rectangle_map_find_compact_position (CoglRectangleMap *map,
+                                           unsigned int width,
+                                           unsigned int height,
+                                           CoglRectangleMapEntry *rectangle);
+
+COGL_EXPORT_TEST void
 _cogl_rectangle_map_remove (CoglRectangleMap *map,
                             const CoglRectangleMapEntry *rectangle);
 
@@ -67,18 +81,18 @@ _cogl_rectangle_map_get_width (CoglRectangleMap *map);
 unsigned int
 _cogl_rectangle_map_get_height (CoglRectangleMap *map);
 
-unsigned int
+COGL_EXPORT_TEST unsigned int
 _cogl_rectangle_map_get_remaining_space (CoglRectangleMap *map);
 
-unsigned int
+COGL_EXPORT_TEST unsigned int
 _cogl_rectangle_map_get_n_rectangles (CoglRectangleMap *map);
 
-void
+COGL_EXPORT_TEST void
 _cogl_rectangle_map_foreach (CoglRectangleMap *map,
                              CoglRectangleMapCallback callback,
                              void *data);
 
-void
+COGL_EXPORT_TEST void
 _cogl_rectangle_map_free (CoglRectangleMap *map);
 
 #endif /* __COGL_RECTANGLE_MAP_H */
@@ -65,6 +65,8 @@ toggle_custom_attribute_enabled_cb (int bit_num, void *user_data)
   else
     GE( context, glDisableVertexAttribArray (bit_num) );
 
+  COGL_GL_STATE_ISSUED (context, ATTRIBUTES);
+
   return TRUE;
 }
 
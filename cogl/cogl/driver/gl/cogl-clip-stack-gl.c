@@ -42,6 +42,69 @@
 #include "driver/gl/cogl-pipeline-opengl-private.h"
 #include "driver/gl/cogl-clip-stack-gl-private.h"
 
+static void
+set_stencil_test_enabled (CoglContext *ctx,
+                          gboolean     enabled)
+{
+  if (ctx->gl_stencil_test_enabled_cache == enabled)
+    {
+      COGL_GL_STATE_SKIPPED (ctx, STENCIL);
+      return;
+    }
+
+  if (enabled)
+    GE (ctx, glEnable (GL_STENCIL_TEST));
+  else
+    GE (ctx, glDisable (GL_STENCIL_TEST));
+
+  ctx->gl_stencil_test_enabled_cache = enabled;
+  COGL_GL_STATE_ISSUED (ctx, STENCIL);
+}
+
+static void
+set_scissor_test_enabled (CoglContext *ctx,
+                          gboolean     enabled)
+{
+  if (ctx->gl_scissor_test_enabled_cache == enabled)
+    {
+      COGL_GL_STATE_SKIPPED (ctx, SCISSOR);
+      return;
+    }
+
+  if (enabled)
+    GE (ctx, glEnable (GL_SCISSOR_TEST));
+  else
+    GE (ctx, glDisable (GL_SCISSOR_TEST));
+
+  ctx->gl_scissor_test_enabled_cache = enabled;
+  COGL_GL_STATE_ISSUED (ctx, SCISSOR);
+}
+
+static void
+set_scissor (CoglContext *ctx,
+             int          x,
+             int          y,
+             int          width,
+             int          height)
+{
+  if (ctx->gl_scissor_cache[0] == x &&
+      ctx->gl_scissor_cache[1] == y &&
+      ctx->gl_scissor_cache[2] == width &&
+      ctx->gl_scissor_cache[3] == height)
+    {
+      COGL_GL_STATE_SKIPPED (ctx, SCISSOR);
+      return;
+    }
+
+  GE (ctx, glScissor (x, y, width, height));
+
+  ctx->gl_scissor_cache[0] = x;
+  ctx->gl_scissor_cache[1] = y;
+  ctx->gl_scissor_cache[2] = width;
+  ctx->gl_scissor_cache[3] = height;
+  COGL_GL_STATE_ISSUED (ctx, SCISSOR);
+}
+
 static void
 add_stencil_clip_rectangle (CoglFramebuffer *framebuffer,
                             CoglMatrixEntry *modelview_entry,
@@ -93,7 +156,7 @@ add_stencil_clip_rectangle (CoglFramebuffer *framebuffer,
     }
   else
     {
-      GE( ctx, glEnable (GL_STENCIL_TEST) );
+      set_stencil_test_enabled (ctx, TRUE);
 
       /* Initially disallow everything */
       GE( ctx, glClearStencil (0) );
@@ -167,7 +230,7 @@ add_stencil_clip_region (CoglFramebuffer *framebuffer,
     }
   else
     {
-      GE( ctx, glEnable (GL_STENCIL_TEST) );
+      set_stencil_test_enabled (ctx, TRUE);
 
       /* Initially disallow everything */
       GE( ctx, glClearStencil (0) );
@@ -278,7 +341,7 @@ add_stencil_clip_silhouette (CoglFramebuffer *framebuffer,
   _cogl_pipeline_flush_gl_state (ctx, ctx->stencil_pipeline,
                                  framebuffer, FALSE, FALSE);
 
-  GE( ctx, glEnable (GL_STENCIL_TEST) );
+  set_stencil_test_enabled (ctx, TRUE);
 
   GE( ctx, glColorMask (FALSE, FALSE, FALSE, FALSE) );
   GE( ctx, glDepthMask (FALSE) );
@@ -413,7 +476,7 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
   ctx->current_clip_stack_valid = TRUE;
   ctx->current_clip_stack = _cogl_clip_stack_ref (stack);
 
-  GE( ctx, glDisable (GL_STENCIL_TEST) );
+  set_stencil_test_enabled (ctx, FALSE);
 
   /* If the stack is empty then there's nothing else to do
    */
@@ -421,7 +484,7 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
     {
       COGL_NOTE (CLIPPING, "Flushed empty clip stack");
 
-      GE (ctx, glDisable (GL_SCISSOR_TEST));
+      set_scissor_test_enabled (ctx, FALSE);
       return;
     }
 
@@ -463,10 +526,11 @@ _cogl_clip_stack_gl_flush (CoglClipStack *stack,
              scissor_x0, scissor_y0,
              scissor_x1, scissor_y1);
 
-  GE (ctx, glEnable (GL_SCISSOR_TEST));
-  GE (ctx, glScissor (scissor_x0, scissor_y_start,
-                      scissor_x1 - scissor_x0,
-                      scissor_y1 - scissor_y0));
+  set_scissor_test_enabled (ctx, TRUE);
+  set_scissor (ctx,
+               scissor_x0, scissor_y_start,
+               scissor_x1 - scissor_x0,
+               scissor_y1 - scissor_y0);
 
   /* Add all of the entries. This will end up adding them in the
      reverse order that they were specified but as all of the clips
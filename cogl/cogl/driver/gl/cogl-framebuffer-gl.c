@@ -62,6 +62,7 @@ cogl_gl_framebuffer_flush_viewport_state (CoglGlFramebuffer *gl_framebuffer)
   CoglFramebufferDriver *driver = COGL_FRAMEBUFFER_DRIVER (gl_framebuffer);
   CoglFramebuffer *framebuffer =
     cogl_framebuffer_driver_get_framebuffer (driver);
+  CoglContext *ctx = cogl_framebuffer_get_context (framebuffer);
   float viewport_x, viewport_y, viewport_width, viewport_height;
   float gl_viewport_y;
 
@@ -85,17 +86,32 @@ cogl_gl_framebuffer_flush_viewport_state (CoglGlFramebuffer *gl_framebuffer)
       cogl_framebuffer_get_height (framebuffer) -
       (viewport_y + viewport_height);
 
+  if (ctx->gl_viewport_cache[0] == viewport_x &&
+      ctx->gl_viewport_cache[1] == gl_viewport_y &&
+      ctx->gl_viewport_cache[2] == viewport_width &&
+      ctx->gl_viewport_cache[3] == viewport_height)
+    {
+      COGL_GL_STATE_SKIPPED (ctx, VIEWPORT);
+      return;
+    }
+
   COGL_NOTE (OPENGL, "Calling glViewport(%f, %f, %f, %f)",
              viewport_x,
              gl_viewport_y,
              viewport_width,
              viewport_height);
 
-  GE (cogl_framebuffer_get_context (framebuffer),
+  GE (ctx,
       glViewport (viewport_x,
                   gl_viewport_y,
                   viewport_width,
                   viewport_height));
+
+  ctx->gl_viewport_cache[0] = viewport_x;
+  ctx->gl_viewport_cache[1] = gl_viewport_y;
+  ctx->gl_viewport_cache[2] = viewport_width;
+  ctx->gl_viewport_cache[3] = viewport_height;
+  COGL_GL_STATE_ISSUED (ctx, VIEWPORT);
 }
 
 static void
@@ -328,12 +344,13 @@ cogl_gl_framebuffer_draw_attributes (CoglFramebufferDriver  *driver,
 {
   CoglFramebuffer *framebuffer =
     cogl_framebuffer_driver_get_framebuffer (driver);
+  CoglContext *ctx = cogl_framebuffer_get_context (framebuffer);
 
   _cogl_flush_attributes_state (framebuffer, pipeline, flags,
                                 attributes, n_attributes);
 
-  GE (cogl_framebuffer_get_context (framebuffer),
-      glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
+  GE (ctx, glDrawArrays ((GLenum)mode, first_vertex, n_vertices));
+  ctx->gl_state_counters.n_draws++;
 }
 
 static size_t
@@ -364,6 +381,7 @@ cogl_gl_framebuffer_draw_indexed_attributes (CoglFramebufferDriver  *driver,
 {
   CoglFramebuffer *framebuffer =
     cogl_framebuffer_driver_get_framebuffer (driver);
+  CoglContext *ctx = cogl_framebuffer_get_context (framebuffer);
   CoglBuffer *buffer;
   uint8_t *base;
   size_t buffer_offset;
@@ -398,11 +416,11 @@ cogl_gl_framebuffer_draw_indexed_attributes (CoglFramebufferDriver  *driver,
       break;
     }
 
-  GE (cogl_framebuffer_get_context (framebuffer),
-      glDrawElements ((GLenum)mode,
-                      n_vertices,
-                      indices_gl_type,
-                      base + buffer_offset + index_size * first_vertex));
+  GE (ctx, glDrawElements ((GLenum)mode,
+                           n_vertices,
+                           indices_gl_type,
+                           base + buffer_offset + index_size * first_vertex));
+  ctx->gl_state_counters.n_draws++;
 
   _cogl_buffer_gl_unbind (buffer);
 }
@@ -491,6 +509,15 @@ cogl_gl_framebuffer_read_pixels_into_bitmap (CoglFramebufferDriver  *driver,
       uint8_t *tmp_data;
       gboolean succeeded;
 
+      if (source & COGL_READ_PIXELS_NO_CONVERSION)
+        {
+          g_set_error_literal (error, COGL_SYSTEM_ERROR,
+                               COGL_SYSTEM_ERROR_UNSUPPORTED,
+                               "Reading pixels requires an intermediate "
+                               "conversion");
+          goto EXIT;
+        }
+
       if (is_read_pixels_format_supported)
         {
           read_format = required_format;
@@ -616,38 +643,8 @@ cogl_gl_framebuffer_read_pixels_into_bitmap (CoglFramebufferDriver  *driver,
       (source & COGL_READ_PIXELS_NO_FLIP) == 0 &&
       !pack_invert_set)
     {
-      uint8_t *temprow;
-      int rowstride;
-      uint8_t *pixels;
-
-      rowstride = cogl_bitmap_get_rowstride (bitmap);
-      pixels = _cogl_bitmap_map (bitmap,
-                                 COGL_BUFFER_ACCESS_READ |
-                                 COGL_BUFFER_ACCESS_WRITE,
-                                 0, /* hints */
-                                 error);
-
-      if (pixels == NULL)
+      if (!_cogl_bitmap_flip_vertically (bitmap, error))
         goto EXIT;
-
-      temprow = g_alloca (rowstride * sizeof (uint8_t));
-
-      /* vertically flip the buffer in-place */
-      for (y = 0; y < height / 2; y++)
-        {
-          if (y != height - y - 1) /* skip center row */
-            {
-              memcpy (temprow,
-                      pixels + y * rowstride, rowstride);
-              memcpy (pixels + y * rowstride,
-                      pixels + (height - y - 1) * rowstride, rowstride);
-              memcpy (pixels + (height - y - 1) * rowstride,
-                      temprow,
-                      rowstride);
-            }
-        }
-
-      _cogl_bitmap_unmap (bitmap);
     }
 
   status = TRUE;
@@ -84,6 +84,10 @@ typedef struct _CoglTextureUnit
    */
   gboolean           dirty_gl_texture;
 
+  /* The sampler object last bound to this unit with glBindSampler, or
+   * 0 if none has been bound yet */
+  GLuint             gl_sampler;
+
   /* A matrix stack giving us the means to associate a texture
    * transform matrix with the texture unit. */
   CoglMatrixStack   *matrix_stack;
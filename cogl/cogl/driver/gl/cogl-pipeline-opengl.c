@@ -73,6 +73,7 @@ texture_unit_init (CoglContext *ctx,
   unit->gl_texture = 0;
   unit->gl_target = 0;
   unit->dirty_gl_texture = FALSE;
+  unit->gl_sampler = 0;
   unit->matrix_stack = cogl_matrix_stack_new (ctx);
 
   unit->layer = NULL;
@@ -137,6 +138,11 @@ _cogl_set_active_texture_unit (int unit_index)
     {
       GE (ctx, glActiveTexture (GL_TEXTURE0 + unit_index));
       glctx->active_texture_unit = unit_index;
+      COGL_GL_STATE_ISSUED (ctx, TEXTURE);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, TEXTURE);
     }
 }
 
@@ -179,9 +185,13 @@ _cogl_bind_gl_texture_transient (GLenum gl_target,
   unit = _cogl_get_texture_unit (1);
 
   if (unit->gl_texture == gl_texture && !unit->dirty_gl_texture)
-    return;
+    {
+      COGL_GL_STATE_SKIPPED (ctx, TEXTURE);
+      return;
+    }
 
   GE (ctx, glBindTexture (gl_target, gl_texture));
+  COGL_GL_STATE_ISSUED (ctx, TEXTURE);
 
   unit->dirty_gl_texture = TRUE;
 }
@@ -273,6 +283,11 @@ flush_depth_state (CoglContext *ctx,
       else
         GE (ctx, glDisable (GL_DEPTH_TEST));
       ctx->depth_test_enabled_cache = depth_state->test_enabled;
+      COGL_GL_STATE_ISSUED (ctx, DEPTH);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, DEPTH);
     }
 
   if (ctx->depth_test_function_cache != depth_state->test_function &&
@@ -280,6 +295,7 @@ flush_depth_state (CoglContext *ctx,
     {
       GE (ctx, glDepthFunc (depth_state->test_function));
       ctx->depth_test_function_cache = depth_state->test_function;
+      COGL_GL_STATE_ISSUED (ctx, DEPTH);
     }
 
   if (ctx->depth_writing_enabled_cache != depth_writing_enabled)
@@ -287,6 +303,11 @@ flush_depth_state (CoglContext *ctx,
       GE (ctx, glDepthMask (depth_writing_enabled ?
                             GL_TRUE : GL_FALSE));
       ctx->depth_writing_enabled_cache = depth_writing_enabled;
+      COGL_GL_STATE_ISSUED (ctx, DEPTH);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, DEPTH);
     }
 
   if ((ctx->depth_range_near_cache != depth_state->range_near ||
@@ -301,6 +322,193 @@ flush_depth_state (CoglContext *ctx,
 
       ctx->depth_range_near_cache = depth_state->range_near;
       ctx->depth_range_far_cache = depth_state->range_far;
+      COGL_GL_STATE_ISSUED (ctx, DEPTH);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, DEPTH);
+    }
+}
+
+#if defined(HAVE_COGL_GLES2) || defined(HAVE_COGL_GL)
+
+static void
+flush_blend_state (CoglContext            *ctx,
+                   CoglPipelineBlendState *blend_state)
+{
+  if (blend_factor_uses_constant (blend_state->blend_src_factor_rgb) ||
+      blend_factor_uses_constant (blend_state->blend_src_factor_alpha) ||
+      blend_factor_uses_constant (blend_state->blend_dst_factor_rgb) ||
+      blend_factor_uses_constant (blend_state->blend_dst_factor_alpha))
+    {
+      float red =
+        cogl_color_get_red_float (&blend_state->blend_constant);
+      float green =
+        cogl_color_get_green_float (&blend_state->blend_constant);
+      float blue =
+        cogl_color_get_blue_float (&blend_state->blend_constant);
+      float alpha =
+        cogl_color_get_alpha_float (&blend_state->blend_constant);
+
+      if (!ctx->gl_blend_color_cache_valid ||
+          ctx->gl_blend_color_cache[0] != red ||
+          ctx->gl_blend_color_cache[1] != green ||
+          ctx->gl_blend_color_cache[2] != blue ||
+          ctx->gl_blend_color_cache[3] != alpha)
+        {
+          GE (ctx, glBlendColor (red, green, blue, alpha));
+          ctx->gl_blend_color_cache[0] = red;
+          ctx->gl_blend_color_cache[1] = green;
+          ctx->gl_blend_color_cache[2] = blue;
+          ctx->gl_blend_color_cache[3] = alpha;
+          ctx->gl_blend_color_cache_valid = TRUE;
+          COGL_GL_STATE_ISSUED (ctx, BLEND);
+        }
+      else
+        {
+          COGL_GL_STATE_SKIPPED (ctx, BLEND);
+        }
+    }
+
+  if (!ctx->gl_blend_state_cache_valid ||
+      ctx->gl_blend_equation_rgb_cache != blend_state->blend_equation_rgb ||
+      ctx->gl_blend_equation_alpha_cache != blend_state->blend_equation_alpha)
+    {
+      GE (ctx, glBlendEquationSeparate (blend_state->blend_equation_rgb,
+                                        blend_state->blend_equation_alpha));
+      ctx->gl_blend_equation_rgb_cache = blend_state->blend_equation_rgb;
+      ctx->gl_blend_equation_alpha_cache = blend_state->blend_equation_alpha;
+      COGL_GL_STATE_ISSUED (ctx, BLEND);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, BLEND);
+    }
+
+  if (!ctx->gl_blend_state_cache_valid ||
+      ctx->gl_blend_src_factor_rgb_cache != blend_state->blend_src_factor_rgb ||
+      ctx->gl_blend_dst_factor_rgb_cache != blend_state->blend_dst_factor_rgb ||
+      ctx->gl_blend_src_factor_alpha_cache !=
+      blend_state->blend_src_factor_alpha ||
+      ctx->gl_blend_dst_factor_alpha_cache !=
+      blend_state->blend_dst_factor_alpha)
+    {
+      GE (ctx, glBlendFuncSeparate (blend_state->blend_src_factor_rgb,
+                                    blend_state->blend_dst_factor_rgb,
+                                    blend_state->blend_src_factor_alpha,
+                                    blend_state->blend_dst_factor_alpha));
+      ctx->gl_blend_src_factor_rgb_cache = blend_state->blend_src_factor_rgb;
+      ctx->gl_blend_dst_factor_rgb_cache = blend_state->blend_dst_factor_rgb;
+      ctx->gl_blend_src_factor_alpha_cache =
+        blend_state->blend_src_factor_alpha;
+      ctx->gl_blend_dst_factor_alpha_cache =
+        blend_state->blend_dst_factor_alpha;
+      COGL_GL_STATE_ISSUED (ctx, BLEND);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, BLEND);
+    }
+
+  ctx->gl_blend_state_cache_valid = TRUE;
+}
+
+#endif
+
+static void
+flush_cull_face_state (CoglContext               *ctx,
+                       CoglPipelineCullFaceState *cull_face_state)
+{
+  gboolean enabled;
+  GLenum mode = GL_BACK;
+  GLenum front_face = GL_CCW;
+
+  enabled = cull_face_state->mode != COGL_PIPELINE_CULL_FACE_MODE_NONE;
+
+  if (!ctx->gl_cull_face_cache_valid ||
+      ctx->gl_cull_face_enabled_cache != enabled)
+    {
+      if (enabled)
+        GE( ctx, glEnable (GL_CULL_FACE) );
+      else
+        GE( ctx, glDisable (GL_CULL_FACE) );
+      ctx->gl_cull_face_enabled_cache = enabled;
+      COGL_GL_STATE_ISSUED (ctx, CULL_FACE);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, CULL_FACE);
+    }
+
+  if (enabled)
+    {
+      gboolean invert_winding;
+
+      switch (cull_face_state->mode)
+        {
+        case COGL_PIPELINE_CULL_FACE_MODE_NONE:
+          g_assert_not_reached ();
+
+        case COGL_PIPELINE_CULL_FACE_MODE_FRONT:
+          mode = GL_FRONT;
+          break;
+
+        case COGL_PIPELINE_CULL_FACE_MODE_BACK:
+          mode = GL_BACK;
+          break;
+
+        case COGL_PIPELINE_CULL_FACE_MODE_BOTH:
+          mode = GL_FRONT_AND_BACK;
+          break;
+        }
+
+      invert_winding =
+        cogl_framebuffer_is_y_flipped (ctx->current_draw_buffer);
+
+      switch (cull_face_state->front_winding)
+        {
+        case COGL_WINDING_CLOCKWISE:
+          front_face = invert_winding ? GL_CCW : GL_CW;
+          break;
+
+        case COGL_WINDING_COUNTER_CLOCKWISE:
+          front_face = invert_winding ? GL_CW : GL_CCW;
+          break;
+        }
+
+      if (!ctx->gl_cull_face_cache_valid ||
+          ctx->gl_cull_face_mode_cache != mode)
+        {
+          GE( ctx, glCullFace (mode) );
+          ctx->gl_cull_face_mode_cache = mode;
+          COGL_GL_STATE_ISSUED (ctx, CULL_FACE);
+        }
+      else
+        {
+          COGL_GL_STATE_SKIPPED (ctx, CULL_FACE);
+        }
+
+      if (!ctx->gl_cull_face_cache_valid ||
+          ctx->gl_front_face_cache != front_face)
+        {
+          GE( ctx, glFrontFace (front_face) );
+          ctx->gl_front_face_cache = front_face;
+          COGL_GL_STATE_ISSUED (ctx, CULL_FACE);
+        }
+      else
+        {
+          COGL_GL_STATE_SKIPPED (ctx, CULL_FACE);
+        }
+
+      ctx->gl_cull_face_cache_valid = TRUE;
+    }
+  else if (!ctx->gl_cull_face_cache_valid)
+    {
+      /* The mode and winding haven't been sent to GL yet so only the
+       * enabled state is known */
+      ctx->gl_cull_face_mode_cache = 0;
+      ctx->gl_front_face_cache = 0;
+      ctx->gl_cull_face_cache_valid = TRUE;
     }
 }
 
@@ -312,6 +520,7 @@ _cogl_pipeline_flush_color_blend_alpha_depth_state (
 {
   _COGL_GET_CONTEXT (ctx, NO_RETVAL);
 
+#if defined(HAVE_COGL_GLES2) || defined(HAVE_COGL_GL)
   if (pipelines_difference & COGL_PIPELINE_STATE_BLEND)
     {
       CoglPipeline *authority =
@@ -319,33 +528,7 @@ _cogl_pipeline_flush_color_blend_alpha_depth_state (
       CoglPipelineBlendState *blend_state =
         &authority->big_state->blend_state;
 
-#if defined(HAVE_COGL_GLES2) || defined(HAVE_COGL_GL)
-      if (blend_factor_uses_constant (blend_state->blend_src_factor_rgb) ||
-          blend_factor_uses_constant (blend_state
-                                      ->blend_src_factor_alpha) ||
-          blend_factor_uses_constant (blend_state->blend_dst_factor_rgb) ||
-          blend_factor_uses_constant (blend_state->blend_dst_factor_alpha))
-        {
-          float red =
-            cogl_color_get_red_float (&blend_state->blend_constant);
-          float green =
-            cogl_color_get_green_float (&blend_state->blend_constant);
-          float blue =
-            cogl_color_get_blue_float (&blend_state->blend_constant);
-          float alpha =
-            cogl_color_get_alpha_float (&blend_state->blend_constant);
-
-
-          GE (ctx, glBlendColor (red, green, blue, alpha));
-        }
-
-      GE (ctx, glBlendEquationSeparate (blend_state->blend_equation_rgb,
-                                        blend_state->blend_equation_alpha));
-
-      GE (ctx, glBlendFuncSeparate (blend_state->blend_src_factor_rgb,
-                                    blend_state->blend_dst_factor_rgb,
-                                    blend_state->blend_src_factor_alpha,
-                                    blend_state->blend_dst_factor_alpha));
+      flush_blend_state (ctx, blend_state);
     }
 #endif
 
@@ -365,46 +548,7 @@ _cogl_pipeline_flush_color_blend_alpha_depth_state (
       CoglPipelineCullFaceState *cull_face_state
         = &authority->big_state->cull_face_state;
 
-      if (cull_face_state->mode == COGL_PIPELINE_CULL_FACE_MODE_NONE)
-        GE( ctx, glDisable (GL_CULL_FACE) );
-      else
-        {
-          gboolean invert_winding;
-
-          GE( ctx, glEnable (GL_CULL_FACE) );
-
-          switch (cull_face_state->mode)
-            {
-            case COGL_PIPELINE_CULL_FACE_MODE_NONE:
-              g_assert_not_reached ();
-
-            case COGL_PIPELINE_CULL_FACE_MODE_FRONT:
-              GE( ctx, glCullFace (GL_FRONT) );
-              break;
-
-            case COGL_PIPELINE_CULL_FACE_MODE_BACK:
-              GE( ctx, glCullFace (GL_BACK) );
-              break;
-
-            case COGL_PIPELINE_CULL_FACE_MODE_BOTH:
-              GE( ctx, glCullFace (GL_FRONT_AND_BACK) );
-              break;
-            }
-
-          invert_winding =
-            cogl_framebuffer_is_y_flipped (ctx->current_draw_buffer);
-
-          switch (cull_face_state->front_winding)
-            {
-            case COGL_WINDING_CLOCKWISE:
-              GE( ctx, glFrontFace (invert_winding ? GL_CCW : GL_CW) );
-              break;
-
-            case COGL_WINDING_COUNTER_CLOCKWISE:
-              GE( ctx, glFrontFace (invert_winding ? GL_CW : GL_CCW) );
-              break;
-            }
-        }
+      flush_cull_face_state (ctx, cull_face_state);
     }
 
   if (pipeline->real_blend_enable != ctx->gl_blend_enable_cache)
@@ -416,6 +560,11 @@ _cogl_pipeline_flush_color_blend_alpha_depth_state (
       /* XXX: we shouldn't update any other blend state if blending
        * is disabled! */
       ctx->gl_blend_enable_cache = pipeline->real_blend_enable;
+      COGL_GL_STATE_ISSUED (ctx, BLEND);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, BLEND);
     }
 }
 
@@ -547,10 +696,17 @@ flush_layers_common_gl_state_cb (CoglPipelineLayer *layer, void *user_data)
           if (unit_index == 1)
             unit->dirty_gl_texture = TRUE;
           else
-            GE (ctx, glBindTexture (gl_target, gl_texture));
+            {
+              GE (ctx, glBindTexture (gl_target, gl_texture));
+              COGL_GL_STATE_ISSUED (ctx, TEXTURE);
+            }
           unit->gl_texture = gl_texture;
           unit->gl_target = gl_target;
         }
+      else
+        {
+          COGL_GL_STATE_SKIPPED (ctx, TEXTURE);
+        }
 
       /* The texture_storage_changed boolean indicates if the
        * CoglTexture's underlying GL texture storage has changed since
@@ -566,7 +722,16 @@ flush_layers_common_gl_state_cb (CoglPipelineLayer *layer, void *user_data)
 
       sampler_state = _cogl_pipeline_layer_get_sampler_state (layer);
 
-      GE( ctx, glBindSampler (unit_index, sampler_state->sampler_object) );
+      if (unit->gl_sampler != sampler_state->sampler_object)
+        {
+          GE( ctx, glBindSampler (unit_index, sampler_state->sampler_object) );
+          unit->gl_sampler = sampler_state->sampler_object;
+          COGL_GL_STATE_ISSUED (ctx, SAMPLER);
+        }
+      else
+        {
+          COGL_GL_STATE_SKIPPED (ctx, SAMPLER);
+        }
     }
 
   cogl_object_ref (layer);
@@ -1154,6 +1319,7 @@ done:
       _cogl_set_active_texture_unit (1);
       GE (ctx, glBindTexture (unit1->gl_target, unit1->gl_texture));
       unit1->dirty_gl_texture = FALSE;
+      COGL_GL_STATE_ISSUED (ctx, TEXTURE);
     }
 
   COGL_TIMER_STOP (_cogl_uprof_context, pipeline_flush_timer);
@@ -839,6 +839,11 @@ _cogl_pipeline_progend_glsl_end (CoglPipeline *pipeline,
           GE( ctx, glUseProgram (0) );
           ctx->current_gl_program = 0;
         }
+      COGL_GL_STATE_ISSUED (ctx, PROGRAM);
+    }
+  else
+    {
+      COGL_GL_STATE_SKIPPED (ctx, PROGRAM);
     }
 
   state.unit = 0;
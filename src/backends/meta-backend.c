@@ -531,11 +531,16 @@ meta_backend_real_post_init (MetaBackend *backend)
   ClutterSeat *seat = priv->default_seat;
   MetaInputSettings *input_settings;
 
+  COGL_TRACE_BEGIN (MetaBackendCreateStage, "Backend: Create stage");
   priv->stage = meta_stage_new (backend);
   clutter_actor_realize (priv->stage);
   META_BACKEND_GET_CLASS (backend)->select_stage_events (backend);
+  COGL_TRACE_END (MetaBackendCreateStage);
 
+  COGL_TRACE_BEGIN (MetaBackendSetupMonitorManager,
+                    "Backend: Setup monitor manager");
   meta_monitor_manager_setup (priv->monitor_manager);
+  COGL_TRACE_END (MetaBackendSetupMonitorManager);
 
   meta_backend_sync_screen_size (backend);
 
@@ -570,6 +575,8 @@ meta_backend_real_post_init (MetaBackend *backend)
     g_object_new (META_TYPE_DBUS_SESSION_WATCHER, NULL);
 
 #ifdef HAVE_REMOTE_DESKTOP
+  COGL_TRACE_BEGIN (MetaBackendInitRemoteAccess,
+                    "Backend: Init screen cast and remote desktop");
   priv->screen_cast = meta_screen_cast_new (backend);
   meta_remote_access_controller_add (
     priv->remote_access_controller,
@@ -578,6 +585,7 @@ meta_backend_real_post_init (MetaBackend *backend)
   meta_remote_access_controller_add (
     priv->remote_access_controller,
     META_DBUS_SESSION_MANAGER (priv->remote_desktop));
+  COGL_TRACE_END (MetaBackendInitRemoteAccess);
 #endif /* HAVE_REMOTE_DESKTOP */
 
   if (!meta_monitor_manager_is_headless (priv->monitor_manager))
@@ -1203,15 +1211,22 @@ meta_backend_initable_init (GInitable     *initable,
   MetaBackend *backend = META_BACKEND (initable);
   MetaBackendPrivate *priv = meta_backend_get_instance_private (backend);
 
+  COGL_TRACE_BEGIN_SCOPED (MetaBackendInit, "Backend: Init");
+
   priv->orientation_manager = g_object_new (META_TYPE_ORIENTATION_MANAGER, NULL);
 
+  COGL_TRACE_BEGIN (MetaBackendInitMonitorManager,
+                    "Backend: Create monitor manager");
   priv->monitor_manager = meta_backend_create_monitor_manager (backend, error);
+  COGL_TRACE_END (MetaBackendInitMonitorManager);
   if (!priv->monitor_manager)
     return FALSE;
 
   priv->color_manager = meta_backend_create_color_manager (backend);
 
+  COGL_TRACE_BEGIN (MetaBackendInitRenderer, "Backend: Create renderer");
   priv->renderer = meta_backend_create_renderer (backend, error);
+  COGL_TRACE_END (MetaBackendInitRenderer);
   if (!priv->renderer)
     return FALSE;
 
@@ -1226,10 +1241,17 @@ meta_backend_initable_init (GInitable     *initable,
              system_bus_gotten_cb,
              backend);
 
+  COGL_TRACE_BEGIN (MetaBackendInitClutter, "Backend: Init Clutter");
   if (!init_clutter (backend, error))
-    return FALSE;
+    {
+      COGL_TRACE_END (MetaBackendInitClutter);
+      return FALSE;
+    }
+  COGL_TRACE_END (MetaBackendInitClutter);
 
+  COGL_TRACE_BEGIN (MetaBackendPostInit, "Backend: Post init");
   meta_backend_post_init (backend);
+  COGL_TRACE_END (MetaBackendPostInit);
 
   while (TRUE)
     {
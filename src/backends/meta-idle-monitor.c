@@ -57,6 +57,7 @@ struct _MetaIdleMonitor
 
   MetaIdleManager *idle_manager;
   GDBusProxy *session_proxy;
+  GCancellable *cancellable;
   gboolean inhibited;
   GHashTable *watches;
   ClutterInputDevice *device;
@@ -94,6 +95,8 @@ meta_idle_monitor_dispose (GObject *object)
 {
   MetaIdleMonitor *monitor = META_IDLE_MONITOR (object);
 
+  g_cancellable_cancel (monitor->cancellable);
+  g_clear_object (&monitor->cancellable);
   g_clear_pointer (&monitor->watches, g_hash_table_destroy);
   g_clear_object (&monitor->session_proxy);
 
@@ -242,26 +245,26 @@ meta_idle_monitor_inhibited_actions_changed (GDBusProxy  *session,
 }
 
 static void
-meta_idle_monitor_init (MetaIdleMonitor *monitor)
+on_session_proxy_ready (GObject      *source_object,
+                        GAsyncResult *result,
+                        gpointer      user_data)
 {
+  MetaIdleMonitor *monitor = user_data;
+  GDBusProxy *session_proxy;
+  g_autoptr (GError) error = NULL;
   GVariant *v;
 
-  monitor->watches = g_hash_table_new_full (NULL, NULL, NULL, free_watch);
-  monitor->last_event_time = g_get_monotonic_time ();
+  session_proxy = g_dbus_proxy_new_for_bus_finish (result, &error);
+  if (!session_proxy)
+    {
+      if (!g_error_matches (error, G_IO_ERROR, G_IO_ERROR_CANCELLED))
+        meta_topic (META_DEBUG_BACKEND,
+                    "Failed to create session manager proxy: %s",
+                    error->message);
+      return;
+    }
 
-  /* Monitor inhibitors */
-  monitor->session_proxy =
-    g_dbus_proxy_new_for_bus_sync (G_BUS_TYPE_SESSION,
-                                   G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS |
-                                   G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
-                                   NULL,
-                                   "org.gnome.SessionManager",
-                                   "/org/gnome/SessionManager",
-                                   "org.gnome.SessionManager",
-                                   NULL,
-                                   NULL);
-  if (!monitor->session_proxy)
-    return;
+  monitor->session_proxy = session_proxy;
 
   g_signal_connect (monitor->session_proxy, "g-properties-changed",
                     G_CALLBACK (meta_idle_monitor_inhibited_actions_changed),
@@ -271,12 +274,32 @@ meta_idle_monitor_init (MetaIdleMonitor *monitor)
                                         "InhibitedActions");
   if (v)
     {
-      monitor->inhibited = !!(g_variant_get_uint32 (v) &
-                              GSM_INHIBITOR_FLAG_IDLE);
+      update_inhibited (monitor,
+                        !!(g_variant_get_uint32 (v) & GSM_INHIBITOR_FLAG_IDLE));
       g_variant_unref (v);
     }
 }
 
+static void
+meta_idle_monitor_init (MetaIdleMonitor *monitor)
+{
+  monitor->watches = g_hash_table_new_full (NULL, NULL, NULL, free_watch);
+  monitor->last_event_time = g_get_monotonic_time ();
+
+  /* Monitor inhibitors, without blocking startup on the session manager */
+  monitor->cancellable = g_cancellable_new ();
+  g_dbus_proxy_new_for_bus (G_BUS_TYPE_SESSION,
+                            G_DBUS_PROXY_FLAGS_DO_NOT_CONNECT_SIGNALS |
+                            G_DBUS_PROXY_FLAGS_DO_NOT_AUTO_START,
+                            NULL,
+                            "org.gnome.SessionManager",
+                            "/org/gnome/SessionManager",
+                            "org.gnome.SessionManager",
+                            monitor->cancellable,
+                            on_session_proxy_ready,
+                            monitor);
+}
+
 static guint32
 get_next_watch_serial (void)
 {
@@ -111,6 +111,11 @@ typedef struct _MetaScreenCastStreamSrcPrivate
   GHashTable *dmabuf_handles;
 
   cairo_region_t *redraw_clip;
+
+  CoglFramebuffer *readback_framebuffer;
+  CoglBitmap *readback_bitmap;
+  struct pw_buffer *readback_buffer;
+  gboolean record_after_readback;
 } MetaScreenCastStreamSrcPrivate;
 
 static struct spa_pod *
@@ -505,11 +510,116 @@ maybe_record_cursor (MetaScreenCastStreamSrc *src,
   g_assert_not_reached ();
 }
 
+static CoglContext *
+get_cogl_context (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStream *stream = meta_screen_cast_stream_src_get_stream (src);
+  MetaScreenCastSession *session = meta_screen_cast_stream_get_session (stream);
+  MetaScreenCast *screen_cast =
+    meta_screen_cast_session_get_screen_cast (session);
+  MetaBackend *backend = meta_screen_cast_get_backend (screen_cast);
+  ClutterBackend *clutter_backend = meta_backend_get_clutter_backend (backend);
+
+  return clutter_backend_get_cogl_context (clutter_backend);
+}
+
+static gboolean
+ensure_readback_framebuffer (MetaScreenCastStreamSrc  *src,
+                             GError                  **error)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  CoglContext *cogl_context = get_cogl_context (src);
+  int width = priv->video_format.size.width;
+  int height = priv->video_format.size.height;
+  CoglTexture2D *texture;
+  CoglOffscreen *offscreen;
+
+  if (priv->readback_framebuffer)
+    return TRUE;
+
+  texture = cogl_texture_2d_new_with_size (cogl_context, width, height);
+  cogl_primitive_texture_set_auto_mipmap (COGL_PRIMITIVE_TEXTURE (texture),
+                                          FALSE);
+  if (!cogl_texture_allocate (COGL_TEXTURE (texture), error))
+    {
+      cogl_object_unref (texture);
+      return FALSE;
+    }
+
+  offscreen = cogl_offscreen_new_with_texture (COGL_TEXTURE (texture));
+  cogl_object_unref (texture);
+  if (!cogl_framebuffer_allocate (COGL_FRAMEBUFFER (offscreen), error))
+    {
+      g_object_unref (offscreen);
+      return FALSE;
+    }
+
+  priv->readback_framebuffer = COGL_FRAMEBUFFER (offscreen);
+  priv->readback_bitmap = cogl_bitmap_new_with_size (cogl_context,
+                                                     width, height,
+                                                     CLUTTER_CAIRO_FORMAT_ARGB32);
+
+  return TRUE;
+}
+
+static void
+clear_readback_framebuffer (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  g_clear_object (&priv->readback_framebuffer);
+  g_clear_pointer (&priv->readback_bitmap, cogl_object_unref);
+}
+
+static gboolean
+can_record_with_readback (MetaScreenCastStreamSrc *src)
+{
+  return cogl_has_feature (get_cogl_context (src), COGL_FEATURE_ID_FENCE);
+}
+
+static gboolean
+copy_readback_bitmap (MetaScreenCastStreamSrc *src,
+                      CoglBitmap              *bitmap,
+                      uint8_t                 *data)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  CoglBuffer *buffer = COGL_BUFFER (cogl_bitmap_get_buffer (bitmap));
+  int bitmap_stride = cogl_bitmap_get_rowstride (bitmap);
+  int height = cogl_bitmap_get_height (bitmap);
+  int row_size = MIN (bitmap_stride, priv->video_stride);
+  const uint8_t *pixels;
+  int y;
+
+  pixels = cogl_buffer_map (buffer, COGL_BUFFER_ACCESS_READ, 0);
+  if (!pixels)
+    return FALSE;
+
+  if (bitmap_stride == priv->video_stride)
+    {
+      memcpy (data, pixels, height * bitmap_stride);
+    }
+  else
+    {
+      for (y = 0; y < height; y++)
+        memcpy (data + y * priv->video_stride,
+                pixels + y * bitmap_stride,
+                row_size);
+    }
+
+  cogl_buffer_unmap (buffer);
+
+  return TRUE;
+}
+
 static gboolean
 do_record_frame (MetaScreenCastStreamSrc  *src,
                  MetaScreenCastRecordFlag  flags,
                  struct spa_buffer        *spa_buffer,
                  uint8_t                  *data,
+                 gboolean                 *needs_readback,
                  GError                  **error)
 {
   MetaScreenCastStreamSrcPrivate *priv =
@@ -522,6 +632,23 @@ do_record_frame (MetaScreenCastStreamSrc  *src,
       int height = priv->video_format.size.height;
       int stride = priv->video_stride;
 
+      /* Paint into an offscreen framebuffer and let the GPU copy it into
+       * a pixel buffer asynchronously, instead of stalling until the
+       * painting has finished to read it straight into the SHM buffer */
+      if (can_record_with_readback (src))
+        {
+          if (!ensure_readback_framebuffer (src, error))
+            return FALSE;
+
+          if (!meta_screen_cast_stream_src_record_to_framebuffer (src,
+                                                                  priv->readback_framebuffer,
+                                                                  error))
+            return FALSE;
+
+          *needs_readback = TRUE;
+          return TRUE;
+        }
+
       return meta_screen_cast_stream_src_record_to_buffer (src,
                                                            width,
                                                            height,
@@ -584,6 +711,91 @@ maybe_schedule_follow_up_frame (MetaScreenCastStreamSrc *src,
                                                    src);
 }
 
+static void
+on_readback_done (CoglFramebuffer *framebuffer,
+                  CoglBitmap      *bitmap,
+                  gboolean         success,
+                  void            *user_data)
+{
+  g_autoptr (MetaScreenCastStreamSrc) src = user_data;
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  struct pw_buffer *buffer = priv->readback_buffer;
+  struct spa_buffer *spa_buffer;
+
+  /* The buffer was removed, the readback cancelled, or the stream
+   * destroyed, while the GPU was still copying the frame */
+  if (!buffer || bitmap != priv->readback_bitmap)
+    return;
+
+  priv->readback_buffer = NULL;
+  spa_buffer = buffer->buffer;
+
+  if (!success ||
+      !copy_readback_bitmap (src, bitmap, spa_buffer->datas[0].data))
+    {
+      g_warning ("Failed to read back screen cast frame");
+      spa_buffer->datas[0].chunk->size = 0;
+      spa_buffer->datas[0].chunk->flags = SPA_CHUNK_FLAG_CORRUPTED;
+    }
+
+  pw_stream_queue_buffer (priv->pipewire_stream, buffer);
+
+  if (priv->record_after_readback && priv->is_enabled)
+    {
+      priv->record_after_readback = FALSE;
+      maybe_schedule_follow_up_frame (src, 0);
+    }
+}
+
+static void
+cancel_readback (MetaScreenCastStreamSrc *src)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+  struct pw_buffer *buffer = priv->readback_buffer;
+  struct spa_buffer *spa_buffer;
+
+  priv->record_after_readback = FALSE;
+
+  if (!buffer)
+    return;
+
+  /* The frame is dropped; the readback callback notices it is stale as
+   * the readback bitmap is replaced too */
+  priv->readback_buffer = NULL;
+  spa_buffer = buffer->buffer;
+  spa_buffer->datas[0].chunk->size = 0;
+  spa_buffer->datas[0].chunk->flags = SPA_CHUNK_FLAG_CORRUPTED;
+  pw_stream_queue_buffer (priv->pipewire_stream, buffer);
+}
+
+static gboolean
+start_readback (MetaScreenCastStreamSrc  *src,
+                struct pw_buffer         *buffer,
+                GError                  **error)
+{
+  MetaScreenCastStreamSrcPrivate *priv =
+    meta_screen_cast_stream_src_get_instance_private (src);
+
+  priv->readback_buffer = buffer;
+
+  if (!cogl_framebuffer_read_pixels_into_bitmap_async (priv->readback_framebuffer,
+                                                       0, 0,
+                                                       COGL_READ_PIXELS_COLOR_BUFFER,
+                                                       priv->readback_bitmap,
+                                                       on_readback_done,
+                                                       g_object_ref (src),
+                                                       error))
+    {
+      priv->readback_buffer = NULL;
+      g_object_unref (src);
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
 static int32_t
 meta_screen_cast_stream_src_calculate_stride (MetaScreenCastStreamSrc *src,
                                               struct spa_data         *spa_data)
@@ -702,6 +914,7 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
   struct spa_buffer *spa_buffer;
   struct spa_meta_header *header;
   uint8_t *data = NULL;
+  gboolean needs_readback = FALSE;
 
   /* Accumulate the damaged region since we might not schedule a frame capture
    * eventually but once we do, we should report all the previous damaged areas.
@@ -741,6 +954,17 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
   if (!priv->pipewire_stream)
     return META_SCREEN_CAST_RECORD_RESULT_RECORDED_NOTHING;
 
+  if (priv->readback_buffer &&
+      !(flags & META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY))
+    {
+      priv->record_after_readback = TRUE;
+      meta_topic (META_DEBUG_SCREEN_CAST,
+                  "Skipped recording frame on stream %u, "
+                  "previous frame still being read back",
+                  priv->node_id);
+      return record_result;
+    }
+
   meta_topic (META_DEBUG_SCREEN_CAST, "Recording %s frame on stream %u",
               flags & META_SCREEN_CAST_RECORD_FLAG_CURSOR_ONLY ?
               "cursor" : "full",
@@ -778,7 +1002,8 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       g_autoptr (GError) error = NULL;
 
       g_clear_handle_id (&priv->follow_up_frame_source_id, g_source_remove);
-      if (do_record_frame (src, flags, spa_buffer, data, &error))
+      if (do_record_frame (src, flags, spa_buffer, data,
+                           &needs_readback, &error))
         {
           maybe_add_damaged_regions_metadata (src, spa_buffer);
           struct spa_data *spa_data = &spa_buffer->datas[0];
@@ -839,6 +1064,20 @@ meta_screen_cast_stream_src_maybe_record_frame_with_timestamp (MetaScreenCastStr
       header->flags = 0;
     }
 
+  if (needs_readback)
+    {
+      g_autoptr (GError) error = NULL;
+
+      /* The buffer is queued once the pixels have been copied into it */
+      if (start_readback (src, buffer, &error))
+        return record_result;
+
+      g_warning ("Failed to read back screen cast frame: %s", error->message);
+      spa_buffer->datas[0].chunk->size = 0;
+      spa_buffer->datas[0].chunk->flags = SPA_CHUNK_FLAG_CORRUPTED;
+      record_result &= ~META_SCREEN_CAST_RECORD_RESULT_RECORDED_FRAME;
+    }
+
   pw_stream_queue_buffer (priv->pipewire_stream, buffer);
 
   return record_result;
@@ -966,6 +1205,9 @@ on_stream_param_changed (void                 *data,
   if (!format || id != SPA_PARAM_Format)
     return;
 
+  /* A readback still in flight has the size of the previous format */
+  cancel_readback (src);
+
   spa_format_video_raw_parse (format,
                               &priv->video_format);
 
@@ -976,6 +1218,8 @@ on_stream_param_changed (void                 *data,
 
   priv->video_stride = stride;
 
+  clear_readback_framebuffer (src);
+
   pod_builder = SPA_POD_BUILDER_INIT (params_buffer, sizeof (params_buffer));
 
   buffer_types = 1 << SPA_DATA_MemFd;
@@ -1135,6 +1379,9 @@ on_stream_remove_buffer (void             *data,
   struct spa_buffer *spa_buffer = buffer->buffer;
   struct spa_data *spa_data = spa_buffer->datas;
 
+  if (priv->readback_buffer == buffer)
+    priv->readback_buffer = NULL;
+
   if (spa_data[0].type == SPA_DATA_DmaBuf)
     {
       if (!g_hash_table_remove (priv->dmabuf_handles, GINT_TO_POINTER (spa_data[0].fd)))
@@ -1499,6 +1746,9 @@ meta_screen_cast_stream_src_dispose (GObject *object)
   if (meta_screen_cast_stream_src_is_enabled (src))
     meta_screen_cast_stream_src_disable (src);
 
+  priv->readback_buffer = NULL;
+  clear_readback_framebuffer (src);
+
   g_clear_pointer (&priv->pipewire_stream, pw_stream_destroy);
   g_clear_pointer (&priv->dmabuf_handles, g_hash_table_destroy);
   g_clear_pointer (&priv->pipewire_core, pw_core_disconnect);
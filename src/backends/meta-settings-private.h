@@ -35,6 +35,7 @@ typedef enum _MetaExperimentalFeature
   META_EXPERIMENTAL_FEATURE_KMS_MODIFIERS  = (1 << 1),
   META_EXPERIMENTAL_FEATURE_RT_SCHEDULER = (1 << 2),
   META_EXPERIMENTAL_FEATURE_AUTOCLOSE_XWAYLAND  = (1 << 3),
+  META_EXPERIMENTAL_FEATURE_PREDICTIVE_FRAME_CALLBACKS = (1 << 4),
 } MetaExperimentalFeature;
 
 typedef enum _MetaXwaylandExtension
@@ -69,6 +70,10 @@ META_EXPORT_TEST
 void meta_settings_enable_experimental_feature (MetaSettings           *settings,
                                                 MetaExperimentalFeature feature);
 
+META_EXPORT_TEST
+void meta_settings_disable_experimental_feature (MetaSettings           *settings,
+                                                 MetaExperimentalFeature feature);
+
 void meta_settings_get_xwayland_grab_patterns (MetaSettings  *settings,
                                                GPtrArray    **allow_list_patterns,
                                                GPtrArray    **deny_list_patterns);
@@ -79,6 +84,8 @@ int meta_settings_get_xwayland_disable_extensions (MetaSettings *settings);
 
 gboolean meta_settings_are_xwayland_byte_swapped_clients_allowed (MetaSettings *settings);
 
+uint64_t meta_settings_get_wayland_client_memory_limit (MetaSettings *settings);
+
 gboolean meta_settings_is_privacy_screen_enabled (MetaSettings *settings);
 
 void meta_settings_set_privacy_screen_enabled (MetaSettings *settings,
@@ -77,6 +77,9 @@ struct _MetaSettings
 
   /* Whether Xwayland should allow X11 clients from different endianness */
   gboolean xwayland_allow_byte_swapped_clients;
+
+  /* Memory limit of Wayland clients in MiB, or 0 */
+  unsigned int wayland_client_memory_limit_mb;
 };
 
 G_DEFINE_TYPE (MetaSettings, meta_settings, G_TYPE_OBJECT)
@@ -269,6 +272,15 @@ meta_settings_enable_experimental_feature (MetaSettings           *settings,
   settings->experimental_features |= feature;
 }
 
+void
+meta_settings_disable_experimental_feature (MetaSettings           *settings,
+                                            MetaExperimentalFeature feature)
+{
+  g_assert (settings->experimental_features_overridden);
+
+  settings->experimental_features &= ~feature;
+}
+
 static gboolean
 experimental_features_handler (GVariant *features_variant,
                                gpointer *result,
@@ -298,6 +310,8 @@ experimental_features_handler (GVariant *features_variant,
         feature = META_EXPERIMENTAL_FEATURE_RT_SCHEDULER;
       else if (g_str_equal (feature_str, "autoclose-xwayland"))
         feature = META_EXPERIMENTAL_FEATURE_AUTOCLOSE_XWAYLAND;
+      else if (g_str_equal (feature_str, "predictive-frame-callbacks"))
+        feature = META_EXPERIMENTAL_FEATURE_PREDICTIVE_FRAME_CALLBACKS;
 
       if (feature)
         g_message ("Enabling experimental feature '%s'", feature_str);
@@ -440,6 +454,14 @@ update_xwayland_allow_byte_swapped_clients (MetaSettings *settings)
                           "xwayland-allow-byte-swapped-clients");
 }
 
+static void
+update_wayland_client_memory_limit (MetaSettings *settings)
+{
+  settings->wayland_client_memory_limit_mb =
+    g_settings_get_uint (settings->wayland_settings,
+                         "client-memory-limit");
+}
+
 static void
 wayland_settings_changed (GSettings    *wayland_settings,
                           gchar        *key,
@@ -462,6 +484,10 @@ wayland_settings_changed (GSettings    *wayland_settings,
     {
       update_xwayland_allow_byte_swapped_clients (settings);
     }
+  else if (g_str_equal (key, "client-memory-limit"))
+    {
+      update_wayland_client_memory_limit (settings);
+    }
 }
 
 void
@@ -492,6 +518,13 @@ meta_settings_are_xwayland_byte_swapped_clients_allowed (MetaSettings *settings)
   return settings->xwayland_allow_byte_swapped_clients;
 }
 
+/* Returns the limit in bytes, or 0 if there is none */
+uint64_t
+meta_settings_get_wayland_client_memory_limit (MetaSettings *settings)
+{
+  return (uint64_t) settings->wayland_client_memory_limit_mb * 1024 * 1024;
+}
+
 gboolean
 meta_settings_is_privacy_screen_enabled (MetaSettings *settings)
 {
@@ -569,6 +602,7 @@ meta_settings_init (MetaSettings *settings)
   update_xwayland_grab_access_rules (settings);
   update_xwayland_allow_grabs (settings);
   update_xwayland_disable_extensions (settings);
+  update_wayland_client_memory_limit (settings);
   update_privacy_settings (settings);
 }
 
@@ -86,6 +86,7 @@ gboolean meta_compositor_drag_window (MetaCompositor       *compositor,
                                       ClutterEventSequence *sequence,
                                       uint32_t              timestamp);
 
+META_EXPORT_TEST
 MetaWindowDrag * meta_compositor_get_current_window_drag (MetaCompositor *compositor);
 
 void meta_compositor_grab_begin (MetaCompositor *compositor);
@@ -48,6 +48,14 @@ struct _MetaEdgeResistanceData
   GArray *right_edges;
   GArray *top_edges;
   GArray *bottom_edges;
+
+  /* Trees over the edges, letting the snapping queries skip whole ranges
+   * of edges that can't overlap a given window. left_edges and right_edges
+   * hold the same edges in the same order, and so do top_edges and
+   * bottom_edges, so they can share their trees.
+   */
+  MetaRectangleTree *vertical_tree;
+  MetaRectangleTree *horizontal_tree;
 };
 
 static GQuark edge_resistance_data_quark = 0;
@@ -158,6 +166,35 @@ find_index_of_edge_near_position (const GArray *edges,
     }
 }
 
+static MetaRectangleTree *
+edge_tree_new (const GArray *edges)
+{
+  g_autofree MetaRectangle *rects = NULL;
+  int i;
+
+  rects = g_new (MetaRectangle, MAX (edges->len, 1));
+  for (i = 0; i < (int) edges->len; i++)
+    rects[i] = g_array_index (edges, MetaEdge*, i)->rect;
+
+  return meta_rectangle_tree_new (rects, edges->len);
+}
+
+static int
+find_overlapping_edge (const MetaRectangleTree *tree,
+                       int                      from,
+                       gboolean                 forward,
+                       const MetaRectangle     *rect,
+                       gboolean                 horizontal)
+{
+  /* Edges in a horizontally sorted array are vertical, and only need to
+   * overlap rect vertically to align with it, and vice versa.
+   */
+  return meta_rectangle_tree_find_overlap (tree, from, forward, rect,
+                                           horizontal ?
+                                           META_DIRECTION_VERTICAL :
+                                           META_DIRECTION_HORIZONTAL);
+}
+
 static gboolean
 points_on_same_side (int ref, int pt1, int pt2)
 {
@@ -165,12 +202,13 @@ points_on_same_side (int ref, int pt1, int pt2)
 }
 
 static int
-find_nearest_position (const GArray        *edges,
-                       int                  position,
-                       int                  old_position,
-                       const MetaRectangle *new_rect,
-                       gboolean             horizontal,
-                       gboolean             only_forward)
+find_nearest_position (const GArray            *edges,
+                       const MetaRectangleTree *tree,
+                       int                      position,
+                       int                      old_position,
+                       const MetaRectangle     *new_rect,
+                       gboolean                 horizontal,
+                       gboolean                 only_forward)
 {
   /* This is basically just a binary search except that we're looking
    * for the value closest to position, rather than finding that
@@ -230,19 +268,18 @@ find_nearest_position (const GArray        *edges,
         }
     }
 
-  /* Now start searching higher than mid */
-  for (i = mid + 1; i < (int)edges->len; i++)
+  /* Now start searching higher than mid, skipping straight to the edges
+   * that overlap new_rect.
+   */
+  for (i = find_overlapping_edge (tree, mid + 1, TRUE, new_rect, horizontal);
+       i != -1 && i < (int) edges->len;
+       i = find_overlapping_edge (tree, i + 1, TRUE, new_rect, horizontal))
     {
       edge = g_array_index (edges, MetaEdge*, i);
       compare = horizontal ? edge->rect.x : edge->rect.y;
 
-      edges_align = horizontal ?
-        meta_rectangle_vert_overlap (&edge->rect, new_rect) :
-        meta_rectangle_horiz_overlap (&edge->rect, new_rect);
-
-      if (edges_align &&
-          (!only_forward ||
-           !points_on_same_side (position, compare, old_position)))
+      if (!only_forward ||
+          !points_on_same_side (position, compare, old_position))
         {
           int dist = ABS (compare - position);
           if (dist < best_dist)
@@ -255,18 +292,17 @@ find_nearest_position (const GArray        *edges,
     }
 
   /* Now start searching lower than mid */
-  for (i = mid-1; i >= 0; i--)
+  for (i = mid > 0 ? find_overlapping_edge (tree, mid - 1, FALSE,
+                                            new_rect, horizontal) : -1;
+       i != -1;
+       i = i > 0 ? find_overlapping_edge (tree, i - 1, FALSE,
+                                          new_rect, horizontal) : -1)
     {
       edge = g_array_index (edges, MetaEdge*, i);
       compare = horizontal ? edge->rect.x : edge->rect.y;
 
-      edges_align = horizontal ?
-        meta_rectangle_vert_overlap (&edge->rect, new_rect) :
-        meta_rectangle_horiz_overlap (&edge->rect, new_rect);
-
-      if (edges_align &&
-          (!only_forward ||
-           !points_on_same_side (position, compare, old_position)))
+      if (!only_forward ||
+          !points_on_same_side (position, compare, old_position))
         {
           int dist = ABS (compare - position);
           if (dist < best_dist)
@@ -416,12 +452,13 @@ apply_edge_resistance (MetaWindow                *window,
 }
 
 static int
-apply_edge_snapping (int                  old_pos,
-                     int                  new_pos,
-                     const MetaRectangle *new_rect,
-                     GArray              *edges,
-                     gboolean             xdir,
-                     gboolean             keyboard_op)
+apply_edge_snapping (int                      old_pos,
+                     int                      new_pos,
+                     const MetaRectangle     *new_rect,
+                     GArray                  *edges,
+                     const MetaRectangleTree *tree,
+                     gboolean                 xdir,
+                     gboolean                 keyboard_op)
 {
   int snap_to;
 
@@ -429,6 +466,7 @@ apply_edge_snapping (int                  old_pos,
     return new_pos;
 
   snap_to = find_nearest_position (edges,
+                                   tree,
                                    new_pos,
                                    old_pos,
                                    new_rect,
@@ -484,6 +522,7 @@ apply_edge_resistance_to_each_side (MetaEdgeResistanceData  *edge_data,
                                         BOX_LEFT (*new_outer),
                                         new_outer,
                                         edge_data->left_edges,
+                                        edge_data->vertical_tree,
                                         TRUE,
                                         keyboard_op);
 
@@ -491,6 +530,7 @@ apply_edge_resistance_to_each_side (MetaEdgeResistanceData  *edge_data,
                                         BOX_RIGHT (*new_outer),
                                         new_outer,
                                         edge_data->right_edges,
+                                        edge_data->vertical_tree,
                                         TRUE,
                                         keyboard_op);
 
@@ -498,6 +538,7 @@ apply_edge_resistance_to_each_side (MetaEdgeResistanceData  *edge_data,
                                         BOX_TOP (*new_outer),
                                         new_outer,
                                         edge_data->top_edges,
+                                        edge_data->horizontal_tree,
                                         FALSE,
                                         keyboard_op);
 
@@ -505,6 +546,7 @@ apply_edge_resistance_to_each_side (MetaEdgeResistanceData  *edge_data,
                                         BOX_BOTTOM (*new_outer),
                                         new_outer,
                                         edge_data->bottom_edges,
+                                        edge_data->horizontal_tree,
                                         FALSE,
                                         keyboard_op);
     }
@@ -681,6 +723,9 @@ meta_edge_resistance_data_free (MetaEdgeResistanceData *edge_data)
   g_hash_table_destroy (edges_to_be_freed);
 
   /* Now free the arrays and data */
+  g_clear_pointer (&edge_data->vertical_tree, meta_rectangle_tree_free);
+  g_clear_pointer (&edge_data->horizontal_tree, meta_rectangle_tree_free);
+
   g_array_free (edge_data->left_edges, TRUE);
   g_array_free (edge_data->right_edges, TRUE);
   g_array_free (edge_data->top_edges, TRUE);
@@ -703,8 +748,8 @@ meta_window_drag_edge_resistance_cleanup (MetaWindowDrag *window_drag)
 }
 
 static int
-stupid_sort_requiring_extra_pointer_dereference (gconstpointer a,
-                                                 gconstpointer b)
+compare_edge_pointers (gconstpointer a,
+                       gconstpointer b)
 {
   const MetaEdge * const *a_edge = a;
   const MetaEdge * const *b_edge = b;
@@ -858,19 +903,28 @@ cache_edges (MetaDisplay *display,
     }
 
   /*
-   * 4th: Sort the arrays (FIXME: This is kinda dumb since the arrays were
-   * individually sorted earlier and we could have done this faster and
-   * avoided this sort by sticking them into the array with some simple
-   * merging of the lists).
+   * 4th: Sort the arrays. The left and right arrays (and likewise the top
+   * and bottom ones) hold the same edges, so sort one and copy it over
+   * instead of sorting it twice.
    */
-  g_array_sort (edge_data->left_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
-  g_array_sort (edge_data->right_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
-  g_array_sort (edge_data->top_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
-  g_array_sort (edge_data->bottom_edges,
-                stupid_sort_requiring_extra_pointer_dereference);
+  g_array_sort (edge_data->left_edges, compare_edge_pointers);
+  g_array_set_size (edge_data->right_edges, 0);
+  g_array_append_vals (edge_data->right_edges,
+                       edge_data->left_edges->data,
+                       edge_data->left_edges->len);
+
+  g_array_sort (edge_data->top_edges, compare_edge_pointers);
+  g_array_set_size (edge_data->bottom_edges, 0);
+  g_array_append_vals (edge_data->bottom_edges,
+                       edge_data->top_edges->data,
+                       edge_data->top_edges->len);
+
+  /*
+   * 5th: Index the perpendicular extents of the edges for the snapping
+   * queries done on every motion event.
+   */
+  edge_data->vertical_tree = edge_tree_new (edge_data->left_edges);
+  edge_data->horizontal_tree = edge_tree_new (edge_data->top_edges);
 
   return edge_data;
 }
@@ -1039,18 +1093,13 @@ compute_resistance_and_snapping_edges (MetaWindowDrag *window_drag)
     }
 
   /*
-   * 4th: Free the extra memory not needed and sort the list
+   * 4th: Free the extra memory not needed
    */
   g_list_free (stacked_windows);
   /* Free the memory used by the obscuring windows/docks lists */
   g_slist_free (window_stacking);
   g_slist_free_full (obscuring_windows, g_free);
 
-  /* Sort the list.  FIXME: Should I bother with this sorting?  I just
-   * sort again later in cache_edges() anyway...
-   */
-  edges = g_list_sort (edges, meta_rectangle_edge_cmp);
-
   /*
    * 5th: Cache the combination of these edges with the onscreen and
    * monitor edges in an array for quick access.  Free the edges since
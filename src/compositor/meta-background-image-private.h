@@ -0,0 +1,20 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+#ifndef META_BACKGROUND_IMAGE_PRIVATE_H
+#define META_BACKGROUND_IMAGE_PRIVATE_H
+
+#include "core/util-private.h"
+#include "meta/meta-background-image.h"
+
+META_EXPORT_TEST
+void meta_background_image_cache_set_max_size (MetaBackgroundImageCache *cache,
+                                               int                       max_width,
+                                               int                       max_height);
+
+META_EXPORT_TEST
+MetaBackgroundImage *meta_background_image_cache_load_for_size (MetaBackgroundImageCache *cache,
+                                                                GFile                    *file,
+                                                                int                       max_width,
+                                                                int                       max_height);
+
+#endif /* META_BACKGROUND_IMAGE_PRIVATE_H */
@@ -18,14 +18,18 @@
 
 #include "config.h"
 
-#include "meta/meta-background-image.h"
+#include "compositor/meta-background-image-private.h"
 
 #include <gdk-pixbuf/gdk-pixbuf.h>
 #include <gio/gio.h>
+#include <stdlib.h>
 
 #include "clutter/clutter.h"
+#include "cogl/cogl-trace.h"
 #include "compositor/cogl-utils.h"
 
+#define LOAD_BUFFER_SIZE 65536
+
 enum
 {
   LOADED,
@@ -34,6 +38,13 @@ enum
 
 static guint signals[LAST_SIGNAL] = { 0 };
 
+typedef struct _MetaBackgroundImageKey
+{
+  GFile *file;
+  int max_width;
+  int max_height;
+} MetaBackgroundImageKey;
+
 /**
  * MetaBackgroundImageCache:
  *
@@ -47,6 +58,10 @@ struct _MetaBackgroundImageCache
   GObject parent_instance;
 
   GHashTable *images;
+
+  /* What meta_background_image_cache_load() decodes images to cover */
+  int max_width;
+  int max_height;
 };
 
 /**
@@ -58,6 +73,7 @@ struct _MetaBackgroundImage
 {
   GObject parent_instance;
   GFile *file;
+  MetaBackgroundImageKey key;
   MetaBackgroundImageCache *cache;
   gboolean in_cache;
   gboolean loaded;
@@ -66,10 +82,32 @@ struct _MetaBackgroundImage
 
 G_DEFINE_TYPE (MetaBackgroundImageCache, meta_background_image_cache, G_TYPE_OBJECT);
 
+static guint
+image_key_hash (gconstpointer data)
+{
+  const MetaBackgroundImageKey *key = data;
+
+  return (g_file_hash (key->file) ^
+          (guint) key->max_width ^
+          ((guint) key->max_height << 16));
+}
+
+static gboolean
+image_key_equal (gconstpointer a,
+                 gconstpointer b)
+{
+  const MetaBackgroundImageKey *key_a = a;
+  const MetaBackgroundImageKey *key_b = b;
+
+  return (key_a->max_width == key_b->max_width &&
+          key_a->max_height == key_b->max_height &&
+          g_file_equal (key_a->file, key_b->file));
+}
+
 static void
 meta_background_image_cache_init (MetaBackgroundImageCache *cache)
 {
-  cache->images = g_hash_table_new (g_file_hash, (GEqualFunc) g_file_equal);
+  cache->images = g_hash_table_new (image_key_hash, image_key_equal);
 }
 
 static void
@@ -115,33 +153,190 @@ meta_background_image_cache_get_default (void)
   return cache;
 }
 
+/* Sets the size that images subsequently loaded with
+ * meta_background_image_cache_load() are decoded to cover, typically that
+ * of the largest monitor in pixels; 0 means no limit.
+ */
+void
+meta_background_image_cache_set_max_size (MetaBackgroundImageCache *cache,
+                                          int                       max_width,
+                                          int                       max_height)
+{
+  g_return_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache));
+
+  cache->max_width = max_width;
+  cache->max_height = max_height;
+}
+
+/* Gets the smallest size with the aspect ratio of the image that still
+ * covers max_width x max_height, if that is smaller than the image.
+ */
+static gboolean
+get_downscaled_size (int  width,
+                     int  height,
+                     int  max_width,
+                     int  max_height,
+                     int *out_width,
+                     int *out_height)
+{
+  if (max_width <= 0 || max_height <= 0)
+    return FALSE;
+
+  if (width <= max_width || height <= max_height)
+    return FALSE;
+
+  /* Scale down until either side reaches its limit, rounding the other up */
+  if ((int64_t) max_width * height >= (int64_t) max_height * width)
+    {
+      *out_width = max_width;
+      *out_height = ((int64_t) height * max_width + width - 1) / width;
+    }
+  else
+    {
+      *out_width = ((int64_t) width * max_height + height - 1) / height;
+      *out_height = max_height;
+    }
+
+  return TRUE;
+}
+
+static void
+on_size_prepared (GdkPixbufLoader *loader,
+                  int              width,
+                  int              height,
+                  gpointer         user_data)
+{
+  int *max_size = user_data;
+  int scaled_width, scaled_height;
+
+  /* Most loaders, and JPEG in particular, decode straight to the requested
+   * size, which is a lot faster than decoding the whole image.
+   */
+  if (get_downscaled_size (width, height,
+                           max_size[0], max_size[1],
+                           &scaled_width, &scaled_height))
+    gdk_pixbuf_loader_set_size (loader, scaled_width, scaled_height);
+}
+
+static GdkPixbuf *
+decode_file (GFile         *file,
+             int            max_width,
+             int            max_height,
+             GCancellable  *cancellable,
+             GError       **error)
+{
+  g_autoptr (GFileInputStream) stream = NULL;
+  g_autoptr (GdkPixbufLoader) loader = NULL;
+  int max_size[2] = { max_width, max_height };
+  guchar buffer[LOAD_BUFFER_SIZE];
+  gssize n_read;
+  GdkPixbuf *pixbuf;
+
+  stream = g_file_read (file, cancellable, error);
+  if (stream == NULL)
+    return NULL;
+
+  loader = gdk_pixbuf_loader_new ();
+  g_signal_connect (loader, "size-prepared",
+                    G_CALLBACK (on_size_prepared), max_size);
+
+  while ((n_read = g_input_stream_read (G_INPUT_STREAM (stream),
+                                        buffer, sizeof (buffer),
+                                        cancellable, error)) > 0)
+    {
+      if (!gdk_pixbuf_loader_write (loader, buffer, n_read, error))
+        {
+          gdk_pixbuf_loader_close (loader, NULL);
+          return NULL;
+        }
+    }
+
+  if (n_read < 0)
+    {
+      gdk_pixbuf_loader_close (loader, NULL);
+      return NULL;
+    }
+
+  if (!gdk_pixbuf_loader_close (loader, error))
+    return NULL;
+
+  pixbuf = gdk_pixbuf_loader_get_pixbuf (loader);
+  if (pixbuf == NULL)
+    {
+      g_set_error (error, GDK_PIXBUF_ERROR, GDK_PIXBUF_ERROR_FAILED,
+                   "Image loader returned no image");
+      return NULL;
+    }
+
+  return g_object_ref (pixbuf);
+}
+
+static gboolean
+is_orientation_transposed (GdkPixbuf *pixbuf)
+{
+  const char *orientation;
+
+  orientation = gdk_pixbuf_get_option (pixbuf, "orientation");
+  if (orientation == NULL)
+    return FALSE;
+
+  /* EXIF orientations 5 to 8 turn the image by a quarter */
+  switch (atoi (orientation))
+    {
+    case 5:
+    case 6:
+    case 7:
+    case 8:
+      return TRUE;
+    default:
+      return FALSE;
+    }
+}
+
 static void
 load_file (GTask               *task,
            MetaBackgroundImage *image,
            gpointer             task_data,
            GCancellable        *cancellable)
 {
+  MetaBackgroundImageKey *key = &image->key;
   GError *error = NULL;
-  GdkPixbuf *pixbuf;
-  GFileInputStream *stream;
-
-  stream = g_file_read (image->file, NULL, &error);
-  if (stream == NULL)
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GdkPixbuf) oriented_pixbuf = NULL;
+
+  pixbuf = decode_file (image->file, key->max_width, key->max_height,
+                        cancellable, &error);
+
+  /* The size to cover is only known to apply to the image as stored, so
+   * decode it again if it turns out to be turned sideways when shown.
+   */
+  if (pixbuf != NULL &&
+      key->max_width > 0 && key->max_height > 0 &&
+      is_orientation_transposed (pixbuf) &&
+      (gdk_pixbuf_get_height (pixbuf) < key->max_width ||
+       gdk_pixbuf_get_width (pixbuf) < key->max_height))
     {
-      g_task_return_error (task, error);
-      return;
+      g_clear_object (&pixbuf);
+      pixbuf = decode_file (image->file, key->max_height, key->max_width,
+                            cancellable, &error);
     }
 
-  pixbuf = gdk_pixbuf_new_from_stream (G_INPUT_STREAM (stream), NULL, &error);
-  g_object_unref (stream);
-
   if (pixbuf == NULL)
     {
       g_task_return_error (task, error);
       return;
     }
 
-  g_task_return_pointer (task, pixbuf, (GDestroyNotify) g_object_unref);
+  /* Rotating can fail to allocate the rotated copy, in which case the
+   * image is better shown turned than not at all.
+   */
+  oriented_pixbuf = gdk_pixbuf_apply_embedded_orientation (pixbuf);
+  if (oriented_pixbuf == NULL)
+    oriented_pixbuf = g_steal_pointer (&pixbuf);
+
+  g_task_return_pointer (task,
+                         g_steal_pointer (&oriented_pixbuf),
+                         (GDestroyNotify) g_object_unref);
 }
 
 static void
@@ -154,7 +349,7 @@ file_loaded (GObject      *source_object,
   g_autoptr (GError) local_error = NULL;
   GTask *task;
   CoglTexture *texture;
-  GdkPixbuf *pixbuf, *rotated;
+  GdkPixbuf *pixbuf;
   int width, height, row_stride;
   guchar *pixels;
   gboolean has_alpha;
@@ -171,19 +366,24 @@ file_loaded (GObject      *source_object,
       goto out;
     }
 
-  rotated = gdk_pixbuf_apply_embedded_orientation (pixbuf);
-  if (rotated != NULL)
-    {
-      g_object_unref (pixbuf);
-      pixbuf = rotated;
-    }
-
   width = gdk_pixbuf_get_width (pixbuf);
   height = gdk_pixbuf_get_height (pixbuf);
   row_stride = gdk_pixbuf_get_rowstride (pixbuf);
   pixels = gdk_pixbuf_get_pixels (pixbuf);
   has_alpha = gdk_pixbuf_get_has_alpha (pixbuf);
 
+  COGL_TRACE_BEGIN_SCOPED (MetaBackgroundImageUpload,
+                           "Background image: Upload");
+#ifdef COGL_HAS_TRACING
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      g_autofree char *description = NULL;
+
+      description = g_strdup_printf ("%dx%d", width, height);
+      COGL_TRACE_DESCRIBE (MetaBackgroundImageUpload, description);
+    }
+#endif
+
   texture = meta_create_texture (width, height,
                                  has_alpha ? COGL_TEXTURE_COMPONENTS_RGBA : COGL_TEXTURE_COMPONENTS_RGB,
                                  META_TEXTURE_ALLOW_SLICING);
@@ -223,19 +423,54 @@ out:
  * signal will be emitted exactly once. The 'loaded' state means that the
  * loading process finished, whether it succeeded or failed.
  *
+ * Images larger than the monitors are downscaled while decoding, keeping
+ * their aspect ratio, to the smallest size that still covers the largest
+ * monitor at the time they are loaded. The texture of the loaded image can
+ * therefore be smaller than the image file.
+ *
  * Return value: (transfer full): a #MetaBackgroundImage to dereference to get the loaded texture
  */
 MetaBackgroundImage *
 meta_background_image_cache_load (MetaBackgroundImageCache *cache,
                                   GFile                    *file)
 {
+  g_return_val_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache), NULL);
+
+  return meta_background_image_cache_load_for_size (cache, file,
+                                                    cache->max_width,
+                                                    cache->max_height);
+}
+
+/* Like meta_background_image_cache_load(), but decodes the image to the
+ * smallest size keeping its aspect ratio that covers max_width x max_height,
+ * or to its full size if those are 0. Images are shared per file and size.
+ */
+MetaBackgroundImage *
+meta_background_image_cache_load_for_size (MetaBackgroundImageCache *cache,
+                                           GFile                    *file,
+                                           int                       max_width,
+                                           int                       max_height)
+{
+  MetaBackgroundImageKey key;
   MetaBackgroundImage *image;
   GTask *task;
 
   g_return_val_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache), NULL);
   g_return_val_if_fail (file != NULL, NULL);
 
-  image = g_hash_table_lookup (cache->images, file);
+  if (max_width <= 0 || max_height <= 0)
+    {
+      max_width = 0;
+      max_height = 0;
+    }
+
+  key = (MetaBackgroundImageKey) {
+    .file = file,
+    .max_width = max_width,
+    .max_height = max_height,
+  };
+
+  image = g_hash_table_lookup (cache->images, &key);
   if (image != NULL)
     return g_object_ref (image);
 
@@ -243,7 +478,12 @@ meta_background_image_cache_load (MetaBackgroundImageCache *cache,
   image->cache = cache;
   image->in_cache = TRUE;
   image->file = g_object_ref (file);
-  g_hash_table_insert (cache->images, image->file, image);
+  image->key = (MetaBackgroundImageKey) {
+    .file = image->file,
+    .max_width = max_width,
+    .max_height = max_height,
+  };
+  g_hash_table_insert (cache->images, &image->key, image);
 
   task = g_task_new (image, NULL, file_loaded, NULL);
 
@@ -258,24 +498,30 @@ meta_background_image_cache_load (MetaBackgroundImageCache *cache,
  * @cache: a #MetaBackgroundImageCache
  * @file: file to remove from the cache
  *
- * Remove an entry from the cache; this would be used if monitoring
- * showed that the file changed.
+ * Remove the entries of a file, at any size, from the cache; this would be
+ * used if monitoring showed that the file changed.
  */
 void
 meta_background_image_cache_purge (MetaBackgroundImageCache *cache,
                                    GFile                    *file)
 {
-  MetaBackgroundImage *image;
+  GHashTableIter iter;
+  gpointer value;
 
   g_return_if_fail (META_IS_BACKGROUND_IMAGE_CACHE (cache));
   g_return_if_fail (file != NULL);
 
-  image = g_hash_table_lookup (cache->images, file);
-  if (image == NULL)
-    return;
+  g_hash_table_iter_init (&iter, cache->images);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      MetaBackgroundImage *image = value;
 
-  g_hash_table_remove (cache->images, image->file);
-  image->in_cache = FALSE;
+      if (!g_file_equal (image->file, file))
+        continue;
+
+      g_hash_table_iter_remove (&iter);
+      image->in_cache = FALSE;
+    }
 }
 
 G_DEFINE_TYPE (MetaBackgroundImage, meta_background_image, G_TYPE_OBJECT);
@@ -291,7 +537,7 @@ meta_background_image_finalize (GObject *object)
   MetaBackgroundImage *image = META_BACKGROUND_IMAGE (object);
 
   if (image->in_cache)
-    g_hash_table_remove (image->cache->images, image->file);
+    g_hash_table_remove (image->cache->images, &image->key);
 
   if (image->texture)
     cogl_object_unref (image->texture);
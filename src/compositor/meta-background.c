@@ -21,12 +21,13 @@
 
 #include "compositor/meta-background-private.h"
 
+#include <math.h>
 #include <string.h>
 
 #include "backends/meta-backend-private.h"
 #include "compositor/cogl-utils.h"
+#include "compositor/meta-background-image-private.h"
 #include "meta/display.h"
-#include "meta/meta-background-image.h"
 #include "meta/meta-background.h"
 #include "meta/meta-monitor-manager.h"
 #include "meta/util.h"
@@ -66,6 +67,10 @@ struct _MetaBackground
   GFile *file2;
   MetaBackgroundImage *background_image2;
 
+  /* The size the background images are loaded to cover */
+  int image_max_width;
+  int image_max_height;
+
   CoglTexture *color_texture;
   CoglTexture *wallpaper_texture;
 
@@ -133,10 +138,89 @@ invalidate_monitor_backgrounds (MetaBackground *self)
     }
 }
 
+/* Gets the size in pixels the background images need to cover to look the
+ * same as when shown at full size with the style, or 0 if the style shows
+ * them at their natural size.
+ */
 static void
-on_monitors_changed (MetaBackground *self)
+get_image_max_size (MetaBackground          *self,
+                    GDesktopBackgroundStyle  style,
+                    int                     *max_width,
+                    int                     *max_height)
 {
-  invalidate_monitor_backgrounds (self);
+  MetaContext *context;
+  MetaBackend *backend;
+  gboolean stage_views_scaled;
+  int i;
+
+  *max_width = 0;
+  *max_height = 0;
+
+  if (!self->display)
+    return;
+
+  switch (style)
+    {
+    case G_DESKTOP_BACKGROUND_STYLE_NONE:
+    case G_DESKTOP_BACKGROUND_STYLE_WALLPAPER:
+    case G_DESKTOP_BACKGROUND_STYLE_CENTERED:
+      return;
+    case G_DESKTOP_BACKGROUND_STYLE_STRETCHED:
+    case G_DESKTOP_BACKGROUND_STYLE_SCALED:
+    case G_DESKTOP_BACKGROUND_STYLE_ZOOM:
+    case G_DESKTOP_BACKGROUND_STYLE_SPANNED:
+      break;
+    }
+
+  context = meta_display_get_context (self->display);
+  backend = meta_context_get_backend (context);
+  stage_views_scaled = meta_backend_is_stage_views_scaled (backend);
+
+  for (i = 0; i < meta_display_get_n_monitors (self->display); i++)
+    {
+      MetaRectangle geometry;
+      float scale = 1.0;
+
+      if (style == G_DESKTOP_BACKGROUND_STYLE_SPANNED)
+        meta_display_get_size (self->display,
+                               &geometry.width, &geometry.height);
+      else
+        meta_display_get_monitor_geometry (self->display, i, &geometry);
+
+      if (stage_views_scaled)
+        scale = meta_display_get_monitor_scale (self->display, i);
+
+      *max_width = MAX (*max_width, (int) ceilf (geometry.width * scale));
+      *max_height = MAX (*max_height, (int) ceilf (geometry.height * scale));
+    }
+}
+
+/* Returns whether the background images need to be loaded again to look
+ * right with the style on the current monitors.
+ */
+static gboolean
+update_image_max_size (MetaBackground          *self,
+                       GDesktopBackgroundStyle  style)
+{
+  MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
+  int max_width, max_height;
+
+  /* Images loaded straight from the cache, e.g. to wait for a background
+   * to be ready, should be the ones backgrounds with most styles end up
+   * sharing.
+   */
+  get_image_max_size (self, G_DESKTOP_BACKGROUND_STYLE_ZOOM,
+                      &max_width, &max_height);
+  meta_background_image_cache_set_max_size (cache, max_width, max_height);
+
+  get_image_max_size (self, style, &max_width, &max_height);
+  if (max_width == self->image_max_width &&
+      max_height == self->image_max_height)
+    return FALSE;
+
+  self->image_max_width = max_width;
+  self->image_max_height = max_height;
+  return TRUE;
 }
 
 static void
@@ -256,13 +340,27 @@ set_file (MetaBackground       *self,
         {
           MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
 
-          *imagep = meta_background_image_cache_load (cache, file);
+          *imagep = meta_background_image_cache_load_for_size (cache, file,
+                                                               self->image_max_width,
+                                                               self->image_max_height);
           g_signal_connect (*imagep, "loaded",
                             G_CALLBACK (on_background_loaded), self);
         }
     }
 }
 
+static void
+on_monitors_changed (MetaBackground *self)
+{
+  invalidate_monitor_backgrounds (self);
+
+  if (update_image_max_size (self, self->style))
+    {
+      set_file (self, &self->file1, &self->background_image1, self->file1, TRUE);
+      set_file (self, &self->file2, &self->background_image2, self->file2, TRUE);
+    }
+}
+
 static void
 on_gl_video_memory_purged (MetaBackground *self)
 {
@@ -324,6 +422,8 @@ meta_background_constructed (GObject *object)
 
   G_OBJECT_CLASS (meta_background_parent_class)->constructed (object);
 
+  update_image_max_size (self, self->style);
+
   g_signal_connect_object (self->display, "gl-video-memory-purged",
                            G_CALLBACK (on_gl_video_memory_purged), object, G_CONNECT_SWAPPED);
 
@@ -634,6 +734,22 @@ create_pipeline (PipelineType type)
   return cogl_pipeline_copy (templates[type]);
 }
 
+static void
+set_pipeline_mipmap_level (CoglPipeline *pipeline,
+                           int           mipmap_level)
+{
+  /* Mipmaps are generated on the GPU the first time a texture is drawn with
+   * a mipmapping filter, so avoid that when only the base level is used, as
+   * for images decoded to the size of the monitors.
+   */
+  if (mipmap_level == 0)
+    cogl_pipeline_set_layer_filters (pipeline, 0,
+                                     COGL_PIPELINE_FILTER_LINEAR,
+                                     COGL_PIPELINE_FILTER_LINEAR);
+  else
+    cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
+}
+
 static gboolean
 texture_has_alpha (CoglTexture *texture)
 {
@@ -694,6 +810,7 @@ ensure_wallpaper_texture (MetaBackground *self,
 
       pipeline = create_pipeline (PIPELINE_REPLACE);
       cogl_pipeline_set_layer_texture (pipeline, 0, texture);
+      set_pipeline_mipmap_level (pipeline, 0);
       cogl_framebuffer_draw_textured_rectangle (fbo, pipeline, 0, 0, width, height,
                                                 0., 0., 1., 1.);
       cogl_object_unref (pipeline);
@@ -868,7 +985,7 @@ meta_background_get_texture (MetaBackground         *self,
                                       self->blend_factor, self->blend_factor, self->blend_factor, self->blend_factor);
           cogl_pipeline_set_layer_texture (pipeline, 0, texture2);
           cogl_pipeline_set_layer_wrap_mode (pipeline, 0, get_wrap_mode (self->style));
-          cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
+          set_pipeline_mipmap_level (pipeline, mipmap_level);
 
           bare_region_visible = draw_texture (self,
                                               monitor->fbo, pipeline,
@@ -900,7 +1017,7 @@ meta_background_get_texture (MetaBackground         *self,
                                      (1 - self->blend_factor));
           cogl_pipeline_set_layer_texture (pipeline, 0, texture1);
           cogl_pipeline_set_layer_wrap_mode (pipeline, 0, get_wrap_mode (self->style));
-          cogl_pipeline_set_layer_max_mipmap_level (pipeline, 0, mipmap_level);
+          set_pipeline_mipmap_level (pipeline, mipmap_level);
 
           bare_region_visible = bare_region_visible || draw_texture (self,
                                                                      monitor->fbo, pipeline,
@@ -1000,11 +1117,15 @@ meta_background_set_blend (MetaBackground          *self,
                            double                   blend_factor,
                            GDesktopBackgroundStyle  style)
 {
+  gboolean force_reload;
+
   g_return_if_fail (META_IS_BACKGROUND (self));
   g_return_if_fail (blend_factor >= 0.0 && blend_factor <= 1.0);
 
-  set_file (self, &self->file1, &self->background_image1, file1, FALSE);
-  set_file (self, &self->file2, &self->background_image2, file2, FALSE);
+  force_reload = update_image_max_size (self, style);
+
+  set_file (self, &self->file1, &self->background_image1, file1, force_reload);
+  set_file (self, &self->file2, &self->background_image2, file2, force_reload);
 
   self->blend_factor = blend_factor;
   self->style = style;
@@ -132,6 +132,7 @@ meta_cullable_cull_out_children (MetaCullable   *cullable,
           cairo_region_t *actor_unobscured_region, *actor_clip_region;
           cairo_region_t *reduced_unobscured_region, *reduced_clip_region;
           graphene_matrix_t actor_transform, inverted_actor_transform;
+          int x_offset, y_offset;
 
           clutter_actor_get_transform (child, &actor_transform);
 
@@ -144,6 +145,27 @@ meta_cullable_cull_out_children (MetaCullable   *cullable,
               continue;
             }
 
+          if (meta_matrix_is_integer_translation (&actor_transform,
+                                                  &x_offset, &y_offset))
+            {
+              /* Most children are only offset by their allocation, so
+               * move the regions into the child's space and back in
+               * place. This gives the same result as the transform and
+               * intersect below, without creating four new regions for
+               * every child. Cullables copy non-empty regions they want
+               * to keep, so translating them afterwards is safe. */
+              cairo_region_translate (unobscured_region, -x_offset, -y_offset);
+              cairo_region_translate (clip_region, -x_offset, -y_offset);
+
+              meta_cullable_cull_out (META_CULLABLE (child),
+                                      unobscured_region,
+                                      clip_region);
+
+              cairo_region_translate (unobscured_region, x_offset, y_offset);
+              cairo_region_translate (clip_region, x_offset, y_offset);
+              continue;
+            }
+
           if (!graphene_matrix_inverse (&actor_transform,
                                         &inverted_actor_transform) ||
               !graphene_matrix_is_2d (&actor_transform))
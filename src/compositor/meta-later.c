@@ -40,6 +40,11 @@ typedef struct _MetaLater
 
   guint source_id;
   gboolean run_once;
+
+  /* How long the callback took the last time it was invoked */
+  int64_t cost_us;
+  gboolean deferrable;
+  gboolean deferred;
 } MetaLater;
 
 #define META_LATER_N_TYPES (META_LATER_IDLE + 1)
@@ -116,8 +121,50 @@ later_type_to_string (MetaLaterType when)
 static gboolean
 meta_later_invoke (MetaLater *later)
 {
+  int64_t start_us;
+  gboolean ret;
+
   COGL_TRACE_BEGIN_SCOPED (later, later_type_to_string (later->when));
-  return later->func (later->user_data);
+
+  start_us = g_get_monotonic_time ();
+  ret = later->func (later->user_data);
+  later->cost_us = g_get_monotonic_time () - start_us;
+
+#ifdef COGL_HAS_TRACING
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      g_autofree char *description = NULL;
+
+      description = g_strdup_printf ("later %u, %s",
+                                     later->id,
+                                     later->deferrable ? "deferrable" :
+                                                         "not deferrable");
+      COGL_TRACE_DESCRIBE (later, description);
+    }
+#endif
+
+  return ret;
+}
+
+static MetaLater *
+find_later (MetaLaters   *laters,
+            unsigned int  later_id)
+{
+  unsigned int i;
+  GSList *l;
+
+  for (i = 0; i < G_N_ELEMENTS (laters->laters); i++)
+    {
+      for (l = laters->laters[i]; l; l = l->next)
+        {
+          MetaLater *later = l->data;
+
+          if (later->id == later_id)
+            return later;
+        }
+    }
+
+  return NULL;
 }
 
 static gboolean
@@ -141,8 +188,23 @@ remove_later_from_list (unsigned int   later_id,
   return FALSE;
 }
 
+/* A deferrable later is skipped for a frame if its last run would not fit
+ * anymore before the frame deadline, but never twice in a row, so that it
+ * can't be starved by a busy compositor.
+ */
+static gboolean
+should_defer_later (MetaLater *later,
+                    int64_t    deadline_us)
+{
+  if (!later->deferrable || later->deferred || deadline_us == 0)
+    return FALSE;
+
+  return g_get_monotonic_time () + later->cost_us > deadline_us;
+}
+
 static void
-run_repaint_laters (GSList **laters_list)
+run_repaint_laters (GSList  **laters_list,
+                    int64_t   deadline_us)
 {
   g_autoptr (GSList) laters_copy = NULL;
   GSList *l;
@@ -162,9 +224,20 @@ run_repaint_laters (GSList **laters_list)
       MetaLater *later = l->data;
 
       if (!later->func)
-        remove_later_from_list (later->id, laters_list);
-      else if (!meta_later_invoke (later))
-        remove_later_from_list (later->id, laters_list);
+        {
+          remove_later_from_list (later->id, laters_list);
+        }
+      else if (should_defer_later (later, deadline_us))
+        {
+          later->deferred = TRUE;
+        }
+      else
+        {
+          later->deferred = FALSE;
+
+          if (!meta_later_invoke (later))
+            remove_later_from_list (later->id, laters_list);
+        }
 
       meta_later_unref (later);
     }
@@ -179,9 +252,21 @@ on_before_update (ClutterStage     *stage,
   unsigned int i;
   GSList *l;
   gboolean needs_schedule_update = FALSE;
+  int64_t target_presentation_time_us;
+  int64_t min_render_time_allowed_us;
+  int64_t deadline_us = 0;
+
+  /* Laters need to be done in time for the frame to be rendered before it
+   * is presented.
+   */
+  if (clutter_frame_get_target_presentation_time (frame,
+                                                  &target_presentation_time_us) &&
+      clutter_frame_get_min_render_time_allowed (frame,
+                                                 &min_render_time_allowed_us))
+    deadline_us = target_presentation_time_us - min_render_time_allowed_us;
 
   for (i = 0; i < G_N_ELEMENTS (laters->laters); i++)
-    run_repaint_laters (&laters->laters[i]);
+    run_repaint_laters (&laters->laters[i], deadline_us);
 
   for (i = 0; i < G_N_ELEMENTS (laters->laters); i++)
     {
@@ -202,17 +287,26 @@ static gboolean
 invoke_later_idle (gpointer data)
 {
   MetaLater *later = data;
+  gboolean ret;
 
-  if (!later->func (later->user_data))
+  meta_later_ref (later);
+
+  later->deferred = FALSE;
+
+  if (!meta_later_invoke (later))
     {
       meta_laters_remove (later->laters, later->id);
-      return FALSE;
+      ret = FALSE;
     }
   else
     {
       later->run_once = TRUE;
-      return TRUE;
+      ret = TRUE;
     }
+
+  meta_later_unref (later);
+
+  return ret;
 }
 
 static void
@@ -328,6 +422,32 @@ meta_laters_remove (MetaLaters   *laters,
     }
 }
 
+/**
+ * meta_laters_set_deferrable:
+ * @laters: a #MetaLaters
+ * @later_id: the integer ID returned from meta_later_add()
+ * @deferrable: whether the callback may be deferred
+ *
+ * Marks a callback added with meta_later_add() as low priority. Laters
+ * that run before a stage update, e.g. %META_LATER_BEFORE_REDRAW, are
+ * timed every time they run; a deferrable one is skipped for a frame if
+ * it took longer the last time than is left until the frame needs to be
+ * rendered, and run in the next frame (or idle, for laters that have an
+ * idle fallback) instead. A later is never deferred twice in a row.
+ */
+void
+meta_laters_set_deferrable (MetaLaters   *laters,
+                            unsigned int  later_id,
+                            gboolean      deferrable)
+{
+  MetaLater *later;
+
+  later = find_later (laters, later_id);
+  g_return_if_fail (later);
+
+  later->deferrable = deferrable;
+}
+
 MetaLaters *
 meta_laters_new (MetaCompositor *compositor)
 {
@@ -0,0 +1,38 @@
+/* -*- mode: C; c-file-style: "gnu"; indent-tabs-mode: nil; -*- */
+
+#ifndef META_SHADOW_FACTORY_PRIVATE_H
+#define META_SHADOW_FACTORY_PRIVATE_H
+
+#include <gio/gio.h>
+
+#include "core/util-private.h"
+#include "meta/meta-shadow-factory.h"
+
+META_EXPORT_TEST
+MetaShadow * meta_shadow_factory_lookup_shadow (MetaShadowFactory *factory,
+                                                MetaWindowShape   *shape,
+                                                int                width,
+                                                int                height,
+                                                const char        *class_name,
+                                                gboolean           focused);
+
+META_EXPORT_TEST
+void meta_shadow_factory_get_shadow_async (MetaShadowFactory   *factory,
+                                           MetaWindowShape     *shape,
+                                           int                  width,
+                                           int                  height,
+                                           const char          *class_name,
+                                           gboolean             focused,
+                                           GCancellable        *cancellable,
+                                           GAsyncReadyCallback  callback,
+                                           gpointer             user_data);
+
+META_EXPORT_TEST
+MetaShadow * meta_shadow_factory_get_shadow_finish (MetaShadowFactory  *factory,
+                                                    GAsyncResult       *result,
+                                                    GError            **error);
+
+META_EXPORT_TEST
+CoglTexture * meta_shadow_get_texture (MetaShadow *shadow);
+
+#endif /* META_SHADOW_FACTORY_PRIVATE_H */
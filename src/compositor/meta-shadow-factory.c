@@ -18,12 +18,14 @@
 
 #include "config.h"
 
+#include "compositor/meta-shadow-factory-private.h"
+
 #include <math.h>
 #include <string.h>
 
+#include "cogl/cogl-trace.h"
 #include "compositor/cogl-utils.h"
 #include "compositor/region-utils.h"
-#include "meta/meta-shadow-factory.h"
 #include "meta/util.h"
 
 /* This file implements blurring the shape of a window to produce a
@@ -40,14 +42,19 @@
  *   2D blur as 1D blur of the rows followed by a 1D blur of the
  *   columns.
  *
- * - For better cache efficiency, we blur rows, transpose the image
- *   in blocks, blur rows again, and then transpose back.
+ * - We blur blocks of adjacent columns together, so that the blur
+ *   works on contiguous pixels and can be vectorized.
+ *
+ * - We approximate the 1D gaussian blur as 3 successive box filters,
+ *   dividing by the filter size with a multiplication.
  *
- * - We approximate the 1D gaussian blur as 3 successive box filters.
+ * - The blur only depends on the shape and the parameters, so it can
+ *   be done in a thread when the shadow is requested asynchronously.
  */
 
 typedef struct _MetaShadowCacheKey  MetaShadowCacheKey;
 typedef struct _MetaShadowClassInfo MetaShadowClassInfo;
+typedef struct _MetaShadowBlur      MetaShadowBlur;
 
 struct _MetaShadowCacheKey
 {
@@ -79,6 +86,26 @@ struct _MetaShadow
 
   guint scale_width : 1;
   guint scale_height : 1;
+
+  /* Set while the shape is being blurred in a thread; the tasks of the
+   * asynchronous requests are returned once the texture is there */
+  guint blurring : 1;
+  GList *pending_tasks;
+};
+
+/* What blurring the shape of a shadow needs and produces; blur_shadow()
+ * doesn't touch anything else, so that it can be done in a thread */
+struct _MetaShadowBlur
+{
+  cairo_region_t *region;
+  int radius;
+  int top_fade;
+  int outer_border_bottom;
+
+  cairo_rectangle_int_t extents;
+  guchar *buffer;
+  int buffer_width;
+  int spread;
 };
 
 struct _MetaShadowClassInfo
@@ -378,6 +405,12 @@ meta_shadow_get_bounds  (MetaShadow            *shadow,
   bounds->height = window_height + shadow->outer_border_top + shadow->outer_border_bottom;
 }
 
+CoglTexture *
+meta_shadow_get_texture (MetaShadow *shadow)
+{
+  return shadow->texture;
+}
+
 static void
 meta_shadow_class_info_free (MetaShadowClassInfo *class_info)
 {
@@ -510,15 +543,55 @@ get_shadow_spread (int radius)
     return 3 * (d / 2) - 1;
 }
 
+/* Dividing the running sum by the filter size is the most expensive part
+ * of a box blur pass. The sum plus rounding is always less than 256 * d,
+ * so as long as d * d < 2^15, multiplying by (2^23 / d + 1) and shifting
+ * gives the exact same quotient, without the product overflowing 32 bits;
+ * unlike the division, that can be vectorized. Larger filters are rare
+ * enough that we just keep dividing for them.
+ */
+#define RECIPROCAL_SHIFT 23
+#define MAX_RECIPROCAL_FILTER_SIZE 181
+
+static uint32_t
+get_box_filter_reciprocal (int d)
+{
+  if (d > MAX_RECIPROCAL_FILTER_SIZE)
+    return 0;
+
+  return (1 << RECIPROCAL_SHIFT) / d + 1;
+}
+
+static inline guchar
+divide_sum (uint32_t sum,
+            int      d,
+            uint32_t reciprocal)
+{
+  if (reciprocal)
+    return ((sum + d / 2) * reciprocal) >> RECIPROCAL_SHIFT;
+  else
+    return (sum + d / 2) / d;
+}
+
+/* d is the filter width; for even d shift indicates how the blurred
+ * result is aligned with the original - does ' x ' go to ' yy' (shift=1)
+ * or 'yy ' (shift=-1)
+ */
+static int
+get_box_filter_offset (int d,
+                       int shift)
+{
+  if (d % 2 == 1)
+    return d / 2;
+  else
+    return (d - shift) / 2;
+}
+
 /* This applies a single box blur pass to a horizontal range of pixels;
  * since the box blur has the same weight for all pixels, we can
  * implement an efficient sliding window algorithm where we add
  * in pixels coming into the window from the right and remove
  * them when they leave the windw to the left.
- *
- * d is the filter width; for even d shift indicates how the blurred
- * result is aligned with the original - does ' x ' go to ' yy' (shift=1)
- * or 'yy ' (shift=-1)
  */
 static void
 blur_xspan (guchar *row,
@@ -529,23 +602,17 @@ blur_xspan (guchar *row,
             int     d,
             int     shift)
 {
-  int offset;
-  int sum = 0;
+  uint32_t reciprocal = get_box_filter_reciprocal (d);
+  int offset = get_box_filter_offset (d, shift);
+  uint32_t sum = 0;
   int i;
 
-  if (d % 2 == 1)
-    offset = d / 2;
-  else
-    offset = (d - shift) / 2;
-
   /* All the conditionals in here look slow, but the branches will
    * be well predicted and there are enough different possibilities
    * that trying to write this as a series of unconditional loops
-   * is hard and not an obvious win. The main slow down here seems
-   * to be the integer division per pixel; one possible optimization
-   * would be to accumulate into two 16-bit integer buffers and
-   * only divide down after all three passes. (SSE parallel implementation
-   * of the divide step is possible.)
+   * is hard and not an obvious win. Each step depends on the sum of
+   * the previous one, so this can't be vectorized along the row;
+   * blur_yspan() does that for columns instead.
    */
   for (i = x0 - d + offset; i < x1 + offset; i++)
     {
@@ -557,13 +624,99 @@ blur_xspan (guchar *row,
           if (i >= d)
             sum -= row[i - d];
 
-          tmp_buffer[i - offset] = (sum + d / 2) / d;
+          tmp_buffer[i - offset] = divide_sum (sum, d, reciprocal);
         }
     }
 
   memcpy (row + x0, tmp_buffer + x0, x1 - x0);
 }
 
+/* Number of columns blurred together by blur_yspan(); enough to make
+ * the sums for all of them small enough to stay in registers or the L1
+ * cache. The loops over the columns go in groups of COLUMN_GROUP_SIZE
+ * so that their trip count is a multiple of the vector size, which is
+ * what the compiler needs to vectorize them without runtime checks.
+ */
+#define COLUMN_BLOCK_SIZE 64
+#define COLUMN_GROUP_SIZE 16
+
+/* Like blur_xspan(), but for a block of n_columns adjacent columns that
+ * are blurred over the same vertical range: the sliding window sums of
+ * the columns are kept side by side, so every step adds and removes a
+ * contiguous run of pixels of a row, which vector instructions handle
+ * many pixels at a time. This also spares us from transposing the buffer
+ * to be able to blur the columns as rows.
+ *
+ * The last group of columns is read in full even if the block ends in
+ * the middle of it, so the buffer needs COLUMN_GROUP_SIZE bytes of
+ * padding at its end; tmp_buffer needs room for COLUMN_BLOCK_SIZE
+ * pixels for each row between y0 and y1.
+ */
+static void
+blur_yspan (guchar *buffer,
+            guchar *tmp_buffer,
+            int     buffer_width,
+            int     buffer_height,
+            int     x0,
+            int     n_columns,
+            int     y0,
+            int     y1,
+            int     d,
+            int     shift)
+{
+  uint32_t reciprocal = get_box_filter_reciprocal (d);
+  int offset = get_box_filter_offset (d, shift);
+  int n_lanes = (n_columns + COLUMN_GROUP_SIZE - 1) & ~(COLUMN_GROUP_SIZE - 1);
+  uint32_t sums[COLUMN_BLOCK_SIZE] = { 0 };
+  int i, j, k;
+
+  for (i = y0 - d + offset; i < y1 + offset; i++)
+    {
+      if (i >= 0 && i < buffer_height)
+        {
+          const guchar *entering = buffer + i * buffer_width + x0;
+
+          for (j = 0; j < n_lanes; j += COLUMN_GROUP_SIZE)
+            for (k = j; k < j + COLUMN_GROUP_SIZE; k++)
+              sums[k] += entering[k];
+        }
+
+      if (i >= y0 + offset)
+        {
+          guchar *dest = tmp_buffer + (i - offset - y0) * COLUMN_BLOCK_SIZE;
+
+          if (i >= d)
+            {
+              const guchar *leaving = buffer + (i - d) * buffer_width + x0;
+
+              for (j = 0; j < n_lanes; j += COLUMN_GROUP_SIZE)
+                for (k = j; k < j + COLUMN_GROUP_SIZE; k++)
+                  sums[k] -= leaving[k];
+            }
+
+          if (reciprocal)
+            {
+              for (j = 0; j < n_lanes; j += COLUMN_GROUP_SIZE)
+                for (k = j; k < j + COLUMN_GROUP_SIZE; k++)
+                  dest[k] = ((sums[k] + d / 2) * reciprocal) >> RECIPROCAL_SHIFT;
+            }
+          else
+            {
+              for (j = 0; j < n_lanes; j += COLUMN_GROUP_SIZE)
+                for (k = j; k < j + COLUMN_GROUP_SIZE; k++)
+                  dest[k] = (sums[k] + d / 2) / d;
+            }
+        }
+    }
+
+  for (i = y0; i < y1; i++)
+    {
+      memcpy (buffer + i * buffer_width + x0,
+              tmp_buffer + (i - y0) * COLUMN_BLOCK_SIZE,
+              n_columns);
+    }
+}
+
 static void
 blur_rows (cairo_region_t   *convolve_region,
            int               x_offset,
@@ -616,6 +769,69 @@ blur_rows (cairo_region_t   *convolve_region,
   g_free (tmp_buffer);
 }
 
+/* The convolve region is flipped - x and y are interchanged - so that
+ * each of its rectangles is a run of adjacent columns that all get blurred
+ * over the same vertical range, as blur_rows() would do after transposing
+ * the buffer.
+ */
+static void
+blur_columns (cairo_region_t   *convolve_region,
+              int               x_offset,
+              int               y_offset,
+              guchar           *buffer,
+              int               buffer_width,
+              int               buffer_height,
+              int               d)
+{
+  int i, x;
+  int n_rectangles;
+  guchar *tmp_buffer;
+
+  tmp_buffer = g_malloc (COLUMN_BLOCK_SIZE * buffer_height);
+
+  n_rectangles = cairo_region_num_rectangles (convolve_region);
+  for (i = 0; i < n_rectangles; i++)
+    {
+      cairo_rectangle_int_t rect;
+      int x1;
+      int y0;
+      int y1;
+
+      cairo_region_get_rectangle (convolve_region, i, &rect);
+
+      x1 = x_offset + rect.y + rect.height;
+      y0 = y_offset + rect.x;
+      y1 = y0 + rect.width;
+
+      for (x = x_offset + rect.y; x < x1; x += COLUMN_BLOCK_SIZE)
+        {
+          int n_columns = MIN (COLUMN_BLOCK_SIZE, x1 - x);
+
+          /* See blur_rows() */
+          if (d % 2 == 1)
+            {
+              blur_yspan (buffer, tmp_buffer, buffer_width, buffer_height,
+                          x, n_columns, y0, y1, d, 0);
+              blur_yspan (buffer, tmp_buffer, buffer_width, buffer_height,
+                          x, n_columns, y0, y1, d, 0);
+              blur_yspan (buffer, tmp_buffer, buffer_width, buffer_height,
+                          x, n_columns, y0, y1, d, 0);
+            }
+          else
+            {
+              blur_yspan (buffer, tmp_buffer, buffer_width, buffer_height,
+                          x, n_columns, y0, y1, d, 1);
+              blur_yspan (buffer, tmp_buffer, buffer_width, buffer_height,
+                          x, n_columns, y0, y1, d, -1);
+              blur_yspan (buffer, tmp_buffer, buffer_width, buffer_height,
+                          x, n_columns, y0, y1, d + 1, 0);
+            }
+        }
+    }
+
+  g_free (tmp_buffer);
+}
+
 static void
 fade_bytes (guchar *bytes,
             int     width,
@@ -629,87 +845,35 @@ fade_bytes (guchar *bytes,
     bytes[i] = (bytes[i] * multiplier) >> 16;
 }
 
-/* Swaps width and height. Either swaps in-place and returns the original
- * buffer or allocates a new buffer, frees the original buffer and returns
- * the new buffer.
- */
-static guchar *
-flip_buffer (guchar *buffer,
-             int     width,
-             int     height)
+static MetaShadowBlur *
+meta_shadow_blur_new (MetaShadow     *shadow,
+                      cairo_region_t *region)
 {
-  /* Working in blocks increases cache efficiency, compared to reading
-   * or writing an entire column at once */
-#define BLOCK_SIZE 16
-
-  if (width == height)
-    {
-      int i0, j0;
-
-      for (j0 = 0; j0 < height; j0 += BLOCK_SIZE)
-        for (i0 = 0; i0 <= j0; i0 += BLOCK_SIZE)
-          {
-            int max_j = MIN(j0 + BLOCK_SIZE, height);
-            int max_i = MIN(i0 + BLOCK_SIZE, width);
-            int i, j;
-
-            if (i0 == j0)
-              {
-                for (j = j0; j < max_j; j++)
-                  for (i = i0; i < j; i++)
-                    {
-                      guchar tmp = buffer[j * width + i];
-                      buffer[j * width + i] = buffer[i * width + j];
-                      buffer[i * width + j] = tmp;
-                    }
-              }
-            else
-              {
-                for (j = j0; j < max_j; j++)
-                  for (i = i0; i < max_i; i++)
-                    {
-                      guchar tmp = buffer[j * width + i];
-                      buffer[j * width + i] = buffer[i * width + j];
-                      buffer[i * width + j] = tmp;
-                    }
-              }
-          }
-
-      return buffer;
-    }
-  else
-    {
-      guchar *new_buffer = g_malloc (height * width);
-      int i0, j0;
-
-      for (i0 = 0; i0 < width; i0 += BLOCK_SIZE)
-        for (j0 = 0; j0 < height; j0 += BLOCK_SIZE)
-          {
-            int max_j = MIN(j0 + BLOCK_SIZE, height);
-            int max_i = MIN(i0 + BLOCK_SIZE, width);
-            int i, j;
+  MetaShadowBlur *blur;
 
-            for (i = i0; i < max_i; i++)
-              for (j = j0; j < max_j; j++)
-                new_buffer[i * height + j] = buffer[j * width + i];
-          }
+  blur = g_new0 (MetaShadowBlur, 1);
+  blur->region = region;
+  blur->radius = shadow->key.radius;
+  blur->top_fade = shadow->key.top_fade;
+  blur->outer_border_bottom = shadow->outer_border_bottom;
 
-      g_free (buffer);
+  return blur;
+}
 
-      return new_buffer;
-    }
-#undef BLOCK_SIZE
+static void
+meta_shadow_blur_free (MetaShadowBlur *blur)
+{
+  cairo_region_destroy (blur->region);
+  g_free (blur->buffer);
+  g_free (blur);
 }
 
+/* Only uses the blur itself, so this can run in a thread */
 static void
-make_shadow (MetaShadow     *shadow,
-             cairo_region_t *region)
+blur_shadow (MetaShadowBlur *blur)
 {
-  ClutterBackend *backend = clutter_get_default_backend ();
-  CoglContext *ctx = clutter_backend_get_cogl_context (backend);
-  GError *error = NULL;
-  int d = get_box_filter_size (shadow->key.radius);
-  int spread = get_shadow_spread (shadow->key.radius);
+  int d = get_box_filter_size (blur->radius);
+  int spread = get_shadow_spread (blur->radius);
   cairo_rectangle_int_t extents;
   cairo_region_t *row_convolve_region;
   cairo_region_t *column_convolve_region;
@@ -720,7 +884,20 @@ make_shadow (MetaShadow     *shadow,
   int y_offset;
   int n_rectangles, j, k;
 
-  cairo_region_get_extents (region, &extents);
+  cairo_region_get_extents (blur->region, &extents);
+
+  COGL_TRACE_BEGIN_SCOPED (MetaShadowBlur, "Shadow: Blur");
+#ifdef COGL_HAS_TRACING
+  if (G_UNLIKELY (cogl_is_tracing_enabled ()))
+    {
+      g_autofree char *description = NULL;
+
+      description = g_strdup_printf ("%dx%d, radius %d",
+                                     extents.width, extents.height,
+                                     blur->radius);
+      COGL_TRACE_DESCRIBE (MetaShadowBlur, description);
+    }
+#endif
 
   /* In the case where top_fade >= 0 and the portion above the top
    * edge of the shape will be cropped, it seems like we could create
@@ -734,76 +911,81 @@ make_shadow (MetaShadow     *shadow,
   buffer_width = extents.width + 2 * spread;
   buffer_height = extents.height + 2 * spread;
 
-  /* Round up so we have aligned rows/columns */
+  /* Round up so we have aligned rows */
   buffer_width = (buffer_width + 3) & ~3;
-  buffer_height = (buffer_height + 3) & ~3;
 
-  /* Square buffer allows in-place swaps, which are roughly 70% faster, but we
-   * don't want to over-allocate too much memory.
-   */
-  if (buffer_height < buffer_width && buffer_height > (3 * buffer_width) / 4)
-    buffer_height = buffer_width;
-  if (buffer_width < buffer_height && buffer_width > (3 * buffer_height) / 4)
-    buffer_width = buffer_height;
-
-  buffer = g_malloc0 (buffer_width * buffer_height);
+  /* See blur_yspan() for the padding at the end */
+  buffer = g_malloc0 (buffer_width * buffer_height + COLUMN_GROUP_SIZE);
 
   /* Blurring with multiple box-blur passes is fast, but (especially for
    * large shadow sizes) we can improve efficiency by restricting the blur
    * to the region that actually needs to be blurred.
    */
-  row_convolve_region = meta_make_border_region (region, spread, spread, FALSE);
-  column_convolve_region = meta_make_border_region (region, 0, spread, TRUE);
+  row_convolve_region = meta_make_border_region (blur->region, spread, spread, FALSE);
+  column_convolve_region = meta_make_border_region (blur->region, 0, spread, TRUE);
 
   /* Offsets between coordinates of the regions and coordinates in the buffer */
   x_offset = spread;
   y_offset = spread;
 
   /* Step 1: unblurred image */
-  n_rectangles = cairo_region_num_rectangles (region);
+  n_rectangles = cairo_region_num_rectangles (blur->region);
   for (k = 0; k < n_rectangles; k++)
     {
       cairo_rectangle_int_t rect;
 
-      cairo_region_get_rectangle (region, k, &rect);
+      cairo_region_get_rectangle (blur->region, k, &rect);
       for (j = y_offset + rect.y; j < y_offset + rect.y + rect.height; j++)
         memset (buffer + buffer_width * j + x_offset + rect.x, 255, rect.width);
     }
 
-  /* Step 2: swap rows and columns */
-  buffer = flip_buffer (buffer, buffer_width, buffer_height);
+  /* Step 2: blur columns */
+  blur_columns (column_convolve_region, x_offset, y_offset,
+                buffer, buffer_width, buffer_height,
+                d);
 
-  /* Step 3: blur rows (really columns) */
-  blur_rows (column_convolve_region, y_offset, x_offset,
-             buffer, buffer_height, buffer_width,
-             d);
-
-  /* Step 4: swap rows and columns */
-  buffer = flip_buffer (buffer, buffer_height, buffer_width);
-
-  /* Step 5: blur rows */
+  /* Step 3: blur rows */
   blur_rows (row_convolve_region, x_offset, y_offset,
              buffer, buffer_width, buffer_height,
              d);
 
-  /* Step 6: fade out the top, if applicable */
-  if (shadow->key.top_fade >= 0)
+  /* Step 4: fade out the top, if applicable */
+  if (blur->top_fade >= 0)
     {
-      for (j = y_offset; j < y_offset + MIN (shadow->key.top_fade, extents.height + shadow->outer_border_bottom); j++)
-        fade_bytes(buffer + j * buffer_width, buffer_width, j - y_offset, shadow->key.top_fade);
+      for (j = y_offset; j < y_offset + MIN (blur->top_fade, extents.height + blur->outer_border_bottom); j++)
+        fade_bytes(buffer + j * buffer_width, buffer_width, j - y_offset, blur->top_fade);
     }
 
+  cairo_region_destroy (row_convolve_region);
+  cairo_region_destroy (column_convolve_region);
+
+  blur->extents = extents;
+  blur->buffer = buffer;
+  blur->buffer_width = buffer_width;
+  blur->spread = spread;
+}
+
+static void
+upload_shadow (MetaShadow     *shadow,
+               MetaShadowBlur *blur)
+{
+  ClutterBackend *backend = clutter_get_default_backend ();
+  CoglContext *ctx = clutter_backend_get_cogl_context (backend);
+  GError *error = NULL;
+  int x_offset = blur->spread;
+  int y_offset = blur->spread;
+
   /* We offset the passed in pixels to crop off the extra area we allocated at the top
    * in the case of top_fade >= 0. We also account for padding at the left for symmetry
    * though that doesn't currently occur.
    */
   shadow->texture = COGL_TEXTURE (cogl_texture_2d_new_from_data (ctx,
-                                                                 shadow->outer_border_left + extents.width + shadow->outer_border_right,
-                                                                 shadow->outer_border_top + extents.height + shadow->outer_border_bottom,
+                                                                 shadow->outer_border_left + blur->extents.width + shadow->outer_border_right,
+                                                                 shadow->outer_border_top + blur->extents.height + shadow->outer_border_bottom,
                                                                  COGL_PIXEL_FORMAT_A_8,
-                                                                 buffer_width,
-                                                                 (buffer +
-                                                                  (y_offset - shadow->outer_border_top) * buffer_width +
+                                                                 blur->buffer_width,
+                                                                 (blur->buffer +
+                                                                  (y_offset - shadow->outer_border_top) * blur->buffer_width +
                                                                   (x_offset - shadow->outer_border_left)),
                                                                  &error));
 
@@ -813,13 +995,84 @@ make_shadow (MetaShadow     *shadow,
       g_error_free (error);
     }
 
-  cairo_region_destroy (row_convolve_region);
-  cairo_region_destroy (column_convolve_region);
-  g_free (buffer);
-
   shadow->pipeline = meta_create_texture_pipeline (shadow->texture);
 }
 
+static void
+make_shadow (MetaShadow     *shadow,
+             cairo_region_t *region)
+{
+  MetaShadowBlur *blur;
+
+  blur = meta_shadow_blur_new (shadow, cairo_region_reference (region));
+  blur_shadow (blur);
+  upload_shadow (shadow, blur);
+  meta_shadow_blur_free (blur);
+}
+
+static void
+blur_shadow_in_thread (GTask        *task,
+                       gpointer      source_object,
+                       gpointer      task_data,
+                       GCancellable *cancellable)
+{
+  blur_shadow (task_data);
+
+  g_task_return_boolean (task, TRUE);
+}
+
+static void
+on_shadow_blurred (GObject      *source_object,
+                   GAsyncResult *result,
+                   gpointer      user_data)
+{
+  MetaShadow *shadow = user_data;
+  MetaShadowBlur *blur = g_task_get_task_data (G_TASK (result));
+  GList *tasks;
+  GList *l;
+
+  shadow->blurring = FALSE;
+
+  /* Somebody may have needed the shadow right away in the meantime */
+  if (!shadow->texture)
+    upload_shadow (shadow, blur);
+
+  tasks = g_steal_pointer (&shadow->pending_tasks);
+  for (l = tasks; l; l = l->next)
+    {
+      GTask *task = l->data;
+
+      g_task_return_pointer (task, meta_shadow_ref (shadow),
+                             (GDestroyNotify) meta_shadow_unref);
+      g_object_unref (task);
+    }
+  g_list_free (tasks);
+
+  meta_shadow_unref (shadow);
+}
+
+static void
+make_shadow_async (MetaShadow     *shadow,
+                   cairo_region_t *region,
+                   GTask          *task)
+{
+  GTask *blur_task;
+
+  shadow->pending_tasks = g_list_prepend (shadow->pending_tasks, task);
+
+  if (shadow->blurring)
+    return;
+
+  shadow->blurring = TRUE;
+
+  blur_task = g_task_new (NULL, NULL, on_shadow_blurred, meta_shadow_ref (shadow));
+  g_task_set_task_data (blur_task,
+                        meta_shadow_blur_new (shadow, cairo_region_reference (region)),
+                        (GDestroyNotify) meta_shadow_blur_free);
+  g_task_run_in_thread (blur_task, blur_shadow_in_thread);
+  g_object_unref (blur_task);
+}
+
 static MetaShadowParams *
 get_shadow_params (MetaShadowFactory *factory,
                    const char        *class_name,
@@ -851,36 +1104,22 @@ get_shadow_params (MetaShadowFactory *factory,
     return &class_info->unfocused;
 }
 
-/**
- * meta_shadow_factory_get_shadow:
- * @factory: a #MetaShadowFactory
- * @shape: the size-invariant shape of the window's region
- * @width: the actual width of the window's region
- * @height: the actual height of the window's region
- * @class_name: name of the class of window shadows
- * @focused: whether the shadow is for a focused window
- *
- * Gets the appropriate shadow object for drawing shadows for the
- * specified window shape. The region that we are shadowing is specified
- * as a combination of a size-invariant extracted shape and the size.
- * In some cases, the same shadow object can be shared between sizes;
- * in other cases a different shadow object is used for each size.
- *
- * Return value: (transfer full): a newly referenced #MetaShadow; unref with
- *  meta_shadow_unref()
+/* Returns a referenced shadow from the cache, or a new one; if the
+ * shadow doesn't have its texture yet, also returns the region that
+ * has to be blurred for it.
  */
-MetaShadow *
-meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
-                                MetaWindowShape   *shape,
-                                int                width,
-                                int                height,
-                                const char        *class_name,
-                                gboolean           focused)
+static MetaShadow *
+get_shadow_for_size (MetaShadowFactory  *factory,
+                     MetaWindowShape    *shape,
+                     int                 width,
+                     int                 height,
+                     const char         *class_name,
+                     gboolean            focused,
+                     cairo_region_t    **region)
 {
   MetaShadowParams *params;
   MetaShadowCacheKey key;
   MetaShadow *shadow;
-  cairo_region_t *region;
   int spread;
   int shape_border_top, shape_border_right, shape_border_bottom, shape_border_left;
   int inner_border_top, inner_border_right, inner_border_bottom, inner_border_left;
@@ -889,9 +1128,6 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
   gboolean cacheable;
   int center_width, center_height;
 
-  g_return_val_if_fail (META_IS_SHADOW_FACTORY (factory), NULL);
-  g_return_val_if_fail (shape != NULL, NULL);
-
   /* Using a single shadow texture for different window sizes only works
    * when there is a central scaled area that is greater than twice
    * the spread of the gaussian blur we are applying to get to the
@@ -938,6 +1174,18 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
   scale_height = inner_border_top + inner_border_bottom <= height;
   cacheable = scale_width && scale_height;
 
+  if (scale_width)
+    center_width = inner_border_left + inner_border_right - (shape_border_left + shape_border_right);
+  else
+    center_width = width - (shape_border_left + shape_border_right);
+
+  if (scale_height)
+    center_height = inner_border_top + inner_border_bottom - (shape_border_top + shape_border_bottom);
+  else
+    center_height = height - (shape_border_top + shape_border_bottom);
+
+  g_assert (center_width >= 0 && center_height >= 0);
+
   if (cacheable)
     {
       key.shape = shape;
@@ -946,7 +1194,16 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
 
       shadow = g_hash_table_lookup (factory->shadows, &key);
       if (shadow)
-        return meta_shadow_ref (shadow);
+        {
+          if (shadow->texture)
+            *region = NULL;
+          else
+            *region = meta_window_shape_to_region (shape,
+                                                   center_width,
+                                                   center_height);
+
+          return meta_shadow_ref (shadow);
+        }
     }
 
   shadow = g_new0 (MetaShadow, 1);
@@ -967,23 +1224,9 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
   shadow->inner_border_left = inner_border_left;
 
   shadow->scale_width = scale_width;
-  if (scale_width)
-    center_width = inner_border_left + inner_border_right - (shape_border_left + shape_border_right);
-  else
-    center_width = width - (shape_border_left + shape_border_right);
-
   shadow->scale_height = scale_height;
-  if (scale_height)
-    center_height = inner_border_top + inner_border_bottom - (shape_border_top + shape_border_bottom);
-  else
-    center_height = height - (shape_border_top + shape_border_bottom);
-
-  g_assert (center_width >= 0 && center_height >= 0);
-
-  region = meta_window_shape_to_region (shape, center_width, center_height);
-  make_shadow (shadow, region);
 
-  cairo_region_destroy (region);
+  *region = meta_window_shape_to_region (shape, center_width, center_height);
 
   if (cacheable)
     g_hash_table_insert (factory->shadows, &shadow->key, shadow);
@@ -991,6 +1234,165 @@ meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
   return shadow;
 }
 
+/**
+ * meta_shadow_factory_get_shadow:
+ * @factory: a #MetaShadowFactory
+ * @shape: the size-invariant shape of the window's region
+ * @width: the actual width of the window's region
+ * @height: the actual height of the window's region
+ * @class_name: name of the class of window shadows
+ * @focused: whether the shadow is for a focused window
+ *
+ * Gets the appropriate shadow object for drawing shadows for the
+ * specified window shape. The region that we are shadowing is specified
+ * as a combination of a size-invariant extracted shape and the size.
+ * In some cases, the same shadow object can be shared between sizes;
+ * in other cases a different shadow object is used for each size.
+ *
+ * Return value: (transfer full): a newly referenced #MetaShadow; unref with
+ *  meta_shadow_unref()
+ */
+MetaShadow *
+meta_shadow_factory_get_shadow (MetaShadowFactory *factory,
+                                MetaWindowShape   *shape,
+                                int                width,
+                                int                height,
+                                const char        *class_name,
+                                gboolean           focused)
+{
+  MetaShadow *shadow;
+  cairo_region_t *region;
+
+  g_return_val_if_fail (META_IS_SHADOW_FACTORY (factory), NULL);
+  g_return_val_if_fail (shape != NULL, NULL);
+
+  shadow = get_shadow_for_size (factory, shape, width, height,
+                                class_name, focused, &region);
+  if (region)
+    {
+      make_shadow (shadow, region);
+      cairo_region_destroy (region);
+    }
+
+  return shadow;
+}
+
+/**
+ * meta_shadow_factory_lookup_shadow:
+ * @factory: a #MetaShadowFactory
+ * @shape: the size-invariant shape of the window's region
+ * @width: the actual width of the window's region
+ * @height: the actual height of the window's region
+ * @class_name: name of the class of window shadows
+ * @focused: whether the shadow is for a focused window
+ *
+ * Like meta_shadow_factory_get_shadow(), but only returns shadows that
+ * can be painted right away, without blurring the shape first.
+ *
+ * Return value: (transfer full) (nullable): a newly referenced #MetaShadow,
+ *  or %NULL if the shadow still has to be created
+ */
+MetaShadow *
+meta_shadow_factory_lookup_shadow (MetaShadowFactory *factory,
+                                   MetaWindowShape   *shape,
+                                   int                width,
+                                   int                height,
+                                   const char        *class_name,
+                                   gboolean           focused)
+{
+  MetaShadow *shadow;
+  cairo_region_t *region;
+
+  g_return_val_if_fail (META_IS_SHADOW_FACTORY (factory), NULL);
+  g_return_val_if_fail (shape != NULL, NULL);
+
+  shadow = get_shadow_for_size (factory, shape, width, height,
+                                class_name, focused, &region);
+  if (region)
+    {
+      cairo_region_destroy (region);
+      meta_shadow_unref (shadow);
+      return NULL;
+    }
+
+  return shadow;
+}
+
+/**
+ * meta_shadow_factory_get_shadow_async:
+ * @factory: a #MetaShadowFactory
+ * @shape: the size-invariant shape of the window's region
+ * @width: the actual width of the window's region
+ * @height: the actual height of the window's region
+ * @class_name: name of the class of window shadows
+ * @focused: whether the shadow is for a focused window
+ * @cancellable: (nullable): a #GCancellable
+ * @callback: called once the shadow can be painted
+ * @user_data: data for @callback
+ *
+ * Like meta_shadow_factory_get_shadow(), but if the shadow has to be
+ * created, the shape is blurred in a thread rather than blocking the
+ * caller. Requests for a shadow that is already being blurred wait for
+ * the same blur.
+ */
+void
+meta_shadow_factory_get_shadow_async (MetaShadowFactory   *factory,
+                                      MetaWindowShape     *shape,
+                                      int                  width,
+                                      int                  height,
+                                      const char          *class_name,
+                                      gboolean             focused,
+                                      GCancellable        *cancellable,
+                                      GAsyncReadyCallback  callback,
+                                      gpointer             user_data)
+{
+  GTask *task;
+  MetaShadow *shadow;
+  cairo_region_t *region;
+
+  g_return_if_fail (META_IS_SHADOW_FACTORY (factory));
+  g_return_if_fail (shape != NULL);
+
+  task = g_task_new (factory, cancellable, callback, user_data);
+  g_task_set_source_tag (task, meta_shadow_factory_get_shadow_async);
+
+  shadow = get_shadow_for_size (factory, shape, width, height,
+                                class_name, focused, &region);
+  if (region)
+    {
+      make_shadow_async (shadow, region, task);
+      cairo_region_destroy (region);
+      meta_shadow_unref (shadow);
+    }
+  else
+    {
+      g_task_return_pointer (task, shadow,
+                             (GDestroyNotify) meta_shadow_unref);
+      g_object_unref (task);
+    }
+}
+
+/**
+ * meta_shadow_factory_get_shadow_finish:
+ * @factory: a #MetaShadowFactory
+ * @result: the #GAsyncResult passed to the callback
+ * @error: return location for a #GError
+ *
+ * Return value: (transfer full): a newly referenced #MetaShadow, or %NULL
+ *  if the request was cancelled
+ */
+MetaShadow *
+meta_shadow_factory_get_shadow_finish (MetaShadowFactory  *factory,
+                                       GAsyncResult       *result,
+                                       GError            **error)
+{
+  g_return_val_if_fail (g_task_is_valid (result, factory), NULL);
+  g_return_val_if_fail (g_task_get_source_tag (G_TASK (result)) ==
+                        meta_shadow_factory_get_shadow_async, NULL);
+
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
 /**
  * meta_shadow_factory_set_params:
  * @factory: a #MetaShadowFactory
@@ -60,6 +60,14 @@ enum
 
 static guint signals[LAST_SIGNAL];
 
+/* Limit to how many separate rectangles we'll draw; beyond this just
+ * fall back and draw the whole thing */
+#define MAX_RECTS 16
+
+/* Scaled down windows, as in an overview, don't need their mipmaps to
+ * follow updates faster than this */
+#define MIPMAP_MIN_REFRESH_INTERVAL_US (G_USEC_PER_SEC / 30)
+
 static CoglPipelineKey opaque_overlay_pipeline_key =
   "meta-shaped-texture-opaque-pipeline-key";
 static CoglPipelineKey blended_overlay_pipeline_key =
@@ -82,6 +90,11 @@ struct _MetaShapedTexture
   CoglPipeline *unblended_tower_pipeline;
 
   MetaTextureMipmap *texture_mipmap;
+  guint mipmap_refresh_id;
+
+  gboolean has_solid_color;
+  CoglColor solid_color;
+  CoglPipeline *solid_color_pipeline;
 
   gboolean is_y_inverted;
 
@@ -137,6 +150,8 @@ static void
 meta_shaped_texture_init (MetaShapedTexture *stex)
 {
   stex->texture_mipmap = meta_texture_mipmap_new ();
+  meta_texture_mipmap_set_min_refresh_interval (stex->texture_mipmap,
+                                                MIPMAP_MIN_REFRESH_INTERVAL_US);
   stex->buffer_scale = 1;
   stex->texture = NULL;
   stex->mask_texture = NULL;
@@ -231,6 +246,7 @@ meta_shaped_texture_reset_pipelines (MetaShapedTexture *stex)
   g_clear_pointer (&stex->masked_tower_pipeline, cogl_object_unref);
   g_clear_pointer (&stex->unblended_pipeline, cogl_object_unref);
   g_clear_pointer (&stex->unblended_tower_pipeline, cogl_object_unref);
+  g_clear_pointer (&stex->solid_color_pipeline, cogl_object_unref);
 }
 
 static void
@@ -238,6 +254,7 @@ meta_shaped_texture_dispose (GObject *object)
 {
   MetaShapedTexture *stex = (MetaShapedTexture *) object;
 
+  g_clear_handle_id (&stex->mipmap_refresh_id, g_source_remove);
   g_clear_pointer (&stex->texture_mipmap, meta_texture_mipmap_free);
 
   g_clear_pointer (&stex->texture, cogl_object_unref);
@@ -477,6 +494,16 @@ get_blended_overlay_pipeline (CoglContext *ctx)
   return pipeline;
 }
 
+static CoglPipeline *
+get_solid_color_pipeline (MetaShapedTexture *stex,
+                          CoglContext       *ctx)
+{
+  if (!stex->solid_color_pipeline)
+    stex->solid_color_pipeline = cogl_pipeline_new (ctx);
+
+  return stex->solid_color_pipeline;
+}
+
 static void
 paint_clipped_rectangle_node (MetaShapedTexture     *stex,
                               ClutterPaintNode      *root_node,
@@ -559,6 +586,113 @@ set_cogl_texture (MetaShapedTexture *stex,
   meta_texture_mipmap_invalidate (stex->texture_mipmap);
 }
 
+static gboolean
+on_mipmap_refresh_timeout (gpointer user_data)
+{
+  MetaShapedTexture *stex = user_data;
+
+  stex->mipmap_refresh_id = 0;
+  clutter_content_invalidate (CLUTTER_CONTENT (stex));
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+maybe_schedule_mipmap_refresh (MetaShapedTexture *stex)
+{
+  int64_t delay_us;
+
+  if (stex->mipmap_refresh_id)
+    return;
+
+  /* Paint again once the changes held back can be applied, in case nothing
+   * else causes a repaint by then.
+   */
+  if (!meta_texture_mipmap_get_refresh_delay (stex->texture_mipmap,
+                                              &delay_us))
+    return;
+
+  stex->mipmap_refresh_id = g_timeout_add ((delay_us + 999) / 1000,
+                                           on_mipmap_refresh_timeout,
+                                           stex);
+  g_source_set_name_by_id (stex->mipmap_refresh_id,
+                           "[mutter] on_mipmap_refresh_timeout");
+}
+
+static void
+do_paint_solid_color (MetaShapedTexture *stex,
+                      ClutterPaintNode  *root_node,
+                      ClutterActorBox   *alloc,
+                      uint8_t            opacity)
+{
+  g_autoptr (ClutterPaintNode) node = NULL;
+  cairo_rectangle_int_t content_rect;
+  CoglContext *ctx;
+  CoglPipeline *pipeline;
+  CoglColor color;
+  float alpha;
+
+  meta_shaped_texture_ensure_size_valid (stex);
+
+  if (stex->dst_width == 0 || stex->dst_height == 0)
+    return;
+
+  content_rect = (cairo_rectangle_int_t) {
+    .width = stex->dst_width,
+    .height = stex->dst_height,
+  };
+
+  /* The color is premultiplied, so the paint opacity applies to all
+   * channels. Without any texture layer, an opaque color is drawn without
+   * blending. */
+  alpha = opacity / 255.0f;
+  cogl_color_init_from_4f (&color,
+                           cogl_color_get_red (&stex->solid_color) * alpha,
+                           cogl_color_get_green (&stex->solid_color) * alpha,
+                           cogl_color_get_blue (&stex->solid_color) * alpha,
+                           cogl_color_get_alpha (&stex->solid_color) * alpha);
+
+  ctx = clutter_backend_get_cogl_context (clutter_get_default_backend ());
+  pipeline = get_solid_color_pipeline (stex, ctx);
+  cogl_pipeline_set_color (pipeline, &color);
+
+  node = clutter_pipeline_node_new (pipeline);
+  clutter_paint_node_set_static_name (node, "MetaShapedTexture (solid color)");
+  clutter_paint_node_add_child (root_node, node);
+
+  if (stex->clip_region &&
+      cairo_region_num_rectangles (stex->clip_region) <= MAX_RECTS)
+    {
+      float ratio_h, ratio_v;
+      int n_rects, i;
+
+      ratio_h = clutter_actor_box_get_width (alloc) / (float) stex->dst_width;
+      ratio_v = clutter_actor_box_get_height (alloc) / (float) stex->dst_height;
+
+      n_rects = cairo_region_num_rectangles (stex->clip_region);
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (stex->clip_region, i, &rect);
+          if (!meta_rectangle_intersect (&content_rect, &rect, &rect))
+            continue;
+
+          clutter_paint_node_add_rectangle (node,
+                                            &(ClutterActorBox) {
+                                              .x1 = alloc->x1 + rect.x * ratio_h,
+                                              .y1 = alloc->y1 + rect.y * ratio_v,
+                                              .x2 = alloc->x1 + (rect.x + rect.width) * ratio_h,
+                                              .y2 = alloc->y1 + (rect.y + rect.height) * ratio_v,
+                                            });
+        }
+    }
+  else
+    {
+      clutter_paint_node_add_rectangle (node, alloc);
+    }
+}
+
 static inline void
 flip_ints (int *x,
            int *y)
@@ -652,6 +786,8 @@ do_paint_content (MetaShapedTexture   *stex,
         {
           paint_tex = meta_texture_mipmap_get_paint_texture (stex->texture_mipmap);
           min_filter = COGL_PIPELINE_FILTER_LINEAR_MIPMAP_NEAREST;
+
+          maybe_schedule_mipmap_refresh (stex);
         }
     }
 
@@ -676,10 +812,6 @@ do_paint_content (MetaShapedTexture   *stex,
         blended_tex_region = NULL;
     }
 
-  /* Limit to how many separate rectangles we'll draw; beyond this just
-   * fall back and draw the whole thing */
-#define MAX_RECTS 16
-
   if (blended_tex_region)
     {
       int n_rects = cairo_region_num_rectangles (blended_tex_region);
@@ -866,7 +998,10 @@ meta_shaped_texture_paint_content (ClutterContent      *content,
   opacity = clutter_actor_get_paint_opacity (actor);
   clutter_actor_get_content_box (actor, &alloc);
 
-  do_paint_content (stex, root_node, paint_context, &alloc, opacity);
+  if (stex->has_solid_color && !stex->mask_texture)
+    do_paint_solid_color (stex, root_node, &alloc, opacity);
+  else
+    do_paint_content (stex, root_node, paint_context, &alloc, opacity);
 }
 
 static gboolean
@@ -952,6 +1087,7 @@ meta_shaped_texture_update_area (MetaShapedTexture     *stex,
 {
   MetaMonitorTransform inverted_transform;
   cairo_rectangle_int_t buffer_rect;
+  cairo_rectangle_int_t texture_area;
   int scaled_and_transformed_width;
   int scaled_and_transformed_height;
 
@@ -974,6 +1110,7 @@ meta_shaped_texture_update_area (MetaShapedTexture     *stex,
   };
 
   meta_rectangle_intersect (&buffer_rect, clip, clip);
+  texture_area = *clip;
 
   meta_rectangle_scale_double (clip,
                                1.0 / stex->buffer_scale,
@@ -1047,7 +1184,7 @@ meta_shaped_texture_update_area (MetaShapedTexture     *stex,
                                      clip);
     }
 
-  meta_texture_mipmap_invalidate (stex->texture_mipmap);
+  meta_texture_mipmap_invalidate_area (stex->texture_mipmap, &texture_area);
 
   return TRUE;
 }
@@ -1069,6 +1206,29 @@ meta_shaped_texture_set_texture (MetaShapedTexture *stex,
   set_cogl_texture (stex, texture);
 }
 
+/**
+ * meta_shaped_texture_set_solid_color: (skip)
+ * @stex: The #MetaShapedTexture
+ * @color: (nullable): The premultiplied color the texture consists of
+ *
+ * Lets @stex paint a plain rectangle of @color instead of sampling its
+ * texture, e.g. for single pixel buffers.
+ */
+void
+meta_shaped_texture_set_solid_color (MetaShapedTexture *stex,
+                                     const CoglColor   *color)
+{
+  if (color)
+    {
+      stex->has_solid_color = TRUE;
+      stex->solid_color = *color;
+    }
+  else
+    {
+      stex->has_solid_color = FALSE;
+    }
+}
+
 /**
  * meta_shaped_texture_set_is_y_inverted: (skip)
  */
@@ -1149,6 +1309,9 @@ meta_shaped_texture_has_alpha (MetaShapedTexture *stex)
   if (!texture)
     return TRUE;
 
+  if (stex->has_solid_color)
+    return cogl_color_get_alpha (&stex->solid_color) < 1.0f;
+
   switch (cogl_texture_get_components (texture))
     {
     case COGL_TEXTURE_COMPONENTS_A:
@@ -163,6 +163,34 @@ meta_surface_actor_wayland_is_view_primary (MetaSurfaceActor *actor,
   return current_primary_view == stage_view;
 }
 
+/* Whether no stage view is primary for the surface, i.e. whether it
+ * is not on any view or culling found it to be fully obscured on all
+ * of them. Such surfaces don't get their frame callbacks emitted
+ * after stage updates. */
+gboolean
+meta_surface_actor_wayland_is_hidden (MetaSurfaceActor *actor)
+{
+  MetaWindowActor *window_actor;
+  GList *l;
+
+  if (clutter_actor_has_mapped_clones (CLUTTER_ACTOR (actor)))
+    return FALSE;
+
+  window_actor = meta_window_actor_from_actor (CLUTTER_ACTOR (actor));
+  if (window_actor && meta_window_actor_is_streaming (window_actor))
+    return FALSE;
+
+  for (l = clutter_actor_peek_stage_views (CLUTTER_ACTOR (actor)); l; l = l->next)
+    {
+      ClutterStageView *view = l->data;
+
+      if (!meta_surface_actor_is_obscured_on_stage_view (actor, view, NULL))
+        return FALSE;
+    }
+
+  return TRUE;
+}
+
 static void
 meta_surface_actor_wayland_apply_transform (ClutterActor      *actor,
                                             graphene_matrix_t *matrix)
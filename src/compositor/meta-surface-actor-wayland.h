@@ -47,6 +47,8 @@ void meta_surface_actor_wayland_surface_destroyed (MetaSurfaceActorWayland *self
 gboolean meta_surface_actor_wayland_is_view_primary (MetaSurfaceActor *actor,
                                                      ClutterStageView *stage_view);
 
+gboolean meta_surface_actor_wayland_is_hidden (MetaSurfaceActor *actor);
+
 G_END_DECLS
 
 #endif /* __META_SURFACE_ACTOR_WAYLAND_H__ */
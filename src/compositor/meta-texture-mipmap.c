@@ -29,6 +29,10 @@
 #include <math.h>
 #include <string.h>
 
+/* Limit to how many separate damage rectangles we'll redraw; beyond this
+ * just redraw their extents */
+#define MAX_DAMAGE_RECTS 16
+
 struct _MetaTextureMipmap
 {
   CoglTexture *base_texture;
@@ -36,6 +40,12 @@ struct _MetaTextureMipmap
   CoglPipeline *pipeline;
   CoglFramebuffer *fb;
   gboolean invalid;
+
+  /* Damage of the base texture since the last refresh, when not invalid */
+  cairo_region_t *damage;
+
+  int64_t min_refresh_interval_us;
+  int64_t last_refresh_us;
 };
 
 /**
@@ -71,10 +81,29 @@ meta_texture_mipmap_free (MetaTextureMipmap *mipmap)
   cogl_clear_object (&mipmap->base_texture);
   cogl_clear_object (&mipmap->mipmap_texture);
   g_clear_object (&mipmap->fb);
+  g_clear_pointer (&mipmap->damage, cairo_region_destroy);
 
   g_free (mipmap);
 }
 
+/**
+ * meta_texture_mipmap_set_min_refresh_interval:
+ * @mipmap: a #MetaTextureMipmap
+ * @interval_us: the minimum time between refreshes, or 0 for no limit
+ *
+ * Limits how often the scaled down texture is refreshed from the base
+ * texture; changes coming in faster than that are accumulated and applied
+ * together, see meta_texture_mipmap_get_refresh_delay().
+ */
+void
+meta_texture_mipmap_set_min_refresh_interval (MetaTextureMipmap *mipmap,
+                                              int64_t            interval_us)
+{
+  g_return_if_fail (mipmap != NULL);
+
+  mipmap->min_refresh_interval_us = interval_us;
+}
+
 /**
  * meta_texture_mipmap_set_base_texture:
  * @mipmap: a #MetaTextureMipmap
@@ -101,7 +130,7 @@ meta_texture_mipmap_set_base_texture (MetaTextureMipmap *mipmap,
   if (mipmap->base_texture != NULL)
     {
       cogl_object_ref (mipmap->base_texture);
-      mipmap->invalid = TRUE;
+      meta_texture_mipmap_invalidate (mipmap);
     }
 }
 
@@ -111,6 +140,45 @@ meta_texture_mipmap_invalidate (MetaTextureMipmap *mipmap)
   g_return_if_fail (mipmap != NULL);
 
   mipmap->invalid = TRUE;
+  g_clear_pointer (&mipmap->damage, cairo_region_destroy);
+}
+
+/**
+ * meta_texture_mipmap_invalidate_area:
+ * @mipmap: a #MetaTextureMipmap
+ * @area: the changed area, in base texture coordinates
+ *
+ * Marks an area of the base texture as changed, so that only the
+ * corresponding part of the scaled down texture is redrawn.
+ */
+void
+meta_texture_mipmap_invalidate_area (MetaTextureMipmap           *mipmap,
+                                     const cairo_rectangle_int_t *area)
+{
+  g_return_if_fail (mipmap != NULL);
+
+  /* Without a scaled down texture, the next one is drawn in full anyway */
+  if (mipmap->invalid || !mipmap->mipmap_texture)
+    return;
+
+  if (!mipmap->damage)
+    {
+      mipmap->damage = cairo_region_create_rectangle (area);
+      return;
+    }
+
+  cairo_region_union_rectangle (mipmap->damage, area);
+
+  /* The texture may not be painted again for a long time, so don't let
+   * the region grow with every change meanwhile */
+  if (cairo_region_num_rectangles (mipmap->damage) > MAX_DAMAGE_RECTS)
+    {
+      cairo_rectangle_int_t extents;
+
+      cairo_region_get_extents (mipmap->damage, &extents);
+      cairo_region_destroy (mipmap->damage);
+      mipmap->damage = cairo_region_create_rectangle (&extents);
+    }
 }
 
 static void
@@ -118,6 +186,7 @@ free_mipmaps (MetaTextureMipmap *mipmap)
 {
   g_clear_object (&mipmap->fb);
   cogl_clear_object (&mipmap->mipmap_texture);
+  g_clear_pointer (&mipmap->damage, cairo_region_destroy);
 }
 
 void
@@ -128,12 +197,83 @@ meta_texture_mipmap_clear (MetaTextureMipmap *mipmap)
   free_mipmaps (mipmap);
 }
 
+static void
+add_damage_rectangle (float                       *coords,
+                      const cairo_rectangle_int_t *rect,
+                      int                          base_width,
+                      int                          base_height,
+                      int                          width,
+                      int                          height)
+{
+  int x1, y1, x2, y2;
+
+  /* The scaled down pixels sampling the damaged ones, padded by one for
+   * the linear filtering and for odd base texture sizes.
+   */
+  x1 = CLAMP (((int64_t) rect->x * width) / base_width - 1, 0, width);
+  y1 = CLAMP (((int64_t) rect->y * height) / base_height - 1, 0, height);
+  x2 = CLAMP (((int64_t) (rect->x + rect->width) * width + base_width - 1) /
+              base_width + 1, 0, width);
+  y2 = CLAMP (((int64_t) (rect->y + rect->height) * height + base_height - 1) /
+              base_height + 1, 0, height);
+
+  /* Same texture coordinates as when drawing the whole texture, so the
+   * refreshed pixels come out exactly the same.
+   */
+  coords[0] = x1;
+  coords[1] = y1;
+  coords[2] = x2;
+  coords[3] = y2;
+  coords[4] = (float) x1 / width;
+  coords[5] = (float) y1 / height;
+  coords[6] = (float) x2 / width;
+  coords[7] = (float) y2 / height;
+}
+
+static void
+draw_damage (MetaTextureMipmap *mipmap,
+             int                width,
+             int                height)
+{
+  int base_width = cogl_texture_get_width (mipmap->base_texture);
+  int base_height = cogl_texture_get_height (mipmap->base_texture);
+  float coords[MAX_DAMAGE_RECTS * 8];
+  int n_rects, i;
+
+  n_rects = cairo_region_num_rectangles (mipmap->damage);
+  if (n_rects > MAX_DAMAGE_RECTS)
+    {
+      cairo_rectangle_int_t extents;
+
+      cairo_region_get_extents (mipmap->damage, &extents);
+      add_damage_rectangle (coords, &extents,
+                            base_width, base_height, width, height);
+      n_rects = 1;
+    }
+  else
+    {
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t rect;
+
+          cairo_region_get_rectangle (mipmap->damage, i, &rect);
+          add_damage_rectangle (&coords[i * 8], &rect,
+                                base_width, base_height, width, height);
+        }
+    }
+
+  cogl_framebuffer_draw_textured_rectangles (mipmap->fb,
+                                             mipmap->pipeline,
+                                             coords, n_rects);
+}
+
 static void
 ensure_mipmap_texture (MetaTextureMipmap *mipmap)
 {
   CoglContext *ctx =
     clutter_backend_get_cogl_context (clutter_get_default_backend ());
   int width, height;
+  int64_t now_us;
 
   /* Let's avoid spending any texture memory copying the base level texture
    * because we'll never need that one and it would have used most of the
@@ -192,28 +332,81 @@ ensure_mipmap_texture (MetaTextureMipmap *mipmap)
       cogl_framebuffer_orthographic (mipmap->fb,
                                      0, 0, width, height, -1.0, 1.0);
 
-      mipmap->invalid = TRUE;
+      meta_texture_mipmap_invalidate (mipmap);
+      mipmap->last_refresh_us = 0;
     }
 
-  if (mipmap->invalid)
+  if (!mipmap->invalid && !mipmap->damage)
+    return;
+
+  /* Windows updating continuously, e.g. playing a video, would otherwise
+   * get the texture redrawn on every commit even though it is only shown
+   * scaled down, so hold on to the changes for a bit.
+   */
+  now_us = g_get_monotonic_time ();
+  if (now_us - mipmap->last_refresh_us < mipmap->min_refresh_interval_us)
+    return;
+
+  if (!mipmap->pipeline)
     {
-      if (!mipmap->pipeline)
-        {
-          mipmap->pipeline = cogl_pipeline_new (ctx);
-          cogl_pipeline_set_blend (mipmap->pipeline, "RGBA = ADD (SRC_COLOR, 0)", NULL);
-          cogl_pipeline_set_layer_filters (mipmap->pipeline, 0,
-                                           COGL_PIPELINE_FILTER_LINEAR,
-                                           COGL_PIPELINE_FILTER_LINEAR);
-        }
+      mipmap->pipeline = cogl_pipeline_new (ctx);
+      cogl_pipeline_set_blend (mipmap->pipeline, "RGBA = ADD (SRC_COLOR, 0)", NULL);
+      cogl_pipeline_set_layer_filters (mipmap->pipeline, 0,
+                                       COGL_PIPELINE_FILTER_LINEAR,
+                                       COGL_PIPELINE_FILTER_LINEAR);
+    }
+
+  cogl_pipeline_set_layer_texture (mipmap->pipeline, 0, mipmap->base_texture);
 
-      cogl_pipeline_set_layer_texture (mipmap->pipeline, 0, mipmap->base_texture);
+  /* Only level 0 of the scaled down texture is drawn here; drawing to it
+   * marks the levels below outdated, and they are regenerated from it on
+   * the GPU the next time it's painted with a mipmap filter.
+   */
+  if (mipmap->invalid)
+    {
       cogl_framebuffer_draw_textured_rectangle (mipmap->fb,
                                                 mipmap->pipeline,
                                                 0, 0, width, height,
                                                 0.0, 0.0, 1.0, 1.0);
-
-      mipmap->invalid = FALSE;
     }
+  else
+    {
+      draw_damage (mipmap, width, height);
+    }
+
+  mipmap->invalid = FALSE;
+  g_clear_pointer (&mipmap->damage, cairo_region_destroy);
+  mipmap->last_refresh_us = now_us;
+}
+
+/**
+ * meta_texture_mipmap_get_refresh_delay:
+ * @mipmap: a #MetaTextureMipmap
+ * @delay_us: (out): return location for the time until the scaled down
+ *   texture may be refreshed
+ *
+ * Gets whether the texture last returned by
+ * meta_texture_mipmap_get_paint_texture() is outdated because its refresh
+ * was held back by the minimum refresh interval.
+ *
+ * Return value: %TRUE if a refresh is pending
+ */
+gboolean
+meta_texture_mipmap_get_refresh_delay (MetaTextureMipmap *mipmap,
+                                       int64_t           *delay_us)
+{
+  g_return_val_if_fail (mipmap != NULL, FALSE);
+
+  if (!mipmap->mipmap_texture)
+    return FALSE;
+
+  if (!mipmap->invalid && !mipmap->damage)
+    return FALSE;
+
+  *delay_us = MAX (0, (mipmap->last_refresh_us +
+                       mipmap->min_refresh_interval_us -
+                       g_get_monotonic_time ()));
+  return TRUE;
 }
 
 /**
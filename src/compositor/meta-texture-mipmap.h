@@ -24,6 +24,7 @@
 #define META_TEXTURE_MIPMAP_H
 
 #include "clutter/clutter.h"
+#include "core/util-private.h"
 
 G_BEGIN_DECLS
 
@@ -37,17 +38,34 @@ G_BEGIN_DECLS
 
 typedef struct _MetaTextureMipmap MetaTextureMipmap;
 
+META_EXPORT_TEST
 MetaTextureMipmap *meta_texture_mipmap_new (void);
 
+META_EXPORT_TEST
 void meta_texture_mipmap_free (MetaTextureMipmap *mipmap);
 
+META_EXPORT_TEST
+void meta_texture_mipmap_set_min_refresh_interval (MetaTextureMipmap *mipmap,
+                                                   int64_t            interval_us);
+
+META_EXPORT_TEST
 void meta_texture_mipmap_set_base_texture (MetaTextureMipmap *mipmap,
                                            CoglTexture *texture);
 
+META_EXPORT_TEST
 CoglTexture *meta_texture_mipmap_get_paint_texture (MetaTextureMipmap *mipmap);
 
+META_EXPORT_TEST
+gboolean meta_texture_mipmap_get_refresh_delay (MetaTextureMipmap *mipmap,
+                                                int64_t           *delay_us);
+
+META_EXPORT_TEST
 void meta_texture_mipmap_invalidate (MetaTextureMipmap *mipmap);
 
+META_EXPORT_TEST
+void meta_texture_mipmap_invalidate_area (MetaTextureMipmap           *mipmap,
+                                          const cairo_rectangle_int_t *area);
+
 void meta_texture_mipmap_clear (MetaTextureMipmap *mipmap);
 
 G_END_DECLS
@@ -28,6 +28,7 @@
 #include "clutter/clutter-frame-clock.h"
 #include "compositor/compositor-private.h"
 #include "compositor/meta-cullable.h"
+#include "compositor/meta-shadow-factory-private.h"
 #include "compositor/meta-shaped-texture-private.h"
 #include "compositor/meta-surface-actor.h"
 #include "compositor/meta-surface-actor-x11.h"
@@ -36,7 +37,6 @@
 #include "core/window-private.h"
 #include "meta/compositor.h"
 #include "meta/meta-enum-types.h"
-#include "meta/meta-shadow-factory.h"
 #include "meta/meta-window-actor.h"
 #include "meta/meta-x11-errors.h"
 #include "meta/window.h"
@@ -74,9 +74,14 @@ struct _MetaWindowActorX11
    * recompute_unfocused_shadow.) Because of our extraction of
    * size-invariant window shape, we'll often find that the new shadow
    * is the same as the old shadow.
+   *
+   * Shadows that still have to be blurred are requested asynchronously;
+   * until they are ready, the old ones keep being painted.
    */
   MetaShadow *focused_shadow;
   MetaShadow *unfocused_shadow;
+  GCancellable *focused_shadow_cancellable;
+  GCancellable *unfocused_shadow_cancellable;
 
   /* A region that matches the shape of the window, including frame bounds */
   cairo_region_t *shape_region;
@@ -617,13 +622,81 @@ set_clip_region_beneath (MetaWindowActorX11 *actor_x11,
     }
 }
 
+static void
+set_shadow (MetaWindowActorX11 *actor_x11,
+            gboolean            appears_focused,
+            MetaShadow         *shadow)
+{
+  if (appears_focused)
+    {
+      g_clear_object (&actor_x11->focused_shadow_cancellable);
+      g_clear_pointer (&actor_x11->focused_shadow, meta_shadow_unref);
+      actor_x11->focused_shadow = shadow;
+    }
+  else
+    {
+      g_clear_object (&actor_x11->unfocused_shadow_cancellable);
+      g_clear_pointer (&actor_x11->unfocused_shadow, meta_shadow_unref);
+      actor_x11->unfocused_shadow = shadow;
+    }
+
+  if (meta_window_actor_is_frozen (META_WINDOW_ACTOR (actor_x11)))
+    return;
+
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (actor_x11));
+  clutter_actor_invalidate_paint_volume (CLUTTER_ACTOR (actor_x11));
+}
+
+static void
+on_focused_shadow_ready (GObject      *source_object,
+                         GAsyncResult *result,
+                         gpointer      user_data)
+{
+  MetaShadow *shadow;
+
+  /* This only fails if the request was cancelled, in which case the
+   * actor may be gone already */
+  shadow = meta_shadow_factory_get_shadow_finish (META_SHADOW_FACTORY (source_object),
+                                                  result, NULL);
+  if (!shadow)
+    return;
+
+  set_shadow (META_WINDOW_ACTOR_X11 (user_data), TRUE, shadow);
+}
+
+static void
+on_unfocused_shadow_ready (GObject      *source_object,
+                           GAsyncResult *result,
+                           gpointer      user_data)
+{
+  MetaShadow *shadow;
+
+  shadow = meta_shadow_factory_get_shadow_finish (META_SHADOW_FACTORY (source_object),
+                                                  result, NULL);
+  if (!shadow)
+    return;
+
+  set_shadow (META_WINDOW_ACTOR_X11 (user_data), FALSE, shadow);
+}
+
+static void
+cancel_shadow_request (GCancellable **cancellable)
+{
+  if (*cancellable)
+    {
+      g_cancellable_cancel (*cancellable);
+      g_clear_object (cancellable);
+    }
+}
+
 static void
 check_needs_shadow (MetaWindowActorX11 *actor_x11)
 {
   MetaWindow *window =
     meta_window_actor_get_meta_window (META_WINDOW_ACTOR (actor_x11));
-  MetaShadow *old_shadow = NULL;
   MetaShadow **shadow_location;
+  GCancellable **cancellable_location;
+  GAsyncReadyCallback shadow_ready;
   gboolean recompute_shadow;
   gboolean should_have_shadow;
   gboolean appears_focused;
@@ -643,28 +716,32 @@ check_needs_shadow (MetaWindowActorX11 *actor_x11)
       recompute_shadow = actor_x11->recompute_focused_shadow;
       actor_x11->recompute_focused_shadow = FALSE;
       shadow_location = &actor_x11->focused_shadow;
+      cancellable_location = &actor_x11->focused_shadow_cancellable;
+      shadow_ready = on_focused_shadow_ready;
     }
   else
     {
       recompute_shadow = actor_x11->recompute_unfocused_shadow;
       actor_x11->recompute_unfocused_shadow = FALSE;
       shadow_location = &actor_x11->unfocused_shadow;
+      cancellable_location = &actor_x11->unfocused_shadow_cancellable;
+      shadow_ready = on_unfocused_shadow_ready;
     }
 
-  if (!should_have_shadow || recompute_shadow)
+  if (!should_have_shadow)
     {
-      if (*shadow_location != NULL)
-        {
-          old_shadow = *shadow_location;
-          *shadow_location = NULL;
-        }
+      cancel_shadow_request (cancellable_location);
+      g_clear_pointer (shadow_location, meta_shadow_unref);
+      return;
     }
 
-  if (!*shadow_location && should_have_shadow)
+  /* The old shadow, if any, is only replaced once the new one is ready */
+  if (recompute_shadow || (!*shadow_location && !*cancellable_location))
     {
       MetaShadowFactory *factory = actor_x11->shadow_factory;
       const char *shadow_class = get_shadow_class (actor_x11);
       cairo_rectangle_int_t shape_bounds;
+      MetaShadow *shadow;
 
       if (!actor_x11->shadow_shape)
         {
@@ -672,16 +749,34 @@ check_needs_shadow (MetaWindowActorX11 *actor_x11)
             meta_window_shape_new (actor_x11->shape_region);
         }
 
+      cancel_shadow_request (cancellable_location);
+
+      /* Shadows that are already blurred, e.g. the ones of other windows
+       * of the same shape, can be painted with this very frame */
       get_shape_bounds (actor_x11, &shape_bounds);
-      *shadow_location =
-        meta_shadow_factory_get_shadow (factory,
-                                        actor_x11->shadow_shape,
-                                        shape_bounds.width, shape_bounds.height,
-                                        shadow_class, appears_focused);
-    }
+      shadow = meta_shadow_factory_lookup_shadow (factory,
+                                                  actor_x11->shadow_shape,
+                                                  shape_bounds.width,
+                                                  shape_bounds.height,
+                                                  shadow_class,
+                                                  appears_focused);
+      if (shadow)
+        {
+          g_clear_pointer (shadow_location, meta_shadow_unref);
+          *shadow_location = shadow;
+          return;
+        }
 
-  if (old_shadow)
-    meta_shadow_unref (old_shadow);
+      *cancellable_location = g_cancellable_new ();
+      meta_shadow_factory_get_shadow_async (factory,
+                                            actor_x11->shadow_shape,
+                                            shape_bounds.width,
+                                            shape_bounds.height,
+                                            shadow_class, appears_focused,
+                                            *cancellable_location,
+                                            shadow_ready,
+                                            actor_x11);
+    }
 }
 
 void
@@ -1561,6 +1656,8 @@ meta_window_actor_x11_dispose (GObject *object)
   g_clear_pointer (&actor_x11->frame_bounds, cairo_region_destroy);
 
   g_clear_pointer (&actor_x11->shadow_class, g_free);
+  cancel_shadow_request (&actor_x11->focused_shadow_cancellable);
+  cancel_shadow_request (&actor_x11->unfocused_shadow_cancellable);
   g_clear_pointer (&actor_x11->focused_shadow, meta_shadow_unref);
   g_clear_pointer (&actor_x11->unfocused_shadow, meta_shadow_unref);
   g_clear_pointer (&actor_x11->shadow_shape, meta_window_shape_unref);
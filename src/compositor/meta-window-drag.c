@@ -30,6 +30,10 @@
 #include "meta/meta-enum-types.h"
 #include "x11/window-x11.h"
 
+#ifdef HAVE_WAYLAND
+#include "wayland/meta-window-wayland.h"
+#endif
+
 enum {
   PROP_0,
   PROP_WINDOW,
@@ -1495,6 +1499,15 @@ update_resize (MetaWindowDrag          *window_drag,
       meta_window_x11_is_awaiting_sync_response (window))
     return;
 
+#ifdef HAVE_WAYLAND
+  /* Likewise, Wayland clients get the next resizing configuration once they
+   * acked and committed the previous one.
+   */
+  if (window->client_type == META_WINDOW_CLIENT_TYPE_WAYLAND &&
+      meta_window_wayland_is_awaiting_resize_ack (META_WINDOW_WAYLAND (window)))
+    return;
+#endif
+
   meta_window_get_frame_rect (window, &old_rect);
 
   /* One sided resizing ought to actually be one-sided, despite the fact that
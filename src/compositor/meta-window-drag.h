@@ -22,6 +22,7 @@
 #ifndef META_WINDOW_DRAG_H
 #define META_WINDOW_DRAG_H
 
+#include "core/util-private.h"
 #include "meta/common.h"
 #include "meta/window.h"
 
@@ -37,6 +38,7 @@ gboolean meta_window_drag_begin (MetaWindowDrag       *drag,
                                  ClutterEventSequence *sequence,
                                  uint32_t              timestamp);
 
+META_EXPORT_TEST
 void meta_window_drag_end (MetaWindowDrag *drag);
 
 void meta_window_drag_update_resize (MetaWindowDrag *drag);
@@ -473,6 +473,40 @@ meta_region_to_cairo_path (cairo_region_t *region,
     }
 }
 
+/**
+ * meta_matrix_is_integer_translation:
+ * @matrix: a #graphene_matrix_t
+ * @out_x: (out): return location for the horizontal offset
+ * @out_y: (out): return location for the vertical offset
+ *
+ * Checks whether @matrix only translates by whole pixels, which is the
+ * case for most actors, since their allocation origin is part of their
+ * transform. Regions can be moved through such a transform in place,
+ * without rebuilding them.
+ *
+ * Return value: %TRUE if @matrix is an integer translation
+ */
+gboolean
+meta_matrix_is_integer_translation (const graphene_matrix_t *matrix,
+                                    int                     *out_x,
+                                    int                     *out_y)
+{
+  double xx, yx, xy, yy, x0, y0;
+
+  if (!graphene_matrix_to_2d (matrix, &xx, &yx, &xy, &yy, &x0, &y0))
+    return FALSE;
+
+  if (xx != 1.0 || yy != 1.0 || yx != 0.0 || xy != 0.0)
+    return FALSE;
+
+  if (x0 != floor (x0) || y0 != floor (y0))
+    return FALSE;
+
+  *out_x = (int) x0;
+  *out_y = (int) y0;
+  return TRUE;
+}
+
 cairo_region_t *
 meta_region_apply_matrix_transform_expand (const cairo_region_t *region,
                                            graphene_matrix_t    *transform)
@@ -480,12 +514,54 @@ meta_region_apply_matrix_transform_expand (const cairo_region_t *region,
   int n_rects, i;
   cairo_rectangle_int_t *rects;
   cairo_region_t *transformed_region;
+  double xx, yx, xy, yy, x0, y0;
+  int x_offset, y_offset;
 
   if (graphene_matrix_is_identity (transform))
     return cairo_region_copy (region);
 
+  if (meta_matrix_is_integer_translation (transform, &x_offset, &y_offset))
+    {
+      transformed_region = cairo_region_copy (region);
+      cairo_region_translate (transformed_region, x_offset, y_offset);
+      return transformed_region;
+    }
+
   n_rects = cairo_region_num_rectangles (region);
   META_REGION_CREATE_RECTANGLE_ARRAY_SCOPED (n_rects, rects);
+
+  if (graphene_matrix_to_2d (transform, &xx, &yx, &xy, &yy, &x0, &y0) &&
+      yx == 0.0 && xy == 0.0)
+    {
+      /* Scaling and translating keeps rectangles axis aligned, so the
+       * bounds only need the two corners. The float math matches what
+       * graphene_matrix_transform_bounds() does, so the result is the
+       * same as in the generic path below. */
+      for (i = 0; i < n_rects; i++)
+        {
+          cairo_rectangle_int_t int_rect;
+          graphene_rect_t transformed_rect;
+          float x1, y1, x2, y2;
+
+          cairo_region_get_rectangle (region, i, &int_rect);
+
+          x1 = (float) int_rect.x * (float) xx + (float) x0;
+          x2 = (float) (int_rect.x + int_rect.width) * (float) xx + (float) x0;
+          y1 = (float) int_rect.y * (float) yy + (float) y0;
+          y2 = (float) (int_rect.y + int_rect.height) * (float) yy + (float) y0;
+
+          graphene_rect_init (&transformed_rect,
+                              MIN (x1, x2), MIN (y1, y2),
+                              fabsf (x2 - x1), fabsf (y2 - y1));
+
+          meta_rectangle_from_graphene_rect (&transformed_rect,
+                                             META_ROUNDING_STRATEGY_GROW,
+                                             &rects[i]);
+        }
+
+      return cairo_region_create_rectangles (rects, n_rects);
+    }
+
   for (i = 0; i < n_rects; i++)
     {
       graphene_rect_t transformed_rect, rect;
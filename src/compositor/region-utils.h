@@ -101,6 +101,7 @@ cairo_region_t * meta_region_scale_double (cairo_region_t       *region,
                                            double                scale,
                                            MetaRoundingStrategy  rounding_strategy);
 
+META_EXPORT_TEST
 cairo_region_t * meta_make_border_region (cairo_region_t *region,
                                           int             x_amount,
                                           int             y_amount,
@@ -119,8 +120,14 @@ cairo_region_t * meta_region_crop_and_scale (cairo_region_t  *region,
 void meta_region_to_cairo_path (cairo_region_t *region,
                                 cairo_t        *cr);
 
+META_EXPORT_TEST
 cairo_region_t *
 meta_region_apply_matrix_transform_expand (const cairo_region_t *region,
                                            graphene_matrix_t    *transform);
 
+META_EXPORT_TEST
+gboolean meta_matrix_is_integer_translation (const graphene_matrix_t *matrix,
+                                             int                     *out_x,
+                                             int                     *out_y);
+
 #endif /* __META_REGION_UTILS_H__ */
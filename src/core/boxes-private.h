@@ -279,6 +279,7 @@ void meta_rectangle_transform (const MetaRectangle  *rect,
                                int                   height,
                                MetaRectangle        *dest);
 
+META_EXPORT_TEST
 void meta_rectangle_from_graphene_rect (const graphene_rect_t *rect,
                                         MetaRoundingStrategy   rounding_strategy,
                                         MetaRectangle         *dest);
@@ -289,4 +290,41 @@ void meta_rectangle_crop_and_scale (const MetaRectangle *rect,
                                     int                  dst_height,
                                     MetaRectangle       *dest);
 
+/* An implicit binary tree over an array of rectangles, in the order they
+ * were given, where every node holds the bounding box of the rectangles
+ * below it. Searches for overlapping rectangles skip whole ranges of
+ * rectangles that can't overlap the one searched for.
+ */
+typedef struct _MetaRectangleTree MetaRectangleTree;
+
+META_EXPORT_TEST
+MetaRectangleTree * meta_rectangle_tree_new (const MetaRectangle *rects,
+                                             int                  n_rects);
+
+META_EXPORT_TEST
+void meta_rectangle_tree_free (MetaRectangleTree *tree);
+
+META_EXPORT_TEST
+int meta_rectangle_tree_find_overlap (const MetaRectangleTree *tree,
+                                      int                      from,
+                                      gboolean                 forward,
+                                      const MetaRectangle     *rect,
+                                      MetaDirection            directions);
+
+/* A static set of rectangles that can quickly be queried for whether any
+ * of them overlaps a given rectangle.
+ */
+typedef struct _MetaRectangleIndex MetaRectangleIndex;
+
+META_EXPORT_TEST
+MetaRectangleIndex * meta_rectangle_index_new (const MetaRectangle *rects,
+                                               int                  n_rects);
+
+META_EXPORT_TEST
+void meta_rectangle_index_free (MetaRectangleIndex *index);
+
+META_EXPORT_TEST
+gboolean meta_rectangle_index_overlaps (const MetaRectangleIndex *index,
+                                        const MetaRectangle      *rect);
+
 #endif /* META_BOXES_PRIVATE_H */
@@ -28,6 +28,7 @@
 #include "core/boxes-private.h"
 
 #include <math.h>
+#include <stdlib.h>
 
 #include "meta/util.h"
 
@@ -413,116 +414,6 @@ meta_rectangle_resize_with_gravity (const MetaRectangle *old_rect,
   rect->height = new_height;
 }
 
-/* Not so simple helper function for get_minimal_spanning_set_for_region() */
-static GList*
-merge_spanning_rects_in_region (GList *region)
-{
-  /* NOTE FOR ANY OPTIMIZATION PEOPLE OUT THERE: Please see the
-   * documentation of get_minimal_spanning_set_for_region() for performance
-   * considerations that also apply to this function.
-   */
-
-  GList *compare;
-  compare = region;
-
-  if (region == NULL)
-    {
-      g_warning ("Region to merge was empty! Either you have some "
-                 "pathological STRUT list or there's a bug somewhere!");
-      return NULL;
-    }
-
-  while (compare && compare->next)
-    {
-      MetaRectangle *a = compare->data;
-      GList *other = compare->next;
-
-      g_assert (a->width > 0 && a->height > 0);
-
-      while (other)
-        {
-          MetaRectangle *b = other->data;
-          GList *delete_me = NULL;
-
-          g_assert (b->width > 0 && b->height > 0);
-
-          /* If a contains b, just remove b */
-          if (meta_rectangle_contains_rect (a, b))
-            {
-              delete_me = other;
-            }
-          /* If b contains a, just remove a */
-          else if (meta_rectangle_contains_rect (b, a))
-            {
-              delete_me = compare;
-            }
-          /* If a and b might be mergeable horizontally */
-          else if (a->y == b->y && a->height == b->height)
-            {
-              /* If a and b overlap */
-              if (meta_rectangle_overlap (a, b))
-                {
-                  int new_x = MIN (a->x, b->x);
-                  a->width = MAX (a->x + a->width, b->x + b->width) - new_x;
-                  a->x = new_x;
-                  delete_me = other;
-                }
-              /* If a and b are adjacent */
-              else if (a->x + a->width == b->x || a->x == b->x + b->width)
-                {
-                  int new_x = MIN (a->x, b->x);
-                  a->width = MAX (a->x + a->width, b->x + b->width) - new_x;
-                  a->x = new_x;
-                  delete_me = other;
-                }
-            }
-          /* If a and b might be mergeable vertically */
-          else if (a->x == b->x && a->width == b->width)
-            {
-              /* If a and b overlap */
-              if (meta_rectangle_overlap (a, b))
-                {
-                  int new_y = MIN (a->y, b->y);
-                  a->height = MAX (a->y + a->height, b->y + b->height) - new_y;
-                  a->y = new_y;
-                  delete_me = other;
-                }
-              /* If a and b are adjacent */
-              else if (a->y + a->height == b->y || a->y == b->y + b->height)
-                {
-                  int new_y = MIN (a->y, b->y);
-                  a->height = MAX (a->y + a->height, b->y + b->height) - new_y;
-                  a->y = new_y;
-                  delete_me = other;
-                }
-            }
-
-          other = other->next;
-
-          /* Delete any rectangle in the list that is no longer wanted */
-          if (delete_me != NULL)
-            {
-              /* Deleting the rect we compare others to is a little tricker */
-              if (compare == delete_me)
-                {
-                  compare = compare->next;
-                  other = compare->next;
-                  a = compare->data;
-                }
-
-              /* Okay, we can free it now */
-              g_free (delete_me->data);
-              region = g_list_delete_link (region, delete_me);
-            }
-
-        }
-
-      compare = compare->next;
-    }
-
-  return region;
-}
-
 /* Simple helper function for get_minimal_spanning_set_for_region()... */
 static gint
 compare_rect_areas (gconstpointer a, gconstpointer b)
@@ -556,6 +447,37 @@ check_strut_align (MetaStrut *strut, const MetaRectangle *rect)
     }
 }
 
+/* ... and one which drops the rectangles that are already covered by
+ * another rectangle of the set, so that the set stays minimal.
+ */
+static void
+remove_covered_rects (GArray *rects)
+{
+  unsigned int i, j;
+
+  i = 0;
+  while (i < rects->len)
+    {
+      MetaRectangle *rect = &g_array_index (rects, MetaRectangle, i);
+      gboolean covered = FALSE;
+
+      for (j = 0; j < rects->len && !covered; j++)
+        {
+          MetaRectangle *other = &g_array_index (rects, MetaRectangle, j);
+
+          /* Of two equal rectangles, only drop the later one */
+          covered = j != i &&
+                    meta_rectangle_contains_rect (other, rect) &&
+                    (j < i || !meta_rectangle_equal (other, rect));
+        }
+
+      if (covered)
+        g_array_remove_index (rects, i);
+      else
+        i++;
+    }
+}
+
 /**
  * meta_rectangle_get_minimal_spanning_set_for_region:
  * @basic_rect: Input rectangle
@@ -581,46 +503,24 @@ meta_rectangle_get_minimal_spanning_set_for_region (
   const MetaRectangle *basic_rect,
   const GSList  *all_struts)
 {
-  /* NOTE FOR OPTIMIZERS: This function *might* be somewhat slow,
-   * especially due to the call to merge_spanning_rects_in_region() (which
-   * is O(n^2) where n is the size of the list generated in this function).
-   * This is made more onerous due to the fact that it involves a fair
-   * number of memory allocation and deallocation calls.  However, n is 1
-   * for default installations of Gnome (because partial struts aren't used
-   * by default and only partial struts increase the size of the spanning
-   * set generated).  With one partial strut, n will be 2 or 3.  With 2
-   * partial struts, n will probably be 4 or 5.  So, n probably isn't large
-   * enough to make this worth bothering.  Further, it is only called from
-   * workspace.c:ensure_work_areas_validated (at least as of the time of
-   * writing this comment), which in turn should only be called if the
-   * strut list changes or the screen or monitor size changes.  If it ever
-   * does show up on profiles (most likely because people start using
-   * ridiculously huge numbers of partial struts), possible optimizations
-   * include:
-   *
-   * (1) rewrite merge_spanning_rects_in_region() to be O(n) or O(nlogn).
-   *     I'm not totally sure it's possible, but with a couple copies of
-   *     the list and sorting them appropriately, I believe it might be.
-   * (2) only call merge_spanning_rects_in_region() with a subset of the
-   *     full list of rectangles.  I believe from some of my preliminary
-   *     debugging and thinking about it that it is possible to figure out
-   *     apriori groups of rectangles which are only merge candidates with
-   *     each other.  (See testboxes.c:get_screen_region() when which==2
-   *     and track the steps of this function carefully to see what gave
-   *     me the hint that this might work)
-   * (3) figure out how to avoid merge_spanning_rects_in_region().  I think
-   *     it might be possible to modify this function to make that
-   *     possible, and I spent just a little while thinking about it, but n
-   *     wasn't large enough to convince me to care yet.
-   * (4) Some of the stuff Rob mentioned at http://mail.gnome.org/archives\
-   *     /metacity-devel-list/2005-November/msg00028.html.  (Sorry for the
-   *     URL splitting.)
+  /* NOTE FOR OPTIMIZERS: Every strut splits each rectangle of the set
+   * into at most four new ones, so the set is pruned of rectangles covered
+   * by another one after every strut rather than merged once at the end;
+   * that keeps it at the size of the final result instead of letting it
+   * grow with every partial strut, which matters with many monitors and
+   * panels.  The pruning is O(n^2) in the size of
+   * the set, but n stays small: the rectangles split off a maximal
+   * rectangle are themselves maximal, so no merging of adjacent
+   * rectangles is ever needed.  This is only called from
+   * workspace.c:ensure_work_areas_validated, i.e. when the strut list or
+   * the monitor layout changes.
    */
 
+  GArray        *rects;
+  GArray        *split_rects;
   GList         *ret;
-  GList         *tmp_list;
   const GSList  *strut_iter;
-  MetaRectangle *temp_rect;
+  unsigned int   i;
 
   /* The algorithm is basically as follows:
    *   Initialize rectangle_set to basic_rect
@@ -631,80 +531,96 @@ meta_rectangle_get_minimal_spanning_set_for_region (
    *       - Remove the old (pre-split) rectangle from the rectangle_set,
    *         and replace it with the new rectangles generated from the
    *         splitting
+   *     Remove the rectangles covered by another one from rectangle_set
    */
 
-  temp_rect = g_new (MetaRectangle, 1);
-  *temp_rect = *basic_rect;
-  ret = g_list_prepend (NULL, temp_rect);
+  rects = g_array_new (FALSE, FALSE, sizeof (MetaRectangle));
+  split_rects = g_array_new (FALSE, FALSE, sizeof (MetaRectangle));
+  g_array_append_val (rects, *basic_rect);
 
   for (strut_iter = all_struts; strut_iter; strut_iter = strut_iter->next)
     {
-      GList *rect_iter;
       MetaStrut *strut = (MetaStrut*)strut_iter->data;
       MetaRectangle *strut_rect = &strut->rect;
+      gboolean strut_aligns;
+      GArray *tmp;
+
+      strut_aligns = check_strut_align (strut, basic_rect);
 
-      tmp_list = ret;
-      ret = NULL;
-      rect_iter = tmp_list;
-      while (rect_iter)
+      /* The set is walked backwards, and the pieces of a split rectangle
+       * added bottom to left, to keep the order of the list based
+       * implementation this replaced; it decides the order of rectangles
+       * of equal area in the result.
+       */
+      g_array_set_size (split_rects, 0);
+      for (i = rects->len; i > 0; i--)
         {
-          MetaRectangle *rect = (MetaRectangle*) rect_iter->data;
+          MetaRectangle rect = g_array_index (rects, MetaRectangle, i - 1);
+          MetaRectangle temp_rect;
 
-          if (!meta_rectangle_overlap (strut_rect, rect) ||
-              !check_strut_align (strut, basic_rect))
-            ret = g_list_prepend (ret, rect);
-          else
+          if (!strut_aligns || !meta_rectangle_overlap (strut_rect, &rect))
             {
-              /* If there is area in rect left of strut */
-              if (BOX_LEFT (*rect) < BOX_LEFT (*strut_rect))
-                {
-                  temp_rect = g_new (MetaRectangle, 1);
-                  *temp_rect = *rect;
-                  temp_rect->width = BOX_LEFT (*strut_rect) - BOX_LEFT (*rect);
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              /* If there is area in rect right of strut */
-              if (BOX_RIGHT (*rect) > BOX_RIGHT (*strut_rect))
-                {
-                  int new_x;
-                  temp_rect = g_new (MetaRectangle, 1);
-                  *temp_rect = *rect;
-                  new_x = BOX_RIGHT (*strut_rect);
-                  temp_rect->width = BOX_RIGHT(*rect) - new_x;
-                  temp_rect->x = new_x;
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              /* If there is area in rect above strut */
-              if (BOX_TOP (*rect) < BOX_TOP (*strut_rect))
-                {
-                  temp_rect = g_new (MetaRectangle, 1);
-                  *temp_rect = *rect;
-                  temp_rect->height = BOX_TOP (*strut_rect) - BOX_TOP (*rect);
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              /* If there is area in rect below strut */
-              if (BOX_BOTTOM (*rect) > BOX_BOTTOM (*strut_rect))
-                {
-                  int new_y;
-                  temp_rect = g_new (MetaRectangle, 1);
-                  *temp_rect = *rect;
-                  new_y = BOX_BOTTOM (*strut_rect);
-                  temp_rect->height = BOX_BOTTOM (*rect) - new_y;
-                  temp_rect->y = new_y;
-                  ret = g_list_prepend (ret, temp_rect);
-                }
-              g_free (rect);
+              g_array_append_val (split_rects, rect);
+              continue;
+            }
+
+          /* If there is area in rect below strut */
+          if (BOX_BOTTOM (rect) > BOX_BOTTOM (*strut_rect))
+            {
+              temp_rect = rect;
+              temp_rect.y = BOX_BOTTOM (*strut_rect);
+              temp_rect.height = BOX_BOTTOM (rect) - temp_rect.y;
+              g_array_append_val (split_rects, temp_rect);
+            }
+          /* If there is area in rect above strut */
+          if (BOX_TOP (rect) < BOX_TOP (*strut_rect))
+            {
+              temp_rect = rect;
+              temp_rect.height = BOX_TOP (*strut_rect) - BOX_TOP (rect);
+              g_array_append_val (split_rects, temp_rect);
+            }
+          /* If there is area in rect right of strut */
+          if (BOX_RIGHT (rect) > BOX_RIGHT (*strut_rect))
+            {
+              temp_rect = rect;
+              temp_rect.x = BOX_RIGHT (*strut_rect);
+              temp_rect.width = BOX_RIGHT (rect) - temp_rect.x;
+              g_array_append_val (split_rects, temp_rect);
+            }
+          /* If there is area in rect left of strut */
+          if (BOX_LEFT (rect) < BOX_LEFT (*strut_rect))
+            {
+              temp_rect = rect;
+              temp_rect.width = BOX_LEFT (*strut_rect) - BOX_LEFT (rect);
+              g_array_append_val (split_rects, temp_rect);
             }
-          rect_iter = rect_iter->next;
         }
-      g_list_free (tmp_list);
+
+      tmp = rects;
+      rects = split_rects;
+      split_rects = tmp;
+
+      remove_covered_rects (rects);
     }
 
   /* Sort by maximal area, just because I feel like it... */
-  ret = g_list_sort (ret, compare_rect_areas);
+  g_array_sort (rects, compare_rect_areas);
+
+  ret = NULL;
+  for (i = rects->len; i > 0; i--)
+    {
+      MetaRectangle *rect = g_new (MetaRectangle, 1);
+
+      *rect = g_array_index (rects, MetaRectangle, i - 1);
+      ret = g_list_prepend (ret, rect);
+    }
 
-  /* Merge rectangles if possible so that the list really is minimal */
-  ret = merge_spanning_rects_in_region (ret);
+  g_array_unref (rects);
+  g_array_unref (split_rects);
+
+  if (ret == NULL)
+    g_warning ("Region to merge was empty! Either you have some "
+               "pathological STRUT list or there's a bug somewhere!");
 
   return ret;
 }
@@ -2206,3 +2122,231 @@ meta_rectangle_crop_and_scale (const MetaRectangle *rect,
 
   meta_rectangle_from_graphene_rect (&tmp, META_ROUNDING_STRATEGY_GROW, dest);
 }
+
+typedef struct
+{
+  int left;
+  int right;
+  int top;
+  int bottom;
+} RectangleTreeBounds;
+
+/* Leaves past the last rectangle have empty bounds on both axes, so that
+ * they never overlap anything, whatever the directions searched along.
+ */
+struct _MetaRectangleTree
+{
+  int n_leaves;
+  RectangleTreeBounds *bounds;
+};
+
+MetaRectangleTree *
+meta_rectangle_tree_new (const MetaRectangle *rects,
+                         int                  n_rects)
+{
+  MetaRectangleTree *tree;
+  int i;
+
+  tree = g_new0 (MetaRectangleTree, 1);
+
+  tree->n_leaves = 1;
+  while (tree->n_leaves < n_rects)
+    tree->n_leaves *= 2;
+
+  tree->bounds = g_new (RectangleTreeBounds, tree->n_leaves * 2);
+
+  for (i = 0; i < tree->n_leaves; i++)
+    {
+      RectangleTreeBounds *leaf = &tree->bounds[tree->n_leaves + i];
+
+      if (i < n_rects)
+        {
+          leaf->left = BOX_LEFT (rects[i]);
+          leaf->right = BOX_RIGHT (rects[i]);
+          leaf->top = BOX_TOP (rects[i]);
+          leaf->bottom = BOX_BOTTOM (rects[i]);
+        }
+      else
+        {
+          leaf->left = INT_MAX;
+          leaf->right = INT_MIN;
+          leaf->top = INT_MAX;
+          leaf->bottom = INT_MIN;
+        }
+    }
+
+  for (i = tree->n_leaves - 1; i > 0; i--)
+    {
+      RectangleTreeBounds *node = &tree->bounds[i];
+      RectangleTreeBounds *first = &tree->bounds[2 * i];
+      RectangleTreeBounds *second = &tree->bounds[2 * i + 1];
+
+      node->left = MIN (first->left, second->left);
+      node->right = MAX (first->right, second->right);
+      node->top = MIN (first->top, second->top);
+      node->bottom = MAX (first->bottom, second->bottom);
+    }
+
+  return tree;
+}
+
+void
+meta_rectangle_tree_free (MetaRectangleTree *tree)
+{
+  g_free (tree->bounds);
+  g_free (tree);
+}
+
+static int
+rectangle_tree_find_overlap_in (const MetaRectangleTree *tree,
+                                int                      node,
+                                int                      node_first,
+                                int                      node_last,
+                                int                      from,
+                                gboolean                 forward,
+                                const MetaRectangle     *rect,
+                                MetaDirection            directions)
+{
+  const RectangleTreeBounds *bounds = &tree->bounds[node];
+  int node_mid;
+  int found;
+
+  if (forward && node_last < from)
+    return -1;
+  if (!forward && node_first > from)
+    return -1;
+
+  /* Touching rectangles don't overlap */
+  if (directions & META_DIRECTION_HORIZONTAL &&
+      (bounds->left >= BOX_RIGHT (*rect) || bounds->right <= BOX_LEFT (*rect)))
+    return -1;
+  if (directions & META_DIRECTION_VERTICAL &&
+      (bounds->top >= BOX_BOTTOM (*rect) || bounds->bottom <= BOX_TOP (*rect)))
+    return -1;
+
+  if (node_first == node_last)
+    return node_first;
+
+  node_mid = node_first + (node_last - node_first) / 2;
+
+  if (forward)
+    {
+      found = rectangle_tree_find_overlap_in (tree, 2 * node,
+                                              node_first, node_mid,
+                                              from, forward, rect, directions);
+      if (found == -1)
+        {
+          found = rectangle_tree_find_overlap_in (tree, 2 * node + 1,
+                                                  node_mid + 1, node_last,
+                                                  from, forward, rect,
+                                                  directions);
+        }
+    }
+  else
+    {
+      found = rectangle_tree_find_overlap_in (tree, 2 * node + 1,
+                                              node_mid + 1, node_last,
+                                              from, forward, rect, directions);
+      if (found == -1)
+        {
+          found = rectangle_tree_find_overlap_in (tree, 2 * node,
+                                                  node_first, node_mid,
+                                                  from, forward, rect,
+                                                  directions);
+        }
+    }
+
+  return found;
+}
+
+/* Returns the index of the first rectangle at or after (or, if !forward,
+ * at or before) from whose extents overlap those of rect along directions,
+ * or -1 if there is none. Along META_DIRECTION_HORIZONTAL, this uses the
+ * same semantics as meta_rectangle_horiz_overlap(), and along
+ * META_DIRECTION_VERTICAL, the same as meta_rectangle_vert_overlap().
+ */
+int
+meta_rectangle_tree_find_overlap (const MetaRectangleTree *tree,
+                                  int                      from,
+                                  gboolean                 forward,
+                                  const MetaRectangle     *rect,
+                                  MetaDirection            directions)
+{
+  return rectangle_tree_find_overlap_in (tree, 1, 0, tree->n_leaves - 1,
+                                         from, forward, rect, directions);
+}
+
+/* The rectangles are sorted by their left side, so that the rectangles
+ * under a subtree of the tree are close to each other horizontally, and
+ * whole subtrees on either side of a queried rectangle get skipped.
+ */
+struct _MetaRectangleIndex
+{
+  MetaRectangleTree *tree;
+};
+
+static int
+compare_rect_left (gconstpointer a,
+                   gconstpointer b)
+{
+  const MetaRectangle *rect_a = a;
+  const MetaRectangle *rect_b = b;
+
+  if (rect_a->x < rect_b->x)
+    return -1;
+  else if (rect_a->x > rect_b->x)
+    return 1;
+  else
+    return 0;
+}
+
+MetaRectangleIndex *
+meta_rectangle_index_new (const MetaRectangle *rects,
+                          int                  n_rects)
+{
+  MetaRectangleIndex *index;
+  g_autofree MetaRectangle *sorted_rects = NULL;
+  int n_sorted_rects = 0;
+  int i;
+
+  /* Empty rectangles don't intersect anything, but would still overlap
+   * along both axes
+   */
+  sorted_rects = g_new (MetaRectangle, MAX (n_rects, 1));
+  for (i = 0; i < n_rects; i++)
+    {
+      if (rects[i].width > 0 && rects[i].height > 0)
+        sorted_rects[n_sorted_rects++] = rects[i];
+    }
+
+  if (n_sorted_rects > 0)
+    qsort (sorted_rects, n_sorted_rects, sizeof (MetaRectangle),
+           compare_rect_left);
+
+  index = g_new0 (MetaRectangleIndex, 1);
+  index->tree = meta_rectangle_tree_new (sorted_rects, n_sorted_rects);
+
+  return index;
+}
+
+void
+meta_rectangle_index_free (MetaRectangleIndex *index)
+{
+  meta_rectangle_tree_free (index->tree);
+  g_free (index);
+}
+
+/* Returns whether any rectangle in index has a non-empty intersection with
+ * rect, with the same semantics as meta_rectangle_intersect().
+ */
+gboolean
+meta_rectangle_index_overlaps (const MetaRectangleIndex *index,
+                               const MetaRectangle      *rect)
+{
+  if (rect->width <= 0 || rect->height <= 0)
+    return FALSE;
+
+  return meta_rectangle_tree_find_overlap (index->tree, 0, TRUE, rect,
+                                           META_DIRECTION_HORIZONTAL |
+                                           META_DIRECTION_VERTICAL) != -1;
+}
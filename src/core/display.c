@@ -1038,17 +1038,6 @@ meta_display_new (MetaContext  *context,
   return display;
 }
 
-static gint
-ptrcmp (gconstpointer a, gconstpointer b)
-{
-  if (a < b)
-    return -1;
-  else if (a > b)
-    return 1;
-  else
-    return 0;
-}
-
 /**
  * meta_display_list_windows:
  * @display: a #MetaDisplay
@@ -1065,8 +1054,6 @@ meta_display_list_windows (MetaDisplay          *display,
                            MetaListWindowsFlags  flags)
 {
   GSList *winlist;
-  GSList *prev;
-  GSList *tmp;
   GHashTableIter iter;
   gpointer key, value;
 
@@ -1083,6 +1070,12 @@ meta_display_list_windows (MetaDisplay          *display,
           if (!META_IS_WINDOW (window) || window->unmanaging)
             continue;
 
+          /* Frame and user time windows map to their client window too;
+           * only list it once, for its own X window.
+           */
+          if (*((Window *) key) != window->xwindow)
+            continue;
+
           if (!window->override_redirect ||
               (flags & META_LIST_INCLUDE_OVERRIDE_REDIRECT) != 0)
             winlist = g_slist_prepend (winlist, window);
@@ -1103,42 +1096,6 @@ meta_display_list_windows (MetaDisplay          *display,
         winlist = g_slist_prepend (winlist, window);
     }
 
-  /* Uniquify the list, since both frame windows and plain
-   * windows are in the hash
-   */
-  winlist = g_slist_sort (winlist, ptrcmp);
-
-  prev = NULL;
-  tmp = winlist;
-  while (tmp != NULL)
-    {
-      GSList *next;
-
-      next = tmp->next;
-
-      if (next &&
-          next->data == tmp->data)
-        {
-          /* Delete tmp from list */
-
-          if (prev)
-            prev->next = next;
-
-          if (tmp == winlist)
-            winlist = next;
-
-          g_slist_free_1 (tmp);
-
-          /* leave prev unchanged */
-        }
-      else
-        {
-          prev = tmp;
-        }
-
-      tmp = next;
-    }
-
   if (flags & META_LIST_SORTED)
     winlist = g_slist_sort (winlist, mru_cmp);
 
@@ -3110,9 +3067,7 @@ check_fullscreen_func (gpointer data)
     {
       /* DOCK window stacking depends on the monitor's fullscreen
          status so we need to trigger a re-layering. */
-      MetaWindow *window = meta_stack_get_top (display->stack);
-      if (window)
-        meta_stack_update_layer (display->stack, window);
+      meta_stack_update_layer (display->stack, NULL);
 
       g_signal_emit (display, display_signals[IN_FULLSCREEN_CHANGED], 0, NULL);
     }
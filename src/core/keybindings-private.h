@@ -31,6 +31,7 @@
 #include <xkbcommon/xkbcommon.h>
 
 #include "core/meta-accel-parse.h"
+#include "core/util-private.h"
 #include "meta/keybindings.h"
 
 typedef struct _MetaKeyHandler MetaKeyHandler;
@@ -95,7 +96,9 @@ typedef struct _MetaKeyBindingKeyboardLayout
 {
   struct xkb_keymap *keymap;
   xkb_layout_index_t index;
-  xkb_level_index_t n_levels;
+
+  /* keysym -> keycodes and levels it is found on, in keycode order */
+  GHashTable *keysym_keycodes;
 } MetaKeyBindingKeyboardLayout;
 
 typedef struct
@@ -124,7 +127,14 @@ typedef struct
    * A primary layout, and an optional secondary layout for when the
    * primary layout does not use the latin alphabet.
    */
-  MetaKeyBindingKeyboardLayout active_layouts[2];
+  MetaKeyBindingKeyboardLayout *active_layouts[2];
+
+  /* Indexed layouts of the current keymap by layout index, and of the US
+   * keymap used as secondary layout, kept across layout switches.
+   */
+  struct xkb_keymap *layouts_keymap;
+  GPtrArray *keymap_layouts;
+  MetaKeyBindingKeyboardLayout *us_layout;
 
   /* Alt+click button grabs */
   ClutterModifierType window_grab_modifiers;
@@ -154,4 +164,31 @@ gboolean meta_prefs_is_locate_pointer_enabled (void);
 void meta_x11_display_grab_keys   (MetaX11Display *x11_display);
 void meta_x11_display_ungrab_keys (MetaX11Display *x11_display);
 
+META_EXPORT_TEST
+MetaKeyBindingKeyboardLayout * meta_key_binding_keyboard_layout_new (struct xkb_keymap  *keymap,
+                                                                     xkb_layout_index_t  index);
+
+META_EXPORT_TEST
+void meta_key_binding_keyboard_layout_free (MetaKeyBindingKeyboardLayout *layout);
+
+META_EXPORT_TEST
+gboolean meta_key_binding_keyboard_layout_needs_secondary (MetaKeyBindingKeyboardLayout *layout);
+
+META_EXPORT_TEST
+void meta_key_binding_manager_get_keycodes_for_keysym (MetaKeyBindingManager *keys,
+                                                       int                    keysym,
+                                                       MetaResolvedKeyCombo  *resolved_combo);
+
+META_EXPORT_TEST
+void meta_key_binding_manager_collect_keygrabs (MetaKeyBindingManager *keys,
+                                                GHashTable            *root_keygrabs,
+                                                GHashTable            *window_keygrabs);
+
+META_EXPORT_TEST
+void meta_key_binding_diff_keygrabs (GHashTable *old_keygrabs,
+                                     GHashTable *new_keygrabs,
+                                     gboolean    regrab_all,
+                                     GHashTable *out_ungrab_keygrabs,
+                                     GHashTable *out_grab_keygrabs);
+
 #endif
@@ -184,6 +184,11 @@ meta_key_binding_is_builtin (MetaKeyBinding *binding)
 static void maybe_update_locate_pointer_keygrab (MetaDisplay *display,
                                                  gboolean     grab);
 
+static void update_keygrabs (MetaDisplay    *display,
+                             GHashTable     *old_root_keygrabs,
+                             GHashTable     *old_window_keygrabs,
+                             xkb_mod_mask_t  old_ignored_modifier_mask);
+
 static GHashTable *key_handlers;
 static GHashTable *external_grabs;
 
@@ -285,92 +290,127 @@ reload_modmap (MetaKeyBindingManager *keys)
               keys->meta_mask);
 }
 
-static gboolean
-is_keycode_for_keysym (struct xkb_keymap *keymap,
-                       xkb_layout_index_t layout,
-                       xkb_level_index_t  level,
-                       xkb_keycode_t      keycode,
-                       xkb_keysym_t       keysym)
-{
-  const xkb_keysym_t *syms;
-  int num_syms, k;
-
-  num_syms = xkb_keymap_key_get_syms_by_level (keymap, keycode, layout, level, &syms);
-  for (k = 0; k < num_syms; k++)
-    {
-      if (syms[k] == keysym)
-        return TRUE;
-    }
-
-  return FALSE;
-}
-
 typedef struct
 {
-  GArray *keycodes;
-  xkb_keysym_t keysym;
-  xkb_layout_index_t layout;
   xkb_level_index_t level;
-} FindKeysymData;
+  xkb_keycode_t keycode;
+} KeysymKeycode;
 
 static void
-get_keycodes_for_keysym_iter (struct xkb_keymap *keymap,
-                              xkb_keycode_t      keycode,
-                              void              *data)
+index_keysyms_iter (struct xkb_keymap *keymap,
+                    xkb_keycode_t      keycode,
+                    void              *data)
 {
-  FindKeysymData *search_data = data;
-  GArray *keycodes = search_data->keycodes;
-  xkb_keysym_t keysym = search_data->keysym;
-  xkb_layout_index_t layout = search_data->layout;
-  xkb_level_index_t level = search_data->level;
+  MetaKeyBindingKeyboardLayout *layout = data;
+  xkb_level_index_t n_levels, level;
+
+  n_levels = xkb_keymap_num_levels_for_key (keymap, keycode, layout->index);
 
-  if (is_keycode_for_keysym (keymap, layout, level, keycode, keysym))
+  for (level = 0; level < n_levels; level++)
     {
-      guint i;
-      gboolean missing = TRUE;
+      const xkb_keysym_t *syms;
+      int num_syms, k;
 
-      /* duplicate keycode detection */
-      for (i = 0; i < keycodes->len; i++)
-        if (g_array_index (keycodes, xkb_keysym_t, i) == keycode)
-          {
-            missing = FALSE;
-            break;
-          }
+      num_syms = xkb_keymap_key_get_syms_by_level (keymap, keycode,
+                                                   layout->index, level,
+                                                   &syms);
+      for (k = 0; k < num_syms; k++)
+        {
+          KeysymKeycode entry = { .level = level, .keycode = keycode };
+          GArray *entries;
+
+          entries = g_hash_table_lookup (layout->keysym_keycodes,
+                                         GUINT_TO_POINTER (syms[k]));
+          if (!entries)
+            {
+              entries = g_array_new (FALSE, FALSE, sizeof (KeysymKeycode));
+              g_hash_table_insert (layout->keysym_keycodes,
+                                   GUINT_TO_POINTER (syms[k]), entries);
+            }
+          else
+            {
+              KeysymKeycode *last =
+                &g_array_index (entries, KeysymKeycode, entries->len - 1);
+
+              /* duplicate keycode detection */
+              if (last->level == level && last->keycode == keycode)
+                continue;
+            }
 
-      if (missing)
-        g_array_append_val (keycodes, keycode);
+          g_array_append_val (entries, entry);
+        }
     }
 }
 
+/* Indexes the keycodes of every keysym of the layout in a single pass over
+ * the keymap, so that resolving a binding doesn't need to walk it.
+ */
+MetaKeyBindingKeyboardLayout *
+meta_key_binding_keyboard_layout_new (struct xkb_keymap  *keymap,
+                                      xkb_layout_index_t  index)
+{
+  MetaKeyBindingKeyboardLayout *layout;
+
+  layout = g_new0 (MetaKeyBindingKeyboardLayout, 1);
+  layout->keymap = xkb_keymap_ref (keymap);
+  layout->index = index;
+  layout->keysym_keycodes =
+    g_hash_table_new_full (NULL, NULL, NULL,
+                           (GDestroyNotify) g_array_unref);
+
+  xkb_keymap_key_for_each (keymap, index_keysyms_iter, layout);
+
+  return layout;
+}
+
+void
+meta_key_binding_keyboard_layout_free (MetaKeyBindingKeyboardLayout *layout)
+{
+  g_hash_table_unref (layout->keysym_keycodes);
+  xkb_keymap_unref (layout->keymap);
+  g_free (layout);
+}
+
 static void
 add_keysym_keycodes_from_layout (int                           keysym,
                                  MetaKeyBindingKeyboardLayout *layout,
                                  GArray                       *keycodes)
 {
-  xkb_level_index_t layout_level;
+  GArray *entries;
+  xkb_level_index_t lowest_level = G_MAXUINT32;
+  unsigned int i;
+
+  if (keycodes->len > 0)
+    return;
+
+  entries = g_hash_table_lookup (layout->keysym_keycodes,
+                                 GUINT_TO_POINTER (keysym));
+  if (!entries)
+    return;
 
-  for (layout_level = 0;
-       layout_level < layout->n_levels && keycodes->len == 0;
-       layout_level++)
+  /* Only use the keycodes of the lowest level the keysym is found on */
+  for (i = 0; i < entries->len; i++)
     {
-      FindKeysymData search_data = (FindKeysymData) {
-        .keycodes = keycodes,
-        .keysym = keysym,
-        .layout = layout->index,
-        .level = layout_level
-      };
-      xkb_keymap_key_for_each (layout->keymap,
-                               get_keycodes_for_keysym_iter,
-                               &search_data);
+      KeysymKeycode *entry = &g_array_index (entries, KeysymKeycode, i);
+
+      lowest_level = MIN (lowest_level, entry->level);
+    }
+
+  for (i = 0; i < entries->len; i++)
+    {
+      KeysymKeycode *entry = &g_array_index (entries, KeysymKeycode, i);
+
+      if (entry->level == lowest_level)
+        g_array_append_val (keycodes, entry->keycode);
     }
 }
 
 /* Original code from gdk_x11_keymap_get_entries_for_keyval() in
  * gdkkeys-x11.c */
-static void
-get_keycodes_for_keysym (MetaKeyBindingManager  *keys,
-                         int                     keysym,
-                         MetaResolvedKeyCombo   *resolved_combo)
+void
+meta_key_binding_manager_get_keycodes_for_keysym (MetaKeyBindingManager *keys,
+                                                  int                    keysym,
+                                                  MetaResolvedKeyCombo  *resolved_combo)
 {
   unsigned int i;
   GArray *keycodes;
@@ -388,9 +428,9 @@ get_keycodes_for_keysym (MetaKeyBindingManager  *keys,
 
   for (i = 0; i < G_N_ELEMENTS (keys->active_layouts); i++)
     {
-      MetaKeyBindingKeyboardLayout *layout = &keys->active_layouts[i];
+      MetaKeyBindingKeyboardLayout *layout = keys->active_layouts[i];
 
-      if (!layout->keymap)
+      if (!layout)
         continue;
 
       add_keysym_keycodes_from_layout (keysym, layout, keycodes);
@@ -403,46 +443,6 @@ get_keycodes_for_keysym (MetaKeyBindingManager  *keys,
                                     keycodes->len == 0 ? TRUE : FALSE);
 }
 
-typedef struct _CalculateLayoutLevelsState
-{
-  struct xkb_keymap *keymap;
-  xkb_layout_index_t layout_index;
-
-  xkb_level_index_t out_n_levels;
-} CalculateLayoutLevelState;
-
-static void
-calculate_n_layout_levels_iter (struct xkb_keymap *keymap,
-                                xkb_keycode_t      keycode,
-                                void              *data)
-{
-  CalculateLayoutLevelState *state = data;
-  xkb_level_index_t n_levels;
-
-  n_levels = xkb_keymap_num_levels_for_key (keymap,
-                                            keycode,
-                                            state->layout_index);
-
-  state->out_n_levels = MAX (n_levels, state->out_n_levels);
-}
-
-static xkb_level_index_t
-calculate_n_layout_levels (struct xkb_keymap *keymap,
-                           xkb_layout_index_t layout_index)
-
-{
-  CalculateLayoutLevelState state = {
-    .keymap = keymap,
-    .layout_index = layout_index,
-
-    .out_n_levels = 0
-  };
-
-  xkb_keymap_key_for_each (keymap, calculate_n_layout_levels_iter, &state);
-
-  return state.out_n_levels;
-}
-
 static void
 reload_iso_next_group_combos (MetaKeyBindingManager *keys)
 {
@@ -458,7 +458,9 @@ reload_iso_next_group_combos (MetaKeyBindingManager *keys)
   if (iso_next_group_option == NULL)
     return;
 
-  get_keycodes_for_keysym (keys, XKB_KEY_ISO_Next_Group, keys->iso_next_group_combo);
+  meta_key_binding_manager_get_keycodes_for_keysym (keys,
+                                                    XKB_KEY_ISO_Next_Group,
+                                                    keys->iso_next_group_combo);
 
   if (keys->iso_next_group_combo[0].len == 0)
     return;
@@ -600,7 +602,8 @@ resolve_key_combo (MetaKeyBindingManager *keys,
 
   if (combo->keysym != 0)
     {
-      get_keycodes_for_keysym (keys, combo->keysym, resolved_combo);
+      meta_key_binding_manager_get_keycodes_for_keysym (keys, combo->keysym,
+                                                        resolved_combo);
     }
   else if (combo->keycode != 0)
     {
@@ -624,103 +627,46 @@ binding_reload_combos_foreach (gpointer key,
   index_binding (keys, binding);
 }
 
-typedef struct _FindLatinKeysymsState
-{
-  MetaKeyBindingKeyboardLayout *layout;
-  gboolean *required_keysyms_found;
-  int n_required_keysyms;
-} FindLatinKeysymsState;
-
-static void
-find_latin_keysym (struct xkb_keymap *keymap,
-                   xkb_keycode_t      key,
-                   void              *data)
+gboolean
+meta_key_binding_keyboard_layout_needs_secondary (MetaKeyBindingKeyboardLayout *layout)
 {
-  FindLatinKeysymsState *state = data;
-  int n_keysyms, i;
-  const xkb_keysym_t *keysyms;
+  xkb_keysym_t keysym;
 
-  n_keysyms = xkb_keymap_key_get_syms_by_level (state->layout->keymap,
-                                                key,
-                                                state->layout->index,
-                                                0,
-                                                &keysyms);
-  for (i = 0; i < n_keysyms; i++)
+  for (keysym = XKB_KEY_a; keysym <= XKB_KEY_z; keysym++)
     {
-      xkb_keysym_t keysym = keysyms[i];
+      GArray *entries;
+      unsigned int i;
+      gboolean found = FALSE;
 
-      if (keysym >= XKB_KEY_a && keysym <= XKB_KEY_z)
-        {
-          unsigned int keysym_index = keysym - XKB_KEY_a;
+      entries = g_hash_table_lookup (layout->keysym_keycodes,
+                                     GUINT_TO_POINTER (keysym));
+      if (!entries)
+        return TRUE;
 
-          if (!state->required_keysyms_found[keysym_index])
-            {
-              state->required_keysyms_found[keysym_index] = TRUE;
-              state->n_required_keysyms--;
-            }
-        }
-    }
-}
+      for (i = 0; i < entries->len && !found; i++)
+        found = g_array_index (entries, KeysymKeycode, i).level == 0;
 
-static gboolean
-needs_secondary_layout (MetaKeyBindingKeyboardLayout *layout)
-{
-  gboolean required_keysyms_found[] = {
-    FALSE, /* XKB_KEY_a */
-    FALSE, /* XKB_KEY_b */
-    FALSE, /* XKB_KEY_c */
-    FALSE, /* XKB_KEY_d */
-    FALSE, /* XKB_KEY_e */
-    FALSE, /* XKB_KEY_f */
-    FALSE, /* XKB_KEY_g */
-    FALSE, /* XKB_KEY_h */
-    FALSE, /* XKB_KEY_i */
-    FALSE, /* XKB_KEY_j */
-    FALSE, /* XKB_KEY_k */
-    FALSE, /* XKB_KEY_l */
-    FALSE, /* XKB_KEY_m */
-    FALSE, /* XKB_KEY_n */
-    FALSE, /* XKB_KEY_o */
-    FALSE, /* XKB_KEY_p */
-    FALSE, /* XKB_KEY_q */
-    FALSE, /* XKB_KEY_r */
-    FALSE, /* XKB_KEY_s */
-    FALSE, /* XKB_KEY_t */
-    FALSE, /* XKB_KEY_u */
-    FALSE, /* XKB_KEY_v */
-    FALSE, /* XKB_KEY_w */
-    FALSE, /* XKB_KEY_x */
-    FALSE, /* XKB_KEY_y */
-    FALSE, /* XKB_KEY_z */
-  };
-  FindLatinKeysymsState state = {
-    .layout = layout,
-    .required_keysyms_found = required_keysyms_found,
-    .n_required_keysyms = G_N_ELEMENTS (required_keysyms_found),
-  };
-
-  xkb_keymap_key_for_each (layout->keymap, find_latin_keysym, &state);
+      if (!found)
+        return TRUE;
+    }
 
-  return state.n_required_keysyms != 0;
+  return FALSE;
 }
 
 static void
-clear_active_keyboard_layouts (MetaKeyBindingManager *keys)
+clear_keymap_layouts (MetaKeyBindingManager *keys)
 {
-  unsigned int i;
+  keys->active_layouts[META_KEY_BINDING_PRIMARY_LAYOUT] = NULL;
+  keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = NULL;
 
-  for (i = 0; i < G_N_ELEMENTS (keys->active_layouts); i++)
-    {
-      MetaKeyBindingKeyboardLayout *layout = &keys->active_layouts[i];
-
-      g_clear_pointer (&layout->keymap, xkb_keymap_unref);
-      *layout = (MetaKeyBindingKeyboardLayout) { 0 };
-    }
+  g_clear_pointer (&keys->keymap_layouts, g_ptr_array_unref);
+  g_clear_pointer (&keys->layouts_keymap, xkb_keymap_unref);
 }
 
-static MetaKeyBindingKeyboardLayout
+static MetaKeyBindingKeyboardLayout *
 create_us_layout (void)
 {
+  MetaKeyBindingKeyboardLayout *layout;
   struct xkb_rule_names names;
   struct xkb_keymap *keymap;
   struct xkb_context *context;
@@ -735,10 +681,42 @@ create_us_layout (void)
   keymap = xkb_keymap_new_from_names (context, &names, XKB_KEYMAP_COMPILE_NO_FLAGS);
   xkb_context_unref (context);
 
-  return (MetaKeyBindingKeyboardLayout) {
-    .keymap = keymap,
-    .n_levels = calculate_n_layout_levels (keymap, 0),
-  };
+  layout = meta_key_binding_keyboard_layout_new (keymap, 0);
+  xkb_keymap_unref (keymap);
+
+  return layout;
+}
+
+/* The layouts of a keymap are indexed the first time they are used, and
+ * kept until the keymap changes, so that switching between them is cheap.
+ */
+static MetaKeyBindingKeyboardLayout *
+ensure_keymap_layout (MetaKeyBindingManager *keys,
+                      struct xkb_keymap     *keymap,
+                      xkb_layout_index_t     layout_index)
+{
+  MetaKeyBindingKeyboardLayout *layout;
+
+  if (keys->layouts_keymap != keymap)
+    {
+      clear_keymap_layouts (keys);
+
+      keys->layouts_keymap = xkb_keymap_ref (keymap);
+      keys->keymap_layouts =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) meta_key_binding_keyboard_layout_free);
+    }
+
+  if (layout_index >= keys->keymap_layouts->len)
+    g_ptr_array_set_size (keys->keymap_layouts, layout_index + 1);
+
+  layout = g_ptr_array_index (keys->keymap_layouts, layout_index);
+  if (!layout)
+    {
+      layout = meta_key_binding_keyboard_layout_new (keymap, layout_index);
+      g_ptr_array_index (keys->keymap_layouts, layout_index) = layout;
+    }
+
+  return layout;
 }
 
 static void
@@ -746,26 +724,22 @@ reload_active_keyboard_layouts (MetaKeyBindingManager *keys)
 {
   struct xkb_keymap *keymap;
   xkb_layout_index_t layout_index;
-  MetaKeyBindingKeyboardLayout primary_layout;
-
-  clear_active_keyboard_layouts (keys);
+  MetaKeyBindingKeyboardLayout *primary_layout;
 
   keymap = meta_backend_get_keymap (keys->backend);
   layout_index = meta_backend_get_keymap_layout_group (keys->backend);
-  primary_layout = (MetaKeyBindingKeyboardLayout) {
-    .keymap = xkb_keymap_ref (keymap),
-    .index = layout_index,
-    .n_levels = calculate_n_layout_levels (keymap, layout_index),
-  };
+  primary_layout = ensure_keymap_layout (keys, keymap, layout_index);
 
   keys->active_layouts[META_KEY_BINDING_PRIMARY_LAYOUT] = primary_layout;
+  keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = NULL;
 
-  if (needs_secondary_layout (&primary_layout))
+  if (meta_key_binding_keyboard_layout_needs_secondary (primary_layout))
     {
-      MetaKeyBindingKeyboardLayout us_layout;
+      if (!keys->us_layout)
+        keys->us_layout = create_us_layout ();
 
-      us_layout = create_us_layout ();
-      keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] = us_layout;
+      keys->active_layouts[META_KEY_BINDING_SECONDARY_LAYOUT] =
+        keys->us_layout;
     }
 }
 
@@ -1122,12 +1096,68 @@ meta_display_get_keybinding_action (MetaDisplay  *display,
   return get_keybinding_action (keys, &resolved_combo);
 }
 
+static void
+add_combo_keygrabs (GHashTable           *keygrabs,
+                    MetaResolvedKeyCombo *resolved_combo)
+{
+  int i;
+
+  for (i = 0; i < resolved_combo->len; i++)
+    g_hash_table_add (keygrabs,
+                      GUINT_TO_POINTER (key_combo_key (resolved_combo, i)));
+}
+
+/* Collects the keycode and mask of every key grabbed by
+ * meta_x11_display_grab_keys() on the root window, and by
+ * meta_window_grab_keys() on windows, as key_combo_key() values.
+ */
+void
+meta_key_binding_manager_collect_keygrabs (MetaKeyBindingManager *keys,
+                                           GHashTable            *root_keygrabs,
+                                           GHashTable            *window_keygrabs)
+{
+  GHashTableIter iter;
+  gpointer value;
+  int i;
+
+  add_combo_keygrabs (root_keygrabs, &keys->overlay_resolved_key_combo);
+
+  if (meta_prefs_is_locate_pointer_enabled ())
+    add_combo_keygrabs (root_keygrabs,
+                        &keys->locate_pointer_resolved_key_combo);
+
+  for (i = 0; i < keys->n_iso_next_group_combos; i++)
+    add_combo_keygrabs (root_keygrabs, &keys->iso_next_group_combo[i]);
+
+  g_hash_table_iter_init (&iter, keys->key_bindings);
+  while (g_hash_table_iter_next (&iter, NULL, &value))
+    {
+      MetaKeyBinding *binding = value;
+
+      if (binding->flags & META_KEY_BINDING_NO_AUTO_GRAB)
+        continue;
+
+      if (binding->flags & META_KEY_BINDING_PER_WINDOW)
+        add_combo_keygrabs (window_keygrabs, &binding->resolved_combo);
+      else
+        add_combo_keygrabs (root_keygrabs, &binding->resolved_combo);
+    }
+}
+
 static void
 reload_keybindings (MetaDisplay *display)
 {
   MetaKeyBindingManager *keys = &display->key_binding_manager;
+  g_autoptr (GHashTable) old_root_keygrabs = NULL;
+  g_autoptr (GHashTable) old_window_keygrabs = NULL;
+  xkb_mod_mask_t old_ignored_modifier_mask;
 
-  ungrab_key_bindings (display);
+  old_root_keygrabs = g_hash_table_new (NULL, NULL);
+  old_window_keygrabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_manager_collect_keygrabs (keys,
+                                             old_root_keygrabs,
+                                             old_window_keygrabs);
+  old_ignored_modifier_mask = keys->ignored_modifier_mask;
 
   /* Deciphering the modmap depends on the loaded keysyms to find out
    * what modifiers is Super and so forth, so we need to reload it
@@ -1136,7 +1166,10 @@ reload_keybindings (MetaDisplay *display)
 
   reload_combos (keys);
 
-  grab_key_bindings (display);
+  update_keygrabs (display,
+                   old_root_keygrabs,
+                   old_window_keygrabs,
+                   old_ignored_modifier_mask);
 }
 
 static GArray *
@@ -1414,7 +1447,8 @@ meta_display_shutdown_keys (MetaDisplay *display)
   g_hash_table_destroy (keys->key_bindings_index);
   g_hash_table_destroy (keys->key_bindings);
 
-  clear_active_keyboard_layouts (keys);
+  clear_keymap_layouts (keys);
+  g_clear_pointer (&keys->us_layout, meta_key_binding_keyboard_layout_free);
 }
 
 /* Grab/ungrab, ignoring all annoying modifiers like NumLock etc. */
@@ -1629,6 +1663,21 @@ meta_window_grab_keys (MetaWindow  *window)
   window->grab_on_frame = window->frame != NULL;
 }
 
+static Window
+get_window_keygrab_xwindow (MetaWindow *window)
+{
+  if (!window->keys_grabbed)
+    return None;
+
+  if (window->grab_on_frame &&
+      window->frame != NULL)
+    return window->frame->xwindow;
+  else if (!window->grab_on_frame)
+    return window->xwindow;
+  else
+    return None;
+}
+
 void
 meta_window_ungrab_keys (MetaWindow  *window)
 {
@@ -1636,17 +1685,157 @@ meta_window_ungrab_keys (MetaWindow  *window)
     {
       MetaDisplay *display = window->display;
       MetaKeyBindingManager *keys = &display->key_binding_manager;
+      Window xwindow;
 
-      if (window->grab_on_frame &&
-          window->frame != NULL)
-        change_window_keygrabs (keys, window->frame->xwindow, FALSE);
-      else if (!window->grab_on_frame)
-        change_window_keygrabs (keys, window->xwindow, FALSE);
+      xwindow = get_window_keygrab_xwindow (window);
+      if (xwindow != None)
+        change_window_keygrabs (keys, xwindow, FALSE);
 
       window->keys_grabbed = FALSE;
     }
 }
 
+static void
+change_keygrabs (MetaKeyBindingManager *keys,
+                 Window                 xwindow,
+                 gboolean               grab,
+                 GHashTable            *keygrabs)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  g_hash_table_iter_init (&iter, keygrabs);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      guint32 keygrab = GPOINTER_TO_UINT (key);
+      xkb_keycode_t keycode = keygrab >> 16;
+      MetaResolvedKeyCombo resolved_combo = {
+        .keycodes = &keycode,
+        .len = 1,
+        .mask = keygrab & 0xffff,
+      };
+
+      meta_change_keygrab (keys, xwindow, grab, &resolved_combo);
+    }
+}
+
+static void
+change_keygrabs_everywhere (MetaDisplay *display,
+                            GSList      *windows,
+                            gboolean     grab,
+                            GHashTable  *root_keygrabs,
+                            GHashTable  *window_keygrabs)
+{
+  MetaKeyBindingManager *keys = &display->key_binding_manager;
+  GSList *l;
+
+  if (display->x11_display && display->x11_display->keys_grabbed)
+    change_keygrabs (keys, display->x11_display->xroot, grab,
+                     root_keygrabs);
+
+  for (l = windows; l; l = l->next)
+    {
+      Window xwindow = get_window_keygrab_xwindow (l->data);
+
+      if (xwindow != None)
+        change_keygrabs (keys, xwindow, grab, window_keygrabs);
+    }
+}
+
+static void
+add_missing_keygrabs (GHashTable *keygrabs,
+                      GHashTable *other_keygrabs,
+                      GHashTable *out_keygrabs)
+{
+  GHashTableIter iter;
+  gpointer key;
+
+  g_hash_table_iter_init (&iter, keygrabs);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      if (!other_keygrabs || !g_hash_table_contains (other_keygrabs, key))
+        g_hash_table_add (out_keygrabs, key);
+    }
+}
+
+/* Computes which of the old keygrabs need to be ungrabbed and which of the
+ * new ones need to be grabbed, leaving keys that are grabbed in both alone,
+ * unless everything needs to be regrabbed.
+ */
+void
+meta_key_binding_diff_keygrabs (GHashTable *old_keygrabs,
+                                GHashTable *new_keygrabs,
+                                gboolean    regrab_all,
+                                GHashTable *out_ungrab_keygrabs,
+                                GHashTable *out_grab_keygrabs)
+{
+  add_missing_keygrabs (old_keygrabs,
+                        regrab_all ? NULL : new_keygrabs,
+                        out_ungrab_keygrabs);
+  add_missing_keygrabs (new_keygrabs,
+                        regrab_all ? NULL : old_keygrabs,
+                        out_grab_keygrabs);
+}
+
+/* Moves the grabs on the root window and on windows with grabbed keys from
+ * the old keygrabs to the current ones, leaving keys that are grabbed in
+ * both alone; switching layouts usually only changes a few of them.
+ */
+static void
+update_keygrabs (MetaDisplay    *display,
+                 GHashTable     *old_root_keygrabs,
+                 GHashTable     *old_window_keygrabs,
+                 xkb_mod_mask_t  old_ignored_modifier_mask)
+{
+  MetaKeyBindingManager *keys = &display->key_binding_manager;
+  g_autoptr (GHashTable) root_keygrabs = NULL;
+  g_autoptr (GHashTable) window_keygrabs = NULL;
+  g_autoptr (GHashTable) root_ungrabs = NULL;
+  g_autoptr (GHashTable) window_ungrabs = NULL;
+  g_autoptr (GHashTable) root_grabs = NULL;
+  g_autoptr (GHashTable) window_grabs = NULL;
+  g_autoptr (GSList) windows = NULL;
+  xkb_mod_mask_t ignored_modifier_mask;
+  gboolean regrab_all;
+
+  if (meta_is_wayland_compositor ())
+    return;
+
+  root_keygrabs = g_hash_table_new (NULL, NULL);
+  window_keygrabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_manager_collect_keygrabs (keys,
+                                             root_keygrabs,
+                                             window_keygrabs);
+
+  /* Keys are grabbed along with every combination of ignored modifiers,
+   * so all grabs need to be redone if those changed.
+   */
+  ignored_modifier_mask = keys->ignored_modifier_mask;
+  regrab_all = ignored_modifier_mask != old_ignored_modifier_mask;
+
+  root_ungrabs = g_hash_table_new (NULL, NULL);
+  root_grabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_diff_keygrabs (old_root_keygrabs, root_keygrabs,
+                                  regrab_all,
+                                  root_ungrabs, root_grabs);
+
+  window_ungrabs = g_hash_table_new (NULL, NULL);
+  window_grabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_diff_keygrabs (old_window_keygrabs, window_keygrabs,
+                                  regrab_all,
+                                  window_ungrabs, window_grabs);
+
+  windows = meta_display_list_windows (display, META_LIST_DEFAULT);
+
+  keys->ignored_modifier_mask = old_ignored_modifier_mask;
+  change_keygrabs_everywhere (display, windows, FALSE,
+                              root_ungrabs, window_ungrabs);
+  keys->ignored_modifier_mask = ignored_modifier_mask;
+
+  change_keygrabs_everywhere (display, windows, TRUE,
+                              root_grabs, window_grabs);
+}
+
 static void
 handle_external_grab (MetaDisplay     *display,
                       MetaWindow      *window,
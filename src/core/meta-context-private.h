@@ -78,6 +78,9 @@ MetaServiceChannel * meta_context_get_service_channel (MetaContext *context);
 
 MetaX11DisplayPolicy meta_context_get_x11_display_policy (MetaContext *context);
 
+META_EXPORT_TEST
+int64_t meta_context_get_time_to_first_frame_us (MetaContext *context);
+
 #ifdef HAVE_X11
 META_EXPORT_TEST
 gboolean meta_context_is_x11_sync (MetaContext *context);
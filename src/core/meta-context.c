@@ -105,6 +105,13 @@ typedef struct _MetaContextPrivate
 #ifdef HAVE_WAYLAND
   MetaServiceChannel *service_channel;
 #endif
+
+  int64_t setup_time_us;
+  int64_t first_frame_time_us;
+  gulong stage_presented_handler_id;
+#ifdef COGL_HAS_TRACING
+  CoglTraceHead first_frame_trace;
+#endif
 } MetaContextPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MetaContext, meta_context, G_TYPE_OBJECT)
@@ -419,6 +426,14 @@ meta_context_setup (MetaContext  *context,
 
   g_warn_if_fail (priv->state == META_CONTEXT_STATE_CONFIGURED);
 
+  priv->setup_time_us = g_get_monotonic_time ();
+#ifdef COGL_HAS_TRACING
+  if (cogl_is_tracing_enabled ())
+    cogl_trace_begin (&priv->first_frame_trace, "Context: Time to first frame");
+#endif
+
+  COGL_TRACE_BEGIN_SCOPED (MetaContextSetup, "Context: Setup");
+
   if (!priv->plugin_name && priv->plugin_gtype == G_TYPE_NONE)
     {
       priv->state = META_CONTEXT_STATE_TERMINATED;
@@ -451,23 +466,75 @@ meta_context_setup (MetaContext  *context,
   return TRUE;
 }
 
+static void
+on_stage_presented (ClutterStage     *stage,
+                    ClutterStageView *view,
+                    ClutterFrameInfo *frame_info,
+                    MetaContext      *context)
+{
+  MetaContextPrivate *priv = meta_context_get_instance_private (context);
+
+  priv->first_frame_time_us = g_get_monotonic_time ();
+  g_clear_signal_handler (&priv->stage_presented_handler_id, stage);
+
+#ifdef COGL_HAS_TRACING
+  if (priv->first_frame_trace.name && cogl_is_tracing_enabled ())
+    cogl_trace_end (&priv->first_frame_trace);
+#endif
+
+  meta_topic (META_DEBUG_STARTUP, "First frame presented after %.3f ms",
+              (priv->first_frame_time_us - priv->setup_time_us) / 1000.0);
+}
+
+/*
+ * Returns the time it took from the start of meta_context_setup() until the
+ * stage presented its first frame, or -1 if no frame was presented yet.
+ */
+int64_t
+meta_context_get_time_to_first_frame_us (MetaContext *context)
+{
+  MetaContextPrivate *priv = meta_context_get_instance_private (context);
+
+  if (!priv->first_frame_time_us)
+    return -1;
+
+  return priv->first_frame_time_us - priv->setup_time_us;
+}
+
 gboolean
 meta_context_start (MetaContext  *context,
                     GError      **error)
 {
   MetaContextPrivate *priv = meta_context_get_instance_private (context);
+  ClutterActor *stage;
 
   g_warn_if_fail (priv->state == META_CONTEXT_STATE_SETUP);
 
+  COGL_TRACE_BEGIN_SCOPED (MetaContextStart, "Context: Start");
+
+  stage = meta_backend_get_stage (priv->backend);
+  priv->stage_presented_handler_id =
+    g_signal_connect (stage, "presented",
+                      G_CALLBACK (on_stage_presented), context);
+
+  COGL_TRACE_BEGIN (MetaContextStartPrefs, "Context: Init preferences");
   meta_prefs_init ();
+  COGL_TRACE_END (MetaContextStartPrefs);
 
 #ifdef HAVE_WAYLAND
   if (meta_context_get_compositor_type (context) ==
       META_COMPOSITOR_TYPE_WAYLAND)
-    priv->wayland_compositor = meta_wayland_compositor_new (context);
+    {
+      COGL_TRACE_BEGIN (MetaContextStartWayland,
+                        "Context: Create Wayland compositor");
+      priv->wayland_compositor = meta_wayland_compositor_new (context);
+      COGL_TRACE_END (MetaContextStartWayland);
+    }
 #endif
 
+  COGL_TRACE_BEGIN (MetaContextStartDisplay, "Context: Create display");
   priv->display = meta_display_new (context, error);
+  COGL_TRACE_END (MetaContextStartDisplay);
   if (!priv->display)
     {
       priv->state = META_CONTEXT_STATE_TERMINATED;
@@ -729,6 +796,12 @@ meta_context_dispose (GObject *object)
     meta_wayland_compositor_prepare_shutdown (priv->wayland_compositor);
 #endif
 
+  if (priv->backend)
+    {
+      g_clear_signal_handler (&priv->stage_presented_handler_id,
+                              meta_backend_get_stage (priv->backend));
+    }
+
   if (priv->display)
     meta_display_close (priv->display, META_CURRENT_TIME);
   g_clear_object (&priv->display);
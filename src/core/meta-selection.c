@@ -21,9 +21,21 @@
 
 #include "config.h"
 
+#ifdef HAVE_SPLICE
+#include <errno.h>
+#include <fcntl.h>
+#include <glib-unix.h>
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
+#include <sys/stat.h>
+#endif
+
 #include "core/meta-selection-private.h"
 #include "meta/meta-selection.h"
 
+/* Maximum amount of data moved per read/write or splice() call */
+#define TRANSFER_CHUNK_SIZE (64 * 1024)
+
 typedef struct TransferRequest TransferRequest;
 
 struct _MetaSelection
@@ -40,6 +52,7 @@ struct TransferRequest
   GOutputStream *ostream;
   gssize len;
   GSource *timeout_source;
+  GSource *splice_source;
   GCancellable *cancellable;
   GCancellable *external_cancellable;
   gulong cancellable_signal_handler;
@@ -260,6 +273,12 @@ transfer_request_free (TransferRequest *request)
       g_clear_pointer (&request->timeout_source, g_source_unref);
     }
 
+  if (request->splice_source)
+    {
+      g_source_destroy (request->splice_source);
+      g_clear_pointer (&request->splice_source, g_source_unref);
+    }
+
   g_clear_object (&request->cancellable);
   g_clear_object (&request->istream);
   g_clear_object (&request->ostream);
@@ -364,13 +383,160 @@ read_selection_source_async (GTask           *task,
                              TransferRequest *request)
 {
   g_input_stream_read_bytes_async (request->istream,
-                                   (gsize) request->len,
+                                   MIN ((gsize) request->len,
+                                        TRANSFER_CHUNK_SIZE),
                                    G_PRIORITY_DEFAULT,
                                    g_task_get_cancellable (task),
                                    (GAsyncReadyCallback) read_cb,
                                    task);
 }
 
+#ifdef HAVE_SPLICE
+static gboolean
+is_pipe_fd (int fd)
+{
+  struct stat stat_buf;
+
+  if (fstat (fd, &stat_buf) != 0)
+    return FALSE;
+
+  return S_ISFIFO (stat_buf.st_mode);
+}
+
+static gboolean
+can_splice_transfer (TransferRequest *request)
+{
+  int in_fd, out_fd;
+
+  if (!G_IS_UNIX_INPUT_STREAM (request->istream) ||
+      !G_IS_UNIX_OUTPUT_STREAM (request->ostream))
+    return FALSE;
+
+  in_fd = g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (request->istream));
+  out_fd = g_unix_output_stream_get_fd (G_UNIX_OUTPUT_STREAM (request->ostream));
+
+  /* SPLICE_F_NONBLOCK only applies to pipes, with anything else on either
+   * end splice() could block the compositor.
+   */
+  return is_pipe_fd (in_fd) && is_pipe_fd (out_fd);
+}
+
+static gboolean splice_transfer_cb (int           fd,
+                                    GIOCondition  condition,
+                                    gpointer      user_data);
+
+static void
+watch_splice_fd (GTask        *task,
+                 int           fd,
+                 GIOCondition  condition)
+{
+  TransferRequest *request = g_task_get_task_data (task);
+  GSource *cancellable_source;
+
+  if (request->splice_source)
+    {
+      g_source_destroy (request->splice_source);
+      g_clear_pointer (&request->splice_source, g_source_unref);
+    }
+
+  request->splice_source = g_unix_fd_source_new (fd, condition);
+  g_source_set_callback (request->splice_source,
+                         (GSourceFunc) splice_transfer_cb,
+                         task, NULL);
+
+  cancellable_source = g_cancellable_source_new (g_task_get_cancellable (task));
+  g_source_set_dummy_callback (cancellable_source);
+  g_source_add_child_source (request->splice_source, cancellable_source);
+  g_source_unref (cancellable_source);
+
+  g_source_attach (request->splice_source, NULL);
+}
+
+static gboolean
+splice_transfer_cb (int           fd,
+                    GIOCondition  condition,
+                    gpointer      user_data)
+{
+  GTask *task = user_data;
+  TransferRequest *request = g_task_get_task_data (task);
+  int in_fd, out_fd;
+  size_t chunk_size = TRANSFER_CHUNK_SIZE;
+  ssize_t n_spliced = 0;
+
+  if (g_task_return_error_if_cancelled (task))
+    {
+      g_object_unref (task);
+      return G_SOURCE_REMOVE;
+    }
+
+  in_fd = g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (request->istream));
+  out_fd = g_unix_output_stream_get_fd (G_UNIX_OUTPUT_STREAM (request->ostream));
+
+  if (request->len >= 0)
+    chunk_size = MIN (chunk_size, (size_t) request->len);
+
+  if (chunk_size > 0)
+    {
+      n_spliced = splice (in_fd, NULL, out_fd, NULL, chunk_size,
+                          SPLICE_F_MOVE | SPLICE_F_NONBLOCK);
+    }
+
+  if (n_spliced > 0)
+    {
+      if (request->len >= 0)
+        request->len -= n_spliced;
+
+      return G_SOURCE_CONTINUE;
+    }
+  else if (n_spliced < 0 && errno == EINTR)
+    {
+      return G_SOURCE_CONTINUE;
+    }
+  else if (n_spliced < 0 && errno == EAGAIN)
+    {
+      /* Whichever end we were not waiting on is the one that would block */
+      if (fd == in_fd)
+        watch_splice_fd (task, out_fd, G_IO_OUT);
+      else
+        watch_splice_fd (task, in_fd, G_IO_IN);
+
+      return G_SOURCE_CONTINUE;
+    }
+  else if (n_spliced < 0)
+    {
+      int errsv = errno;
+
+      g_task_return_new_error (task, G_IO_ERROR,
+                               g_io_error_from_errno (errsv),
+                               "Error splicing selection data: %s",
+                               g_strerror (errsv));
+      g_object_unref (task);
+      return G_SOURCE_REMOVE;
+    }
+
+  /* Same semantics as the unbounded g_output_stream_splice_async() path */
+  if (request->len < 0)
+    {
+      g_input_stream_close (request->istream, NULL, NULL);
+      g_output_stream_close (request->ostream, NULL, NULL);
+    }
+
+  g_task_return_boolean (task, TRUE);
+  g_object_unref (task);
+  return G_SOURCE_REMOVE;
+}
+
+static void
+splice_transfer_async (GTask           *task,
+                       TransferRequest *request)
+{
+  int in_fd;
+
+  in_fd = g_unix_input_stream_get_fd (G_UNIX_INPUT_STREAM (request->istream));
+  watch_splice_fd (task, in_fd, G_IO_IN);
+}
+#endif /* HAVE_SPLICE */
+
 static void
 source_read_cb (MetaSelectionSource *source,
                 GAsyncResult        *result,
@@ -391,6 +557,17 @@ source_read_cb (MetaSelectionSource *source,
   request = g_task_get_task_data (task);
   request->istream = stream;
 
+#ifdef HAVE_SPLICE
+  /* Move data between pipes in the kernel, without copying it through
+   * user space.
+   */
+  if (can_splice_transfer (request))
+    {
+      splice_transfer_async (task, request);
+      return;
+    }
+#endif
+
   if (request->len < 0)
     {
       g_output_stream_splice_async (request->ostream,
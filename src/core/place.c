@@ -44,65 +44,23 @@ typedef enum
   META_BOTTOM
 } MetaWindowDirection;
 
-static gint
-northwest_cmp (gconstpointer a,
-               gconstpointer b)
+typedef struct _CascadeCandidate
 {
-  MetaWindow *aw = (gpointer) a;
-  MetaWindow *bw = (gpointer) b;
-  MetaRectangle a_frame;
-  MetaRectangle b_frame;
-  int from_origin_a;
-  int from_origin_b;
-  int ax, ay, bx, by;
-
-  meta_window_get_frame_rect (aw, &a_frame);
-  meta_window_get_frame_rect (bw, &b_frame);
-  ax = a_frame.x;
-  ay = a_frame.y;
-  bx = b_frame.x;
-  by = b_frame.y;
-
-  /* probably there's a fast good-enough-guess we could use here. */
-  from_origin_a = sqrt (ax * ax + ay * ay);
-  from_origin_b = sqrt (bx * bx + by * by);
-
-  if (from_origin_a < from_origin_b)
-    return -1;
-  else if (from_origin_a > from_origin_b)
-    return 1;
-  else
-    return 0;
-}
+  MetaRectangle frame_rect;
+  int titlebar_height;
+  int distance;
+} CascadeCandidate;
 
 static gint
-northeast_cmp (gconstpointer a,
-               gconstpointer b,
-               gpointer      user_data)
+cascade_candidate_cmp (gconstpointer a,
+                       gconstpointer b)
 {
-  MetaWindow *aw = (gpointer) a;
-  MetaWindow *bw = (gpointer) b;
-  MetaRectangle *area = user_data;
-  MetaRectangle a_frame;
-  MetaRectangle b_frame;
-  int from_origin_a;
-  int from_origin_b;
-  int ax, ay, bx, by;
-
-  meta_window_get_frame_rect (aw, &a_frame);
-  meta_window_get_frame_rect (bw, &b_frame);
-  ax = (area->x + area->width) - (a_frame.x + a_frame.width);
-  ay = a_frame.y;
-  bx = (area->x + area->width) - (b_frame.x + b_frame.width);
-  by = b_frame.y;
-
-  /* probably there's a fast good-enough-guess we could use here. */
-  from_origin_a = sqrt (ax * ax + ay * ay);
-  from_origin_b = sqrt (bx * bx + by * by);
-
-  if (from_origin_a < from_origin_b)
+  const CascadeCandidate *a_candidate = a;
+  const CascadeCandidate *b_candidate = b;
+
+  if (a_candidate->distance < b_candidate->distance)
     return -1;
-  else if (from_origin_a > from_origin_b)
+  else if (a_candidate->distance > b_candidate->distance)
     return 1;
   else
     return 0;
@@ -121,7 +79,8 @@ find_next_cascade (MetaWindow *window,
   MetaContext *context = meta_display_get_context (display);
   MetaBackend *backend = meta_context_get_backend (context);
   GList *tmp;
-  GList *sorted;
+  GArray *sorted;
+  guint i;
   int cascade_origin_x, cascade_x, cascade_y;
   MetaRectangle titlebar_rect;
   int x_threshold, y_threshold;
@@ -154,11 +113,34 @@ find_next_cascade (MetaWindow *window,
   current = meta_backend_get_current_logical_monitor (backend);
   meta_window_get_work_area_for_logical_monitor (window, current, &work_area);
 
-  sorted = g_list_copy (windows);
-  if (ltr)
-    sorted = g_list_sort (sorted, northwest_cmp);
-  else
-    sorted = g_list_sort_with_data (sorted, northeast_cmp, &work_area);
+  /* Sort the windows by distance from the corner the cascade starts in,
+   * fetching their geometry only once.
+   */
+  sorted = g_array_sized_new (FALSE, FALSE, sizeof (CascadeCandidate),
+                              g_list_length (windows));
+  for (tmp = windows; tmp; tmp = tmp->next)
+    {
+      MetaWindow *w = tmp->data;
+      CascadeCandidate candidate;
+      int dx, dy;
+
+      meta_window_get_frame_rect (w, &candidate.frame_rect);
+      meta_window_get_titlebar_rect (w, &titlebar_rect);
+      candidate.titlebar_height = titlebar_rect.height;
+
+      if (ltr)
+        dx = candidate.frame_rect.x;
+      else
+        dx = ((work_area.x + work_area.width) -
+              (candidate.frame_rect.x + candidate.frame_rect.width));
+      dy = candidate.frame_rect.y;
+
+      /* probably there's a fast good-enough-guess we could use here. */
+      candidate.distance = sqrt (dx * dx + dy * dy);
+
+      g_array_append_val (sorted, candidate);
+    }
+  g_array_sort (sorted, cascade_candidate_cmp);
 
   meta_window_get_frame_rect (window, &frame_rect);
   window_width = frame_rect.width;
@@ -173,21 +155,19 @@ find_next_cascade (MetaWindow *window,
   /* Find first cascade position that's not used. */
 
   cascade_stage = 0;
-  tmp = sorted;
-  while (tmp != NULL)
+  i = 0;
+  while (i < sorted->len)
     {
-      MetaWindow *w;
-      MetaRectangle w_frame_rect;
+      CascadeCandidate *candidate;
       int wx, ww, wy;
       gboolean nearby;
 
-      w = tmp->data;
+      candidate = &g_array_index (sorted, CascadeCandidate, i);
 
       /* we want frame position, not window position */
-      meta_window_get_frame_rect (w, &w_frame_rect);
-      wx = w_frame_rect.x;
-      ww = w_frame_rect.width;
-      wy = w_frame_rect.y;
+      wx = candidate->frame_rect.x;
+      ww = candidate->frame_rect.width;
+      wy = candidate->frame_rect.y;
 
       if (ltr)
         nearby = ABS (wx - cascade_x) < x_threshold &&
@@ -198,13 +178,11 @@ find_next_cascade (MetaWindow *window,
 
       if (nearby)
         {
-          meta_window_get_titlebar_rect (w, &titlebar_rect);
-
           /* Cascade the window evenly by the titlebar height; this isn't a typo. */
           cascade_x = ltr
-            ? wx + titlebar_rect.height
-            : wx + ww - titlebar_rect.height - window_width;
-          cascade_y = wy + titlebar_rect.height;
+            ? wx + candidate->titlebar_height
+            : wx + ww - candidate->titlebar_height - window_width;
+          cascade_y = wy + candidate->titlebar_height;
 
           /* If we go off the screen, start over with a new cascade */
           if (((cascade_x + window_width) >
@@ -230,7 +208,7 @@ find_next_cascade (MetaWindow *window,
                    (work_area.x + work_area.width)) &&
                   (cascade_x >= work_area.x))
                 {
-                  tmp = sorted;
+                  i = 0;
                   continue;
                 }
               else
@@ -246,14 +224,14 @@ find_next_cascade (MetaWindow *window,
           /* Keep searching for a further-down-the-diagonal window. */
         }
 
-      tmp = tmp->next;
+      i++;
     }
 
   /* cascade_x and cascade_y will match the last window in the list
    * that was "in the way" (in the approximate cascade diagonal)
    */
 
-  g_list_free (sorted);
+  g_array_free (sorted, TRUE);
 
   *new_x = cascade_x;
   *new_y = cascade_y;
@@ -423,99 +401,69 @@ avoid_being_obscured_as_second_modal_dialog (MetaWindow *window,
 }
 
 static gboolean
-rectangle_overlaps_some_window (MetaRectangle *rect,
-                                GList         *windows)
+window_blocks_placement (MetaWindow *window)
 {
-  GList *tmp;
-  MetaRectangle dest;
-
-  tmp = windows;
-  while (tmp != NULL)
+  switch (window->type)
     {
-      MetaWindow *other = tmp->data;
-      MetaRectangle other_rect;
-
-      switch (other->type)
-        {
-        case META_WINDOW_DOCK:
-        case META_WINDOW_SPLASHSCREEN:
-        case META_WINDOW_DESKTOP:
-        case META_WINDOW_DIALOG:
-        case META_WINDOW_MODAL_DIALOG:
-	/* override redirect window types: */
-	case META_WINDOW_DROPDOWN_MENU:
-	case META_WINDOW_POPUP_MENU:
-	case META_WINDOW_TOOLTIP:
-	case META_WINDOW_NOTIFICATION:
-	case META_WINDOW_COMBO:
-	case META_WINDOW_DND:
-	case META_WINDOW_OVERRIDE_OTHER:
-          break;
-
-        case META_WINDOW_NORMAL:
-        case META_WINDOW_UTILITY:
-        case META_WINDOW_TOOLBAR:
-        case META_WINDOW_MENU:
-          meta_window_get_frame_rect (other, &other_rect);
-
-          if (meta_rectangle_intersect (rect, &other_rect, &dest))
-            return TRUE;
-          break;
-        }
+    case META_WINDOW_DOCK:
+    case META_WINDOW_SPLASHSCREEN:
+    case META_WINDOW_DESKTOP:
+    case META_WINDOW_DIALOG:
+    case META_WINDOW_MODAL_DIALOG:
+    /* override redirect window types: */
+    case META_WINDOW_DROPDOWN_MENU:
+    case META_WINDOW_POPUP_MENU:
+    case META_WINDOW_TOOLTIP:
+    case META_WINDOW_NOTIFICATION:
+    case META_WINDOW_COMBO:
+    case META_WINDOW_DND:
+    case META_WINDOW_OVERRIDE_OTHER:
+      return FALSE;
 
-      tmp = tmp->next;
+    case META_WINDOW_NORMAL:
+    case META_WINDOW_UTILITY:
+    case META_WINDOW_TOOLBAR:
+    case META_WINDOW_MENU:
+      return TRUE;
     }
 
   return FALSE;
 }
 
+/* Orders by top edge, then by leading edge (left edge for LTR, right
+ * edge for RTL).
+ */
 static gint
-leftmost_cmp (gconstpointer a, gconstpointer b)
+top_then_leading_cmp (gconstpointer a,
+                      gconstpointer b,
+                      gpointer      user_data)
 {
-  MetaWindow *aw = (gpointer) a;
-  MetaWindow *bw = (gpointer) b;
-  MetaRectangle a_frame;
-  MetaRectangle b_frame;
-  int ax, bx;
-
-  meta_window_get_frame_rect (aw, &a_frame);
-  meta_window_get_frame_rect (bw, &b_frame);
-  ax = a_frame.x;
-  bx = b_frame.x;
-
-  if (ax < bx)
-    return -1;
-  else if (ax > bx)
-    return 1;
+  const MetaRectangle *a_frame = a;
+  const MetaRectangle *b_frame = b;
+  gboolean ltr = GPOINTER_TO_INT (user_data);
+
+  if (a_frame->y != b_frame->y)
+    return a_frame->y < b_frame->y ? -1 : 1;
+  else if (a_frame->x != b_frame->x)
+    return (a_frame->x < b_frame->x) == ltr ? -1 : 1;
   else
     return 0;
 }
 
+/* Orders by leading edge, then by top edge. */
 static gint
-rightmost_cmp (gconstpointer a,
-               gconstpointer b)
-{
-  return -leftmost_cmp (a, b);
-}
-
-static gint
-topmost_cmp (gconstpointer a, gconstpointer b)
+leading_then_top_cmp (gconstpointer a,
+                      gconstpointer b,
+                      gpointer      user_data)
 {
-  MetaWindow *aw = (gpointer) a;
-  MetaWindow *bw = (gpointer) b;
-  MetaRectangle a_frame;
-  MetaRectangle b_frame;
-  int ay, by;
-
-  meta_window_get_frame_rect (aw, &a_frame);
-  meta_window_get_frame_rect (bw, &b_frame);
-  ay = a_frame.y;
-  by = b_frame.y;
-
-  if (ay < by)
-    return -1;
-  else if (ay > by)
-    return 1;
+  const MetaRectangle *a_frame = a;
+  const MetaRectangle *b_frame = b;
+  gboolean ltr = GPOINTER_TO_INT (user_data);
+
+  if (a_frame->x != b_frame->x)
+    return (a_frame->x < b_frame->x) == ltr ? -1 : 1;
+  else if (a_frame->y != b_frame->y)
+    return a_frame->y < b_frame->y ? -1 : 1;
   else
     return 0;
 }
@@ -567,24 +515,49 @@ find_first_fit (MetaWindow         *window,
    * existing window in each of those cases.
    */
   int retval;
-  GList *below_sorted;
-  GList *end_sorted;
+  GArray *below_sorted;
+  GArray *end_sorted;
+  GArray *obstacles;
+  MetaRectangleIndex *obstacle_index;
   GList *tmp;
   MetaRectangle rect;
   MetaRectangle work_area;
   gboolean ltr = meta_get_locale_direction () == META_LOCALE_DIRECTION_LTR;
+  guint i;
 
   retval = FALSE;
 
-  /* Below each window */
-  below_sorted = g_list_copy (windows);
-  below_sorted = g_list_sort (below_sorted, ltr ? leftmost_cmp : rightmost_cmp);
-  below_sorted = g_list_sort (below_sorted, topmost_cmp);
+  /* Fetch the frame rects once; both the candidate positions and the
+   * overlap checks only depend on them. Windows that other windows may
+   * overlap are still used as candidates, but not as obstacles.
+   */
+  below_sorted = g_array_new (FALSE, FALSE, sizeof (MetaRectangle));
+  obstacles = g_array_new (FALSE, FALSE, sizeof (MetaRectangle));
+  for (tmp = windows; tmp; tmp = tmp->next)
+    {
+      MetaWindow *w = tmp->data;
+      MetaRectangle frame_rect;
+
+      meta_window_get_frame_rect (w, &frame_rect);
+      g_array_append_val (below_sorted, frame_rect);
+
+      if (window_blocks_placement (w))
+        g_array_append_val (obstacles, frame_rect);
+    }
+
+  obstacle_index =
+    meta_rectangle_index_new ((MetaRectangle *) obstacles->data,
+                              obstacles->len);
+  g_array_free (obstacles, TRUE);
 
   /* To the right of each window */
-  end_sorted = g_list_copy (windows);
-  end_sorted = g_list_sort (end_sorted, topmost_cmp);
-  end_sorted = g_list_sort (end_sorted, ltr ? leftmost_cmp : rightmost_cmp);
+  end_sorted = g_array_copy (below_sorted);
+  g_array_sort_with_data (end_sorted, leading_then_top_cmp,
+                          GINT_TO_POINTER (ltr));
+
+  /* Below each window */
+  g_array_sort_with_data (below_sorted, top_then_leading_cmp,
+                          GINT_TO_POINTER (ltr));
 
   meta_window_get_frame_rect (window, &rect);
 
@@ -607,7 +580,7 @@ find_first_fit (MetaWindow         *window,
   center_tile_rect_in_area (&rect, &work_area);
 
   if (meta_rectangle_contains_rect (&work_area, &rect) &&
-      !rectangle_overlaps_some_window (&rect, windows))
+      !meta_rectangle_index_overlaps (obstacle_index, &rect))
     {
       *new_x = rect.x;
       *new_y = rect.y;
@@ -618,19 +591,16 @@ find_first_fit (MetaWindow         *window,
     }
 
   /* try below each window */
-  tmp = below_sorted;
-  while (tmp != NULL)
+  for (i = 0; i < below_sorted->len; i++)
     {
-      MetaWindow *w = tmp->data;
-      MetaRectangle frame_rect;
+      MetaRectangle *frame_rect = &g_array_index (below_sorted,
+                                                  MetaRectangle, i);
 
-      meta_window_get_frame_rect (w, &frame_rect);
-
-      rect.x = frame_rect.x;
-      rect.y = frame_rect.y + frame_rect.height;
+      rect.x = frame_rect->x;
+      rect.y = frame_rect->y + frame_rect->height;
 
       if (meta_rectangle_contains_rect (&work_area, &rect) &&
-          !rectangle_overlaps_some_window (&rect, below_sorted))
+          !meta_rectangle_index_overlaps (obstacle_index, &rect))
         {
           *new_x = rect.x;
           *new_y = rect.y;
@@ -639,27 +609,22 @@ find_first_fit (MetaWindow         *window,
 
           goto out;
         }
-
-      tmp = tmp->next;
     }
 
   /* try to the right (or left in RTL environment) of each window */
-  tmp = end_sorted;
-  while (tmp != NULL)
+  for (i = 0; i < end_sorted->len; i++)
     {
-      MetaWindow *w = tmp->data;
-      MetaRectangle frame_rect;
-
-      meta_window_get_frame_rect (w, &frame_rect);
+      MetaRectangle *frame_rect = &g_array_index (end_sorted,
+                                                  MetaRectangle, i);
 
       if (ltr)
-        rect.x = frame_rect.x + frame_rect.width;
+        rect.x = frame_rect->x + frame_rect->width;
       else
-        rect.x = frame_rect.x - rect.width;
-      rect.y = frame_rect.y;
+        rect.x = frame_rect->x - rect.width;
+      rect.y = frame_rect->y;
 
       if (meta_rectangle_contains_rect (&work_area, &rect) &&
-          !rectangle_overlaps_some_window (&rect, end_sorted))
+          !meta_rectangle_index_overlaps (obstacle_index, &rect))
         {
           *new_x = rect.x;
           *new_y = rect.y;
@@ -668,13 +633,12 @@ find_first_fit (MetaWindow         *window,
 
           goto out;
         }
-
-      tmp = tmp->next;
     }
 
 out:
-  g_list_free (below_sorted);
-  g_list_free (end_sorted);
+  meta_rectangle_index_free (obstacle_index);
+  g_array_free (below_sorted, TRUE);
+  g_array_free (end_sorted, TRUE);
   return retval;
 }
 
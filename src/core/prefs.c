@@ -100,6 +100,7 @@ static gboolean gnome_accessibility = FALSE;
 static gboolean gnome_animations = TRUE;
 static gboolean locate_pointer_is_enabled = FALSE;
 static unsigned int check_alive_timeout = 5000;
+static unsigned int obscured_frame_callback_interval = 1000;
 static char *cursor_theme = NULL;
 /* cursor_size will, when running as an X11 compositing window manager, be the
  * actual cursor size, multiplied with the global window scaling factor. On
@@ -508,6 +509,13 @@ static MetaUintPreference preferences_uint[] =
       },
       &check_alive_timeout,
     },
+    {
+      { "obscured-frame-callback-interval",
+        SCHEMA_MUTTER,
+        META_PREF_OBSCURED_FRAME_CALLBACK_INTERVAL,
+      },
+      &obscured_frame_callback_interval,
+    },
     { { NULL, 0, 0 }, NULL },
   };
 
@@ -1689,6 +1697,9 @@ meta_preference_to_string (MetaPreference pref)
 
     case META_PREF_CHECK_ALIVE_TIMEOUT:
       return "CHECK_ALIVE_TIMEOUT";
+
+    case META_PREF_OBSCURED_FRAME_CALLBACK_INTERVAL:
+      return "OBSCURED_FRAME_CALLBACK_INTERVAL";
     }
 
   return "(unknown)";
@@ -2041,6 +2052,12 @@ meta_prefs_get_check_alive_timeout (void)
   return check_alive_timeout;
 }
 
+unsigned int
+meta_prefs_get_obscured_frame_callback_interval (void)
+{
+  return obscured_frame_callback_interval;
+}
+
 const char *
 meta_prefs_get_iso_next_group_option (void)
 {
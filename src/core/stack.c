@@ -155,6 +155,17 @@ on_stack_changed (MetaStack *stack)
 static void
 meta_stack_init (MetaStack *stack)
 {
+  stack->sorted_links = g_hash_table_new (NULL, NULL);
+  stack->by_position = g_ptr_array_new ();
+  stack->relayer_windows = g_hash_table_new (NULL, NULL);
+  stack->constraint_targets =
+    g_hash_table_new_full (NULL, NULL, NULL,
+                           (GDestroyNotify) g_ptr_array_unref);
+  stack->constraint_dependents =
+    g_hash_table_new_full (NULL, NULL, NULL,
+                           (GDestroyNotify) g_ptr_array_unref);
+  stack->need_regraph = TRUE;
+
   g_signal_connect (stack, "changed",
                     G_CALLBACK (on_stack_changed), NULL);
 }
@@ -165,6 +176,11 @@ meta_stack_finalize (GObject *object)
   MetaStack *stack = META_STACK (object);
 
   g_list_free (stack->sorted);
+  g_hash_table_destroy (stack->sorted_links);
+  g_ptr_array_free (stack->by_position, TRUE);
+  g_hash_table_destroy (stack->relayer_windows);
+  g_hash_table_destroy (stack->constraint_targets);
+  g_hash_table_destroy (stack->constraint_dependents);
 
   G_OBJECT_CLASS (meta_stack_parent_class)->finalize (object);
 }
@@ -253,6 +269,14 @@ meta_stack_new (MetaDisplay *display)
                        NULL);
 }
 
+static void
+invalidate_constraints (MetaStack *stack)
+{
+  g_hash_table_remove_all (stack->constraint_targets);
+  g_hash_table_remove_all (stack->constraint_dependents);
+  stack->need_regraph = TRUE;
+}
+
 static void
 meta_stack_changed (MetaStack *stack)
 {
@@ -283,13 +307,16 @@ meta_stack_add (MetaStack  *stack,
     meta_bug ("Window %s had stack position already", window->desc);
 
   stack->sorted = g_list_prepend (stack->sorted, window);
+  g_hash_table_insert (stack->sorted_links, window, stack->sorted);
   stack->need_resort = TRUE; /* may not be needed as we add to top */
   stack->need_constrain = TRUE;
   stack->need_relayer = TRUE;
+  invalidate_constraints (stack);
 
   g_signal_emit (stack, signals[WINDOW_ADDED], 0, window);
 
   window->stack_position = stack->n_positions;
+  g_ptr_array_add (stack->by_position, window);
   stack->n_positions += 1;
   meta_topic (META_DEBUG_STACK,
               "Window %s has stack_position initialized to %d",
@@ -317,8 +344,14 @@ meta_stack_remove (MetaStack  *stack,
                                           stack->n_positions - 1);
   window->stack_position = -1;
   stack->n_positions -= 1;
+  g_ptr_array_remove_index (stack->by_position, stack->n_positions);
 
-  stack->sorted = g_list_remove (stack->sorted, window);
+  stack->sorted =
+    g_list_delete_link (stack->sorted,
+                        g_hash_table_lookup (stack->sorted_links, window));
+  g_hash_table_remove (stack->sorted_links, window);
+  g_hash_table_remove (stack->relayer_windows, window);
+  invalidate_constraints (stack);
 
   g_signal_emit (stack, signals[WINDOW_REMOVED], 0, window);
 
@@ -330,8 +363,12 @@ void
 meta_stack_update_layer (MetaStack  *stack,
                          MetaWindow *window)
 {
-  MetaWorkspaceManager *workspace_manager = window->display->workspace_manager;
-  stack->need_relayer = TRUE;
+  MetaWorkspaceManager *workspace_manager = stack->display->workspace_manager;
+
+  if (!window)
+    stack->need_relayer = TRUE;
+  else if (meta_window_is_in_stack (window))
+    g_hash_table_add (stack->relayer_windows, window);
 
   meta_stack_changed (stack);
   meta_stack_update_window_tile_matches (stack, workspace_manager->active_workspace);
@@ -343,6 +380,7 @@ meta_stack_update_transient (MetaStack  *stack,
 {
   MetaWorkspaceManager *workspace_manager = window->display->workspace_manager;
   stack->need_constrain = TRUE;
+  invalidate_constraints (stack);
 
   meta_stack_changed (stack);
   meta_stack_update_window_tile_matches (stack, workspace_manager->active_workspace);
@@ -445,29 +483,6 @@ meta_stack_update_window_tile_matches (MetaStack     *stack,
   g_list_free (windows);
 }
 
-/* Front of the layer list is the topmost window,
- * so the lower stack position is later in the list
- */
-static int
-compare_window_position (void *a,
-                         void *b)
-{
-  MetaWindow *window_a = a;
-  MetaWindow *window_b = b;
-
-  /* Go by layer, then stack_position */
-  if (window_a->layer < window_b->layer)
-    return 1; /* move window_a later in list */
-  else if (window_a->layer > window_b->layer)
-    return -1;
-  else if (window_a->stack_position < window_b->stack_position)
-    return 1; /* move window_a later in list */
-  else if (window_a->stack_position > window_b->stack_position)
-    return -1;
-  else
-    return 0; /* not reached */
-}
-
 /*
  * Stacking constraints
  *
@@ -568,12 +583,43 @@ add_constraint (Constraint **constraints,
 }
 
 static void
-create_constraints (Constraint **constraints,
-                    GList       *windows)
+add_constraint_edge (MetaStack  *stack,
+                     MetaWindow *above,
+                     MetaWindow *below)
+{
+  GPtrArray *targets;
+  GPtrArray *dependents;
+
+  targets = g_hash_table_lookup (stack->constraint_targets, above);
+  if (!targets)
+    {
+      targets = g_ptr_array_new ();
+      g_hash_table_insert (stack->constraint_targets, above, targets);
+    }
+  g_ptr_array_add (targets, below);
+
+  dependents = g_hash_table_lookup (stack->constraint_dependents, below);
+  if (!dependents)
+    {
+      dependents = g_ptr_array_new ();
+      g_hash_table_insert (stack->constraint_dependents, below, dependents);
+    }
+  g_ptr_array_add (dependents, above);
+}
+
+/* Work out which windows each window has to be kept above. This only
+ * depends on transiency, groups and window types, so it is cached across
+ * restacks and only redone once one of those changed.
+ */
+static void
+ensure_constraint_graph (MetaStack *stack)
 {
   GList *tmp;
 
-  tmp = windows;
+  if (!stack->need_regraph)
+    return;
+
+  tmp = stack->sorted;
   while (tmp != NULL)
     {
       MetaWindow *w = tmp->data;
@@ -626,7 +672,7 @@ create_constraints (Constraint **constraints,
                   meta_topic (META_DEBUG_STACK,
                               "Constraining %s above %s as it's transient for its group",
                               w->desc, group_window->desc);
-                  add_constraint (constraints, w, group_window);
+                  add_constraint_edge (stack, w, group_window);
                 }
 
               tmp2 = tmp2->next;
@@ -645,12 +691,40 @@ create_constraints (Constraint **constraints,
               meta_topic (META_DEBUG_STACK,
                           "Constraining %s above %s due to transiency",
                           w->desc, parent->desc);
-              add_constraint (constraints, w, parent);
+              add_constraint_edge (stack, w, parent);
             }
         }
 
       tmp = tmp->next;
     }
+
+  stack->need_regraph = FALSE;
+}
+
+static void
+create_constraints (Constraint **constraints,
+                    MetaStack   *stack)
+{
+  GList *tmp;
+
+  ensure_constraint_graph (stack);
+
+  tmp = stack->sorted;
+  while (tmp != NULL)
+    {
+      MetaWindow *w = tmp->data;
+      GPtrArray *targets;
+      unsigned int i;
+
+      targets = g_hash_table_lookup (stack->constraint_targets, w);
+      if (targets)
+        {
+          for (i = 0; i < targets->len; i++)
+            add_constraint (constraints, w, g_ptr_array_index (targets, i));
+        }
+
+      tmp = tmp->next;
+    }
 }
 
 static void
@@ -811,6 +885,30 @@ apply_constraints (Constraint **constraints,
   g_slist_free (heads);
 }
 
+static void
+relayer_window (MetaStack  *stack,
+                MetaWindow *w)
+{
+  MetaStackLayer old_layer;
+
+  old_layer = w->layer;
+
+  w->layer = meta_window_calculate_layer (w);
+
+  if (w->layer != old_layer)
+    {
+      meta_topic (META_DEBUG_STACK,
+                  "Window %s moved from layer %u to %u",
+                  w->desc, old_layer, w->layer);
+      stack->need_resort = TRUE;
+      stack->need_constrain = TRUE;
+      /* don't need to constrain as constraining
+       * purely operates in terms of stack_position
+       * not layer
+       */
+    }
+}
+
 /**
  * stack_do_relayer:
  *
@@ -819,43 +917,70 @@ apply_constraints (Constraint **constraints,
 static void
 stack_do_relayer (MetaStack *stack)
 {
+  g_autoptr (GPtrArray) windows = NULL;
+  GHashTableIter iter;
+  gpointer key;
   GList *tmp;
+  unsigned int i;
 
-  if (!stack->need_relayer)
+  if (stack->need_relayer)
+    {
+      meta_topic (META_DEBUG_STACK,
+                  "Recomputing layers");
+
+      tmp = stack->sorted;
+
+      while (tmp != NULL)
+        {
+          relayer_window (stack, tmp->data);
+          tmp = tmp->next;
+        }
+
+      g_hash_table_remove_all (stack->relayer_windows);
+      stack->need_relayer = FALSE;
+      return;
+    }
+
+  if (g_hash_table_size (stack->relayer_windows) == 0)
     return;
 
   meta_topic (META_DEBUG_STACK,
-              "Recomputing layers");
+              "Recomputing layers of %u windows",
+              g_hash_table_size (stack->relayer_windows));
 
-  tmp = stack->sorted;
+  /* Windows kept above the changed ones may have been promoted to their
+   * previous layer while constraining, so recompute those as well.
+   */
+  ensure_constraint_graph (stack);
 
-  while (tmp != NULL)
-    {
-      MetaWindow *w;
-      MetaStackLayer old_layer;
+  windows = g_ptr_array_new ();
+  g_hash_table_iter_init (&iter, stack->relayer_windows);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    g_ptr_array_add (windows, key);
 
-      w = tmp->data;
-      old_layer = w->layer;
+  for (i = 0; i < windows->len; i++)
+    {
+      GPtrArray *dependents;
+      unsigned int j;
 
-      w->layer = meta_window_calculate_layer (w);
+      dependents = g_hash_table_lookup (stack->constraint_dependents,
+                                        g_ptr_array_index (windows, i));
+      if (!dependents)
+        continue;
 
-      if (w->layer != old_layer)
+      for (j = 0; j < dependents->len; j++)
         {
-          meta_topic (META_DEBUG_STACK,
-                      "Window %s moved from layer %u to %u",
-                      w->desc, old_layer, w->layer);
-          stack->need_resort = TRUE;
-          stack->need_constrain = TRUE;
-          /* don't need to constrain as constraining
-           * purely operates in terms of stack_position
-           * not layer
-           */
-        }
+          MetaWindow *dependent = g_ptr_array_index (dependents, j);
 
-      tmp = tmp->next;
+          if (g_hash_table_add (stack->relayer_windows, dependent))
+            g_ptr_array_add (windows, dependent);
+        }
     }
 
-  stack->need_relayer = FALSE;
+  for (i = 0; i < windows->len; i++)
+    relayer_window (stack, g_ptr_array_index (windows, i));
+
+  g_hash_table_remove_all (stack->relayer_windows);
 }
 
 /**
@@ -880,7 +1005,7 @@ stack_do_constrain (MetaStack *stack)
   constraints = g_new0 (Constraint*,
                         stack->n_positions);
 
-  create_constraints (constraints, stack->sorted);
+  create_constraints (constraints, stack);
 
   graph_constraints (constraints, stack->n_positions);
 
@@ -900,14 +1025,57 @@ stack_do_constrain (MetaStack *stack)
 static void
 stack_do_resort (MetaStack *stack)
 {
+  GList *heads[META_LAYER_LAST + 1] = { NULL, };
+  GList *tails[META_LAYER_LAST + 1] = { NULL, };
+  GList *tail = NULL;
+  unsigned int i;
+  int layer;
+
   if (!stack->need_resort)
     return;
 
   meta_topic (META_DEBUG_STACK,
               "Sorting stack list");
 
-  stack->sorted = g_list_sort (stack->sorted,
-                               (GCompareFunc) compare_window_position);
+  /* Stack positions are unique and already indexed, so rather than
+   * sorting, relink the existing list nodes bucketed by layer, walking
+   * each layer from the bottom up so its topmost window ends up first.
+   */
+  for (i = 0; i < stack->by_position->len; i++)
+    {
+      MetaWindow *w = g_ptr_array_index (stack->by_position, i);
+      GList *link;
+
+      link = g_hash_table_lookup (stack->sorted_links, w);
+      layer = MIN (w->layer, META_LAYER_LAST);
+
+      link->prev = NULL;
+      link->next = heads[layer];
+      if (heads[layer])
+        heads[layer]->prev = link;
+      else
+        tails[layer] = link;
+      heads[layer] = link;
+    }
+
+  stack->sorted = NULL;
+  for (layer = META_LAYER_LAST; layer >= 0; layer--)
+    {
+      if (!heads[layer])
+        continue;
+
+      if (tail)
+        {
+          tail->next = heads[layer];
+          heads[layer]->prev = tail;
+        }
+      else
+        {
+          stack->sorted = heads[layer];
+        }
+
+      tail = tails[layer];
+    }
 
   meta_display_queue_check_fullscreen (stack->display);
 
@@ -968,7 +1136,7 @@ meta_stack_get_above (MetaStack  *stack,
 
   stack_ensure_sorted (stack);
 
-  link = g_list_find (stack->sorted, window);
+  link = g_hash_table_lookup (stack->sorted_links, window);
   if (link == NULL)
     return NULL;
   if (link->prev == NULL)
@@ -993,7 +1161,7 @@ meta_stack_get_below (MetaStack  *stack,
 
   stack_ensure_sorted (stack);
 
-  link = g_list_find (stack->sorted, window);
+  link = g_hash_table_lookup (stack->sorted_links, window);
 
   if (link == NULL)
     return NULL;
@@ -1058,31 +1226,17 @@ meta_stack_windows_cmp (MetaStack  *stack,
     return 0; /* not reached */
 }
 
-static int
-compare_just_window_stack_position (void *a,
-                                    void *b)
-{
-  MetaWindow *window_a = a;
-  MetaWindow *window_b = b;
-
-  if (window_a->stack_position < window_b->stack_position)
-    return -1; /* move window_a earlier in list */
-  else if (window_a->stack_position > window_b->stack_position)
-    return 1;
-  else
-    return 0; /* not reached */
-}
-
 GList *
 meta_stack_get_positions (MetaStack *stack)
 {
-  GList *tmp;
+  GList *tmp = NULL;
+  unsigned int i;
 
   /* Make sure to handle any adds or removes */
   stack_ensure_sorted (stack);
 
-  tmp = g_list_copy (stack->sorted);
-  tmp = g_list_sort (tmp, (GCompareFunc) compare_just_window_stack_position);
+  for (i = stack->by_position->len; i > 0; i--)
+    tmp = g_list_prepend (tmp, g_ptr_array_index (stack->by_position, i - 1));
 
   return tmp;
 }
@@ -1148,10 +1302,12 @@ meta_stack_set_positions (MetaStack *stack,
   stack->need_constrain = TRUE;
 
   i = 0;
-  tmp = windows;
+  tmp = stack->sorted;
   while (tmp != NULL)
     {
       MetaWindow *w = tmp->data;
+      g_hash_table_insert (stack->sorted_links, w, tmp);
+      g_ptr_array_index (stack->by_position, i) = w;
       w->stack_position = i++;
       tmp = tmp->next;
     }
@@ -1167,10 +1323,11 @@ void
 meta_window_set_stack_position_no_sync (MetaWindow *window,
                                         int         position)
 {
-  int low, high, delta;
-  GList *tmp;
+  MetaStack *stack = window->display->stack;
+  MetaWindow **windows;
+  int i;
 
-  g_return_if_fail (window->display->stack != NULL);
+  g_return_if_fail (stack != NULL);
   g_return_if_fail (window->stack_position >= 0);
   g_return_if_fail (position >= 0);
   g_return_if_fail (position < window->display->stack->n_positions);
@@ -1182,34 +1339,30 @@ meta_window_set_stack_position_no_sync (MetaWindow *window,
       return;
     }
 
-  window->display->stack->need_resort = TRUE;
-  window->display->stack->need_constrain = TRUE;
+  stack->need_resort = TRUE;
+  stack->need_constrain = TRUE;
+
+  /* Only the windows between the old and new position shift by one */
+  windows = (MetaWindow **) stack->by_position->pdata;
 
   if (position < window->stack_position)
     {
-      low = position;
-      high = window->stack_position - 1;
-      delta = 1;
+      for (i = window->stack_position; i > position; i--)
+        {
+          windows[i] = windows[i - 1];
+          windows[i]->stack_position = i;
+        }
     }
   else
     {
-      low = window->stack_position + 1;
-      high = position;
-      delta = -1;
-    }
-
-  tmp = window->display->stack->sorted;
-  while (tmp != NULL)
-    {
-      MetaWindow *w = tmp->data;
-
-      if (w->stack_position >= low &&
-          w->stack_position <= high)
-        w->stack_position += delta;
-
-      tmp = tmp->next;
+      for (i = window->stack_position; i < position; i++)
+        {
+          windows[i] = windows[i + 1];
+          windows[i]->stack_position = i;
+        }
     }
 
+  windows[position] = window;
   window->stack_position = position;
 
   meta_topic (META_DEBUG_STACK,
@@ -60,6 +60,27 @@ struct _MetaStack
   /** The MetaWindows of the windows we manage, sorted in order. */
   GList *sorted;
 
+  /** The link of each MetaWindow in sorted, for constant time lookups. */
+  GHashTable *sorted_links;
+
+  /** The MetaWindows of the windows we manage, indexed by stack_position. */
+  GPtrArray *by_position;
+
+  /**
+   * Windows whose layer needs to be recalculated, when not all of them
+   * need to be (see need_relayer).
+   */
+  GHashTable *relayer_windows;
+
+  /**
+   * Transiency constraints between the windows in the stack, kept across
+   * restacks: for each window, the windows it must be stacked above, and
+   * the windows that must be stacked above it. Rebuilt when need_regraph
+   * is set.
+   */
+  GHashTable *constraint_targets;
+  GHashTable *constraint_dependents;
+
   /**
    * If this is zero, the local stack oughtn't to be brought up to date with
    * the X server's stack, because it is in the middle of being updated.
@@ -96,6 +117,12 @@ struct _MetaStack
    * recalculated with respect to transiency (parent and child windows)?
    */
   unsigned int need_constrain : 1;
+
+  /**
+   * Has the transiency between windows changed, so that the cached
+   * constraints need to be rebuilt?
+   */
+  unsigned int need_regraph : 1;
 };
 
 #define META_TYPE_STACK (meta_stack_get_type ())
@@ -135,11 +162,11 @@ void       meta_stack_remove (MetaStack  *stack,
 /**
  * meta_stack_update_layer:
  * @stack: The stack to recalculate
- * @window: Dummy parameter
- *
- * Recalculates the correct layer for all windows in the stack,
- * and moves them about accordingly.
+ * @window: (nullable): The window whose layer may have changed
  *
+ * Recalculates the correct layer for @window and the windows constrained
+ * to stay above it, and moves them about accordingly. If @window is %NULL,
+ * the layers of all windows in the stack are recalculated.
  */
 void       meta_stack_update_layer (MetaStack  *stack,
                                     MetaWindow *window);
@@ -235,6 +262,7 @@ MetaWindow * meta_stack_get_bottom (MetaStack  *stack);
  * Returns: %NULL if there is no such window;
  *          the window above @window otherwise.
  */
+META_EXPORT_TEST
 MetaWindow * meta_stack_get_above (MetaStack  *stack,
                                    MetaWindow *window,
                                    gboolean    only_within_layer);
@@ -1577,8 +1577,8 @@ meta_window_unmanage (MetaWindow  *window,
     {
       MetaWorkspace *workspace = tmp->data;
 
-      g_assert (g_list_find (workspace->windows, window) == NULL);
-      g_assert (g_list_find (workspace->mru_list, window) == NULL);
+      g_assert (!g_hash_table_contains (workspace->window_links, window));
+      g_assert (!g_hash_table_contains (workspace->mru_links, window));
 
       tmp = tmp->next;
     }
@@ -4577,7 +4577,7 @@ meta_window_make_most_recent (MetaWindow *window)
       MetaWorkspace *workspace = l->data;
       GList *self, *link;
 
-      self = g_list_find (workspace->mru_list, window);
+      self = meta_workspace_get_mru_link (workspace, window);
       if (!self)
         continue;
 
@@ -4588,8 +4588,8 @@ meta_window_make_most_recent (MetaWindow *window)
       if (workspace == workspace_manager->active_workspace ||
           window->on_all_workspaces_requested)
         {
-          workspace->mru_list = g_list_delete_link (workspace->mru_list, self);
-          workspace->mru_list = g_list_prepend (workspace->mru_list, window);
+          meta_workspace_move_in_mru_list (workspace, window,
+                                           workspace->mru_list);
           continue;
         }
 
@@ -4602,11 +4602,7 @@ meta_window_make_most_recent (MetaWindow *window)
             break;
         }
 
-      if (link == self)
-        continue;
-
-      workspace->mru_list = g_list_delete_link (workspace->mru_list, self);
-      workspace->mru_list = g_list_insert_before (workspace->mru_list, link, window);
+      meta_workspace_move_in_mru_list (workspace, window, link);
     }
 }
 
@@ -5077,19 +5073,11 @@ lower_window_and_transients (MetaWindow *window,
           meta_window_located_on_workspace (window,
                                             workspace_manager->active_workspace))
         {
-          GList *link;
-          link = g_list_find (workspace_manager->active_workspace->mru_list,
-                              window);
-          g_assert (link);
-
-          workspace_manager->active_workspace->mru_list =
-            g_list_remove_link (workspace_manager->active_workspace->mru_list,
-                                link);
-          g_list_free (link);
-
-          workspace_manager->active_workspace->mru_list =
-            g_list_append (workspace_manager->active_workspace->mru_list,
-                           window);
+          g_assert (meta_workspace_get_mru_link (workspace_manager->active_workspace,
+                                                 window));
+
+          meta_workspace_move_in_mru_list (workspace_manager->active_workspace,
+                                           window, NULL);
         }
     }
 
@@ -5445,8 +5433,13 @@ meta_window_type_changed (MetaWindow *window)
   else
     meta_window_destroy_frame (window);
 
-  /* update stacking constraints */
+  /* update stacking constraints, as the type decides both the layer and
+   * whether the window is kept above its parent or its group */
+  meta_stack_freeze (window->display->stack);
   meta_window_update_layer (window);
+  if (!window->override_redirect)
+    meta_stack_update_transient (window->display->stack, window);
+  meta_stack_thaw (window->display->stack);
 
   meta_window_grab_keys (window);
 
@@ -6191,13 +6184,14 @@ ensure_mru_position_after (MetaWindow *window,
    */
 
   MetaWorkspaceManager *workspace_manager = window->display->workspace_manager;
-  GList* active_mru_list;
+  MetaWorkspace *active_workspace = workspace_manager->active_workspace;
   GList* window_position;
   GList* after_this_one_position;
 
-  active_mru_list         = workspace_manager->active_workspace->mru_list;
-  window_position         = g_list_find (active_mru_list, window);
-  after_this_one_position = g_list_find (active_mru_list, after_this_one);
+  window_position         = meta_workspace_get_mru_link (active_workspace,
+                                                         window);
+  after_this_one_position = meta_workspace_get_mru_link (active_workspace,
+                                                         after_this_one);
 
   /* after_this_one_position is NULL when we switch workspaces, but in
    * that case we don't need to do any MRU shuffling so we can simply
@@ -6208,14 +6202,8 @@ ensure_mru_position_after (MetaWindow *window,
 
   if (g_list_length (window_position) > g_list_length (after_this_one_position))
     {
-      workspace_manager->active_workspace->mru_list =
-        g_list_delete_link (workspace_manager->active_workspace->mru_list,
-                            window_position);
-
-      workspace_manager->active_workspace->mru_list =
-        g_list_insert_before (workspace_manager->active_workspace->mru_list,
-                              after_this_one_position->next,
-                              window);
+      meta_workspace_move_in_mru_list (active_workspace, window,
+                                       after_this_one_position->next);
     }
 }
 
@@ -41,6 +41,8 @@ struct _MetaWorkspace
   MetaWorkspaceManager *manager;
 
   GList *windows;
+  /* The link of each window in windows */
+  GHashTable *window_links;
 
   /* The "MRU list", or "most recently used" list, is a list of
    * MetaWindows ordered based on the time the the user interacted
@@ -52,6 +54,8 @@ struct _MetaWorkspace
    * can sometimes be not the window the user interacted with last,
    */
   GList *mru_list;
+  /* The link of each window in mru_list */
+  GHashTable *mru_links;
 
   GList  *list_containing_self;
 
@@ -82,6 +86,12 @@ void           meta_workspace_remove_window (MetaWorkspace *workspace,
 void           meta_workspace_relocate_windows (MetaWorkspace *workspace,
                                                 MetaWorkspace *new_home);
 
+GList * meta_workspace_get_mru_link (MetaWorkspace *workspace,
+                                     MetaWindow    *window);
+void    meta_workspace_move_in_mru_list (MetaWorkspace *workspace,
+                                         MetaWindow    *window,
+                                         GList         *sibling);
+
 void meta_workspace_get_work_area_for_logical_monitor (MetaWorkspace      *workspace,
                                                        MetaLogicalMonitor *logical_monitor,
                                                        MetaRectangle      *area);
@@ -177,7 +177,7 @@ meta_workspace_get_property (GObject      *object,
        * This is reliable, but not very efficient; should we store
        * the list length ?
        */
-      g_value_set_uint (value, g_list_length (ws->windows));
+      g_value_set_uint (value, g_hash_table_size (ws->window_links));
       break;
     case PROP_WORKSPACE_INDEX:
       g_value_set_uint (value, meta_workspace_index (ws));
@@ -253,7 +253,9 @@ meta_workspace_new (MetaWorkspaceManager *workspace_manager)
   workspace_manager->workspaces =
     g_list_append (workspace_manager->workspaces, workspace);
   workspace->windows = NULL;
+  workspace->window_links = g_hash_table_new (NULL, NULL);
   workspace->mru_list = NULL;
+  workspace->mru_links = g_hash_table_new (NULL, NULL);
 
   workspace->work_areas_invalid = TRUE;
   workspace->work_area_screen.x = 0;
@@ -341,6 +343,9 @@ meta_workspace_remove (MetaWorkspace *workspace)
   meta_workspace_clear_logical_monitor_data (workspace);
 
   g_list_free (workspace->mru_list);
+  g_hash_table_destroy (workspace->mru_links);
+  g_list_free (workspace->windows);
+  g_hash_table_destroy (workspace->window_links);
   g_list_free (workspace->list_containing_self);
 
   workspace_free_builtin_struts (workspace);
@@ -367,20 +372,27 @@ meta_workspace_remove (MetaWorkspace *workspace)
    */
 }
 
+/* Whether window is one of the windows of the workspace listed by
+ * meta_workspace_list_windows(); workspace->windows also contains
+ * override-redirect windows, and windows that are being unmanaged.
+ */
+static gboolean
+is_listed_window (MetaWindow *window)
+{
+  return !window->override_redirect && !window->unmanaging;
+}
+
 static void
 update_workspace_default_focus (MetaWorkspace *workspace,
                                 MetaWindow    *not_this_one)
 {
-  g_autoptr (GSList) windows = NULL;
-  GSList *l;
+  GList *l;
 
-  windows = meta_display_list_windows (workspace->display, META_LIST_DEFAULT);
-  for (l = windows; l; l = l->next)
+  for (l = workspace->windows; l; l = l->next)
     {
       MetaWindow *window = META_WINDOW (l->data);
 
-      if (meta_window_located_on_workspace (window, workspace) &&
-          window != not_this_one)
+      if (is_listed_window (window) && window != not_this_one)
         meta_window_update_appears_focused (window);
     }
 }
@@ -391,7 +403,7 @@ meta_workspace_add_window (MetaWorkspace *workspace,
 {
   MetaWorkspaceManager *workspace_manager;
 
-  g_return_if_fail (g_list_find (workspace->mru_list, window) == NULL);
+  g_return_if_fail (!g_hash_table_contains (workspace->mru_links, window));
 
   COGL_TRACE_BEGIN_SCOPED (MetaWorkspaceAddWindow,
                            "Workspace (add window)");
@@ -399,8 +411,10 @@ meta_workspace_add_window (MetaWorkspace *workspace,
   workspace_manager = workspace->display->workspace_manager;
 
   workspace->mru_list = g_list_prepend (workspace->mru_list, window);
+  g_hash_table_insert (workspace->mru_links, window, workspace->mru_list);
 
   workspace->windows = g_list_prepend (workspace->windows, window);
+  g_hash_table_insert (workspace->window_links, window, workspace->windows);
 
   if (window->struts)
     {
@@ -422,14 +436,24 @@ meta_workspace_remove_window (MetaWorkspace *workspace,
                               MetaWindow    *window)
 {
   MetaWorkspaceManager *workspace_manager = workspace->display->workspace_manager;
+  GList *link;
 
   COGL_TRACE_BEGIN_SCOPED (MetaWorkspaceRemoveWindow,
                            "Workspace (remove window)");
 
-  workspace->windows = g_list_remove (workspace->windows, window);
+  link = g_hash_table_lookup (workspace->window_links, window);
+  if (link)
+    {
+      workspace->windows = g_list_delete_link (workspace->windows, link);
+      g_hash_table_remove (workspace->window_links, window);
+    }
 
-  workspace->mru_list = g_list_remove (workspace->mru_list, window);
-  g_assert (g_list_find (workspace->mru_list, window) == NULL);
+  link = g_hash_table_lookup (workspace->mru_links, window);
+  if (link)
+    {
+      workspace->mru_list = g_list_delete_link (workspace->mru_list, link);
+      g_hash_table_remove (workspace->mru_links, window);
+    }
 
   if (window->struts)
     {
@@ -470,6 +494,35 @@ meta_workspace_relocate_windows (MetaWorkspace *workspace,
   assert_workspace_empty (workspace);
 }
 
+GList *
+meta_workspace_get_mru_link (MetaWorkspace *workspace,
+                             MetaWindow    *window)
+{
+  return g_hash_table_lookup (workspace->mru_links, window);
+}
+
+/* Moves window right before sibling in the MRU list, or to its end if
+ * sibling is NULL.
+ */
+void
+meta_workspace_move_in_mru_list (MetaWorkspace *workspace,
+                                 MetaWindow    *window,
+                                 GList         *sibling)
+{
+  GList *link;
+
+  link = g_hash_table_lookup (workspace->mru_links, window);
+  g_return_if_fail (link != NULL);
+
+  if (link == sibling)
+    return;
+
+  /* Reuse the link, so that mru_links stays valid */
+  workspace->mru_list = g_list_remove_link (workspace->mru_list, link);
+  workspace->mru_list = g_list_insert_before_link (workspace->mru_list,
+                                                   sibling, link);
+}
+
 void
 meta_workspace_queue_calc_showing  (MetaWorkspace *workspace)
 {
@@ -765,27 +818,55 @@ meta_workspace_index_changed (MetaWorkspace *workspace)
 GList*
 meta_workspace_list_windows (MetaWorkspace *workspace)
 {
-  GSList *display_windows, *l;
   GList *workspace_windows;
-
-  display_windows = meta_display_list_windows (workspace->display,
-                                               META_LIST_DEFAULT);
+  GList *l;
 
   workspace_windows = NULL;
-  for (l = display_windows; l != NULL; l = l->next)
+  for (l = workspace->windows; l != NULL; l = l->next)
     {
       MetaWindow *window = l->data;
 
-      if (meta_window_located_on_workspace (window, workspace))
+      if (is_listed_window (window))
         workspace_windows = g_list_prepend (workspace_windows,
                                             window);
     }
 
-  g_slist_free (display_windows);
-
   return workspace_windows;
 }
 
+/**
+ * meta_workspace_foreach_window:
+ * @workspace: a #MetaWorkspace
+ * @func: (scope call) (closure user_data): Called for each window on @workspace
+ * @user_data: User data
+ *
+ * Call @func for every window that meta_workspace_list_windows() would
+ * list, in most recently used order, without allocating a list. @func
+ * must not add windows to or remove windows from @workspace.
+ *
+ * Iteration will stop if @func at any point returns %FALSE.
+ */
+void
+meta_workspace_foreach_window (MetaWorkspace         *workspace,
+                               MetaWindowForeachFunc  func,
+                               void                  *user_data)
+{
+  GList *l;
+
+  g_return_if_fail (META_IS_WORKSPACE (workspace));
+
+  for (l = workspace->mru_list; l != NULL; l = l->next)
+    {
+      MetaWindow *window = l->data;
+
+      if (!is_listed_window (window))
+        continue;
+
+      if (!(* func) (window, user_data))
+        break;
+    }
+}
+
 void
 meta_workspace_invalidate_work_area (MetaWorkspace *workspace)
 {
@@ -58,4 +58,9 @@ META_EXPORT
 void meta_laters_remove (MetaLaters   *laters,
                          unsigned int  later_id);
 
+META_EXPORT
+void meta_laters_set_deferrable (MetaLaters   *laters,
+                                 unsigned int  later_id,
+                                 gboolean      deferrable);
+
 #endif /* META_LATER_H */
@@ -104,6 +104,7 @@ typedef enum
   META_PREF_DRAG_THRESHOLD,
   META_PREF_LOCATE_POINTER,
   META_PREF_CHECK_ALIVE_TIMEOUT,
+  META_PREF_OBSCURED_FRAME_CALLBACK_INTERVAL,
 } MetaPreference;
 
 typedef void (* MetaPrefsChangedFunc) (MetaPreference pref,
@@ -478,4 +479,7 @@ GDesktopVisualBellType meta_prefs_get_visual_bell_type (void);
 META_EXPORT
 unsigned int meta_prefs_get_check_alive_timeout (void);
 
+META_EXPORT
+unsigned int meta_prefs_get_obscured_frame_callback_interval (void);
+
 #endif
@@ -23,6 +23,7 @@
 
 #include <meta/types.h>
 #include <meta/boxes.h>
+#include <meta/window.h>
 
 #define META_TYPE_WORKSPACE            (meta_workspace_get_type ())
 #define META_WORKSPACE(obj)            (G_TYPE_CHECK_INSTANCE_CAST ((obj), META_TYPE_WORKSPACE, MetaWorkspace))
@@ -45,6 +46,11 @@ MetaDisplay *meta_workspace_get_display (MetaWorkspace *workspace);
 META_EXPORT
 GList* meta_workspace_list_windows (MetaWorkspace *workspace);
 
+META_EXPORT
+void meta_workspace_foreach_window (MetaWorkspace         *workspace,
+                                    MetaWindowForeachFunc  func,
+                                    void                  *user_data);
+
 META_EXPORT
 void meta_workspace_get_work_area_for_monitor (MetaWorkspace *workspace,
                                                int            which_monitor,
@@ -0,0 +1,166 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <gdk-pixbuf/gdk-pixbuf.h>
+#include <glib/gstdio.h>
+
+#include "compositor/meta-background-image-private.h"
+#include "meta-test/meta-context-test.h"
+
+#define IMAGE_WIDTH 3840
+#define IMAGE_HEIGHT 2160
+
+static GFile *
+create_test_image (int width,
+                   int height)
+{
+  g_autoptr (GdkPixbuf) pixbuf = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree char *path = NULL;
+  int fd;
+
+  pixbuf = gdk_pixbuf_new (GDK_COLORSPACE_RGB, FALSE, 8, width, height);
+  gdk_pixbuf_fill (pixbuf, 0x3465a4ff);
+
+  fd = g_file_open_tmp ("mutter-background-XXXXXX.png", &path, &error);
+  if (fd == -1)
+    g_error ("Failed to create test image file: %s", error->message);
+  g_close (fd, NULL);
+
+  if (!gdk_pixbuf_save (pixbuf, path, "png", &error, NULL))
+    g_error ("Failed to save test image: %s", error->message);
+
+  return g_file_new_for_path (path);
+}
+
+static void
+delete_test_image (GFile *file)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!g_file_delete (file, NULL, &error))
+    g_warning ("Failed to delete test image: %s", error->message);
+}
+
+static void
+wait_for_image (MetaBackgroundImage *image)
+{
+  while (!meta_background_image_is_loaded (image))
+    g_main_context_iteration (NULL, TRUE);
+
+  g_assert_true (meta_background_image_get_success (image));
+}
+
+static void
+assert_texture_size (MetaBackgroundImage *image,
+                     int                  width,
+                     int                  height)
+{
+  CoglTexture *texture = meta_background_image_get_texture (image);
+
+  g_assert_cmpint (cogl_texture_get_width (texture), ==, width);
+  g_assert_cmpint (cogl_texture_get_height (texture), ==, height);
+}
+
+static void
+meta_test_background_image_downscale (void)
+{
+  MetaBackgroundImageCache *cache = meta_background_image_cache_get_default ();
+  g_autoptr (GFile) file = NULL;
+  g_autoptr (MetaBackgroundImage) full_image = NULL;
+  g_autoptr (MetaBackgroundImage) image = NULL;
+  g_autoptr (MetaBackgroundImage) shared_image = NULL;
+  g_autoptr (MetaBackgroundImage) purged_image = NULL;
+  int64_t start_us, full_us, scaled_us;
+
+  file = create_test_image (IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  start_us = g_get_monotonic_time ();
+  full_image = meta_background_image_cache_load_for_size (cache, file, 0, 0);
+  wait_for_image (full_image);
+  full_us = g_get_monotonic_time () - start_us;
+  assert_texture_size (full_image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  /* Covering a portrait monitor keeps the height of the image */
+  image = meta_background_image_cache_load_for_size (cache, file, 600, 800);
+  wait_for_image (image);
+  assert_texture_size (image, 1423, 800);
+  g_clear_object (&image);
+
+  start_us = g_get_monotonic_time ();
+  image = meta_background_image_cache_load_for_size (cache, file, 1920, 1200);
+  wait_for_image (image);
+  scaled_us = g_get_monotonic_time () - start_us;
+  assert_texture_size (image, 2134, 1200);
+
+  /* Images loaded without a size use the one of the cache */
+  meta_background_image_cache_set_max_size (cache, 1920, 1200);
+  shared_image = meta_background_image_cache_load (cache, file);
+  g_assert_true (shared_image == image);
+  meta_background_image_cache_set_max_size (cache, 0, 0);
+
+  /* Images smaller than the size to cover are left alone */
+  g_clear_object (&shared_image);
+  shared_image = meta_background_image_cache_load_for_size (cache, file,
+                                                            7680, 4320);
+  wait_for_image (shared_image);
+  assert_texture_size (shared_image, IMAGE_WIDTH, IMAGE_HEIGHT);
+
+  meta_background_image_cache_purge (cache, file);
+  purged_image = meta_background_image_cache_load_for_size (cache, file,
+                                                            1920, 1200);
+  g_assert_true (purged_image != image);
+  wait_for_image (purged_image);
+
+  g_test_message ("Loading a %dx%d background took %.3f ms and %.1f MiB "
+                  "at full size, %.3f ms and %.1f MiB to cover 1920x1200",
+                  IMAGE_WIDTH, IMAGE_HEIGHT,
+                  full_us / 1000.0,
+                  IMAGE_WIDTH * IMAGE_HEIGHT * 3 / (1024.0 * 1024.0),
+                  scaled_us / 1000.0,
+                  2134 * 1200 * 3 / (1024.0 * 1024.0));
+  g_test_minimized_result (scaled_us / 1000.0,
+                           "%.3f ms to load a downscaled background",
+                           scaled_us / 1000.0);
+
+  delete_test_image (file);
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/compositor/background-image/downscale",
+                   meta_test_background_image_downscale);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NONE);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
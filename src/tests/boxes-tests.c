@@ -1371,6 +1371,576 @@ test_find_closest_point_to_line (void)
   g_assert (fabs (rx - answer_x) < EPSILON && fabs (ry - answer_y) < EPSILON);
 }
 
+static gboolean
+rects_overlap_brute_force (const MetaRectangle *rects,
+                           int                  n_rects,
+                           const MetaRectangle *rect)
+{
+  int i;
+
+  for (i = 0; i < n_rects; i++)
+    {
+      MetaRectangle overlap;
+
+      if (meta_rectangle_intersect (&rects[i], rect, &overlap))
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+test_rectangle_index (void)
+{
+  MetaRectangle rects[64];
+  MetaRectangleIndex *index;
+  int n_rects;
+  int i;
+
+  for (n_rects = 0; n_rects < (int) G_N_ELEMENTS (rects); n_rects += 7)
+    {
+      for (i = 0; i < n_rects; i++)
+        {
+          get_random_rect (&rects[i]);
+          /* Use smaller rects, so that not everything overlaps */
+          rects[i].width = rects[i].width / 8 + 1;
+          rects[i].height = rects[i].height / 8 + 1;
+        }
+
+      index = meta_rectangle_index_new (rects, n_rects);
+
+      for (i = 0; i < NUM_RANDOM_RUNS / 10; i++)
+        {
+          MetaRectangle rect;
+
+          get_random_rect (&rect);
+          rect.width = rect.width / 8;
+          rect.height = rect.height / 8;
+
+          g_assert_cmpint (meta_rectangle_index_overlaps (index, &rect),
+                           ==,
+                           rects_overlap_brute_force (rects, n_rects, &rect));
+        }
+
+      /* Touching isn't overlapping */
+      if (n_rects > 0)
+        {
+          MetaRectangle rect = rects[0];
+
+          rect.x += rect.width;
+          g_assert_cmpint (meta_rectangle_index_overlaps (index, &rect),
+                           ==,
+                           rects_overlap_brute_force (rects, n_rects, &rect));
+        }
+
+      meta_rectangle_index_free (index);
+    }
+}
+
+static int
+find_overlap_brute_force (const MetaRectangle *rects,
+                          int                  n_rects,
+                          int                  from,
+                          gboolean             forward,
+                          const MetaRectangle *rect,
+                          MetaDirection        directions)
+{
+  int i;
+
+  for (i = forward ? from : MIN (from, n_rects - 1);
+       i >= 0 && i < n_rects;
+       i += forward ? 1 : -1)
+    {
+      if (directions & META_DIRECTION_HORIZONTAL &&
+          !meta_rectangle_horiz_overlap (&rects[i], rect))
+        continue;
+      if (directions & META_DIRECTION_VERTICAL &&
+          !meta_rectangle_vert_overlap (&rects[i], rect))
+        continue;
+
+      return i;
+    }
+
+  return -1;
+}
+
+static void
+test_rectangle_tree (void)
+{
+  MetaDirection all_directions[] = {
+    META_DIRECTION_HORIZONTAL,
+    META_DIRECTION_VERTICAL,
+    META_DIRECTION_HORIZONTAL | META_DIRECTION_VERTICAL,
+  };
+  MetaRectangle rects[64];
+  MetaRectangleTree *tree;
+  int n_rects;
+  int i;
+
+  for (n_rects = 0; n_rects < (int) G_N_ELEMENTS (rects); n_rects += 7)
+    {
+      for (i = 0; i < n_rects; i++)
+        {
+          get_random_rect (&rects[i]);
+          rects[i].width = rects[i].width / 8 + 1;
+          rects[i].height = rects[i].height / 8 + 1;
+
+          /* Edge resistance builds trees of window and monitor edges, which
+           * are empty along one axis
+           */
+          if (i % 3 == 1)
+            rects[i].width = 0;
+          else if (i % 3 == 2)
+            rects[i].height = 0;
+        }
+
+      tree = meta_rectangle_tree_new (rects, n_rects);
+
+      for (i = 0; i < NUM_RANDOM_RUNS / 10; i++)
+        {
+          MetaDirection directions;
+          MetaRectangle rect;
+          gboolean forward;
+          int from;
+
+          get_random_rect (&rect);
+          rect.width = rect.width / 8;
+          rect.height = rect.height / 8;
+          directions = all_directions[rand () % G_N_ELEMENTS (all_directions)];
+          forward = rand () % 2;
+          from = rand () % (n_rects + 1);
+
+          g_assert_cmpint (meta_rectangle_tree_find_overlap (tree, from,
+                                                             forward, &rect,
+                                                             directions),
+                           ==,
+                           find_overlap_brute_force (rects, n_rects, from,
+                                                     forward, &rect,
+                                                     directions));
+        }
+
+      meta_rectangle_tree_free (tree);
+    }
+}
+
+#define N_PLACEMENT_COLUMNS 25
+#define N_PLACEMENT_ROWS 20
+
+static void
+test_rectangle_index_placement_benchmark (void)
+{
+  MetaRectangle rects[N_PLACEMENT_COLUMNS * N_PLACEMENT_ROWS];
+  MetaRectangleIndex *index;
+  int n_rects = G_N_ELEMENTS (rects);
+  int n_index_overlaps = 0;
+  int n_brute_force_overlaps = 0;
+  int64_t start_us;
+  double index_ms;
+  double brute_force_ms;
+  int i;
+
+  /* A wall of 500 non-overlapping windows, queried like find_first_fit()
+   * does when placing a new window: below and to the right of each one.
+   */
+  for (i = 0; i < n_rects; i++)
+    {
+      rects[i] = (MetaRectangle) {
+        .x = (i % N_PLACEMENT_COLUMNS) * 150,
+        .y = (i / N_PLACEMENT_COLUMNS) * 100,
+        .width = 150,
+        .height = 100,
+      };
+    }
+
+  start_us = g_get_monotonic_time ();
+  index = meta_rectangle_index_new (rects, n_rects);
+  for (i = 0; i < n_rects; i++)
+    {
+      MetaRectangle below = rects[i];
+      MetaRectangle end = rects[i];
+
+      below.y += below.height;
+      end.x += end.width;
+
+      n_index_overlaps += meta_rectangle_index_overlaps (index, &below);
+      n_index_overlaps += meta_rectangle_index_overlaps (index, &end);
+    }
+  meta_rectangle_index_free (index);
+  index_ms = (g_get_monotonic_time () - start_us) / 1000.0;
+
+  start_us = g_get_monotonic_time ();
+  for (i = 0; i < n_rects; i++)
+    {
+      MetaRectangle below = rects[i];
+      MetaRectangle end = rects[i];
+
+      below.y += below.height;
+      end.x += end.width;
+
+      n_brute_force_overlaps +=
+        rects_overlap_brute_force (rects, n_rects, &below);
+      n_brute_force_overlaps +=
+        rects_overlap_brute_force (rects, n_rects, &end);
+    }
+  brute_force_ms = (g_get_monotonic_time () - start_us) / 1000.0;
+
+  g_assert_cmpint (n_index_overlaps, ==, n_brute_force_overlaps);
+
+  g_test_message ("Placing next to %d windows: "
+                  "%.3f ms indexed, %.3f ms scanning every window",
+                  n_rects, index_ms, brute_force_ms);
+  g_test_minimized_result (index_ms, "%.3f ms indexed", index_ms);
+}
+
+#define N_WORK_AREA_MONITORS 8
+#define N_WORK_AREA_RUNS 100
+
+static gboolean
+strut_reaches_side (const MetaStrut     *strut,
+                    const MetaRectangle *rect)
+{
+  switch (strut->side)
+    {
+    case META_SIDE_TOP:
+      return strut->rect.y <= rect->y;
+    case META_SIDE_BOTTOM:
+      return strut->rect.y + strut->rect.height >= rect->y + rect->height;
+    case META_SIDE_LEFT:
+      return strut->rect.x <= rect->x;
+    case META_SIDE_RIGHT:
+      return strut->rect.x + strut->rect.width >= rect->x + rect->width;
+    default:
+      return FALSE;
+    }
+}
+
+static int
+compare_ints (gconstpointer a,
+              gconstpointer b)
+{
+  return *(const int *) a - *(const int *) b;
+}
+
+static void
+append_span (GArray *coords,
+             int     start,
+             int     length)
+{
+  int end = start + length;
+
+  g_array_append_val (coords, start);
+  g_array_append_val (coords, end);
+}
+
+static void
+sort_unique_ints (GArray *array)
+{
+  unsigned int i, j;
+
+  g_array_sort (array, compare_ints);
+
+  for (i = 0, j = 0; i < array->len; i++)
+    {
+      int value = g_array_index (array, int, i);
+
+      if (j > 0 && value == g_array_index (array, int, j - 1))
+        continue;
+      g_array_index (array, int, j++) = value;
+    }
+  g_array_set_size (array, j);
+}
+
+static gboolean
+grid_cells_free (const gboolean *free_cells,
+                 int             n_rows,
+                 int             col0,
+                 int             col1,
+                 int             row0,
+                 int             row1)
+{
+  int col, row;
+
+  for (col = col0; col < col1; col++)
+    {
+      for (row = row0; row < row1; row++)
+        {
+          if (!free_cells[col * n_rows + row])
+            return FALSE;
+        }
+    }
+
+  return TRUE;
+}
+
+/* Finds all maximal rectangles of @basic_rect minus the @struts reaching
+ * the side they claim, by cutting @basic_rect into a grid along all strut
+ * edges and trying every rectangle of grid cells.
+ */
+static GList *
+get_maximal_rects_brute_force (const MetaRectangle *basic_rect,
+                               const GSList        *struts)
+{
+  g_autoptr (GArray) strut_rects = NULL;
+  g_autoptr (GArray) xs = NULL;
+  g_autoptr (GArray) ys = NULL;
+  g_autofree gboolean *free_cells = NULL;
+  GList *ret = NULL;
+  int n_cols, n_rows;
+  int col0, col1, row0, row1;
+  unsigned int i;
+
+  strut_rects = g_array_new (FALSE, FALSE, sizeof (MetaRectangle));
+  xs = g_array_new (FALSE, FALSE, sizeof (int));
+  ys = g_array_new (FALSE, FALSE, sizeof (int));
+
+  append_span (xs, basic_rect->x, basic_rect->width);
+  append_span (ys, basic_rect->y, basic_rect->height);
+
+  for (; struts; struts = struts->next)
+    {
+      MetaStrut *strut = struts->data;
+      MetaRectangle clipped;
+
+      if (!strut_reaches_side (strut, basic_rect) ||
+          !meta_rectangle_intersect (&strut->rect, basic_rect, &clipped))
+        continue;
+
+      g_array_append_val (strut_rects, clipped);
+      append_span (xs, clipped.x, clipped.width);
+      append_span (ys, clipped.y, clipped.height);
+    }
+
+  sort_unique_ints (xs);
+  sort_unique_ints (ys);
+  n_cols = xs->len - 1;
+  n_rows = ys->len - 1;
+
+  free_cells = g_new0 (gboolean, n_cols * n_rows);
+  for (col0 = 0; col0 < n_cols; col0++)
+    {
+      for (row0 = 0; row0 < n_rows; row0++)
+        {
+          int x = g_array_index (xs, int, col0);
+          int y = g_array_index (ys, int, row0);
+          MetaRectangle cell;
+
+          cell = meta_rect (x, y,
+                            g_array_index (xs, int, col0 + 1) - x,
+                            g_array_index (ys, int, row0 + 1) - y);
+
+          free_cells[col0 * n_rows + row0] =
+            !rects_overlap_brute_force ((MetaRectangle *) strut_rects->data,
+                                        strut_rects->len, &cell);
+        }
+    }
+
+  for (col0 = 0; col0 < n_cols; col0++)
+    for (col1 = col0 + 1; col1 <= n_cols; col1++)
+      for (row0 = 0; row0 < n_rows; row0++)
+        for (row1 = row0 + 1; row1 <= n_rows; row1++)
+          {
+            int x, y, width, height;
+
+            if (!grid_cells_free (free_cells, n_rows, col0, col1, row0, row1))
+              continue;
+
+            /* Skip the rectangle if it can grow to any side */
+            if ((col0 > 0 &&
+                 grid_cells_free (free_cells, n_rows,
+                                  col0 - 1, col0, row0, row1)) ||
+                (col1 < n_cols &&
+                 grid_cells_free (free_cells, n_rows,
+                                  col1, col1 + 1, row0, row1)) ||
+                (row0 > 0 &&
+                 grid_cells_free (free_cells, n_rows,
+                                  col0, col1, row0 - 1, row0)) ||
+                (row1 < n_rows &&
+                 grid_cells_free (free_cells, n_rows,
+                                  col0, col1, row1, row1 + 1)))
+              continue;
+
+            x = g_array_index (xs, int, col0);
+            y = g_array_index (ys, int, row0);
+            width = g_array_index (xs, int, col1) - x;
+            height = g_array_index (ys, int, row1) - y;
+            ret = g_list_prepend (ret, new_meta_rect (x, y, width, height));
+          }
+
+  return ret;
+}
+
+static gint
+find_equal_rect (gconstpointer a,
+                 gconstpointer b)
+{
+  return !meta_rectangle_equal (a, b);
+}
+
+/* The minimal spanning set is exactly the set of maximal rectangles */
+static void
+assert_region_is_maximal_rects (const MetaRectangle *basic_rect,
+                                const GSList        *struts,
+                                GList               *region)
+{
+  GList *expected;
+  GList *l;
+
+  expected = get_maximal_rects_brute_force (basic_rect, struts);
+
+  g_assert_cmpuint (g_list_length (region), ==, g_list_length (expected));
+  for (l = region; l; l = l->next)
+    g_assert_nonnull (g_list_find_custom (expected, l->data, find_equal_rect));
+  for (l = expected; l; l = l->next)
+    g_assert_nonnull (g_list_find_custom (region, l->data, find_equal_rect));
+
+  meta_rectangle_free_list_and_elements (expected);
+}
+
+static void
+test_spanning_set_maximal_rects (void)
+{
+  MetaRectangle basic_rect = { 0, 0, 1600, 1200 };
+  const MetaSide sides[] = {
+    META_SIDE_LEFT, META_SIDE_RIGHT, META_SIDE_TOP, META_SIDE_BOTTOM,
+  };
+  int i, j;
+
+  for (i = 0; i < NUM_RANDOM_RUNS / 10; i++)
+    {
+      GSList *struts = NULL;
+      GList *region;
+      int n_struts = rand () % 9;
+
+      /* Struts at most half as deep as the screen, most of them at the
+       * side they claim; the others don't reach it and are ignored.
+       */
+      for (j = 0; j < n_struts; j++)
+        {
+          MetaSide side = sides[rand () % G_N_ELEMENTS (sides)];
+          MetaRectangle rect;
+
+          get_random_rect (&rect);
+          rect.width = MIN (rect.width, basic_rect.width - rect.x);
+          rect.height = MIN (rect.height, basic_rect.height - rect.y);
+
+          if (side == META_SIDE_TOP || side == META_SIDE_BOTTOM)
+            {
+              rect.height = rect.height % (basic_rect.height / 2) + 1;
+              if (rand () % 4 != 0)
+                rect.y = side == META_SIDE_TOP ?
+                         0 : basic_rect.height - rect.height;
+            }
+          else
+            {
+              rect.width = rect.width % (basic_rect.width / 2) + 1;
+              if (rand () % 4 != 0)
+                rect.x = side == META_SIDE_LEFT ?
+                         0 : basic_rect.width - rect.width;
+            }
+
+          struts = g_slist_prepend (struts,
+                                    new_meta_strut (rect.x, rect.y,
+                                                    rect.width, rect.height,
+                                                    side));
+        }
+
+      region = meta_rectangle_get_minimal_spanning_set_for_region (&basic_rect,
+                                                                   struts);
+      assert_region_is_maximal_rects (&basic_rect, struts, region);
+
+      meta_rectangle_free_list_and_elements (region);
+      free_strut_list (struts);
+    }
+}
+
+static void
+test_work_areas_benchmark (void)
+{
+  MetaRectangle monitors[N_WORK_AREA_MONITORS];
+  MetaRectangle display_rect = { 0, 0, 4 * 1920, 2 * 1080 };
+  GList *monitor_list = NULL;
+  GSList *struts = NULL;
+  int64_t start_us;
+  double ms_per_run;
+  int i, j;
+
+  /* Eight monitors in two rows, each with a top bar, a bottom dock and a
+   * side panel, and what workspace.c:ensure_work_areas_validated() does
+   * with them whenever the struts change.
+   */
+  for (i = 0; i < N_WORK_AREA_MONITORS; i++)
+    {
+      MetaRectangle *monitor = &monitors[i];
+
+      *monitor = meta_rect ((i % 4) * 1920, (i / 4) * 1080, 1920, 1080);
+      monitor_list = g_list_prepend (monitor_list, monitor);
+
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (monitor->x, monitor->y,
+                                                1920, 32,
+                                                META_SIDE_TOP));
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (monitor->x + 560,
+                                                monitor->y + 1080 - 64,
+                                                800, 64,
+                                                META_SIDE_BOTTOM));
+      struts = g_slist_prepend (struts,
+                                new_meta_strut (monitor->x, monitor->y + 300,
+                                                48, 480,
+                                                META_SIDE_LEFT));
+    }
+
+  /* Check the results once before timing them */
+  for (j = 0; j <= N_WORK_AREA_MONITORS; j++)
+    {
+      MetaRectangle *basic_rect;
+      GList *region;
+
+      basic_rect = j < N_WORK_AREA_MONITORS ? &monitors[j] : &display_rect;
+      region = meta_rectangle_get_minimal_spanning_set_for_region (basic_rect,
+                                                                   struts);
+      assert_region_is_maximal_rects (basic_rect, struts, region);
+      meta_rectangle_free_list_and_elements (region);
+    }
+
+  start_us = g_get_monotonic_time ();
+  for (i = 0; i < N_WORK_AREA_RUNS; i++)
+    {
+      GList *region;
+      GList *edges;
+
+      for (j = 0; j < N_WORK_AREA_MONITORS; j++)
+        {
+          region = meta_rectangle_get_minimal_spanning_set_for_region (
+            &monitors[j], struts);
+          g_assert_nonnull (region);
+          meta_rectangle_free_list_and_elements (region);
+        }
+
+      region = meta_rectangle_get_minimal_spanning_set_for_region (
+        &display_rect, struts);
+      g_assert_nonnull (region);
+      meta_rectangle_free_list_and_elements (region);
+
+      edges = meta_rectangle_find_onscreen_edges (&display_rect, struts);
+      meta_rectangle_free_list_and_elements (edges);
+
+      edges = meta_rectangle_find_nonintersected_monitor_edges (monitor_list,
+                                                                struts);
+      meta_rectangle_free_list_and_elements (edges);
+    }
+  ms_per_run = (g_get_monotonic_time () - start_us) / 1000.0 /
+               N_WORK_AREA_RUNS;
+
+  g_test_message ("Computing work areas and edges of %d monitors with %d "
+                  "struts took %.3f ms",
+                  N_WORK_AREA_MONITORS, g_slist_length (struts), ms_per_run);
+  g_test_minimized_result (ms_per_run, "%.3f ms per update", ms_per_run);
+
+  g_list_free (monitor_list);
+  free_strut_list (struts);
+}
+
 void
 init_boxes_tests (void)
 {
@@ -1399,4 +1969,13 @@ init_boxes_tests (void)
   g_test_add_func ("/util/boxes/gravity-resize", test_gravity_resize);
   g_test_add_func ("/util/boxes/closest-point-to-line",
                    test_find_closest_point_to_line);
+
+  g_test_add_func ("/util/boxes/rectangle-tree", test_rectangle_tree);
+  g_test_add_func ("/util/boxes/rectangle-index", test_rectangle_index);
+  g_test_add_func ("/util/boxes/rectangle-index-placement-benchmark",
+                   test_rectangle_index_placement_benchmark);
+  g_test_add_func ("/util/boxes/spanning-set-maximal-rects",
+                   test_spanning_set_maximal_rects);
+  g_test_add_func ("/util/boxes/work-areas-benchmark",
+                   test_work_areas_benchmark);
 }
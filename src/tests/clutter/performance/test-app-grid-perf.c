@@ -0,0 +1,112 @@
+#include <clutter/clutter.h>
+
+#include <stdlib.h>
+#include <string.h>
+#include "test-common.h"
+
+#define STAGE_WIDTH  800
+#define STAGE_HEIGHT 600
+
+#define ICON_SIZE    48
+#define ICON_SPACING 16
+
+static gboolean batchable;
+
+static gboolean
+queue_redraw (gpointer stage)
+{
+  clutter_actor_queue_redraw (CLUTTER_ACTOR (stage));
+
+  return G_SOURCE_CONTINUE;
+}
+
+static ClutterActor *
+create_icon (int n)
+{
+  ClutterContent *image;
+  ClutterActor *icon;
+  guint8 *data;
+  int x, y;
+
+  /* Give every icon its own contents so that they can't share a
+   * texture unless they are batched */
+  data = g_malloc (ICON_SIZE * ICON_SIZE * 4);
+  for (y = 0; y < ICON_SIZE; y++)
+    for (x = 0; x < ICON_SIZE; x++)
+      {
+        guint8 *p = data + (y * ICON_SIZE + x) * 4;
+
+        p[0] = (x * 5 + n * 37) & 0xff;
+        p[1] = (y * 5 + n * 91) & 0xff;
+        p[2] = (n * 13) & 0xff;
+        p[3] = 0xff;
+      }
+
+  image = clutter_image_new ();
+  clutter_image_set_batchable (CLUTTER_IMAGE (image), batchable);
+  clutter_image_set_data (CLUTTER_IMAGE (image),
+                          data,
+                          COGL_PIXEL_FORMAT_RGBA_8888,
+                          ICON_SIZE, ICON_SIZE,
+                          ICON_SIZE * 4,
+                          NULL);
+  g_free (data);
+
+  icon = clutter_actor_new ();
+  clutter_actor_set_size (icon, ICON_SIZE, ICON_SIZE);
+  clutter_actor_set_content (icon, image);
+  g_object_unref (image);
+
+  return icon;
+}
+
+int
+main (int argc, char *argv[])
+{
+  ClutterActor    *stage;
+  ClutterColor     stage_color = { 0x00, 0x00, 0x00, 0xff };
+  int              rows, cols;
+  int              row, col;
+
+  clutter_perf_fps_init ();
+
+  clutter_test_init (&argc, &argv);
+
+  batchable = argc > 1 && strcmp (argv[1], "--batched") == 0;
+
+  cols = STAGE_WIDTH / (ICON_SIZE + ICON_SPACING);
+  rows = STAGE_HEIGHT / (ICON_SIZE + ICON_SPACING);
+
+  g_print ("%d icons of %dx%d, %s\n",
+           rows * cols, ICON_SIZE, ICON_SIZE,
+           batchable ? "batched" : "not batched");
+
+  stage = clutter_test_get_stage ();
+  clutter_actor_set_size (stage, STAGE_WIDTH, STAGE_HEIGHT);
+  clutter_actor_set_background_color (CLUTTER_ACTOR (stage), &stage_color);
+  clutter_stage_set_title (CLUTTER_STAGE (stage), "App Grid Performance");
+  g_signal_connect (stage, "destroy", G_CALLBACK (clutter_test_quit), NULL);
+
+  for (row = 0; row < rows; row++)
+    for (col = 0; col < cols; col++)
+      {
+        ClutterActor *icon = create_icon (row * cols + col);
+
+        clutter_actor_set_position (icon,
+                                    col * (ICON_SIZE + ICON_SPACING),
+                                    row * (ICON_SIZE + ICON_SPACING));
+        clutter_actor_add_child (stage, icon);
+      }
+
+  clutter_actor_show (stage);
+
+  /* The number of draw calls per frame is part of the "GL state
+   * changes" trace mark emitted after each swap */
+  clutter_perf_fps_start (CLUTTER_STAGE (stage));
+  clutter_threads_add_idle (queue_redraw, stage);
+  clutter_test_main ();
+  clutter_perf_fps_report (batchable ? "test-app-grid-perf-batched"
+                                     : "test-app-grid-perf");
+
+  return 0;
+}
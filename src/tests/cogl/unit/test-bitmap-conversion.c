@@ -0,0 +1,204 @@
+#include "cogl-config.h"
+
+#include "cogl/cogl.h"
+#include "cogl/cogl-bitmap-private.h"
+#include "tests/cogl-test-utils.h"
+
+#define BITMAP_WIDTH 37
+#define BITMAP_HEIGHT 3
+#define BITMAP_ROWSTRIDE (BITMAP_WIDTH * 4 + 12)
+
+static const CoglPixelFormat formats_8888[] = {
+  COGL_PIXEL_FORMAT_RGBA_8888,
+  COGL_PIXEL_FORMAT_BGRA_8888,
+  COGL_PIXEL_FORMAT_ARGB_8888,
+  COGL_PIXEL_FORMAT_ABGR_8888,
+  COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+  COGL_PIXEL_FORMAT_BGRA_8888_PRE,
+  COGL_PIXEL_FORMAT_ARGB_8888_PRE,
+  COGL_PIXEL_FORMAT_ABGR_8888_PRE,
+};
+
+static const CoglPixelFormat formats_1010102[] = {
+  COGL_PIXEL_FORMAT_RGBA_1010102,
+  COGL_PIXEL_FORMAT_BGRA_1010102,
+  COGL_PIXEL_FORMAT_XRGB_2101010,
+  COGL_PIXEL_FORMAT_ARGB_2101010,
+  COGL_PIXEL_FORMAT_XBGR_2101010,
+  COGL_PIXEL_FORMAT_ABGR_2101010,
+  COGL_PIXEL_FORMAT_RGBA_1010102_PRE,
+  COGL_PIXEL_FORMAT_BGRA_1010102_PRE,
+  COGL_PIXEL_FORMAT_ARGB_2101010_PRE,
+  COGL_PIXEL_FORMAT_ABGR_2101010_PRE,
+};
+
+static uint8_t *
+create_random_data (void)
+{
+  uint8_t *data;
+  int i;
+
+  data = g_malloc (BITMAP_ROWSTRIDE * BITMAP_HEIGHT);
+  for (i = 0; i < BITMAP_ROWSTRIDE * BITMAP_HEIGHT; i++)
+    data[i] = g_test_rand_int_range (0, 256);
+
+  return data;
+}
+
+static void
+assert_rows_equal (const uint8_t *expected,
+                   const uint8_t *actual,
+                   CoglPixelFormat src_format,
+                   CoglPixelFormat dst_format)
+{
+  int y;
+
+  for (y = 0; y < BITMAP_HEIGHT; y++)
+    {
+      const uint8_t *expected_row = expected + y * BITMAP_ROWSTRIDE;
+      const uint8_t *actual_row = actual + y * BITMAP_ROWSTRIDE;
+
+      if (memcmp (expected_row, actual_row, BITMAP_WIDTH * 4) != 0)
+        {
+          g_error ("Fast path mismatch converting %s to %s",
+                   cogl_pixel_format_to_string (src_format),
+                   cogl_pixel_format_to_string (dst_format));
+        }
+    }
+}
+
+static void
+convert (const uint8_t   *src_data,
+         CoglPixelFormat  src_format,
+         uint8_t         *dst_data,
+         CoglPixelFormat  dst_format,
+         gboolean         use_fast_paths)
+{
+  g_autoptr (GError) error = NULL;
+  CoglBitmap *src_bmp;
+  CoglBitmap *dst_bmp;
+
+  src_bmp = cogl_bitmap_new_for_data (test_ctx,
+                                      BITMAP_WIDTH, BITMAP_HEIGHT,
+                                      src_format,
+                                      BITMAP_ROWSTRIDE,
+                                      (uint8_t *) src_data);
+  dst_bmp = cogl_bitmap_new_for_data (test_ctx,
+                                      BITMAP_WIDTH, BITMAP_HEIGHT,
+                                      dst_format,
+                                      BITMAP_ROWSTRIDE,
+                                      dst_data);
+
+  _cogl_bitmap_set_conversion_fast_paths_enabled (use_fast_paths);
+  _cogl_bitmap_convert_into_bitmap (src_bmp, dst_bmp, &error);
+  _cogl_bitmap_set_conversion_fast_paths_enabled (TRUE);
+  g_assert_no_error (error);
+
+  cogl_object_unref (dst_bmp);
+  cogl_object_unref (src_bmp);
+}
+
+static void
+check_conversion (const uint8_t   *src_data,
+                  CoglPixelFormat  src_format,
+                  CoglPixelFormat  dst_format)
+{
+  g_autofree uint8_t *expected = NULL;
+  g_autofree uint8_t *actual = NULL;
+
+  expected = g_malloc0 (BITMAP_ROWSTRIDE * BITMAP_HEIGHT);
+  actual = g_malloc0 (BITMAP_ROWSTRIDE * BITMAP_HEIGHT);
+
+  convert (src_data, src_format, expected, dst_format, FALSE);
+  convert (src_data, src_format, actual, dst_format, TRUE);
+
+  assert_rows_equal (expected, actual, src_format, dst_format);
+}
+
+static void
+test_bitmap_conversion_8888 (void)
+{
+  g_autofree uint8_t *src_data = NULL;
+  int i, j;
+
+  src_data = create_random_data ();
+
+  for (i = 0; i < G_N_ELEMENTS (formats_8888); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (formats_8888); j++)
+        check_conversion (src_data, formats_8888[i], formats_8888[j]);
+    }
+}
+
+static void
+test_bitmap_conversion_10_to_8 (void)
+{
+  g_autofree uint8_t *src_data = NULL;
+  int i, j;
+
+  src_data = create_random_data ();
+
+  for (i = 0; i < G_N_ELEMENTS (formats_1010102); i++)
+    {
+      for (j = 0; j < G_N_ELEMENTS (formats_8888); j++)
+        check_conversion (src_data, formats_1010102[i], formats_8888[j]);
+    }
+}
+
+static void
+premult_in_place (uint8_t         *data,
+                  CoglPixelFormat  format,
+                  CoglPixelFormat  dst_format,
+                  gboolean         use_fast_paths)
+{
+  g_autoptr (GError) error = NULL;
+  CoglBitmap *bmp;
+
+  bmp = cogl_bitmap_new_for_data (test_ctx,
+                                  BITMAP_WIDTH, BITMAP_HEIGHT,
+                                  format,
+                                  BITMAP_ROWSTRIDE,
+                                  data);
+
+  _cogl_bitmap_set_conversion_fast_paths_enabled (use_fast_paths);
+  _cogl_bitmap_convert_premult_status (bmp, dst_format, &error);
+  _cogl_bitmap_set_conversion_fast_paths_enabled (TRUE);
+  g_assert_no_error (error);
+  g_assert_cmpint (cogl_bitmap_get_format (bmp), ==, dst_format);
+
+  cogl_object_unref (bmp);
+}
+
+static void
+test_bitmap_premult_in_place (void)
+{
+  g_autofree uint8_t *src_data = NULL;
+  int i;
+
+  src_data = create_random_data ();
+
+  for (i = 0; i < G_N_ELEMENTS (formats_8888); i++)
+    {
+      CoglPixelFormat format = formats_8888[i];
+      CoglPixelFormat dst_format = format ^ COGL_PREMULT_BIT;
+      g_autofree uint8_t *expected = NULL;
+      g_autofree uint8_t *actual = NULL;
+
+      expected = g_memdup2 (src_data, BITMAP_ROWSTRIDE * BITMAP_HEIGHT);
+      actual = g_memdup2 (src_data, BITMAP_ROWSTRIDE * BITMAP_HEIGHT);
+
+      premult_in_place (expected, format, dst_format, FALSE);
+      premult_in_place (actual, format, dst_format, TRUE);
+
+      assert_rows_equal (expected, actual, format, dst_format);
+    }
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/bitmap-conversion/8888",
+                   test_bitmap_conversion_8888);
+  g_test_add_func ("/bitmap-conversion/10-to-8",
+                   test_bitmap_conversion_10_to_8);
+  g_test_add_func ("/bitmap-conversion/premult-in-place",
+                   test_bitmap_premult_in_place);
+)
@@ -0,0 +1,147 @@
+#include "cogl-config.h"
+
+#include "cogl/cogl.h"
+#include "cogl/cogl-context-private.h"
+#include "cogl/cogl-framebuffer-private.h"
+#include "tests/cogl-test-utils.h"
+
+#define ICON_SIZE 32
+#define GRID_COLUMNS 12
+#define GRID_ROWS 8
+#define N_ICONS (GRID_COLUMNS * GRID_ROWS)
+
+static uint32_t
+icon_color (int icon)
+{
+  return (((icon * 37) & 0xff) << 24 |
+          ((icon * 91) & 0xff) << 16 |
+          ((icon * 13) & 0xff) << 8 |
+          0xff);
+}
+
+static CoglTexture *
+create_icon (int      icon,
+             gboolean batchable)
+{
+  uint32_t color = icon_color (icon);
+  uint8_t data[ICON_SIZE * ICON_SIZE * 4];
+  int i;
+
+  for (i = 0; i < ICON_SIZE * ICON_SIZE; i++)
+    {
+      data[i * 4 + 0] = color >> 24;
+      data[i * 4 + 1] = color >> 16;
+      data[i * 4 + 2] = color >> 8;
+      data[i * 4 + 3] = color;
+    }
+
+  if (batchable)
+    {
+      CoglAtlasTexture *atlas_tex;
+
+      atlas_tex = cogl_atlas_texture_new_from_data (test_ctx,
+                                                    ICON_SIZE, ICON_SIZE,
+                                                    COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                    ICON_SIZE * 4,
+                                                    data,
+                                                    NULL);
+      return atlas_tex ? COGL_TEXTURE (atlas_tex) : NULL;
+    }
+
+  return COGL_TEXTURE (cogl_texture_2d_new_from_data (test_ctx,
+                                                      ICON_SIZE, ICON_SIZE,
+                                                      COGL_PIXEL_FORMAT_RGBA_8888_PRE,
+                                                      ICON_SIZE * 4,
+                                                      data,
+                                                      NULL));
+}
+
+/* Draws a grid of distinct icons, each with its own pipeline like
+ * an app grid would, and returns the number of draw calls issued */
+static unsigned int
+draw_icon_grid (gboolean batchable)
+{
+  CoglTexture *icons[N_ICONS];
+  unsigned int n_draws;
+  int i;
+
+  for (i = 0; i < N_ICONS; i++)
+    {
+      icons[i] = create_icon (i, batchable);
+      if (!icons[i])
+        {
+          while (i--)
+            cogl_object_unref (icons[i]);
+          return 0;
+        }
+    }
+
+  cogl_framebuffer_orthographic (test_fb, 0, 0, FB_WIDTH, FB_HEIGHT, -1, 100);
+  cogl_framebuffer_clear4f (test_fb, COGL_BUFFER_BIT_COLOR, 0, 0, 0, 1);
+  _cogl_framebuffer_flush_journal (test_fb);
+
+  n_draws = test_ctx->gl_state_counters.n_draws;
+
+  for (i = 0; i < N_ICONS; i++)
+    {
+      CoglPipeline *pipeline;
+      float x = (i % GRID_COLUMNS) * (ICON_SIZE + 8);
+      float y = (i / GRID_COLUMNS) * (ICON_SIZE + 8);
+
+      pipeline = cogl_pipeline_new (test_ctx);
+      cogl_pipeline_set_layer_texture (pipeline, 0, icons[i]);
+      cogl_pipeline_set_layer_filters (pipeline, 0,
+                                       COGL_PIPELINE_FILTER_NEAREST,
+                                       COGL_PIPELINE_FILTER_NEAREST);
+      cogl_framebuffer_draw_textured_rectangle (test_fb, pipeline,
+                                                x, y,
+                                                x + ICON_SIZE, y + ICON_SIZE,
+                                                0, 0, 1, 1);
+      cogl_object_unref (pipeline);
+    }
+
+  _cogl_framebuffer_flush_journal (test_fb);
+
+  n_draws = test_ctx->gl_state_counters.n_draws - n_draws;
+
+  for (i = 0; i < N_ICONS; i++)
+    {
+      int x = (i % GRID_COLUMNS) * (ICON_SIZE + 8);
+      int y = (i / GRID_COLUMNS) * (ICON_SIZE + 8);
+
+      test_utils_check_pixel (test_fb,
+                              x + ICON_SIZE / 2, y + ICON_SIZE / 2,
+                              icon_color (i));
+      cogl_object_unref (icons[i]);
+    }
+
+  return n_draws;
+}
+
+static void
+test_journal_batching_icon_grid (void)
+{
+  unsigned int n_separate_draws;
+  unsigned int n_batched_draws;
+
+  n_separate_draws = draw_icon_grid (FALSE);
+  n_batched_draws = draw_icon_grid (TRUE);
+
+  if (n_batched_draws == 0)
+    {
+      g_test_skip ("Texture atlas not available");
+      return;
+    }
+
+  g_test_message ("%d icons: %u draw calls with separate textures, "
+                  "%u with batched textures",
+                  N_ICONS, n_separate_draws, n_batched_draws);
+
+  g_assert_cmpuint (n_separate_draws, ==, N_ICONS);
+  g_assert_cmpuint (n_batched_draws, ==, 1);
+}
+
+COGL_TEST_SUITE (
+  g_test_add_func ("/journal/batching/icon-grid",
+                   test_journal_batching_icon_grid);
+)
@@ -0,0 +1,193 @@
+#include "cogl-config.h"
+
+#include "cogl/cogl-rectangle-map.h"
+#include "tests/cogl-test-utils.h"
+
+#define MAP_SIZE 512
+#define MAX_RECTANGLES 4096
+
+typedef struct
+{
+  CoglRectangleMapEntry rectangles[MAX_RECTANGLES];
+  int n_rectangles;
+  unsigned int used_space;
+} TestState;
+
+static gboolean
+entries_intersect (const CoglRectangleMapEntry *a,
+                   const CoglRectangleMapEntry *b)
+{
+  return (a->x < b->x + b->width &&
+          b->x < a->x + a->width &&
+          a->y < b->y + b->height &&
+          b->y < a->y + a->height);
+}
+
+static void
+count_rectangle_cb (const CoglRectangleMapEntry *entry,
+                    void                        *rectangle_data,
+                    void                        *user_data)
+{
+  int *n_rectangles = user_data;
+
+  (*n_rectangles)++;
+}
+
+static void
+verify_map (CoglRectangleMap *map,
+            TestState        *state)
+{
+  int n_rectangles = 0;
+  int i, j;
+
+  for (i = 0; i < state->n_rectangles; i++)
+    {
+      const CoglRectangleMapEntry *rectangle = &state->rectangles[i];
+
+      g_assert_cmpuint (rectangle->x + rectangle->width, <=, MAP_SIZE);
+      g_assert_cmpuint (rectangle->y + rectangle->height, <=, MAP_SIZE);
+
+      for (j = i + 1; j < state->n_rectangles; j++)
+        g_assert_false (entries_intersect (rectangle, &state->rectangles[j]));
+    }
+
+  _cogl_rectangle_map_foreach (map, count_rectangle_cb, &n_rectangles);
+  g_assert_cmpint (n_rectangles, ==, state->n_rectangles);
+  g_assert_cmpuint (_cogl_rectangle_map_get_n_rectangles (map),
+                    ==,
+                    state->n_rectangles);
+  g_assert_cmpuint (_cogl_rectangle_map_get_remaining_space (map),
+                    ==,
+                    MAP_SIZE * MAP_SIZE - state->used_space);
+}
+
+static void
+remove_rectangle (CoglRectangleMap *map,
+                  TestState        *state,
+                  int               index)
+{
+  CoglRectangleMapEntry *rectangle = &state->rectangles[index];
+
+  _cogl_rectangle_map_remove (map, rectangle);
+  state->used_space -= rectangle->width * rectangle->height;
+  state->rectangles[index] = state->rectangles[--state->n_rectangles];
+}
+
+static void
+test_rectangle_map_add_remove (void)
+{
+  CoglRectangleMap *map;
+  TestState state = { 0 };
+  int i;
+
+  map = _cogl_rectangle_map_new (MAP_SIZE, MAP_SIZE, NULL);
+
+  for (i = 0; i < 3000; i++)
+    {
+      if (state.n_rectangles > 0 && g_test_rand_int_range (0, 3) == 0)
+        {
+          remove_rectangle (map, &state,
+                            g_test_rand_int_range (0, state.n_rectangles));
+        }
+      else
+        {
+          CoglRectangleMapEntry rectangle;
+          unsigned int width = g_test_rand_int_range (1, 64);
+          unsigned int height = g_test_rand_int_range (1, 64);
+
+          if (_cogl_rectangle_map_add (map, width, height, NULL, &rectangle))
+            {
+              g_assert_cmpuint (rectangle.width, ==, width);
+              g_assert_cmpuint (rectangle.height, ==, height);
+
+              state.rectangles[state.n_rectangles++] = rectangle;
+              state.used_space += width * height;
+            }
+        }
+
+      if (i % 100 == 0)
+        verify_map (map, &state);
+    }
+
+  verify_map (map, &state);
+
+  while (state.n_rectangles > 0)
+    remove_rectangle (map, &state, 0);
+
+  verify_map (map, &state);
+
+  /* With everything removed the whole area must be usable again */
+  g_assert_true (_cogl_rectangle_map_add (map, MAP_SIZE, MAP_SIZE,
+                                          NULL, NULL));
+
+  _cogl_rectangle_map_free (map);
+}
+
+static void
+test_rectangle_map_occupancy (void)
+{
+  CoglRectangleMap *map;
+  TestState state = { 0 };
+  int i;
+
+  map = _cogl_rectangle_map_new (MAP_SIZE, MAP_SIZE, NULL);
+
+  /* Keep adding icon and glyph sized rectangles until it's full */
+  for (i = 0; i < MAX_RECTANGLES; i++)
+    {
+      CoglRectangleMapEntry rectangle;
+      unsigned int width = g_test_rand_int_range (8, 48);
+      unsigned int height = g_test_rand_int_range (8, 48);
+
+      if (_cogl_rectangle_map_add (map, width, height, NULL, &rectangle))
+        {
+          state.rectangles[state.n_rectangles++] = rectangle;
+          state.used_space += width * height;
+        }
+    }
+
+  verify_map (map, &state);
+
+  g_assert_cmpuint (state.used_space * 100 / (MAP_SIZE * MAP_SIZE), >=, 85);
+
+  _cogl_rectangle_map_free (map);
+}
+
+static void
+test_rectangle_map_compact (void)
+{
+  CoglRectangleMap *map;
+  CoglRectangleMapEntry top = { 0, 0, MAP_SIZE, 16 };
+  CoglRectangleMapEntry bottom = { 0, MAP_SIZE - 16, 16, 16 };
+  CoglRectangleMapEntry position;
+
+  map = _cogl_rectangle_map_new (MAP_SIZE, MAP_SIZE, NULL);
+
+  g_assert_true (_cogl_rectangle_map_add_at (map, &top, NULL));
+  g_assert_true (_cogl_rectangle_map_add_at (map, &bottom, NULL));
+  g_assert_false (_cogl_rectangle_map_add_at (map, &bottom, NULL));
+
+  /* The bottom rectangle can move up to just below the top one */
+  _cogl_rectangle_map_remove (map, &bottom);
+  _cogl_rectangle_map_merge_free_space (map);
+  g_assert_true (_cogl_rectangle_map_find_compact_position (map,
+                                                            bottom.width,
+                                                            bottom.height,
+                                                            &position));
+  g_assert_cmpuint (position.x, ==, 0);
+  g_assert_cmpuint (position.y, ==, 16);
+  g_assert_true (_cogl_rectangle_map_add_at (map, &position, NULL));
+
+  g_assert_cmpuint (_cogl_rectangle_map_get_n_rectangles (map), ==, 2);
+
+  _cogl_rectangle_map_free (map);
+}
+
+COGL_TEST_SUITE_MINIMAL (
+  g_test_add_func ("/rectangle-map/add-remove",
+                   test_rectangle_map_add_remove);
+  g_test_add_func ("/rectangle-map/occupancy",
+                   test_rectangle_map_occupancy);
+  g_test_add_func ("/rectangle-map/compact",
+                   test_rectangle_map_compact);
+)
@@ -0,0 +1,227 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <fcntl.h>
+#include <glib.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+#include "wayland/meta-drm-timeline.h"
+
+typedef struct
+{
+  int drm_fd;
+  uint32_t drm_syncobj;
+  MetaDrmTimeline *timeline;
+} TimelineFixture;
+
+/*
+ * Any render node supporting timeline syncobjs will do; in CI this is
+ * typically vgem.
+ */
+static int
+open_timeline_render_node (void)
+{
+  int i;
+
+  for (i = 128; i < 192; i++)
+    {
+      g_autofree char *path = NULL;
+      uint64_t timeline_supported = 0;
+      int fd;
+
+      path = g_strdup_printf ("/dev/dri/renderD%d", i);
+      fd = open (path, O_RDWR | O_CLOEXEC);
+      if (fd < 0)
+        continue;
+
+      if (drmGetCap (fd, DRM_CAP_SYNCOBJ_TIMELINE, &timeline_supported) == 0 &&
+          timeline_supported)
+        return fd;
+
+      close (fd);
+    }
+
+  return -1;
+}
+
+static void
+timeline_fixture_setup (TimelineFixture *fixture,
+                        gconstpointer    user_data)
+{
+  g_autoptr (GError) error = NULL;
+  int syncobj_fd;
+
+  fixture->drm_fd = open_timeline_render_node ();
+  if (fixture->drm_fd < 0)
+    return;
+
+  g_assert_cmpint (drmSyncobjCreate (fixture->drm_fd, 0,
+                                     &fixture->drm_syncobj), ==, 0);
+  g_assert_cmpint (drmSyncobjHandleToFD (fixture->drm_fd,
+                                         fixture->drm_syncobj,
+                                         &syncobj_fd), ==, 0);
+
+  fixture->timeline = meta_drm_timeline_import_syncobj (fixture->drm_fd,
+                                                        syncobj_fd,
+                                                        &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (fixture->timeline);
+  close (syncobj_fd);
+}
+
+static void
+timeline_fixture_teardown (TimelineFixture *fixture,
+                           gconstpointer    user_data)
+{
+  if (fixture->drm_fd < 0)
+    return;
+
+  g_clear_object (&fixture->timeline);
+  drmSyncobjDestroy (fixture->drm_fd, fixture->drm_syncobj);
+  close (fixture->drm_fd);
+}
+
+static gboolean
+is_fd_readable (int fd,
+                int timeout_ms)
+{
+  GPollFD poll_fd = {
+    .fd = fd,
+    .events = G_IO_IN,
+  };
+
+  return g_poll (&poll_fd, 1, timeout_ms) == 1 &&
+         (poll_fd.revents & G_IO_IN);
+}
+
+static void
+meta_test_drm_timeline_eventfd (TimelineFixture *fixture,
+                                gconstpointer    user_data)
+{
+  g_autoptr (GError) error = NULL;
+  uint64_t point = 1;
+  int eventfd;
+
+  if (fixture->drm_fd < 0)
+    {
+      g_test_skip ("No render node with timeline syncobj support");
+      return;
+    }
+
+  g_assert_false (meta_drm_timeline_is_signaled (fixture->timeline, 1, NULL));
+
+  eventfd = meta_drm_timeline_get_eventfd (fixture->timeline, 1, &error);
+  g_assert_no_error (error);
+  g_assert_cmpint (eventfd, >=, 0);
+  g_assert_false (is_fd_readable (eventfd, 0));
+
+  g_assert_cmpint (drmSyncobjTimelineSignal (fixture->drm_fd,
+                                             &fixture->drm_syncobj, &point,
+                                             1), ==, 0);
+
+  g_assert_true (is_fd_readable (eventfd, 1000));
+  g_assert_true (meta_drm_timeline_is_signaled (fixture->timeline, 1, NULL));
+  g_assert_false (meta_drm_timeline_is_signaled (fixture->timeline, 2, NULL));
+
+  close (eventfd);
+}
+
+static void
+meta_test_drm_timeline_signal (TimelineFixture *fixture,
+                               gconstpointer    user_data)
+{
+  g_autoptr (GError) error = NULL;
+  uint64_t value = 0;
+
+  if (fixture->drm_fd < 0)
+    {
+      g_test_skip ("No render node with timeline syncobj support");
+      return;
+    }
+
+  g_assert_true (meta_drm_timeline_signal (fixture->timeline, 3, &error));
+  g_assert_no_error (error);
+
+  g_assert_cmpint (drmSyncobjQuery (fixture->drm_fd,
+                                    &fixture->drm_syncobj, &value,
+                                    1), ==, 0);
+  g_assert_cmpuint (value, ==, 3);
+}
+
+static void
+meta_test_drm_timeline_set_sync_point (TimelineFixture *fixture,
+                                       gconstpointer    user_data)
+{
+  g_autoptr (GError) error = NULL;
+  uint32_t signaled_syncobj;
+  int sync_fd;
+
+  if (fixture->drm_fd < 0)
+    {
+      g_test_skip ("No render node with timeline syncobj support");
+      return;
+    }
+
+  /* A sync file of an already signaled fence, as e.g. sw_sync would hand
+   * out once its timeline has advanced */
+  g_assert_cmpint (drmSyncobjCreate (fixture->drm_fd,
+                                     DRM_SYNCOBJ_CREATE_SIGNALED,
+                                     &signaled_syncobj), ==, 0);
+  g_assert_cmpint (drmSyncobjExportSyncFile (fixture->drm_fd,
+                                             signaled_syncobj,
+                                             &sync_fd), ==, 0);
+
+  g_assert_true (meta_drm_timeline_set_sync_point (fixture->timeline, 5,
+                                                   sync_fd, &error));
+  g_assert_no_error (error);
+  g_assert_true (meta_drm_timeline_is_signaled (fixture->timeline, 5, NULL));
+
+  close (sync_fd);
+  drmSyncobjDestroy (fixture->drm_fd, signaled_syncobj);
+}
+
+static void
+init_drm_timeline_tests (void)
+{
+  g_test_add ("/wayland/drm-timeline/eventfd",
+              TimelineFixture, NULL,
+              timeline_fixture_setup,
+              meta_test_drm_timeline_eventfd,
+              timeline_fixture_teardown);
+  g_test_add ("/wayland/drm-timeline/signal",
+              TimelineFixture, NULL,
+              timeline_fixture_setup,
+              meta_test_drm_timeline_signal,
+              timeline_fixture_teardown);
+  g_test_add ("/wayland/drm-timeline/set-sync-point",
+              TimelineFixture, NULL,
+              timeline_fixture_setup,
+              meta_test_drm_timeline_set_sync_point,
+              timeline_fixture_teardown);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+  init_drm_timeline_tests ();
+  return g_test_run ();
+}
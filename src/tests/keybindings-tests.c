@@ -0,0 +1,553 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <string.h>
+#include <xkbcommon/xkbcommon.h>
+
+#include "core/keybindings-private.h"
+
+#define CONTROL_MASK (1 << 2)
+#define ALT_MASK (1 << 3)
+#define SUPER_MASK (1 << 6)
+
+typedef struct
+{
+  const char *layout;
+  const char *variant;
+} TestKeymap;
+
+static const TestKeymap test_keymaps[] = {
+  { "us", "" },
+  { "us", "dvorak" },
+  { "us,ru", "" },
+  { "ru,us", "" },
+  { "de,fr", "" },
+  { "il", "" },
+};
+
+static struct xkb_keymap *
+create_keymap (const char *layout,
+               const char *variant)
+{
+  struct xkb_rule_names names = {
+    .rules = "evdev",
+    .model = "pc105+inet",
+    .layout = layout,
+    .variant = variant,
+    .options = "",
+  };
+  struct xkb_context *context;
+  struct xkb_keymap *keymap;
+
+  context = xkb_context_new (XKB_CONTEXT_NO_FLAGS);
+  keymap = xkb_keymap_new_from_names (context, &names,
+                                      XKB_KEYMAP_COMPILE_NO_FLAGS);
+  xkb_context_unref (context);
+  g_assert_nonnull (keymap);
+
+  return keymap;
+}
+
+/* Resolves keycodes the way it was done before layouts were indexed:
+ * walking the whole keymap for every level of the layout, until a level
+ * the keysym is found on.
+ */
+static void
+add_reference_keycodes (struct xkb_keymap  *keymap,
+                        xkb_layout_index_t  layout,
+                        xkb_keysym_t        keysym,
+                        GArray             *keycodes)
+{
+  xkb_level_index_t n_levels = 0;
+  xkb_level_index_t level;
+  xkb_keycode_t keycode;
+
+  for (keycode = xkb_keymap_min_keycode (keymap);
+       keycode <= xkb_keymap_max_keycode (keymap);
+       keycode++)
+    {
+      n_levels = MAX (n_levels,
+                      xkb_keymap_num_levels_for_key (keymap, keycode, layout));
+    }
+
+  for (level = 0; level < n_levels && keycodes->len == 0; level++)
+    {
+      for (keycode = xkb_keymap_min_keycode (keymap);
+           keycode <= xkb_keymap_max_keycode (keymap);
+           keycode++)
+        {
+          const xkb_keysym_t *syms;
+          int num_syms, k;
+          unsigned int i;
+          gboolean missing = TRUE;
+
+          num_syms = xkb_keymap_key_get_syms_by_level (keymap, keycode,
+                                                       layout, level, &syms);
+          for (k = 0; k < num_syms; k++)
+            {
+              if (syms[k] == keysym)
+                break;
+            }
+          if (k == num_syms)
+            continue;
+
+          for (i = 0; i < keycodes->len; i++)
+            {
+              if (g_array_index (keycodes, xkb_keycode_t, i) == keycode)
+                missing = FALSE;
+            }
+
+          if (missing)
+            g_array_append_val (keycodes, keycode);
+        }
+    }
+}
+
+static gboolean
+reference_needs_secondary_layout (struct xkb_keymap  *keymap,
+                                  xkb_layout_index_t  layout)
+{
+  xkb_keysym_t keysym;
+
+  for (keysym = XKB_KEY_a; keysym <= XKB_KEY_z; keysym++)
+    {
+      xkb_keycode_t keycode;
+      gboolean found = FALSE;
+
+      for (keycode = xkb_keymap_min_keycode (keymap);
+           keycode <= xkb_keymap_max_keycode (keymap) && !found;
+           keycode++)
+        {
+          const xkb_keysym_t *syms;
+          int num_syms, k;
+
+          num_syms = xkb_keymap_key_get_syms_by_level (keymap, keycode,
+                                                       layout, 0, &syms);
+          for (k = 0; k < num_syms; k++)
+            found = found || syms[k] == keysym;
+        }
+
+      if (!found)
+        return TRUE;
+    }
+
+  return FALSE;
+}
+
+static void
+add_layout_keysyms (struct xkb_keymap  *keymap,
+                    xkb_layout_index_t  layout,
+                    GHashTable         *keysyms)
+{
+  xkb_keycode_t keycode;
+
+  for (keycode = xkb_keymap_min_keycode (keymap);
+       keycode <= xkb_keymap_max_keycode (keymap);
+       keycode++)
+    {
+      xkb_level_index_t n_levels, level;
+
+      n_levels = xkb_keymap_num_levels_for_key (keymap, keycode, layout);
+      for (level = 0; level < n_levels; level++)
+        {
+          const xkb_keysym_t *syms;
+          int num_syms, k;
+
+          num_syms = xkb_keymap_key_get_syms_by_level (keymap, keycode,
+                                                       layout, level, &syms);
+          for (k = 0; k < num_syms; k++)
+            g_hash_table_add (keysyms, GUINT_TO_POINTER (syms[k]));
+        }
+    }
+}
+
+static void
+set_active_layout (MetaKeyBindingManager        *keys,
+                   MetaKeyBindingKeyboardLayout *layout,
+                   MetaKeyBindingKeyboardLayout *us_layout)
+{
+  keys->active_layouts[0] = layout;
+
+  if (meta_key_binding_keyboard_layout_needs_secondary (layout))
+    keys->active_layouts[1] = us_layout;
+  else
+    keys->active_layouts[1] = NULL;
+}
+
+static void
+assert_resolves_like_reference (struct xkb_keymap  *keymap,
+                                xkb_layout_index_t  layout_index,
+                                struct xkb_keymap  *us_keymap,
+                                MetaKeyBindingKeyboardLayout *us_layout)
+{
+  MetaKeyBindingManager keys = { 0 };
+  MetaKeyBindingKeyboardLayout *layout;
+  g_autoptr (GHashTable) keysyms = NULL;
+  gboolean needs_secondary;
+  GHashTableIter iter;
+  gpointer key;
+
+  layout = meta_key_binding_keyboard_layout_new (keymap, layout_index);
+
+  needs_secondary = reference_needs_secondary_layout (keymap, layout_index);
+  g_assert_cmpint (meta_key_binding_keyboard_layout_needs_secondary (layout),
+                   ==,
+                   needs_secondary);
+  set_active_layout (&keys, layout, us_layout);
+
+  keysyms = g_hash_table_new (NULL, NULL);
+  add_layout_keysyms (keymap, layout_index, keysyms);
+  add_layout_keysyms (us_keymap, 0, keysyms);
+
+  g_hash_table_iter_init (&iter, keysyms);
+  while (g_hash_table_iter_next (&iter, &key, NULL))
+    {
+      xkb_keysym_t keysym = GPOINTER_TO_UINT (key);
+      g_autoptr (GArray) reference_keycodes = NULL;
+      MetaResolvedKeyCombo resolved_combo = { 0 };
+
+      reference_keycodes = g_array_new (FALSE, FALSE, sizeof (xkb_keycode_t));
+      add_reference_keycodes (keymap, layout_index, keysym,
+                              reference_keycodes);
+      if (needs_secondary)
+        add_reference_keycodes (us_keymap, 0, keysym, reference_keycodes);
+
+      meta_key_binding_manager_get_keycodes_for_keysym (&keys, keysym,
+                                                        &resolved_combo);
+
+      g_assert_cmpmem (resolved_combo.keycodes,
+                       resolved_combo.len * sizeof (xkb_keycode_t),
+                       reference_keycodes->data,
+                       reference_keycodes->len * sizeof (xkb_keycode_t));
+      g_free (resolved_combo.keycodes);
+    }
+
+  meta_key_binding_keyboard_layout_free (layout);
+}
+
+static void
+meta_test_keybindings_resolve_keycodes (void)
+{
+  struct xkb_keymap *us_keymap;
+  MetaKeyBindingKeyboardLayout *us_layout;
+  unsigned int i;
+
+  us_keymap = create_keymap ("us", "");
+  us_layout = meta_key_binding_keyboard_layout_new (us_keymap, 0);
+
+  for (i = 0; i < G_N_ELEMENTS (test_keymaps); i++)
+    {
+      struct xkb_keymap *keymap;
+      xkb_layout_index_t layout_index;
+
+      keymap = create_keymap (test_keymaps[i].layout,
+                              test_keymaps[i].variant);
+
+      for (layout_index = 0;
+           layout_index < xkb_keymap_num_layouts (keymap);
+           layout_index++)
+        {
+          g_test_message ("Resolving keycodes of layout %u of %s(%s)",
+                          layout_index,
+                          test_keymaps[i].layout,
+                          test_keymaps[i].variant);
+          assert_resolves_like_reference (keymap, layout_index,
+                                          us_keymap, us_layout);
+        }
+
+      xkb_keymap_unref (keymap);
+    }
+
+  meta_key_binding_keyboard_layout_free (us_layout);
+  xkb_keymap_unref (us_keymap);
+}
+
+static void
+meta_test_keybindings_secondary_layout (void)
+{
+  struct xkb_keymap *keymap;
+  MetaKeyBindingKeyboardLayout *us_layout;
+  MetaKeyBindingKeyboardLayout *ru_layout;
+  MetaKeyBindingManager keys = { 0 };
+  MetaResolvedKeyCombo resolved_combo = { 0 };
+  xkb_keycode_t us_keycode;
+
+  keymap = create_keymap ("us,ru", "");
+  us_layout = meta_key_binding_keyboard_layout_new (keymap, 0);
+  ru_layout = meta_key_binding_keyboard_layout_new (keymap, 1);
+
+  g_assert_false (meta_key_binding_keyboard_layout_needs_secondary (us_layout));
+  g_assert_true (meta_key_binding_keyboard_layout_needs_secondary (ru_layout));
+
+  set_active_layout (&keys, us_layout, us_layout);
+  meta_key_binding_manager_get_keycodes_for_keysym (&keys, XKB_KEY_a,
+                                                    &resolved_combo);
+  g_assert_cmpint (resolved_combo.len, ==, 1);
+  us_keycode = resolved_combo.keycodes[0];
+  g_clear_pointer (&resolved_combo.keycodes, g_free);
+
+  /* Latin keysyms missing from the primary layout come from the US one */
+  set_active_layout (&keys, ru_layout, us_layout);
+  meta_key_binding_manager_get_keycodes_for_keysym (&keys, XKB_KEY_a,
+                                                    &resolved_combo);
+  g_assert_cmpint (resolved_combo.len, ==, 1);
+  g_assert_cmpuint (resolved_combo.keycodes[0], ==, us_keycode);
+  g_clear_pointer (&resolved_combo.keycodes, g_free);
+
+  /* but keysyms of the primary layout win */
+  meta_key_binding_manager_get_keycodes_for_keysym (&keys, XKB_KEY_Cyrillic_ef,
+                                                    &resolved_combo);
+  g_assert_cmpint (resolved_combo.len, ==, 1);
+  g_assert_cmpuint (resolved_combo.keycodes[0], ==, us_keycode);
+  g_clear_pointer (&resolved_combo.keycodes, g_free);
+
+  meta_key_binding_keyboard_layout_free (ru_layout);
+  meta_key_binding_keyboard_layout_free (us_layout);
+  xkb_keymap_unref (keymap);
+}
+
+typedef struct
+{
+  xkb_keysym_t keysym;
+  xkb_mod_mask_t mask;
+  MetaKeyBindingFlags flags;
+} TestBinding;
+
+static const TestBinding test_bindings[] = {
+  /* Moved between US and French layouts */
+  { XKB_KEY_a, SUPER_MASK, META_KEY_BINDING_NONE },
+  { XKB_KEY_q, CONTROL_MASK, META_KEY_BINDING_NONE },
+  { XKB_KEY_w, ALT_MASK, META_KEY_BINDING_PER_WINDOW },
+  { XKB_KEY_z, CONTROL_MASK, META_KEY_BINDING_NO_AUTO_GRAB },
+  /* In the same place in both */
+  { XKB_KEY_s, CONTROL_MASK, META_KEY_BINDING_NONE },
+  { XKB_KEY_Tab, ALT_MASK, META_KEY_BINDING_NONE },
+  { XKB_KEY_F1, 0, META_KEY_BINDING_NONE },
+  { XKB_KEY_Return, SUPER_MASK, META_KEY_BINDING_PER_WINDOW },
+};
+
+static void
+resolve_test_bindings (MetaKeyBindingManager *keys,
+                       MetaKeyBinding        *bindings)
+{
+  unsigned int i;
+
+  for (i = 0; i < G_N_ELEMENTS (test_bindings); i++)
+    {
+      MetaKeyBinding *binding = &bindings[i];
+
+      binding->flags = test_bindings[i].flags;
+      meta_key_binding_manager_get_keycodes_for_keysym (keys,
+                                                        test_bindings[i].keysym,
+                                                        &binding->resolved_combo);
+      binding->resolved_combo.mask = test_bindings[i].mask;
+      g_assert_cmpint (binding->resolved_combo.len, >, 0);
+
+      g_hash_table_insert (keys->key_bindings, binding, binding);
+    }
+}
+
+static void
+clear_test_bindings (MetaKeyBindingManager *keys,
+                     MetaKeyBinding        *bindings)
+{
+  unsigned int i;
+
+  g_hash_table_remove_all (keys->key_bindings);
+
+  for (i = 0; i < G_N_ELEMENTS (test_bindings); i++)
+    g_clear_pointer (&bindings[i].resolved_combo.keycodes, g_free);
+}
+
+static gboolean
+resolved_combos_equal (MetaResolvedKeyCombo *a,
+                       MetaResolvedKeyCombo *b)
+{
+  return (a->len == b->len &&
+          memcmp (a->keycodes, b->keycodes,
+                  a->len * sizeof (xkb_keycode_t)) == 0);
+}
+
+/* Keygrabs are collected as keycode and mask pairs */
+static gpointer
+get_keygrab (MetaResolvedKeyCombo *resolved_combo,
+             int                   i)
+{
+  return GUINT_TO_POINTER ((resolved_combo->keycodes[i] & 0xffff) << 16 |
+                           (resolved_combo->mask & 0xffff));
+}
+
+static void
+meta_test_keybindings_keygrabs_diff (void)
+{
+  struct xkb_keymap *keymap;
+  MetaKeyBindingKeyboardLayout *us_layout;
+  MetaKeyBindingKeyboardLayout *fr_layout;
+  MetaKeyBindingManager keys = { 0 };
+  MetaKeyBinding us_bindings[G_N_ELEMENTS (test_bindings)] = { 0 };
+  MetaKeyBinding fr_bindings[G_N_ELEMENTS (test_bindings)] = { 0 };
+  g_autoptr (GHashTable) old_root_keygrabs = NULL;
+  g_autoptr (GHashTable) old_window_keygrabs = NULL;
+  g_autoptr (GHashTable) root_keygrabs = NULL;
+  g_autoptr (GHashTable) window_keygrabs = NULL;
+  g_autoptr (GHashTable) ungrabs = NULL;
+  g_autoptr (GHashTable) grabs = NULL;
+  unsigned int n_changed_keygrabs = 0;
+  unsigned int n_unchanged_keygrabs = 0;
+  unsigned int i;
+  int j;
+
+  keymap = create_keymap ("us,fr", "");
+  us_layout = meta_key_binding_keyboard_layout_new (keymap, 0);
+  fr_layout = meta_key_binding_keyboard_layout_new (keymap, 1);
+  keys.key_bindings = g_hash_table_new (NULL, NULL);
+
+  set_active_layout (&keys, us_layout, us_layout);
+  resolve_test_bindings (&keys, us_bindings);
+  old_root_keygrabs = g_hash_table_new (NULL, NULL);
+  old_window_keygrabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_manager_collect_keygrabs (&keys,
+                                             old_root_keygrabs,
+                                             old_window_keygrabs);
+  g_hash_table_remove_all (keys.key_bindings);
+
+  set_active_layout (&keys, fr_layout, us_layout);
+  resolve_test_bindings (&keys, fr_bindings);
+  root_keygrabs = g_hash_table_new (NULL, NULL);
+  window_keygrabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_manager_collect_keygrabs (&keys,
+                                             root_keygrabs,
+                                             window_keygrabs);
+
+  /* Switching layouts only changes the grabs of the moved keys */
+  for (i = 0; i < G_N_ELEMENTS (test_bindings); i++)
+    {
+      MetaResolvedKeyCombo *old_combo = &us_bindings[i].resolved_combo;
+      MetaResolvedKeyCombo *new_combo = &fr_bindings[i].resolved_combo;
+      gboolean per_window = test_bindings[i].flags & META_KEY_BINDING_PER_WINDOW;
+      GHashTable *old_keygrabs =
+        per_window ? old_window_keygrabs : old_root_keygrabs;
+      GHashTable *new_keygrabs = per_window ? window_keygrabs : root_keygrabs;
+
+      ungrabs = g_hash_table_new (NULL, NULL);
+      grabs = g_hash_table_new (NULL, NULL);
+      meta_key_binding_diff_keygrabs (old_keygrabs, new_keygrabs, FALSE,
+                                      ungrabs, grabs);
+
+      if (test_bindings[i].flags & META_KEY_BINDING_NO_AUTO_GRAB)
+        {
+          for (j = 0; j < old_combo->len; j++)
+            g_assert_false (g_hash_table_contains (ungrabs,
+                                                   get_keygrab (old_combo, j)));
+          for (j = 0; j < new_combo->len; j++)
+            g_assert_false (g_hash_table_contains (grabs,
+                                                   get_keygrab (new_combo, j)));
+        }
+      else if (resolved_combos_equal (old_combo, new_combo))
+        {
+          for (j = 0; j < old_combo->len; j++)
+            {
+              g_assert_false (g_hash_table_contains (ungrabs,
+                                                     get_keygrab (old_combo, j)));
+              g_assert_false (g_hash_table_contains (grabs,
+                                                     get_keygrab (old_combo, j)));
+            }
+          n_unchanged_keygrabs += old_combo->len;
+        }
+      else
+        {
+          for (j = 0; j < old_combo->len; j++)
+            g_assert_true (g_hash_table_contains (ungrabs,
+                                                  get_keygrab (old_combo, j)));
+          for (j = 0; j < new_combo->len; j++)
+            g_assert_true (g_hash_table_contains (grabs,
+                                                  get_keygrab (new_combo, j)));
+          n_changed_keygrabs += old_combo->len;
+        }
+
+      g_clear_pointer (&ungrabs, g_hash_table_unref);
+      g_clear_pointer (&grabs, g_hash_table_unref);
+    }
+
+  g_assert_cmpuint (n_changed_keygrabs, >, 0);
+  g_assert_cmpuint (n_unchanged_keygrabs, >, 0);
+
+  /* and nothing else */
+  ungrabs = g_hash_table_new (NULL, NULL);
+  grabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_diff_keygrabs (old_root_keygrabs, root_keygrabs, FALSE,
+                                  ungrabs, grabs);
+  meta_key_binding_diff_keygrabs (old_window_keygrabs, window_keygrabs, FALSE,
+                                  ungrabs, grabs);
+  g_assert_cmpuint (g_hash_table_size (ungrabs), ==, n_changed_keygrabs);
+  g_assert_cmpuint (g_hash_table_size (grabs), ==, n_changed_keygrabs);
+  g_clear_pointer (&ungrabs, g_hash_table_unref);
+  g_clear_pointer (&grabs, g_hash_table_unref);
+
+  /* Every grab depends on the ignored modifiers, so changing those
+   * regrabs everything
+   */
+  ungrabs = g_hash_table_new (NULL, NULL);
+  grabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_diff_keygrabs (old_root_keygrabs, root_keygrabs, TRUE,
+                                  ungrabs, grabs);
+  g_assert_cmpuint (g_hash_table_size (ungrabs), ==,
+                    g_hash_table_size (old_root_keygrabs));
+  g_assert_cmpuint (g_hash_table_size (grabs), ==,
+                    g_hash_table_size (root_keygrabs));
+  g_clear_pointer (&ungrabs, g_hash_table_unref);
+  g_clear_pointer (&grabs, g_hash_table_unref);
+
+  ungrabs = g_hash_table_new (NULL, NULL);
+  grabs = g_hash_table_new (NULL, NULL);
+  meta_key_binding_diff_keygrabs (old_root_keygrabs, old_root_keygrabs, TRUE,
+                                  ungrabs, grabs);
+  g_assert_cmpuint (g_hash_table_size (ungrabs), ==,
+                    g_hash_table_size (old_root_keygrabs));
+  g_assert_cmpuint (g_hash_table_size (grabs), ==,
+                    g_hash_table_size (old_root_keygrabs));
+  g_clear_pointer (&ungrabs, g_hash_table_unref);
+  g_clear_pointer (&grabs, g_hash_table_unref);
+
+  clear_test_bindings (&keys, fr_bindings);
+  for (i = 0; i < G_N_ELEMENTS (test_bindings); i++)
+    g_clear_pointer (&us_bindings[i].resolved_combo.keycodes, g_free);
+  g_hash_table_unref (keys.key_bindings);
+
+  meta_key_binding_keyboard_layout_free (fr_layout);
+  meta_key_binding_keyboard_layout_free (us_layout);
+  xkb_keymap_unref (keymap);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/core/keybindings/resolve-keycodes",
+                   meta_test_keybindings_resolve_keycodes);
+  g_test_add_func ("/core/keybindings/secondary-layout",
+                   meta_test_keybindings_secondary_layout);
+  g_test_add_func ("/core/keybindings/keygrabs-diff",
+                   meta_test_keybindings_keygrabs_diff);
+
+  return g_test_run ();
+}
@@ -0,0 +1,119 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "core/meta-context-private.h"
+#include "meta/meta-context.h"
+#include "meta/meta-backend.h"
+#include "tests/meta-test-utils.h"
+
+/* Generous, as this covers the whole startup on slow CI runners */
+#define FIRST_FRAME_TIMEOUT_S 30
+
+static void
+on_stage_presented (ClutterStage     *stage,
+                    ClutterStageView *view,
+                    ClutterFrameInfo *frame_info,
+                    MetaContext      *context)
+{
+  if (meta_context_get_time_to_first_frame_us (context) < 0)
+    return;
+
+  meta_context_terminate (context);
+}
+
+static gboolean
+on_first_frame_timeout (gpointer user_data)
+{
+  MetaContext *context = user_data;
+
+  meta_context_terminate_with_error (context,
+                                     g_error_new (G_IO_ERROR,
+                                                  G_IO_ERROR_TIMED_OUT,
+                                                  "No frame was presented"));
+
+  return G_SOURCE_REMOVE;
+}
+
+static gboolean
+queue_first_frame (gpointer user_data)
+{
+  MetaContext *context = user_data;
+  MetaBackend *backend = meta_context_get_backend (context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+
+  g_signal_connect (stage, "presented",
+                    G_CALLBACK (on_stage_presented), context);
+  clutter_actor_queue_redraw (stage);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+meta_test_startup_time_to_first_frame (void)
+{
+  char *fake_args[] = {
+      (char *) "mutter-startup-time-test",
+      (char *) "--wayland",
+      (char *) "--headless",
+      (char *) "--virtual-monitor",
+      (char *) "800x600",
+  };
+  char **fake_argv = fake_args;
+  int fake_argc = G_N_ELEMENTS (fake_args);
+  g_autoptr (MetaContext) context = NULL;
+  g_autoptr (GError) error = NULL;
+  int64_t time_to_first_frame_us;
+  unsigned int timeout_id;
+
+  context = meta_create_context ("Startup time test");
+  g_assert (meta_context_configure (context, &fake_argc, &fake_argv, &error));
+  meta_context_set_plugin_name (context, meta_test_get_plugin_name ());
+  g_assert (meta_context_setup (context, &error));
+  g_assert (meta_context_start (context, &error));
+
+  g_idle_add (queue_first_frame, context);
+  timeout_id = g_timeout_add_seconds (FIRST_FRAME_TIMEOUT_S,
+                                      on_first_frame_timeout,
+                                      context);
+
+  meta_context_run_main_loop (context, &error);
+  g_assert_no_error (error);
+  g_clear_handle_id (&timeout_id, g_source_remove);
+
+  time_to_first_frame_us = meta_context_get_time_to_first_frame_us (context);
+  g_assert_cmpint (time_to_first_frame_us, >, 0);
+
+  g_test_message ("First frame presented %.3f ms after setup started",
+                  time_to_first_frame_us / 1000.0);
+  g_test_minimized_result (time_to_first_frame_us / 1000.0,
+                           "%.3f ms to first frame",
+                           time_to_first_frame_us / 1000.0);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/backends/native/startup/time-to-first-frame",
+                   meta_test_startup_time_to_first_frame);
+
+  return g_test_run ();
+}
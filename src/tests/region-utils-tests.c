@@ -0,0 +1,308 @@
+/*
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <math.h>
+
+#include "compositor/region-utils.h"
+
+#define STAGE_WIDTH 3840
+#define STAGE_HEIGHT 2160
+#define N_WINDOWS 64
+#define N_FRAMES 200
+
+static cairo_region_t *
+create_random_region (int n_rects)
+{
+  cairo_region_t *region;
+  int i;
+
+  region = cairo_region_create ();
+
+  for (i = 0; i < n_rects; i++)
+    {
+      cairo_rectangle_int_t rect = {
+        .x = g_test_rand_int_range (-200, 1800),
+        .y = g_test_rand_int_range (-200, 1000),
+        .width = g_test_rand_int_range (1, 400),
+        .height = g_test_rand_int_range (1, 400),
+      };
+
+      cairo_region_union_rectangle (region, &rect);
+    }
+
+  return region;
+}
+
+static cairo_region_t *
+transform_expand_reference (const cairo_region_t *region,
+                            graphene_matrix_t    *transform)
+{
+  g_autofree cairo_rectangle_int_t *rects = NULL;
+  int n_rects, i;
+
+  n_rects = cairo_region_num_rectangles (region);
+  rects = g_new0 (cairo_rectangle_int_t, n_rects);
+
+  for (i = 0; i < n_rects; i++)
+    {
+      graphene_rect_t rect, transformed_rect;
+      cairo_rectangle_int_t int_rect;
+
+      cairo_region_get_rectangle (region, i, &int_rect);
+      rect = meta_rectangle_to_graphene_rect (&int_rect);
+      graphene_matrix_transform_bounds (transform, &rect, &transformed_rect);
+      meta_rectangle_from_graphene_rect (&transformed_rect,
+                                         META_ROUNDING_STRATEGY_GROW,
+                                         &rects[i]);
+    }
+
+  return cairo_region_create_rectangles (rects, n_rects);
+}
+
+static void
+meta_test_region_transform_expand (void)
+{
+  graphene_matrix_t transforms[8];
+  int i, j;
+
+  graphene_matrix_init_translate (&transforms[0],
+                                  &GRAPHENE_POINT3D_INIT (12, -7, 0));
+  graphene_matrix_init_translate (&transforms[1],
+                                  &GRAPHENE_POINT3D_INIT (12.5f, 0.25f, 0));
+  graphene_matrix_init_scale (&transforms[2], 2.0f, 2.0f, 1.0f);
+  graphene_matrix_init_scale (&transforms[3], 1.0f / 1.25f, 1.0f / 1.25f, 1.0f);
+  graphene_matrix_init_scale (&transforms[4], 1.5f, 0.75f, 1.0f);
+  graphene_matrix_translate (&transforms[4],
+                             &GRAPHENE_POINT3D_INIT (31.3f, -4.7f, 0));
+  graphene_matrix_init_scale (&transforms[5], -1.0f, 1.0f, 1.0f);
+  graphene_matrix_translate (&transforms[5],
+                             &GRAPHENE_POINT3D_INIT (1920, 0, 0));
+  graphene_matrix_init_rotate (&transforms[6], 90.0f, graphene_vec3_z_axis ());
+  graphene_matrix_init_rotate (&transforms[7], 30.0f, graphene_vec3_z_axis ());
+  graphene_matrix_translate (&transforms[7],
+                             &GRAPHENE_POINT3D_INIT (100, 100, 0));
+
+  for (i = 0; i < 50; i++)
+    {
+      cairo_region_t *region;
+
+      region = create_random_region (g_test_rand_int_range (1, 40));
+
+      for (j = 0; j < G_N_ELEMENTS (transforms); j++)
+        {
+          cairo_region_t *expected;
+          cairo_region_t *result;
+
+          expected = transform_expand_reference (region, &transforms[j]);
+          result = meta_region_apply_matrix_transform_expand (region,
+                                                              &transforms[j]);
+
+          g_assert_true (cairo_region_equal (expected, result));
+
+          cairo_region_destroy (expected);
+          cairo_region_destroy (result);
+        }
+
+      cairo_region_destroy (region);
+    }
+}
+
+static void
+meta_test_region_integer_translation (void)
+{
+  graphene_matrix_t matrix;
+  int x, y;
+
+  graphene_matrix_init_translate (&matrix, &GRAPHENE_POINT3D_INIT (10, -20, 0));
+  g_assert_true (meta_matrix_is_integer_translation (&matrix, &x, &y));
+  g_assert_cmpint (x, ==, 10);
+  g_assert_cmpint (y, ==, -20);
+
+  graphene_matrix_init_translate (&matrix, &GRAPHENE_POINT3D_INIT (10.5f, 0, 0));
+  g_assert_false (meta_matrix_is_integer_translation (&matrix, &x, &y));
+
+  graphene_matrix_init_scale (&matrix, 2.0f, 2.0f, 1.0f);
+  g_assert_false (meta_matrix_is_integer_translation (&matrix, &x, &y));
+
+  graphene_matrix_init_perspective (&matrix, 60.0f, 1.0f, 0.1f, 100.0f);
+  g_assert_false (meta_matrix_is_integer_translation (&matrix, &x, &y));
+}
+
+typedef struct
+{
+  graphene_matrix_t transform;
+  cairo_region_t *opaque_region;
+} TestWindow;
+
+static void
+init_windows (TestWindow *windows)
+{
+  int i;
+
+  for (i = 0; i < N_WINDOWS; i++)
+    {
+      TestWindow *window = &windows[i];
+      int width = g_test_rand_int_range (300, 1600);
+      int height = g_test_rand_int_range (200, 1000);
+      int radius = 12;
+      int shadow = 24;
+      int r;
+
+      graphene_matrix_init_translate (
+        &window->transform,
+        &GRAPHENE_POINT3D_INIT (g_test_rand_int_range (0, STAGE_WIDTH - width),
+                                g_test_rand_int_range (0, STAGE_HEIGHT - height),
+                                0));
+
+      /* A client side decorated window: opaque apart from the shadow
+       * around it and the rounded top corners */
+      window->opaque_region = cairo_region_create ();
+      for (r = 0; r < radius; r++)
+        {
+          int inset = radius - (int) sqrt (radius * radius - (radius - r) *
+                                                             (radius - r));
+          cairo_rectangle_int_t row = {
+            shadow + inset, shadow + r, width - 2 * inset, 1,
+          };
+
+          cairo_region_union_rectangle (window->opaque_region, &row);
+        }
+
+      cairo_region_union_rectangle (window->opaque_region,
+                                    &(cairo_rectangle_int_t) {
+                                      shadow, shadow + radius,
+                                      width, height - radius,
+                                    });
+    }
+}
+
+static void
+cull_windows (TestWindow     *windows,
+              cairo_region_t *unobscured_region,
+              gboolean        translate_in_place)
+{
+  int i;
+
+  for (i = N_WINDOWS - 1; i >= 0; i--)
+    {
+      TestWindow *window = &windows[i];
+      graphene_matrix_t inverted;
+      cairo_region_t *actor_region;
+      cairo_region_t *reduced_region;
+      int x, y;
+
+      if (translate_in_place &&
+          meta_matrix_is_integer_translation (&window->transform, &x, &y))
+        {
+          cairo_region_translate (unobscured_region, -x, -y);
+          cairo_region_subtract (unobscured_region, window->opaque_region);
+          cairo_region_translate (unobscured_region, x, y);
+          continue;
+        }
+
+      graphene_matrix_inverse (&window->transform, &inverted);
+      actor_region =
+        meta_region_apply_matrix_transform_expand (unobscured_region,
+                                                   &inverted);
+      cairo_region_subtract (actor_region, window->opaque_region);
+      reduced_region =
+        meta_region_apply_matrix_transform_expand (actor_region,
+                                                   &window->transform);
+      cairo_region_intersect (unobscured_region, reduced_region);
+
+      cairo_region_destroy (actor_region);
+      cairo_region_destroy (reduced_region);
+    }
+}
+
+static double
+run_cull_benchmark (TestWindow      *windows,
+                    gboolean         translate_in_place,
+                    cairo_region_t **out_region)
+{
+  const cairo_rectangle_int_t stage_rect = {
+    0, 0, STAGE_WIDTH, STAGE_HEIGHT,
+  };
+  int frame;
+
+  g_test_timer_start ();
+
+  for (frame = 0; frame < N_FRAMES; frame++)
+    {
+      cairo_region_t *unobscured_region;
+
+      unobscured_region = cairo_region_create_rectangle (&stage_rect);
+      cull_windows (windows, unobscured_region, translate_in_place);
+
+      if (frame == N_FRAMES - 1)
+        *out_region = unobscured_region;
+      else
+        cairo_region_destroy (unobscured_region);
+    }
+
+  return g_test_timer_elapsed ();
+}
+
+static void
+meta_test_region_cull_benchmark (void)
+{
+  TestWindow windows[N_WINDOWS];
+  cairo_region_t *transformed_region;
+  cairo_region_t *translated_region;
+  double transformed_time;
+  double translated_time;
+  int i;
+
+  init_windows (windows);
+
+  transformed_time = run_cull_benchmark (windows, FALSE, &transformed_region);
+  translated_time = run_cull_benchmark (windows, TRUE, &translated_region);
+
+  /* Both ways of culling must end up with the same region */
+  g_assert_true (cairo_region_equal (transformed_region, translated_region));
+
+  g_test_message ("Culling %d windows, %d frames: "
+                  "%.2f ms transforming regions, %.2f ms translating in place",
+                  N_WINDOWS, N_FRAMES,
+                  transformed_time * 1000.0, translated_time * 1000.0);
+  g_test_minimized_result (translated_time * 1000.0 / N_FRAMES,
+                           "%.3f ms per frame", translated_time * 1000.0 / N_FRAMES);
+
+  cairo_region_destroy (transformed_region);
+  cairo_region_destroy (translated_region);
+  for (i = 0; i < N_WINDOWS; i++)
+    cairo_region_destroy (windows[i].opaque_region);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_test_init (&argc, &argv, NULL);
+
+  g_test_add_func ("/compositor/region-utils/transform-expand",
+                   meta_test_region_transform_expand);
+  g_test_add_func ("/compositor/region-utils/integer-translation",
+                   meta_test_region_integer_translation);
+
+  if (g_test_perf ())
+    g_test_add_func ("/compositor/region-utils/cull-benchmark",
+                     meta_test_region_cull_benchmark);
+
+  return g_test_run ();
+}
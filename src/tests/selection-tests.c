@@ -0,0 +1,441 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gio/gunixinputstream.h>
+#include <gio/gunixoutputstream.h>
+#include <glib-unix.h>
+#include <glib/gstdio.h>
+#include <signal.h>
+#include <unistd.h>
+
+#include "meta-test/meta-context-test.h"
+#include "meta/display.h"
+#include "meta/meta-selection.h"
+#include "meta/meta-selection-source-memory.h"
+
+#define TEST_MIMETYPE "application/x-mutter-test"
+
+/* Larger than both the pipe buffers and the transfer chunks */
+#define TEST_DATA_SIZE (1024 * 1024 + 123)
+#define TEST_BOUNDED_SIZE 100000
+
+typedef enum _TransferTarget
+{
+  TRANSFER_TARGET_PIPE,
+  TRANSFER_TARGET_FILE,
+} TransferTarget;
+
+typedef struct _BenchmarkTransfer
+{
+  const char *name;
+  gboolean from_pipe;
+  size_t size;
+} BenchmarkTransfer;
+
+static MetaContext *test_context;
+
+/* A selection source whose data comes through a pipe, like the one of a
+ * Wayland client does */
+#define META_TYPE_TEST_PIPE_SOURCE (meta_test_pipe_source_get_type ())
+G_DECLARE_FINAL_TYPE (MetaTestPipeSource, meta_test_pipe_source,
+                      META, TEST_PIPE_SOURCE, MetaSelectionSource)
+
+struct _MetaTestPipeSource
+{
+  MetaSelectionSource parent_instance;
+  GBytes *content;
+};
+
+G_DEFINE_TYPE (MetaTestPipeSource, meta_test_pipe_source,
+               META_TYPE_SELECTION_SOURCE)
+
+typedef struct _PipeWriter
+{
+  int fd;
+  GBytes *content;
+} PipeWriter;
+
+static gpointer
+write_pipe_thread_func (gpointer user_data)
+{
+  PipeWriter *writer = user_data;
+  size_t size;
+  const uint8_t *data = g_bytes_get_data (writer->content, &size);
+  size_t offset = 0;
+
+  /* Bounded transfers close the pipe before reading all of it */
+  while (offset < size)
+    {
+      ssize_t n_written;
+
+      n_written = write (writer->fd, data + offset, size - offset);
+      if (n_written < 0 && errno == EINTR)
+        continue;
+      if (n_written < 0)
+        break;
+
+      offset += n_written;
+    }
+
+  close (writer->fd);
+  g_bytes_unref (writer->content);
+  g_free (writer);
+
+  return NULL;
+}
+
+static void
+meta_test_pipe_source_read_async (MetaSelectionSource *source,
+                                  const char          *mimetype,
+                                  GCancellable        *cancellable,
+                                  GAsyncReadyCallback  callback,
+                                  gpointer             user_data)
+{
+  MetaTestPipeSource *pipe_source = META_TEST_PIPE_SOURCE (source);
+  g_autoptr (GTask) task = NULL;
+  g_autoptr (GError) error = NULL;
+  PipeWriter *writer;
+  int fds[2];
+
+  task = g_task_new (source, cancellable, callback, user_data);
+  g_task_set_source_tag (task, meta_test_pipe_source_read_async);
+
+  if (!g_unix_open_pipe (fds, FD_CLOEXEC, &error))
+    {
+      g_task_return_error (task, g_steal_pointer (&error));
+      return;
+    }
+
+  writer = g_new0 (PipeWriter, 1);
+  writer->fd = fds[1];
+  writer->content = g_bytes_ref (pipe_source->content);
+  g_thread_unref (g_thread_new ("selection source writer",
+                                write_pipe_thread_func, writer));
+
+  g_task_return_pointer (task, g_unix_input_stream_new (fds[0], TRUE),
+                         g_object_unref);
+}
+
+static GInputStream *
+meta_test_pipe_source_read_finish (MetaSelectionSource  *source,
+                                   GAsyncResult         *result,
+                                   GError              **error)
+{
+  g_assert (g_task_get_source_tag (G_TASK (result)) ==
+            meta_test_pipe_source_read_async);
+  return g_task_propagate_pointer (G_TASK (result), error);
+}
+
+static GList *
+meta_test_pipe_source_get_mimetypes (MetaSelectionSource *source)
+{
+  return g_list_prepend (NULL, g_strdup (TEST_MIMETYPE));
+}
+
+static void
+meta_test_pipe_source_finalize (GObject *object)
+{
+  MetaTestPipeSource *pipe_source = META_TEST_PIPE_SOURCE (object);
+
+  g_clear_pointer (&pipe_source->content, g_bytes_unref);
+
+  G_OBJECT_CLASS (meta_test_pipe_source_parent_class)->finalize (object);
+}
+
+static void
+meta_test_pipe_source_class_init (MetaTestPipeSourceClass *klass)
+{
+  MetaSelectionSourceClass *source_class = META_SELECTION_SOURCE_CLASS (klass);
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_test_pipe_source_finalize;
+
+  source_class->read_async = meta_test_pipe_source_read_async;
+  source_class->read_finish = meta_test_pipe_source_read_finish;
+  source_class->get_mimetypes = meta_test_pipe_source_get_mimetypes;
+}
+
+static void
+meta_test_pipe_source_init (MetaTestPipeSource *pipe_source)
+{
+}
+
+static MetaSelectionSource *
+meta_test_pipe_source_new (GBytes *content)
+{
+  MetaTestPipeSource *pipe_source;
+
+  pipe_source = g_object_new (META_TYPE_TEST_PIPE_SOURCE, NULL);
+  pipe_source->content = g_bytes_ref (content);
+
+  return META_SELECTION_SOURCE (pipe_source);
+}
+
+static GBytes *
+create_test_data (size_t size)
+{
+  uint8_t *data;
+  size_t i;
+
+  data = g_malloc (size);
+  for (i = 0; i < size; i++)
+    data[i] = (i * 7 + i / 4096) & 0xff;
+
+  return g_bytes_new_take (data, size);
+}
+
+static gpointer
+read_pipe_thread_func (gpointer user_data)
+{
+  int fd = GPOINTER_TO_INT (user_data);
+  GByteArray *array;
+  uint8_t buffer[16 * 1024];
+
+  array = g_byte_array_new ();
+
+  while (TRUE)
+    {
+      ssize_t n_read;
+
+      n_read = read (fd, buffer, sizeof (buffer));
+      if (n_read < 0 && errno == EINTR)
+        continue;
+      g_assert_cmpint (n_read, >=, 0);
+      if (n_read == 0)
+        break;
+
+      g_byte_array_append (array, buffer, n_read);
+    }
+
+  close (fd);
+
+  return g_byte_array_free_to_bytes (array);
+}
+
+static void
+on_transfer_done (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
+{
+  gboolean *done = user_data;
+  g_autoptr (GError) error = NULL;
+
+  g_assert_true (meta_selection_transfer_finish (META_SELECTION (source_object),
+                                                 result, &error));
+  g_assert_no_error (error);
+
+  *done = TRUE;
+}
+
+static GBytes *
+transfer_selection (MetaSelectionSource *source,
+                    TransferTarget       target,
+                    gssize               size)
+{
+  MetaDisplay *display = meta_context_get_display (test_context);
+  MetaSelection *selection = meta_display_get_selection (display);
+  g_autoptr (GOutputStream) output = NULL;
+  g_autoptr (GError) error = NULL;
+  g_autofree char *path = NULL;
+  GThread *reader = NULL;
+  GBytes *content;
+  gboolean done = FALSE;
+
+  switch (target)
+    {
+    case TRANSFER_TARGET_PIPE:
+      {
+        int fds[2];
+
+        g_assert_true (g_unix_open_pipe (fds, FD_CLOEXEC, &error));
+        g_assert_no_error (error);
+
+        reader = g_thread_new ("selection target reader",
+                               read_pipe_thread_func,
+                               GINT_TO_POINTER (fds[0]));
+        output = g_unix_output_stream_new (fds[1], TRUE);
+        break;
+      }
+    case TRANSFER_TARGET_FILE:
+      {
+        int fd;
+
+        fd = g_file_open_tmp ("mutter-selection-test-XXXXXX", &path, &error);
+        g_assert_no_error (error);
+
+        output = g_unix_output_stream_new (fd, TRUE);
+        break;
+      }
+    }
+
+  meta_selection_set_owner (selection, META_SELECTION_CLIPBOARD, source);
+  meta_selection_transfer_async (selection, META_SELECTION_CLIPBOARD,
+                                 TEST_MIMETYPE, size, output,
+                                 NULL, on_transfer_done, &done);
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+  meta_selection_unset_owner (selection, META_SELECTION_CLIPBOARD, source);
+
+  /* Only unbounded transfers close the output themselves */
+  g_output_stream_close (output, NULL, &error);
+  g_assert_no_error (error);
+
+  switch (target)
+    {
+    case TRANSFER_TARGET_PIPE:
+      content = g_thread_join (reader);
+      break;
+    case TRANSFER_TARGET_FILE:
+      {
+        char *data;
+        size_t length;
+
+        g_file_get_contents (path, &data, &length, &error);
+        g_assert_no_error (error);
+        g_unlink (path);
+
+        content = g_bytes_new_take (data, length);
+        break;
+      }
+    }
+
+  return content;
+}
+
+static void
+assert_transferred (MetaSelectionSource *source,
+                    GBytes              *expected_content,
+                    TransferTarget       target)
+{
+  g_autoptr (GBytes) expected_prefix = NULL;
+  g_autoptr (GBytes) content = NULL;
+  g_autoptr (GBytes) prefix = NULL;
+
+  content = transfer_selection (source, target, -1);
+  g_assert_true (g_bytes_equal (content, expected_content));
+
+  expected_prefix = g_bytes_new_from_bytes (expected_content, 0,
+                                            TEST_BOUNDED_SIZE);
+  prefix = transfer_selection (source, target, TEST_BOUNDED_SIZE);
+  g_assert_true (g_bytes_equal (prefix, expected_prefix));
+}
+
+static void
+meta_test_selection_transfer_splice (void)
+{
+  g_autoptr (GBytes) content = NULL;
+  g_autoptr (MetaSelectionSource) source = NULL;
+
+  content = create_test_data (TEST_DATA_SIZE);
+  source = meta_test_pipe_source_new (content);
+
+  /* Pipes on both ends are spliced in the kernel */
+  assert_transferred (source, content, TRANSFER_TARGET_PIPE);
+}
+
+static void
+meta_test_selection_transfer_stream (void)
+{
+  g_autoptr (GBytes) content = NULL;
+  g_autoptr (MetaSelectionSource) pipe_source = NULL;
+  g_autoptr (MetaSelectionSource) memory_source = NULL;
+
+  content = create_test_data (TEST_DATA_SIZE);
+  pipe_source = meta_test_pipe_source_new (content);
+  memory_source = meta_selection_source_memory_new (TEST_MIMETYPE, content);
+
+  /* Anything else than a pipe on either end falls back to streams */
+  assert_transferred (pipe_source, content, TRANSFER_TARGET_FILE);
+  assert_transferred (memory_source, content, TRANSFER_TARGET_PIPE);
+}
+
+static void
+meta_test_selection_transfer_benchmark (gconstpointer data)
+{
+  const BenchmarkTransfer *transfer = data;
+  g_autoptr (GBytes) content = NULL;
+  g_autoptr (GBytes) transferred = NULL;
+  g_autoptr (MetaSelectionSource) source = NULL;
+  int64_t start_us, elapsed_us;
+  double elapsed_ms;
+
+  content = create_test_data (transfer->size);
+  if (transfer->from_pipe)
+    source = meta_test_pipe_source_new (content);
+  else
+    source = meta_selection_source_memory_new (TEST_MIMETYPE, content);
+
+  start_us = g_get_monotonic_time ();
+  transferred = transfer_selection (source, TRANSFER_TARGET_PIPE, -1);
+  elapsed_us = g_get_monotonic_time () - start_us;
+
+  g_assert_cmpuint (g_bytes_get_size (transferred), ==, transfer->size);
+
+  elapsed_ms = elapsed_us / 1000.0;
+  g_test_message ("Transferring %zu MiB %s took %.3f ms",
+                  transfer->size / (1024 * 1024), transfer->name, elapsed_ms);
+  g_test_minimized_result (elapsed_ms, "%.3f ms", elapsed_ms);
+}
+
+static const BenchmarkTransfer benchmark_transfers[] = {
+  { "from a pipe, spliced", TRUE, 100 * 1024 * 1024 },
+  { "from memory, through streams", FALSE, 100 * 1024 * 1024 },
+};
+
+static void
+init_tests (void)
+{
+  g_test_add_func ("/core/selection/transfer/splice",
+                   meta_test_selection_transfer_splice);
+  g_test_add_func ("/core/selection/transfer/stream",
+                   meta_test_selection_transfer_stream);
+
+  if (g_test_perf ())
+    {
+      g_test_add_data_func ("/core/selection/transfer/benchmark/splice",
+                            &benchmark_transfers[0],
+                            meta_test_selection_transfer_benchmark);
+      g_test_add_data_func ("/core/selection/transfer/benchmark/stream",
+                            &benchmark_transfers[1],
+                            meta_test_selection_transfer_benchmark);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  /* Bounded transfers close the source pipe while it is still written to */
+  signal (SIGPIPE, SIG_IGN);
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NONE);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  test_context = context;
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
@@ -0,0 +1,684 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <math.h>
+#include <string.h>
+
+#include "compositor/meta-shadow-factory-private.h"
+#include "compositor/region-utils.h"
+#include "meta-test/meta-context-test.h"
+
+#define N_ITERATIONS 20
+
+typedef struct _ShadowShape
+{
+  const char *name;
+  int width;
+  int height;
+  /* -1 for an ellipse */
+  int corner_radius;
+} ShadowShape;
+
+static const ShadowShape shadow_shapes[] = {
+  /* A decorated window */
+  { "rounded", 800, 600, 12 },
+  /* A menu */
+  { "rectangle", 300, 400, 0 },
+  /* A shaped window, which can't be 9-sliced */
+  { "ellipse", 400, 300, -1 },
+};
+
+/* The radii of popup menus, unfocused and focused windows, and a large
+ * one as a theme could set it */
+static const int shadow_radii[] = { 1, 8, 10, 30 };
+
+static int
+get_row_inset (const ShadowShape *shape,
+               int                y)
+{
+  double dy;
+
+  if (shape->corner_radius < 0)
+    {
+      double a = shape->width / 2.0;
+      double b = shape->height / 2.0;
+
+      dy = (y + 0.5 - b) / b;
+
+      return (int) round (a - a * sqrt (1.0 - dy * dy));
+    }
+  else
+    {
+      int r = shape->corner_radius;
+
+      if (y >= r && y < shape->height - r)
+        return 0;
+
+      if (y >= r)
+        y = shape->height - 1 - y;
+
+      dy = r - y - 0.5;
+
+      return (int) round (r - sqrt (r * r - dy * dy));
+    }
+}
+
+static MetaWindowShape *
+create_window_shape (const ShadowShape *shape)
+{
+  cairo_region_t *region;
+  MetaWindowShape *window_shape;
+  int y;
+
+  region = cairo_region_create ();
+  for (y = 0; y < shape->height; y++)
+    {
+      int inset = get_row_inset (shape, y);
+      cairo_rectangle_int_t rect = {
+        .x = inset,
+        .y = y,
+        .width = shape->width - 2 * inset,
+        .height = 1,
+      };
+
+      cairo_region_union_rectangle (region, &rect);
+    }
+
+  window_shape = meta_window_shape_new (region);
+  cairo_region_destroy (region);
+
+  return window_shape;
+}
+
+static MetaShadowFactory *
+create_shadow_factory (int radius)
+{
+  MetaShadowFactory *factory;
+  MetaShadowParams params = {
+    .radius = radius,
+    .top_fade = -1,
+    .x_offset = 0,
+    .y_offset = 0,
+    .opacity = 255,
+  };
+
+  factory = meta_shadow_factory_new ();
+  meta_shadow_factory_set_params (factory, "normal", TRUE, &params);
+
+  return factory;
+}
+
+static uint8_t *
+get_shadow_data (MetaShadow *shadow,
+                 int        *width,
+                 int        *height)
+{
+  CoglTexture *texture = meta_shadow_get_texture (shadow);
+  uint8_t *data;
+
+  g_assert_nonnull (texture);
+
+  *width = cogl_texture_get_width (texture);
+  *height = cogl_texture_get_height (texture);
+
+  data = g_malloc (*width * *height);
+  cogl_texture_get_data (texture, COGL_PIXEL_FORMAT_A_8, *width, data);
+
+  return data;
+}
+
+static void
+on_shadow_ready (GObject      *source_object,
+                 GAsyncResult *result,
+                 gpointer      user_data)
+{
+  MetaShadow **shadow = user_data;
+  g_autoptr (GError) error = NULL;
+
+  *shadow = meta_shadow_factory_get_shadow_finish (META_SHADOW_FACTORY (source_object),
+                                                   result, &error);
+  g_assert_no_error (error);
+  g_assert_nonnull (*shadow);
+}
+
+static void
+on_shadow_cancelled (GObject      *source_object,
+                     GAsyncResult *result,
+                     gpointer      user_data)
+{
+  gboolean *done = user_data;
+  g_autoptr (GError) error = NULL;
+  MetaShadow *shadow;
+
+  shadow = meta_shadow_factory_get_shadow_finish (META_SHADOW_FACTORY (source_object),
+                                                  result, &error);
+  g_assert_error (error, G_IO_ERROR, G_IO_ERROR_CANCELLED);
+  g_assert_null (shadow);
+
+  *done = TRUE;
+}
+
+/* The blur as it was done before blurring columns in blocks and dividing
+ * through reciprocals, kept as the reference the current one has to match
+ * bit for bit.
+ */
+static int
+get_reference_box_filter_size (int radius)
+{
+  return (int) (0.5 + radius * (0.75 * sqrt (2 * M_PI)));
+}
+
+static int
+get_reference_shadow_spread (int radius)
+{
+  int d;
+
+  if (radius == 0)
+    return 0;
+
+  d = get_reference_box_filter_size (radius);
+
+  if (d % 2 == 1)
+    return 3 * (d / 2);
+  else
+    return 3 * (d / 2) - 1;
+}
+
+static void
+reference_blur_xspan (uint8_t *row,
+                      uint8_t *tmp_buffer,
+                      int      row_width,
+                      int      x0,
+                      int      x1,
+                      int      d,
+                      int      shift)
+{
+  int offset;
+  int sum = 0;
+  int i;
+
+  if (d % 2 == 1)
+    offset = d / 2;
+  else
+    offset = (d - shift) / 2;
+
+  for (i = x0 - d + offset; i < x1 + offset; i++)
+    {
+      if (i >= 0 && i < row_width)
+        sum += row[i];
+
+      if (i >= x0 + offset)
+        {
+          if (i >= d)
+            sum -= row[i - d];
+
+          tmp_buffer[i - offset] = (sum + d / 2) / d;
+        }
+    }
+
+  memcpy (row + x0, tmp_buffer + x0, x1 - x0);
+}
+
+static void
+reference_blur_rows (cairo_region_t *convolve_region,
+                     int             x_offset,
+                     int             y_offset,
+                     uint8_t        *buffer,
+                     int             buffer_width,
+                     int             buffer_height,
+                     int             d)
+{
+  g_autofree uint8_t *tmp_buffer = NULL;
+  int i, j;
+
+  tmp_buffer = g_malloc (buffer_width);
+
+  for (i = 0; i < cairo_region_num_rectangles (convolve_region); i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (convolve_region, i, &rect);
+
+      for (j = y_offset + rect.y; j < y_offset + rect.y + rect.height; j++)
+        {
+          uint8_t *row = buffer + j * buffer_width;
+          int x0 = x_offset + rect.x;
+          int x1 = x0 + rect.width;
+
+          if (d % 2 == 1)
+            {
+              reference_blur_xspan (row, tmp_buffer, buffer_width, x0, x1, d, 0);
+              reference_blur_xspan (row, tmp_buffer, buffer_width, x0, x1, d, 0);
+              reference_blur_xspan (row, tmp_buffer, buffer_width, x0, x1, d, 0);
+            }
+          else
+            {
+              reference_blur_xspan (row, tmp_buffer, buffer_width, x0, x1, d, 1);
+              reference_blur_xspan (row, tmp_buffer, buffer_width, x0, x1, d, -1);
+              reference_blur_xspan (row, tmp_buffer, buffer_width, x0, x1, d + 1, 0);
+            }
+        }
+    }
+}
+
+static uint8_t *
+reference_flip_buffer (uint8_t *buffer,
+                       int      width,
+                       int      height)
+{
+  uint8_t *new_buffer;
+  int i, j;
+
+  new_buffer = g_malloc (width * height);
+  for (j = 0; j < height; j++)
+    for (i = 0; i < width; i++)
+      new_buffer[i * height + j] = buffer[j * width + i];
+
+  g_free (buffer);
+
+  return new_buffer;
+}
+
+/* Returns the blurred region with a border of the spread around it, which
+ * is what the shadow texture holds when the top isn't faded. */
+static uint8_t *
+reference_blur_region (cairo_region_t *region,
+                       int             radius,
+                       int            *width,
+                       int            *height)
+{
+  int d = get_reference_box_filter_size (radius);
+  int spread = get_reference_shadow_spread (radius);
+  cairo_rectangle_int_t extents;
+  cairo_region_t *row_convolve_region;
+  cairo_region_t *column_convolve_region;
+  uint8_t *buffer;
+  int buffer_width;
+  int buffer_height;
+  int i, j;
+
+  cairo_region_get_extents (region, &extents);
+
+  buffer_width = extents.width + 2 * spread;
+  buffer_height = extents.height + 2 * spread;
+  buffer = g_malloc0 (buffer_width * buffer_height);
+
+  row_convolve_region = meta_make_border_region (region, spread, spread, FALSE);
+  column_convolve_region = meta_make_border_region (region, 0, spread, TRUE);
+
+  for (i = 0; i < cairo_region_num_rectangles (region); i++)
+    {
+      cairo_rectangle_int_t rect;
+
+      cairo_region_get_rectangle (region, i, &rect);
+      for (j = spread + rect.y; j < spread + rect.y + rect.height; j++)
+        memset (buffer + buffer_width * j + spread + rect.x, 255, rect.width);
+    }
+
+  buffer = reference_flip_buffer (buffer, buffer_width, buffer_height);
+  reference_blur_rows (column_convolve_region, spread, spread,
+                       buffer, buffer_height, buffer_width,
+                       d);
+  buffer = reference_flip_buffer (buffer, buffer_height, buffer_width);
+  reference_blur_rows (row_convolve_region, spread, spread,
+                       buffer, buffer_width, buffer_height,
+                       d);
+
+  cairo_region_destroy (row_convolve_region);
+  cairo_region_destroy (column_convolve_region);
+
+  *width = buffer_width;
+  *height = buffer_height;
+
+  return buffer;
+}
+
+/* The region the factory blurs for a shape: the shape itself if it can't
+ * be 9-sliced, otherwise one with a center just big enough for the blur */
+static cairo_region_t *
+get_blurred_region (MetaWindowShape   *window_shape,
+                    const ShadowShape *shape,
+                    int                radius)
+{
+  int spread = get_reference_shadow_spread (radius);
+  int top, right, bottom, left;
+  int center_width, center_height;
+
+  meta_window_shape_get_borders (window_shape, &top, &right, &bottom, &left);
+
+  if (left + right + 2 * spread <= shape->width)
+    center_width = 2 * spread;
+  else
+    center_width = shape->width - (left + right);
+
+  if (top + bottom + 2 * spread <= shape->height)
+    center_height = 2 * spread;
+  else
+    center_height = shape->height - (top + bottom);
+
+  return meta_window_shape_to_region (window_shape, center_width, center_height);
+}
+
+static void
+meta_test_shadow_factory_reference (void)
+{
+  /* Even and odd filter sizes, and the largest filter size divided
+   * through its reciprocal next to the smallest one that isn't: radius
+   * 96 gives d = 181, radius 97 gives d = 182 */
+  const int radii[] = { 1, 2, 8, 10, 96, 97 };
+  int i, j;
+
+  for (i = 0; i < G_N_ELEMENTS (shadow_shapes); i++)
+    {
+      const ShadowShape *shape = &shadow_shapes[i];
+      MetaWindowShape *window_shape;
+
+      window_shape = create_window_shape (shape);
+
+      for (j = 0; j < G_N_ELEMENTS (radii); j++)
+        {
+          g_autoptr (MetaShadowFactory) factory = NULL;
+          cairo_region_t *region;
+          MetaShadow *shadow;
+          g_autofree uint8_t *data = NULL;
+          g_autofree uint8_t *expected_data = NULL;
+          int width, height;
+          int expected_width, expected_height;
+
+          factory = create_shadow_factory (radii[j]);
+          shadow = meta_shadow_factory_get_shadow (factory, window_shape,
+                                                   shape->width, shape->height,
+                                                   "normal", TRUE);
+          data = get_shadow_data (shadow, &width, &height);
+
+          region = get_blurred_region (window_shape, shape, radii[j]);
+          expected_data = reference_blur_region (region, radii[j],
+                                                 &expected_width,
+                                                 &expected_height);
+          cairo_region_destroy (region);
+
+          g_assert_cmpint (width, ==, expected_width);
+          g_assert_cmpint (height, ==, expected_height);
+          g_assert_cmpmem (data, width * height,
+                           expected_data, width * height);
+
+          meta_shadow_unref (shadow);
+        }
+
+      meta_window_shape_unref (window_shape);
+    }
+}
+
+static void
+meta_test_shadow_factory_symmetric (void)
+{
+  /* These radii make odd box filters, which blur symmetrically */
+  const int radii[] = { 8, 10, 12 };
+  const ShadowShape shape = { "rounded", 200, 200, 16 };
+  MetaWindowShape *window_shape;
+  int i;
+
+  window_shape = create_window_shape (&shape);
+
+  for (i = 0; i < G_N_ELEMENTS (radii); i++)
+    {
+      g_autoptr (MetaShadowFactory) factory = NULL;
+      MetaShadow *shadow;
+      g_autofree uint8_t *data = NULL;
+      int width, height;
+      int x, y;
+
+      factory = create_shadow_factory (radii[i]);
+      shadow = meta_shadow_factory_get_shadow (factory, window_shape,
+                                               shape.width, shape.height,
+                                               "normal", TRUE);
+      data = get_shadow_data (shadow, &width, &height);
+
+      g_assert_cmpint (width, ==, height);
+      g_assert_cmpint (data[(height / 2) * width + width / 2], ==, 255);
+
+      for (y = 0; y < height; y++)
+        {
+          for (x = 0; x < width; x++)
+            {
+              uint8_t value = data[y * width + x];
+
+              g_assert_cmpint (value, ==, data[y * width + width - 1 - x]);
+              g_assert_cmpint (value, ==, data[(height - 1 - y) * width + x]);
+            }
+        }
+
+      meta_shadow_unref (shadow);
+    }
+
+  meta_window_shape_unref (window_shape);
+}
+
+static void
+meta_test_shadow_factory_async (void)
+{
+  int i;
+
+  for (i = 0; i < G_N_ELEMENTS (shadow_shapes); i++)
+    {
+      const ShadowShape *shape = &shadow_shapes[i];
+      g_autoptr (MetaShadowFactory) factory = NULL;
+      g_autoptr (MetaShadowFactory) sync_factory = NULL;
+      MetaWindowShape *window_shape;
+      MetaShadow *shadow = NULL;
+      MetaShadow *other_shadow = NULL;
+      MetaShadow *sync_shadow;
+      g_autofree uint8_t *data = NULL;
+      g_autofree uint8_t *sync_data = NULL;
+      int width, height;
+      int sync_width, sync_height;
+
+      window_shape = create_window_shape (shape);
+      factory = create_shadow_factory (10);
+      sync_factory = create_shadow_factory (10);
+
+      /* Unless the shape is blurred for every size, both requests wait
+       * for the same blur */
+      meta_shadow_factory_get_shadow_async (factory, window_shape,
+                                            shape->width, shape->height,
+                                            "normal", TRUE, NULL,
+                                            on_shadow_ready, &shadow);
+      meta_shadow_factory_get_shadow_async (factory, window_shape,
+                                            shape->width, shape->height,
+                                            "normal", TRUE, NULL,
+                                            on_shadow_ready, &other_shadow);
+
+      while (!shadow || !other_shadow)
+        g_main_context_iteration (NULL, TRUE);
+
+      if (shape->corner_radius >= 0)
+        g_assert_true (shadow == other_shadow);
+
+      sync_shadow = meta_shadow_factory_get_shadow (sync_factory, window_shape,
+                                                    shape->width, shape->height,
+                                                    "normal", TRUE);
+
+      data = get_shadow_data (shadow, &width, &height);
+      sync_data = get_shadow_data (sync_shadow, &sync_width, &sync_height);
+      g_assert_cmpint (width, ==, sync_width);
+      g_assert_cmpint (height, ==, sync_height);
+      g_assert_cmpmem (data, width * height, sync_data, width * height);
+
+      meta_shadow_unref (sync_shadow);
+      meta_shadow_unref (other_shadow);
+      meta_shadow_unref (shadow);
+      meta_window_shape_unref (window_shape);
+    }
+}
+
+static void
+meta_test_shadow_factory_lookup (void)
+{
+  const ShadowShape *shape = &shadow_shapes[0];
+  g_autoptr (MetaShadowFactory) factory = NULL;
+  MetaWindowShape *window_shape;
+  MetaShadow *shadow;
+  MetaShadow *cached_shadow;
+
+  window_shape = create_window_shape (shape);
+  factory = create_shadow_factory (10);
+
+  /* Nothing is blurred by a lookup */
+  g_assert_null (meta_shadow_factory_lookup_shadow (factory, window_shape,
+                                                    shape->width,
+                                                    shape->height,
+                                                    "normal", TRUE));
+
+  shadow = meta_shadow_factory_get_shadow (factory, window_shape,
+                                           shape->width, shape->height,
+                                           "normal", TRUE);
+
+  /* Other sizes of the same shape share the shadow while it's in use */
+  cached_shadow = meta_shadow_factory_lookup_shadow (factory, window_shape,
+                                                     shape->width + 100,
+                                                     shape->height + 100,
+                                                     "normal", TRUE);
+  g_assert_true (cached_shadow == shadow);
+  g_assert_nonnull (meta_shadow_get_texture (cached_shadow));
+
+  meta_shadow_unref (cached_shadow);
+  meta_shadow_unref (shadow);
+  meta_window_shape_unref (window_shape);
+}
+
+static void
+meta_test_shadow_factory_cancel (void)
+{
+  const ShadowShape *shape = &shadow_shapes[0];
+  g_autoptr (MetaShadowFactory) factory = NULL;
+  g_autoptr (GCancellable) cancellable = NULL;
+  MetaWindowShape *window_shape;
+  MetaShadow *sync_shadow;
+  gboolean done = FALSE;
+
+  window_shape = create_window_shape (shape);
+  factory = create_shadow_factory (10);
+  cancellable = g_cancellable_new ();
+
+  meta_shadow_factory_get_shadow_async (factory, window_shape,
+                                        shape->width, shape->height,
+                                        "normal", TRUE, cancellable,
+                                        on_shadow_cancelled, &done);
+  g_cancellable_cancel (cancellable);
+
+  /* Needing the shadow right away doesn't wait for the blur */
+  sync_shadow = meta_shadow_factory_get_shadow (factory, window_shape,
+                                                shape->width, shape->height,
+                                                "normal", TRUE);
+  g_assert_nonnull (meta_shadow_get_texture (sync_shadow));
+
+  while (!done)
+    g_main_context_iteration (NULL, TRUE);
+
+  meta_shadow_unref (sync_shadow);
+  meta_window_shape_unref (window_shape);
+}
+
+static void
+meta_test_shadow_factory_blur (gconstpointer data)
+{
+  const ShadowShape *shape = data;
+  MetaWindowShape *window_shape;
+  double total_ms = 0.0;
+  int i;
+
+  window_shape = create_window_shape (shape);
+
+  for (i = 0; i < G_N_ELEMENTS (shadow_radii); i++)
+    {
+      g_autoptr (MetaShadowFactory) factory = NULL;
+      int64_t start_us, elapsed_us;
+      double ms_per_shadow;
+      int j;
+
+      factory = create_shadow_factory (shadow_radii[i]);
+
+      /* Shadows are only cached while in use, so every iteration blurs */
+      start_us = g_get_monotonic_time ();
+      for (j = 0; j < N_ITERATIONS; j++)
+        {
+          MetaShadow *shadow;
+
+          shadow = meta_shadow_factory_get_shadow (factory, window_shape,
+                                                   shape->width, shape->height,
+                                                   "normal", TRUE);
+          meta_shadow_unref (shadow);
+        }
+      elapsed_us = g_get_monotonic_time () - start_us;
+
+      ms_per_shadow = elapsed_us / 1000.0 / N_ITERATIONS;
+      g_test_message ("Creating the shadow of a %dx%d %s shape with "
+                      "radius %d took %.3f ms",
+                      shape->width, shape->height, shape->name,
+                      shadow_radii[i], ms_per_shadow);
+      total_ms += ms_per_shadow;
+    }
+
+  g_test_minimized_result (total_ms, "%.3f ms for all radii", total_ms);
+
+  meta_window_shape_unref (window_shape);
+}
+
+static void
+init_tests (void)
+{
+  int i;
+
+  g_test_add_func ("/compositor/shadow-factory/reference",
+                   meta_test_shadow_factory_reference);
+  g_test_add_func ("/compositor/shadow-factory/symmetric",
+                   meta_test_shadow_factory_symmetric);
+  g_test_add_func ("/compositor/shadow-factory/async",
+                   meta_test_shadow_factory_async);
+  g_test_add_func ("/compositor/shadow-factory/lookup",
+                   meta_test_shadow_factory_lookup);
+  g_test_add_func ("/compositor/shadow-factory/cancel",
+                   meta_test_shadow_factory_cancel);
+
+  for (i = 0; i < G_N_ELEMENTS (shadow_shapes); i++)
+    {
+      g_autofree char *path = NULL;
+
+      path = g_strdup_printf ("/compositor/shadow-factory/blur/%s",
+                              shadow_shapes[i].name);
+      g_test_add_data_func (path, &shadow_shapes[i],
+                            meta_test_shadow_factory_blur);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NONE);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
@@ -0,0 +1,368 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "compositor/meta-texture-mipmap.h"
+#include "meta-test/meta-context-test.h"
+
+#define TEST_FORMAT COGL_PIXEL_FORMAT_RGBA_8888_PRE
+
+/* Like the windows of an overview, where every window shows a video */
+#define N_WINDOWS 30
+#define N_FRAMES 60
+#define PATCH_SIZE 64
+
+typedef enum _RefreshMode
+{
+  REFRESH_MODE_FULL,
+  REFRESH_MODE_DAMAGE,
+} RefreshMode;
+
+static CoglContext *
+get_cogl_context (void)
+{
+  return clutter_backend_get_cogl_context (clutter_get_default_backend ());
+}
+
+static uint8_t *
+create_pattern (int     width,
+                int     height,
+                uint8_t seed)
+{
+  uint8_t *data;
+  int x, y;
+
+  data = g_malloc (width * height * 4);
+
+  for (y = 0; y < height; y++)
+    {
+      for (x = 0; x < width; x++)
+        {
+          uint8_t *pixel = &data[(y * width + x) * 4];
+
+          pixel[0] = x * 7 + seed;
+          pixel[1] = y * 13 + seed;
+          pixel[2] = (x ^ y) + seed;
+          pixel[3] = 255;
+        }
+    }
+
+  return data;
+}
+
+static CoglTexture *
+create_texture (int width,
+                int height)
+{
+  g_autofree uint8_t *data = NULL;
+  g_autoptr (GError) error = NULL;
+  CoglTexture2D *texture;
+
+  data = create_pattern (width, height, 0);
+  texture = cogl_texture_2d_new_from_data (get_cogl_context (),
+                                           width, height,
+                                           TEST_FORMAT,
+                                           width * 4,
+                                           data,
+                                           &error);
+  if (!texture)
+    g_error ("Failed to create texture: %s", error->message);
+
+  return COGL_TEXTURE (texture);
+}
+
+static void
+update_texture_area (CoglTexture           *texture,
+                     cairo_rectangle_int_t *area,
+                     uint8_t                seed)
+{
+  g_autofree uint8_t *data = NULL;
+
+  data = create_pattern (area->width, area->height, seed);
+  g_assert_true (cogl_texture_set_region (texture,
+                                          0, 0,
+                                          area->x, area->y,
+                                          area->width, area->height,
+                                          area->width, area->height,
+                                          TEST_FORMAT,
+                                          area->width * 4,
+                                          data));
+}
+
+static uint8_t *
+read_texture (CoglTexture *texture)
+{
+  int width = cogl_texture_get_width (texture);
+  int height = cogl_texture_get_height (texture);
+  uint8_t *data;
+
+  data = g_malloc (width * height * 4);
+  cogl_texture_get_data (texture, TEST_FORMAT, width * 4, data);
+
+  return data;
+}
+
+static void
+assert_textures_equal (CoglTexture *texture,
+                       CoglTexture *expected_texture)
+{
+  g_autofree uint8_t *data = NULL;
+  g_autofree uint8_t *expected_data = NULL;
+  int width, height, i;
+
+  width = cogl_texture_get_width (texture);
+  height = cogl_texture_get_height (texture);
+  g_assert_cmpint (width, ==, cogl_texture_get_width (expected_texture));
+  g_assert_cmpint (height, ==, cogl_texture_get_height (expected_texture));
+
+  data = read_texture (texture);
+  expected_data = read_texture (expected_texture);
+
+  /* Allow for rounding differences of the texture coordinates */
+  for (i = 0; i < width * height * 4; i++)
+    g_assert_cmpint (ABS (data[i] - expected_data[i]), <=, 1);
+}
+
+static void
+meta_test_texture_mipmap_damage (void)
+{
+  MetaTextureMipmap *mipmap;
+  MetaTextureMipmap *reference_mipmap;
+  CoglTexture *base_texture;
+  cairo_rectangle_int_t areas[] = {
+    { .x = 101, .y = 17, .width = 37, .height = 23 },
+    { .x = 0, .y = 0, .width = 1, .height = 1 },
+    { .x = 300, .y = 150, .width = 33, .height = 51 },
+  };
+  unsigned int i;
+
+  /* Odd sizes don't scale down evenly */
+  base_texture = create_texture (333, 201);
+
+  mipmap = meta_texture_mipmap_new ();
+  meta_texture_mipmap_set_base_texture (mipmap, base_texture);
+  g_assert_cmpint (cogl_texture_get_width (meta_texture_mipmap_get_paint_texture (mipmap)),
+                   ==, 166);
+
+  for (i = 0; i < G_N_ELEMENTS (areas); i++)
+    {
+      update_texture_area (base_texture, &areas[i], i + 1);
+      meta_texture_mipmap_invalidate_area (mipmap, &areas[i]);
+    }
+
+  reference_mipmap = meta_texture_mipmap_new ();
+  meta_texture_mipmap_set_base_texture (reference_mipmap, base_texture);
+
+  assert_textures_equal (meta_texture_mipmap_get_paint_texture (mipmap),
+                         meta_texture_mipmap_get_paint_texture (reference_mipmap));
+
+  meta_texture_mipmap_free (reference_mipmap);
+  meta_texture_mipmap_free (mipmap);
+  cogl_object_unref (base_texture);
+}
+
+static void
+meta_test_texture_mipmap_rate_limit (void)
+{
+  MetaTextureMipmap *mipmap;
+  CoglTexture *base_texture;
+  cairo_rectangle_int_t area = { .x = 10, .y = 10, .width = 20, .height = 20 };
+  g_autofree uint8_t *data = NULL;
+  g_autofree uint8_t *held_back_data = NULL;
+  int64_t delay_us;
+
+  base_texture = create_texture (128, 128);
+
+  mipmap = meta_texture_mipmap_new ();
+  meta_texture_mipmap_set_min_refresh_interval (mipmap, G_USEC_PER_SEC * 60);
+  meta_texture_mipmap_set_base_texture (mipmap, base_texture);
+
+  data = read_texture (meta_texture_mipmap_get_paint_texture (mipmap));
+  g_assert_false (meta_texture_mipmap_get_refresh_delay (mipmap, &delay_us));
+
+  update_texture_area (base_texture, &area, 1);
+  meta_texture_mipmap_invalidate_area (mipmap, &area);
+
+  held_back_data =
+    read_texture (meta_texture_mipmap_get_paint_texture (mipmap));
+  g_assert_cmpmem (held_back_data, 64 * 64 * 4, data, 64 * 64 * 4);
+  g_assert_true (meta_texture_mipmap_get_refresh_delay (mipmap, &delay_us));
+  g_assert_cmpint (delay_us, >, 0);
+
+  meta_texture_mipmap_set_min_refresh_interval (mipmap, 0);
+  meta_texture_mipmap_get_paint_texture (mipmap);
+  g_assert_false (meta_texture_mipmap_get_refresh_delay (mipmap, &delay_us));
+
+  meta_texture_mipmap_free (mipmap);
+  cogl_object_unref (base_texture);
+}
+
+static double
+paint_overview (CoglFramebuffer    *framebuffer,
+                CoglPipeline       *pipeline,
+                CoglTexture       **base_textures,
+                MetaTextureMipmap **mipmaps,
+                RefreshMode         mode)
+{
+  int base_width = cogl_texture_get_width (base_textures[0]);
+  int base_height = cogl_texture_get_height (base_textures[0]);
+  int64_t start_us;
+  int frame, i;
+
+  start_us = g_get_monotonic_time ();
+
+  for (frame = 0; frame < N_FRAMES; frame++)
+    {
+      cogl_framebuffer_clear4f (framebuffer, COGL_BUFFER_BIT_COLOR,
+                                0.0, 0.0, 0.0, 1.0);
+
+      for (i = 0; i < N_WINDOWS; i++)
+        {
+          cairo_rectangle_int_t area;
+          CoglTexture *paint_texture;
+          float x, y;
+
+          area = (cairo_rectangle_int_t) {
+            .x = (frame * PATCH_SIZE) % (base_width - PATCH_SIZE),
+            .y = (i * PATCH_SIZE) % (base_height - PATCH_SIZE),
+            .width = PATCH_SIZE,
+            .height = PATCH_SIZE,
+          };
+          update_texture_area (base_textures[i], &area, frame);
+
+          if (mode == REFRESH_MODE_FULL)
+            meta_texture_mipmap_invalidate (mipmaps[i]);
+          else
+            meta_texture_mipmap_invalidate_area (mipmaps[i], &area);
+
+          paint_texture = meta_texture_mipmap_get_paint_texture (mipmaps[i]);
+          cogl_pipeline_set_layer_texture (pipeline, 0, paint_texture);
+
+          /* Five rows of six windows, at a sixth of their size */
+          x = (i % 6) * base_width / 6.0f;
+          y = (i / 6) * base_height / 6.0f;
+          cogl_framebuffer_draw_rectangle (framebuffer, pipeline,
+                                           x, y,
+                                           x + base_width / 6.0f,
+                                           y + base_height / 6.0f);
+        }
+
+      cogl_framebuffer_finish (framebuffer);
+    }
+
+  return (g_get_monotonic_time () - start_us) / 1000.0 / N_FRAMES;
+}
+
+static void
+meta_test_texture_mipmap_overview (gconstpointer data)
+{
+  const int *size = data;
+  CoglContext *ctx = get_cogl_context ();
+  CoglTexture *base_textures[N_WINDOWS];
+  MetaTextureMipmap *mipmaps[N_WINDOWS];
+  CoglTexture *stage_texture;
+  CoglOffscreen *offscreen;
+  CoglFramebuffer *framebuffer;
+  CoglPipeline *pipeline;
+  g_autoptr (GError) error = NULL;
+  double full_ms, damage_ms;
+  int i;
+
+  stage_texture = COGL_TEXTURE (cogl_texture_2d_new_with_size (ctx,
+                                                               size[0],
+                                                               size[1]));
+  offscreen = cogl_offscreen_new_with_texture (stage_texture);
+  framebuffer = COGL_FRAMEBUFFER (offscreen);
+  if (!cogl_framebuffer_allocate (framebuffer, &error))
+    g_error ("Failed to allocate framebuffer: %s", error->message);
+  cogl_framebuffer_orthographic (framebuffer, 0, 0, size[0], size[1],
+                                 -1.0, 1.0);
+
+  pipeline = cogl_pipeline_new (ctx);
+  cogl_pipeline_set_layer_filters (pipeline, 0,
+                                   COGL_PIPELINE_FILTER_LINEAR_MIPMAP_NEAREST,
+                                   COGL_PIPELINE_FILTER_LINEAR);
+
+  for (i = 0; i < N_WINDOWS; i++)
+    {
+      base_textures[i] = create_texture (size[0], size[1]);
+      mipmaps[i] = meta_texture_mipmap_new ();
+      meta_texture_mipmap_set_base_texture (mipmaps[i], base_textures[i]);
+    }
+
+  full_ms = paint_overview (framebuffer, pipeline,
+                            base_textures, mipmaps,
+                            REFRESH_MODE_FULL);
+  damage_ms = paint_overview (framebuffer, pipeline,
+                              base_textures, mipmaps,
+                              REFRESH_MODE_DAMAGE);
+
+  g_test_message ("Painting %d animating %dx%d windows scaled down took "
+                  "%.3f ms per frame refreshing whole mipmaps, "
+                  "%.3f ms refreshing damage only",
+                  N_WINDOWS, size[0], size[1], full_ms, damage_ms);
+  g_test_minimized_result (damage_ms, "%.3f ms per frame", damage_ms);
+
+  for (i = 0; i < N_WINDOWS; i++)
+    {
+      meta_texture_mipmap_free (mipmaps[i]);
+      cogl_object_unref (base_textures[i]);
+    }
+
+  cogl_object_unref (pipeline);
+  g_object_unref (framebuffer);
+  cogl_object_unref (stage_texture);
+}
+
+static void
+init_tests (void)
+{
+  static const int small_size[] = { 640, 360 };
+  static const int large_size[] = { 1920, 1080 };
+
+  g_test_add_func ("/compositor/texture-mipmap/damage",
+                   meta_test_texture_mipmap_damage);
+  g_test_add_func ("/compositor/texture-mipmap/rate-limit",
+                   meta_test_texture_mipmap_rate_limit);
+  g_test_add_data_func ("/compositor/texture-mipmap/overview/640x360",
+                        small_size,
+                        meta_test_texture_mipmap_overview);
+
+  if (g_test_perf ())
+    {
+      g_test_add_data_func ("/compositor/texture-mipmap/overview/1920x1080",
+                            large_size,
+                            meta_test_texture_mipmap_overview);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_NONE);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
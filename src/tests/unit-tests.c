@@ -31,6 +31,7 @@
 #include "core/display-private.h"
 #include "meta-test/meta-context-test.h"
 #include "meta/compositor.h"
+#include "meta/meta-backend.h"
 #include "meta/meta-context.h"
 #include "tests/boxes-tests.h"
 #include "tests/monitor-config-migration-unit-tests.h"
@@ -199,6 +200,119 @@ meta_test_util_later_schedule_from_later (void)
   g_assert_cmpint (data.state, ==, META_TEST_LATER_FINISHED);
 }
 
+typedef struct _MetaTestLaterDeferrableData
+{
+  GMainLoop *loop;
+  int n_frames;
+  int last_run_frame;
+  int n_runs;
+  int n_deferred;
+  gboolean has_deadline;
+} MetaTestLaterDeferrableData;
+
+static void
+on_later_deferrable_before_update (ClutterStage                *stage,
+                                   ClutterStageView            *stage_view,
+                                   ClutterFrame                *frame,
+                                   MetaTestLaterDeferrableData *data)
+{
+  int64_t target_presentation_time_us;
+  int64_t min_render_time_allowed_us;
+
+  if (clutter_frame_get_target_presentation_time (frame,
+                                                  &target_presentation_time_us) &&
+      clutter_frame_get_min_render_time_allowed (frame,
+                                                 &min_render_time_allowed_us))
+    data->has_deadline = TRUE;
+}
+
+static gboolean
+test_later_deferrable_count_frames_callback (gpointer user_data)
+{
+  MetaTestLaterDeferrableData *data = user_data;
+
+  data->n_frames++;
+
+  return TRUE;
+}
+
+static gboolean
+test_later_deferrable_expensive_callback (gpointer user_data)
+{
+  MetaTestLaterDeferrableData *data = user_data;
+
+  /* Deferred at most once in a row */
+  if (data->n_runs > 0)
+    {
+      g_assert_cmpint (data->n_frames - data->last_run_frame, <=, 2);
+      if (data->n_frames - data->last_run_frame == 2)
+        data->n_deferred++;
+    }
+
+  data->last_run_frame = data->n_frames;
+  data->n_runs++;
+
+  /* Longer than a whole frame, so it never fits before the deadline */
+  g_usleep (G_USEC_PER_SEC / 20);
+
+  if (data->n_runs < 3)
+    return TRUE;
+
+  g_main_loop_quit (data->loop);
+  return FALSE;
+}
+
+static void
+meta_test_util_later_deferrable (void)
+{
+  MetaTestLaterDeferrableData data = { 0 };
+  MetaDisplay *display = meta_context_get_display (test_context);
+  MetaCompositor *compositor = meta_display_get_compositor (display);
+  MetaLaters *laters = meta_compositor_get_laters (compositor);
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  unsigned int later_id;
+  unsigned int count_frames_later_id;
+  gulong before_update_handler_id;
+
+  data.loop = g_main_loop_new (NULL, FALSE);
+
+  before_update_handler_id =
+    g_signal_connect (stage, "before-update",
+                      G_CALLBACK (on_later_deferrable_before_update),
+                      &data);
+
+  later_id = meta_laters_add (laters, META_LATER_BEFORE_REDRAW,
+                              test_later_deferrable_expensive_callback,
+                              &data,
+                              NULL);
+  meta_laters_set_deferrable (laters, later_id, TRUE);
+
+  /* Added last, so it runs first in every frame */
+  count_frames_later_id =
+    meta_laters_add (laters, META_LATER_BEFORE_REDRAW,
+                     test_later_deferrable_count_frames_callback,
+                     &data,
+                     NULL);
+
+  g_main_loop_run (data.loop);
+  g_main_loop_unref (data.loop);
+
+  meta_laters_remove (laters, count_frames_later_id);
+  g_signal_handler_disconnect (stage, before_update_handler_id);
+
+  g_assert_cmpint (data.n_runs, ==, 3);
+
+  /* Without a frame deadline nothing is ever deferred */
+  if (!data.has_deadline)
+    {
+      g_test_skip ("The frame clock provides no frame deadline");
+      return;
+    }
+
+  g_assert_cmpint (data.n_deferred, >=, 1);
+}
+
 static void
 meta_test_adjacent_to (void)
 {
@@ -235,6 +349,8 @@ init_tests (void)
   g_test_add_func ("/util/meta-later/order", meta_test_util_later_order);
   g_test_add_func ("/util/meta-later/schedule-from-later",
                    meta_test_util_later_schedule_from_later);
+  g_test_add_func ("/util/meta-later/deferrable",
+                   meta_test_util_later_deferrable);
 
   g_test_add_func ("/core/boxes/adjacent-to", meta_test_adjacent_to);
 
@@ -0,0 +1,219 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+static WaylandDisplay *display;
+
+static struct wl_surface *occluded_surface;
+static struct xdg_surface *occluded_xdg_surface;
+static struct xdg_toplevel *occluded_xdg_toplevel;
+
+static struct wl_surface *occluder_surface;
+static struct xdg_surface *occluder_xdg_surface;
+static struct xdg_toplevel *occluder_xdg_toplevel;
+
+static int occluder_width;
+static int occluder_height;
+static gboolean occluder_shown;
+
+static void create_occluder (void);
+
+static void
+handle_xdg_toplevel_configure (void                *data,
+                               struct xdg_toplevel *xdg_toplevel,
+                               int32_t              width,
+                               int32_t              height,
+                               struct wl_array     *state)
+{
+  if (xdg_toplevel != occluder_xdg_toplevel)
+    return;
+
+  occluder_width = width;
+  occluder_height = height;
+}
+
+static void
+handle_xdg_toplevel_close (void                *data,
+                           struct xdg_toplevel *xdg_toplevel)
+{
+  g_assert_not_reached ();
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+  handle_xdg_toplevel_configure,
+  handle_xdg_toplevel_close,
+};
+
+static void draw_occluded (void);
+
+static void
+handle_occluded_frame_callback (void               *data,
+                                struct wl_callback *callback,
+                                uint32_t            time)
+{
+  wl_callback_destroy (callback);
+
+  if (!occluder_xdg_toplevel)
+    create_occluder ();
+
+  /* Keep drawing as fast as frame callbacks allow, like a game or a
+   * video player would */
+  draw_occluded ();
+}
+
+static const struct wl_callback_listener occluded_frame_listener = {
+  handle_occluded_frame_callback,
+};
+
+static void
+draw_occluded (void)
+{
+  struct wl_callback *frame_callback;
+
+  draw_surface (display, occluded_surface, 100, 100, 0xff00ff00);
+  wl_surface_damage_buffer (occluded_surface, 0, 0, 100, 100);
+  frame_callback = wl_surface_frame (occluded_surface);
+  wl_callback_add_listener (frame_callback, &occluded_frame_listener, NULL);
+  wl_surface_commit (occluded_surface);
+  wl_display_flush (display->display);
+}
+
+static void
+handle_occluded_xdg_surface_configure (void               *data,
+                                       struct xdg_surface *xdg_surface,
+                                       uint32_t            serial)
+{
+  xdg_surface_ack_configure (xdg_surface, serial);
+
+  if (!occluder_xdg_toplevel)
+    draw_occluded ();
+}
+
+static const struct xdg_surface_listener occluded_xdg_surface_listener = {
+  handle_occluded_xdg_surface_configure,
+};
+
+static void
+handle_occluder_frame_callback (void               *data,
+                                struct wl_callback *callback,
+                                uint32_t            time)
+{
+  wl_callback_destroy (callback);
+
+  if (!occluder_shown)
+    {
+      occluder_shown = TRUE;
+      test_driver_sync_point (display->test_driver, 0, NULL);
+    }
+}
+
+static const struct wl_callback_listener occluder_frame_listener = {
+  handle_occluder_frame_callback,
+};
+
+static void
+handle_occluder_xdg_surface_configure (void               *data,
+                                       struct xdg_surface *xdg_surface,
+                                       uint32_t            serial)
+{
+  struct wl_region *opaque_region;
+  struct wl_callback *frame_callback;
+
+  if (occluder_width == 0 || occluder_height == 0)
+    {
+      xdg_surface_ack_configure (xdg_surface, serial);
+      wl_surface_commit (occluder_surface);
+      return;
+    }
+
+  draw_surface (display, occluder_surface,
+                occluder_width, occluder_height,
+                0xff0000ff);
+
+  opaque_region = wl_compositor_create_region (display->compositor);
+  wl_region_add (opaque_region, 0, 0, occluder_width, occluder_height);
+  wl_surface_set_opaque_region (occluder_surface, opaque_region);
+  wl_region_destroy (opaque_region);
+
+  xdg_surface_ack_configure (xdg_surface, serial);
+  frame_callback = wl_surface_frame (occluder_surface);
+  wl_callback_add_listener (frame_callback, &occluder_frame_listener, NULL);
+  wl_surface_commit (occluder_surface);
+  wl_display_flush (display->display);
+}
+
+static const struct xdg_surface_listener occluder_xdg_surface_listener = {
+  handle_occluder_xdg_surface_configure,
+};
+
+static void
+create_occluder (void)
+{
+  occluder_surface = wl_compositor_create_surface (display->compositor);
+  occluder_xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base,
+                                                      occluder_surface);
+  xdg_surface_add_listener (occluder_xdg_surface,
+                            &occluder_xdg_surface_listener, NULL);
+  occluder_xdg_toplevel = xdg_surface_get_toplevel (occluder_xdg_surface);
+  xdg_toplevel_add_listener (occluder_xdg_toplevel,
+                             &xdg_toplevel_listener, NULL);
+  xdg_toplevel_set_title (occluder_xdg_toplevel, "occluder");
+  xdg_toplevel_set_fullscreen (occluder_xdg_toplevel, NULL);
+  wl_surface_commit (occluder_surface);
+}
+
+static void
+on_sync_event (WaylandDisplay *display,
+               uint32_t        serial)
+{
+  g_assert (serial == 0);
+
+  exit (EXIT_SUCCESS);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  g_signal_connect (display, "sync-event", G_CALLBACK (on_sync_event), NULL);
+
+  occluded_surface = wl_compositor_create_surface (display->compositor);
+  occluded_xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base,
+                                                      occluded_surface);
+  xdg_surface_add_listener (occluded_xdg_surface,
+                            &occluded_xdg_surface_listener, NULL);
+  occluded_xdg_toplevel = xdg_surface_get_toplevel (occluded_xdg_surface);
+  xdg_toplevel_add_listener (occluded_xdg_toplevel,
+                             &xdg_toplevel_listener, NULL);
+  xdg_toplevel_set_title (occluded_xdg_toplevel, "occluded");
+  wl_surface_commit (occluded_surface);
+
+  while (TRUE)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
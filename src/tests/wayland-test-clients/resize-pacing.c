@@ -0,0 +1,198 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <poll.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+/* Simulated time it takes the client to render a new size */
+#define RENDER_DELAY_MS 50
+
+static WaylandDisplay *display;
+
+static struct wl_surface *surface;
+static struct xdg_surface *xdg_surface;
+static struct xdg_toplevel *xdg_toplevel;
+
+static gboolean running;
+
+static int committed_width;
+static int committed_height;
+
+static int pending_width;
+static int pending_height;
+
+static gboolean has_delayed_commit;
+static uint32_t delayed_serial;
+static int delayed_width;
+static int delayed_height;
+static int64_t delayed_commit_time_us;
+
+static void
+handle_xdg_toplevel_configure (void                *data,
+                               struct xdg_toplevel *xdg_toplevel,
+                               int32_t              width,
+                               int32_t              height,
+                               struct wl_array     *states)
+{
+  pending_width = width > 0 ? width : 100;
+  pending_height = height > 0 ? height : 100;
+}
+
+static void
+handle_xdg_toplevel_close (void                *data,
+                           struct xdg_toplevel *xdg_toplevel)
+{
+  g_assert_not_reached ();
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+  handle_xdg_toplevel_configure,
+  handle_xdg_toplevel_close,
+};
+
+static void
+commit_size (uint32_t serial,
+             int      width,
+             int      height)
+{
+  draw_surface (display, surface, width, height, 0xff00ffff);
+  xdg_surface_ack_configure (xdg_surface, serial);
+  wl_surface_commit (surface);
+  wl_display_flush (display->display);
+
+  committed_width = width;
+  committed_height = height;
+}
+
+static void
+handle_xdg_surface_configure (void               *data,
+                              struct xdg_surface *xdg_surface,
+                              uint32_t            serial)
+{
+  if (committed_width == 0)
+    {
+      commit_size (serial, pending_width, pending_height);
+      test_driver_sync_point (display->test_driver, 0, NULL);
+      return;
+    }
+
+  if (pending_width == committed_width &&
+      pending_height == committed_height)
+    {
+      if (!has_delayed_commit)
+        {
+          xdg_surface_ack_configure (xdg_surface, serial);
+          wl_surface_commit (surface);
+          wl_display_flush (display->display);
+        }
+      return;
+    }
+
+  /* The compositor must not send another size before it saw the previous
+   * one acked and committed */
+  if (has_delayed_commit &&
+      (pending_width != delayed_width || pending_height != delayed_height))
+    g_error ("Got resized to %dx%d while still rendering %dx%d",
+             pending_width, pending_height, delayed_width, delayed_height);
+
+  has_delayed_commit = TRUE;
+  delayed_serial = serial;
+  delayed_width = pending_width;
+  delayed_height = pending_height;
+  delayed_commit_time_us = (g_get_monotonic_time () +
+                            RENDER_DELAY_MS * G_TIME_SPAN_MILLISECOND);
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+  handle_xdg_surface_configure,
+};
+
+static void
+on_sync_event (WaylandDisplay *display,
+               uint32_t        serial)
+{
+  g_assert (serial == 0);
+
+  running = FALSE;
+}
+
+static int
+get_poll_timeout_ms (void)
+{
+  int64_t now_us;
+
+  if (!has_delayed_commit)
+    return -1;
+
+  now_us = g_get_monotonic_time ();
+  if (now_us >= delayed_commit_time_us)
+    return 0;
+
+  return (int) ((delayed_commit_time_us - now_us) /
+                G_TIME_SPAN_MILLISECOND) + 1;
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  struct pollfd poll_fd;
+
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  g_signal_connect (display, "sync-event", G_CALLBACK (on_sync_event), NULL);
+
+  surface = wl_compositor_create_surface (display->compositor);
+  xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base, surface);
+  xdg_surface_add_listener (xdg_surface, &xdg_surface_listener, NULL);
+  xdg_toplevel = xdg_surface_get_toplevel (xdg_surface);
+  xdg_toplevel_add_listener (xdg_toplevel, &xdg_toplevel_listener, NULL);
+  xdg_toplevel_set_title (xdg_toplevel, "resize-pacing");
+  wl_surface_commit (surface);
+
+  poll_fd.fd = wl_display_get_fd (display->display);
+  poll_fd.events = POLLIN;
+
+  running = TRUE;
+  while (running)
+    {
+      if (wl_display_dispatch_pending (display->display) == -1 ||
+          wl_display_flush (display->display) == -1)
+        return EXIT_FAILURE;
+
+      if (poll (&poll_fd, 1, get_poll_timeout_ms ()) == -1)
+        return EXIT_FAILURE;
+
+      if (poll_fd.revents & POLLIN &&
+          wl_display_dispatch (display->display) == -1)
+        return EXIT_FAILURE;
+
+      if (has_delayed_commit &&
+          g_get_monotonic_time () >= delayed_commit_time_us)
+        {
+          has_delayed_commit = FALSE;
+          commit_size (delayed_serial, delayed_width, delayed_height);
+          test_driver_sync_point (display->test_driver, 1, NULL);
+        }
+    }
+
+  return EXIT_SUCCESS;
+}
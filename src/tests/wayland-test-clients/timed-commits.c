@@ -0,0 +1,271 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include <glib.h>
+#include <wayland-client.h>
+
+#include "wayland-test-client-utils.h"
+
+#define TARGET_DELAY_US (G_USEC_PER_SEC / 5)
+#define N_FIFO_COMMITS 3
+
+typedef enum _State
+{
+  STATE_INIT = 0,
+  STATE_WAIT_FOR_FRAME_1,
+  STATE_WAIT_FOR_TIMED_PRESENTATION,
+  STATE_WAIT_FOR_FIFO_PRESENTATIONS,
+} State;
+
+static WaylandDisplay *display;
+
+static struct wl_surface *surface;
+static struct xdg_surface *xdg_surface;
+static struct xdg_toplevel *xdg_toplevel;
+static struct wp_commit_timer_v1 *commit_timer;
+static struct wp_fifo_v1 *fifo;
+
+static State state;
+static int64_t target_time_us;
+static int64_t fifo_presentation_times_us[N_FIFO_COMMITS];
+static int n_fifo_presentations;
+
+static void
+handle_xdg_toplevel_configure (void                *data,
+                               struct xdg_toplevel *xdg_toplevel,
+                               int32_t              width,
+                               int32_t              height,
+                               struct wl_array     *state)
+{
+}
+
+static void
+handle_xdg_toplevel_close (void                *data,
+                           struct xdg_toplevel *xdg_toplevel)
+{
+  g_assert_not_reached ();
+}
+
+static const struct xdg_toplevel_listener xdg_toplevel_listener = {
+  handle_xdg_toplevel_configure,
+  handle_xdg_toplevel_close,
+};
+
+static void
+handle_feedback_sync_output (void                           *data,
+                             struct wp_presentation_feedback *feedback,
+                             struct wl_output                *output)
+{
+}
+
+static void commit_fifo_updates (void);
+
+static void
+handle_feedback_presented (void                            *data,
+                           struct wp_presentation_feedback *feedback,
+                           uint32_t                         tv_sec_hi,
+                           uint32_t                         tv_sec_lo,
+                           uint32_t                         tv_nsec,
+                           uint32_t                         refresh_ns,
+                           uint32_t                         seq_hi,
+                           uint32_t                         seq_lo,
+                           uint32_t                         flags)
+{
+  uint64_t tv_sec = ((uint64_t) tv_sec_hi << 32) | tv_sec_lo;
+  int64_t presentation_time_us;
+
+  wp_presentation_feedback_destroy (feedback);
+
+  presentation_time_us = tv_sec * G_USEC_PER_SEC + tv_nsec / 1000;
+
+  switch (state)
+    {
+    case STATE_WAIT_FOR_TIMED_PRESENTATION:
+      /* Content is shown in the frame presented closest to its target */
+      g_assert_cmpint (presentation_time_us,
+                       >=,
+                       target_time_us - refresh_ns / 1000 / 2);
+      commit_fifo_updates ();
+      break;
+    case STATE_WAIT_FOR_FIFO_PRESENTATIONS:
+      fifo_presentation_times_us[n_fifo_presentations++] =
+        presentation_time_us;
+
+      if (n_fifo_presentations > 1)
+        {
+          /* Every update must have been shown in a frame of its own */
+          g_assert_cmpint (presentation_time_us,
+                           >,
+                           fifo_presentation_times_us[n_fifo_presentations - 2]);
+        }
+
+      if (n_fifo_presentations == N_FIFO_COMMITS)
+        test_driver_sync_point (display->test_driver, 0, NULL);
+      break;
+    case STATE_INIT:
+    case STATE_WAIT_FOR_FRAME_1:
+      g_assert_not_reached ();
+    }
+}
+
+static void
+handle_feedback_discarded (void                            *data,
+                           struct wp_presentation_feedback *feedback)
+{
+  g_error ("Content update was discarded instead of being presented");
+}
+
+static const struct wp_presentation_feedback_listener feedback_listener = {
+  handle_feedback_sync_output,
+  handle_feedback_presented,
+  handle_feedback_discarded,
+};
+
+static void
+draw_and_request_feedback (uint32_t color)
+{
+  struct wp_presentation_feedback *feedback;
+
+  draw_surface (display, surface, 100, 100, color);
+  wl_surface_damage_buffer (surface, 0, 0, 100, 100);
+  feedback = wp_presentation_feedback (display->presentation, surface);
+  wp_presentation_feedback_add_listener (feedback, &feedback_listener, NULL);
+}
+
+static void
+commit_timed_update (void)
+{
+  uint64_t tv_sec;
+
+  target_time_us = g_get_monotonic_time () + TARGET_DELAY_US;
+  tv_sec = target_time_us / G_USEC_PER_SEC;
+
+  draw_and_request_feedback (0xff00ff00);
+  wp_commit_timer_v1_set_timestamp (commit_timer,
+                                    tv_sec >> 32,
+                                    tv_sec & 0xffffffff,
+                                    (target_time_us % G_USEC_PER_SEC) * 1000);
+  wl_surface_commit (surface);
+  wl_display_flush (display->display);
+
+  state = STATE_WAIT_FOR_TIMED_PRESENTATION;
+}
+
+static void
+commit_fifo_updates (void)
+{
+  int i;
+
+  state = STATE_WAIT_FOR_FIFO_PRESENTATIONS;
+
+  /* Commit all updates at once, leaving pacing them to the compositor */
+  for (i = 0; i < N_FIFO_COMMITS; i++)
+    {
+      draw_and_request_feedback (0xff0000ff + (i << 8));
+      wp_fifo_v1_wait_barrier (fifo);
+      wp_fifo_v1_set_barrier (fifo);
+      wl_surface_commit (surface);
+    }
+
+  wl_display_flush (display->display);
+}
+
+static void
+handle_frame_callback (void               *data,
+                       struct wl_callback *callback,
+                       uint32_t            time)
+{
+  wl_callback_destroy (callback);
+
+  g_assert_cmpint (state, ==, STATE_WAIT_FOR_FRAME_1);
+  commit_timed_update ();
+}
+
+static const struct wl_callback_listener frame_listener = {
+  handle_frame_callback,
+};
+
+static void
+handle_xdg_surface_configure (void               *data,
+                              struct xdg_surface *xdg_surface,
+                              uint32_t            serial)
+{
+  struct wl_callback *frame_callback;
+
+  xdg_surface_ack_configure (xdg_surface, serial);
+
+  if (state != STATE_INIT)
+    {
+      wl_surface_commit (surface);
+      return;
+    }
+
+  draw_surface (display, surface, 100, 100, 0xffff0000);
+  frame_callback = wl_surface_frame (surface);
+  wl_callback_add_listener (frame_callback, &frame_listener, NULL);
+  wl_surface_commit (surface);
+  wl_display_flush (display->display);
+
+  state = STATE_WAIT_FOR_FRAME_1;
+}
+
+static const struct xdg_surface_listener xdg_surface_listener = {
+  handle_xdg_surface_configure,
+};
+
+static void
+on_sync_event (WaylandDisplay *display,
+               uint32_t        serial)
+{
+  g_assert (serial == 0);
+
+  exit (EXIT_SUCCESS);
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  display = wayland_display_new (WAYLAND_DISPLAY_CAPABILITY_TEST_DRIVER);
+  g_signal_connect (display, "sync-event", G_CALLBACK (on_sync_event), NULL);
+
+  g_assert_nonnull (display->commit_timing_mgr);
+  g_assert_nonnull (display->fifo_mgr);
+  g_assert_nonnull (display->presentation);
+
+  surface = wl_compositor_create_surface (display->compositor);
+  commit_timer =
+    wp_commit_timing_manager_v1_get_timer (display->commit_timing_mgr,
+                                           surface);
+  fifo = wp_fifo_manager_v1_get_fifo (display->fifo_mgr, surface);
+  xdg_surface = xdg_wm_base_get_xdg_surface (display->xdg_wm_base, surface);
+  xdg_surface_add_listener (xdg_surface, &xdg_surface_listener, NULL);
+  xdg_toplevel = xdg_surface_get_toplevel (xdg_surface);
+  xdg_toplevel_add_listener (xdg_toplevel, &xdg_toplevel_listener, NULL);
+  xdg_toplevel_set_title (xdg_toplevel, "timed-commits");
+  wl_surface_commit (surface);
+
+  while (TRUE)
+    {
+      if (wl_display_dispatch (display->display) == -1)
+        return EXIT_FAILURE;
+    }
+
+  return EXIT_SUCCESS;
+}
@@ -166,6 +166,22 @@ handle_registry_global (void               *user_data,
       display->shm = wl_registry_bind (registry,
                                        id, &wl_shm_interface, 1);
     }
+  else if (strcmp (interface, wp_commit_timing_manager_v1_interface.name) == 0)
+    {
+      display->commit_timing_mgr =
+        wl_registry_bind (registry, id,
+                          &wp_commit_timing_manager_v1_interface, 1);
+    }
+  else if (strcmp (interface, wp_fifo_manager_v1_interface.name) == 0)
+    {
+      display->fifo_mgr =
+        wl_registry_bind (registry, id, &wp_fifo_manager_v1_interface, 1);
+    }
+  else if (strcmp (interface, wp_presentation_interface.name) == 0)
+    {
+      display->presentation =
+        wl_registry_bind (registry, id, &wp_presentation_interface, 1);
+    }
   else if (strcmp (interface, wp_fractional_scale_manager_v1_interface.name) == 0)
     {
       display->fractional_scale_mgr =
@@ -19,8 +19,11 @@
 
 #include <gio/gio.h>
 
+#include "backends/meta-settings-private.h"
 #include "backends/meta-virtual-monitor.h"
+#include "compositor/compositor-private.h"
 #include "compositor/meta-window-actor-private.h"
+#include "compositor/meta-window-drag.h"
 #include "core/display-private.h"
 #include "core/window-private.h"
 #include "meta-test/meta-context-test.h"
@@ -30,7 +33,10 @@
 #include "tests/meta-wayland-test-driver.h"
 #include "tests/meta-wayland-test-utils.h"
 #include "wayland/meta-wayland-client-private.h"
+#include "wayland/meta-wayland-client-usage.h"
+#include "wayland/meta-wayland-commit-timing.h"
 #include "wayland/meta-wayland-filter-manager.h"
+#include "wayland/meta-wayland-private.h"
 #include "wayland/meta-wayland-surface.h"
 
 #include "dummy-client-protocol.h"
@@ -669,6 +675,352 @@ xdg_foreign_set_parent_of (void)
   meta_wayland_test_client_finish (wayland_test_client);
 }
 
+static void
+on_occluded_state_applied (MetaWaylandSurface *surface,
+                           int                *n_commits)
+{
+  (*n_commits)++;
+}
+
+static void
+occluded_frame_callbacks (void)
+{
+  g_autoptr (GSettings) settings = NULL;
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  ClutterStageView *view;
+  MetaWaylandTestClient *wayland_test_client;
+  MetaWindow *window;
+  MetaWaylandSurface *surface;
+  unsigned int interval_ms = 50;
+  int n_frames = 60;
+  float frames_per_interval;
+  int n_commits = 0;
+  gulong handler_id;
+  int i;
+
+  settings = g_settings_new ("org.gnome.mutter");
+  g_assert_true (g_settings_set_uint (settings,
+                                      "obscured-frame-callback-interval",
+                                      interval_ms));
+
+  view = clutter_stage_peek_stage_views (CLUTTER_STAGE (stage))->data;
+  frames_per_interval =
+    interval_ms * clutter_stage_view_get_refresh_rate (view) / 1000.0f;
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "occluded-frame-callbacks");
+
+  /* The client only reaches the sync point once the occluder has been
+   * painted, so after the next paint the other window is obscured */
+  wait_for_sync_point (0);
+  wait_until_after_paint ();
+
+  window = find_client_window ("occluded");
+  surface = meta_window_get_wayland_surface (window);
+  handler_id = g_signal_connect (surface, "pre-state-applied",
+                                 G_CALLBACK (on_occluded_state_applied),
+                                 &n_commits);
+
+  for (i = 0; i < n_frames; i++)
+    wait_until_after_paint ();
+
+  g_signal_handler_disconnect (surface, handler_id);
+
+  /* The occluded client must neither be starved, nor be able to draw
+   * once per stage update */
+  g_assert_cmpint (n_commits, >=, 1);
+  g_assert_cmpint (n_commits, <=, (int) (n_frames / frames_per_interval) + 2);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  g_settings_reset (settings, "obscured-frame-callback-interval");
+}
+
+typedef struct
+{
+  MetaWaylandCompositor *compositor;
+  MetaWaylandSurface *surface;
+  int64_t expected_dispatch_time_us;
+  int n_updates;
+  int n_held_back;
+  int n_dispatched;
+} PredictiveFrameCallbacksData;
+
+static gboolean
+has_pending_frame_callbacks (PredictiveFrameCallbacksData *data)
+{
+  return !!g_list_find (data->compositor->frame_callback_surfaces,
+                        data->surface);
+}
+
+static void
+on_predictive_before_update (ClutterStage                 *stage,
+                             ClutterStageView             *stage_view,
+                             ClutterFrame                 *frame,
+                             PredictiveFrameCallbacksData *data)
+{
+  /* Held back frame callbacks must be out by the time they are due, so
+   * that the client can make it into the update following them */
+  if (data->expected_dispatch_time_us && has_pending_frame_callbacks (data))
+    g_assert_cmpint (g_get_monotonic_time (), <,
+                     data->expected_dispatch_time_us);
+}
+
+static void
+on_predictive_after_update (ClutterStage                 *stage,
+                            ClutterStageView             *stage_view,
+                            ClutterFrame                 *frame,
+                            PredictiveFrameCallbacksData *data)
+{
+  ClutterFrameClock *frame_clock =
+    clutter_stage_view_get_frame_clock (stage_view);
+  MetaWaylandCommitTiming *timing;
+  int64_t predicted_update_time_us;
+  int64_t commit_time_us;
+
+  data->n_updates++;
+
+  /* Frame callbacks still pending after the compositor handled the update
+   * were held back */
+  if (!has_pending_frame_callbacks (data))
+    {
+      data->expected_dispatch_time_us = 0;
+      return;
+    }
+
+  g_assert_true (clutter_frame_clock_predict_next_update_time (frame_clock,
+                                                               frame,
+                                                               &predicted_update_time_us));
+  timing =
+    meta_wayland_commit_timing_lookup (wl_resource_get_client (data->surface->resource));
+  g_assert_nonnull (timing);
+  g_assert_true (meta_wayland_commit_timing_get_estimate (timing,
+                                                          &commit_time_us));
+
+  if (!data->expected_dispatch_time_us)
+    data->n_held_back++;
+
+  data->expected_dispatch_time_us = predicted_update_time_us -
+                                    commit_time_us -
+                                    PREDICTIVE_FRAME_CALLBACK_SLACK_US;
+}
+
+static void
+on_predictive_state_applied (MetaWaylandSurface           *surface,
+                             PredictiveFrameCallbacksData *data)
+{
+  int64_t frame_callback_time_us =
+    surface->commit_latency.frame_callback_time_us;
+
+  if (!data->expected_dispatch_time_us || !frame_callback_time_us)
+    return;
+
+  /* The client draws in response to the held back frame callbacks, which
+   * must not have been emitted before they were due */
+  g_assert_cmpint (frame_callback_time_us, >=,
+                   data->expected_dispatch_time_us);
+
+  data->expected_dispatch_time_us = 0;
+  data->n_dispatched++;
+}
+
+static void
+predictive_frame_callbacks (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  MetaWaylandTestClient *wayland_test_client;
+  PredictiveFrameCallbacksData data = { 0 };
+  MetaWindow *window;
+  gulong before_update_handler_id;
+  gulong after_update_handler_id;
+  gulong state_applied_handler_id;
+
+  meta_settings_enable_experimental_feature (
+    settings, META_EXPERIMENTAL_FEATURE_PREDICTIVE_FRAME_CALLBACKS);
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "predictive-frame-callbacks");
+  wait_for_sync_point (0);
+
+  /* Only the frame callbacks of focused windows are predicted */
+  window = find_client_window ("predictive-frame-callbacks");
+  meta_window_activate (window, 0);
+  g_assert_true (meta_window_appears_focused (window));
+
+  data.compositor = meta_context_get_wayland_compositor (test_context);
+  data.surface = meta_window_get_wayland_surface (window);
+  before_update_handler_id =
+    g_signal_connect (stage, "before-update",
+                      G_CALLBACK (on_predictive_before_update), &data);
+  after_update_handler_id =
+    g_signal_connect (stage, "after-update",
+                      G_CALLBACK (on_predictive_after_update), &data);
+  state_applied_handler_id =
+    g_signal_connect (data.surface, "pre-state-applied",
+                      G_CALLBACK (on_predictive_state_applied), &data);
+
+  /* The client redraws on every frame callback, so once enough commit
+   * times were recorded, its frame callbacks are held back after each
+   * update, and dispatched ahead of the next one */
+  while (data.n_dispatched < 5)
+    {
+      g_main_context_iteration (NULL, TRUE);
+
+      if (data.n_updates > 100 && data.n_held_back == 0)
+        break;
+    }
+
+  g_signal_handler_disconnect (stage, before_update_handler_id);
+  g_signal_handler_disconnect (stage, after_update_handler_id);
+  g_signal_handler_disconnect (data.surface, state_applied_handler_id);
+
+  g_assert_cmpint (data.n_held_back, >, 0);
+  g_assert_cmpint (data.n_dispatched, ==, 5);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  meta_settings_disable_experimental_feature (
+    settings, META_EXPERIMENTAL_FEATURE_PREDICTIVE_FRAME_CALLBACKS);
+}
+
+static void
+timed_commits (void)
+{
+  MetaWaylandTestClient *wayland_test_client;
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "timed-commits");
+
+  /* The client checks the presentation times of its timed and FIFO
+   * paced content updates itself */
+  wait_for_sync_point (0);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+}
+
+static void
+resize_pacing (void)
+{
+  MetaBackend *backend = meta_context_get_backend (test_context);
+  MetaDisplay *display = meta_context_get_display (test_context);
+  ClutterSeat *seat = meta_backend_get_default_seat (backend);
+  MetaWaylandTestClient *wayland_test_client;
+  MetaWindowDrag *window_drag;
+  MetaWindow *window;
+  MetaRectangle rect;
+  int64_t timeout_us;
+  int i;
+
+  virtual_pointer = clutter_seat_create_virtual_device (seat,
+                                                        CLUTTER_POINTER_DEVICE);
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "client-usage");
+
+  wait_for_sync_point (0);
+  wait_until_after_paint ();
+
+  window = find_client_window ("client-usage");
+  meta_window_move_frame (window, FALSE, 0, 0);
+  meta_window_get_frame_rect (window, &rect);
+  g_assert_cmpint (rect.width, ==, 100);
+  g_assert_cmpint (rect.height, ==, 100);
+
+  clutter_virtual_input_device_notify_absolute_motion (virtual_pointer,
+                                                       CLUTTER_CURRENT_TIME,
+                                                       rect.width - 1,
+                                                       rect.height - 1);
+  wait_until_after_paint ();
+
+  g_assert_true (meta_window_begin_grab_op (window,
+                                            META_GRAB_OP_RESIZING_SE,
+                                            clutter_seat_get_pointer (seat),
+                                            NULL,
+                                            meta_display_get_current_time_roundtrip (display)));
+
+  /* Move the pointer a lot faster than the client, which takes a while to
+   * render each size, can follow: every burst of motion arrives while the
+   * client is still rendering the first size it caused, and the client
+   * fails if it is sent a new size while still busy with the previous
+   * one. Sync point 1 is emitted when the client commits a rendered size.
+   */
+  for (i = 1; i <= 20; i++)
+    {
+      clutter_virtual_input_device_notify_absolute_motion (virtual_pointer,
+                                                           CLUTTER_CURRENT_TIME,
+                                                           rect.width - 1 + i * 5,
+                                                           rect.height - 1 + i * 5);
+      if (i % 5 == 0)
+        wait_for_sync_point (1);
+    }
+
+  /* Once it caught up, the window ends up following the last motion */
+  timeout_us = g_get_monotonic_time () + 5 * G_USEC_PER_SEC;
+  while (TRUE)
+    {
+      meta_window_get_frame_rect (window, &rect);
+      if (rect.width == 200 && rect.height == 200)
+        break;
+
+      g_assert_cmpint (g_get_monotonic_time (), <, timeout_us);
+      g_main_context_iteration (NULL, TRUE);
+    }
+
+  window_drag =
+    meta_compositor_get_current_window_drag (display->compositor);
+  g_assert_nonnull (window_drag);
+  meta_window_drag_end (window_drag);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+
+  g_clear_object (&virtual_pointer);
+}
+
+static void
+client_usage (void)
+{
+  MetaWaylandTestClient *wayland_test_client;
+  MetaWaylandClientUsage *usage;
+  MetaWaylandSurface *surface;
+  MetaWindow *window;
+
+  wayland_test_client =
+    meta_wayland_test_client_new (test_context, "client-usage");
+
+  wait_for_sync_point (0);
+  wait_until_after_paint ();
+
+  window = find_client_window ("client-usage");
+  surface = meta_window_get_wayland_surface (window);
+  usage =
+    meta_wayland_client_usage_lookup (wl_resource_get_client (surface->resource));
+  g_assert_nonnull (usage);
+
+  /* A single 100x100 ARGB8888 wl_shm buffer, uploaded to a texture */
+  g_assert_cmpuint (meta_wayland_client_usage_get_n_surfaces (usage), ==, 1);
+  g_assert_cmpuint (meta_wayland_client_usage_get_memory (usage,
+                                                          META_WAYLAND_CLIENT_MEMORY_TYPE_SHM),
+                    >=, 100 * 100 * 4);
+  g_assert_cmpuint (meta_wayland_client_usage_get_memory (usage,
+                                                          META_WAYLAND_CLIENT_MEMORY_TYPE_TEXTURE),
+                    >=, 100 * 100 * 4);
+  g_assert_cmpuint (meta_wayland_client_usage_get_memory (usage,
+                                                          META_WAYLAND_CLIENT_MEMORY_TYPE_DMA_BUF),
+                    ==, 0);
+  g_assert_cmpuint (meta_wayland_client_usage_get_n_pending_transactions (usage),
+                    ==, 0);
+
+  meta_wayland_test_driver_emit_sync_event (test_driver, 0);
+  meta_wayland_test_client_finish (wayland_test_client);
+}
+
 static MetaWaylandAccess
 dummy_global_filter (const struct wl_client *client,
                      const struct wl_global *global,
@@ -882,6 +1234,16 @@ init_tests (void)
                    toplevel_bounds_struts);
   g_test_add_func ("/wayland/toplevel/bounds/monitors",
                    toplevel_bounds_monitors);
+  g_test_add_func ("/wayland/surface/occluded-frame-callbacks",
+                   occluded_frame_callbacks);
+  g_test_add_func ("/wayland/surface/predictive-frame-callbacks",
+                   predictive_frame_callbacks);
+  g_test_add_func ("/wayland/surface/timed-commits",
+                   timed_commits);
+  g_test_add_func ("/wayland/toplevel/resize-pacing",
+                   resize_pacing);
+  g_test_add_func ("/wayland/client/usage",
+                   client_usage);
   g_test_add_func ("/wayland/xdg-foreign/set-parent-of",
                    xdg_foreign_set_parent_of);
   g_test_add_func ("/wayland/registry/filter",
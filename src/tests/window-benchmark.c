@@ -0,0 +1,323 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "core/display-private.h"
+#include "core/window-private.h"
+#include "meta-test/meta-context-test.h"
+#include "meta/meta-workspace-manager.h"
+#include "meta/workspace.h"
+#include "tests/meta-test-utils.h"
+
+/* Like the stacking tests, but with a lot of windows: every parent window
+ * has a few transients, as e.g. an IDE with many dialogs open would.
+ */
+#define N_TRANSIENTS_PER_PARENT 4
+#define N_RAISES 200
+
+#define N_WORKSPACES 4
+#define N_SWITCHES 200
+
+static MetaContext *test_context;
+
+static MetaTestClient *
+create_test_client (void)
+{
+  MetaTestClient *test_client;
+  g_autoptr (GError) error = NULL;
+
+  test_client = meta_test_client_new (test_context, "1",
+                                      META_WINDOW_CLIENT_TYPE_WAYLAND,
+                                      &error);
+  if (!test_client)
+    g_error ("Failed to launch test client: %s", error->message);
+
+  return test_client;
+}
+
+static void
+destroy_test_client (MetaTestClient *test_client)
+{
+  g_autoptr (GError) error = NULL;
+
+  if (!meta_test_client_quit (test_client, &error))
+    g_error ("Failed to quit test client: %s", error->message);
+  meta_test_client_destroy (test_client);
+}
+
+/* Creates and shows @n_windows windows, every parent window followed by
+ * @n_transients_per_parent windows transient for it, and returns them once
+ * they are all shown.
+ */
+static GPtrArray *
+create_windows (MetaTestClient *test_client,
+                int             n_windows,
+                int             n_transients_per_parent)
+{
+  g_autoptr (GError) error = NULL;
+  GPtrArray *windows;
+  int i;
+
+  for (i = 0; i < n_windows; i++)
+    {
+      g_autofree char *window_id = NULL;
+
+      window_id = g_strdup_printf ("%d", i);
+
+      if (!meta_test_client_do (test_client, &error,
+                                "create", window_id,
+                                NULL))
+        g_error ("Failed to create window %s: %s", window_id, error->message);
+
+      if (i % (n_transients_per_parent + 1) != 0)
+        {
+          g_autofree char *parent_id = NULL;
+
+          parent_id = g_strdup_printf ("%d",
+                                       i - i % (n_transients_per_parent + 1));
+          if (!meta_test_client_do (test_client, &error,
+                                    "set_parent", window_id, parent_id,
+                                    NULL))
+            g_error ("Failed to set parent of %s: %s",
+                     window_id, error->message);
+        }
+
+      if (!meta_test_client_do (test_client, &error,
+                                "show", window_id,
+                                NULL))
+        g_error ("Failed to show window %s: %s", window_id, error->message);
+    }
+
+  if (!meta_test_client_wait (test_client, &error))
+    g_error ("Failed to sync test client: %s", error->message);
+
+  windows = g_ptr_array_new ();
+  for (i = 0; i < n_windows; i++)
+    {
+      g_autofree char *window_id = NULL;
+      MetaWindow *window;
+
+      window_id = g_strdup_printf ("%d", i);
+      window = meta_test_client_find_window (test_client, window_id, &error);
+      if (!window)
+        g_error ("Failed to find window %s: %s", window_id, error->message);
+
+      meta_test_client_wait_for_window_shown (test_client, window);
+      g_ptr_array_add (windows, window);
+    }
+
+  return windows;
+}
+
+static void
+report_time_per_operation (int64_t     elapsed_us,
+                           int         n_operations,
+                           const char *operation,
+                           const char *description)
+{
+  double ms_per_operation;
+
+  ms_per_operation = elapsed_us / 1000.0 / n_operations;
+  g_test_message ("%s took %.3f ms", description, ms_per_operation);
+  g_test_minimized_result (ms_per_operation, "%.3f ms per %s",
+                           ms_per_operation, operation);
+}
+
+static void
+assert_transients_above (MetaWindow *parent)
+{
+  MetaStack *stack = parent->display->stack;
+  MetaWindow *above;
+  int n_transients = 0;
+
+  for (above = meta_stack_get_above (stack, parent, FALSE);
+       above && meta_window_get_transient_for (above) == parent;
+       above = meta_stack_get_above (stack, above, FALSE))
+    n_transients++;
+
+  g_assert_cmpint (n_transients, ==, N_TRANSIENTS_PER_PARENT);
+  g_assert_null (above);
+}
+
+static void
+meta_test_stack_raise_transients (gconstpointer data)
+{
+  int n_windows = GPOINTER_TO_INT (data);
+  MetaTestClient *test_client;
+  g_autoptr (GPtrArray) windows = NULL;
+  g_autoptr (GPtrArray) parents = NULL;
+  g_autofree char *description = NULL;
+  int64_t start_us;
+  unsigned int j;
+  int i;
+
+  test_client = create_test_client ();
+  windows = create_windows (test_client, n_windows, N_TRANSIENTS_PER_PARENT);
+
+  parents = g_ptr_array_new ();
+  for (j = 0; j < windows->len; j++)
+    {
+      MetaWindow *window = g_ptr_array_index (windows, j);
+
+      if (!meta_window_get_transient_for (window))
+        g_ptr_array_add (parents, window);
+    }
+
+  start_us = g_get_monotonic_time ();
+  for (i = 0; i < N_RAISES; i++)
+    {
+      MetaWindow *parent;
+
+      parent = g_ptr_array_index (parents,
+                                  g_test_rand_int_range (0, parents->len));
+      meta_window_raise (parent);
+    }
+  description = g_strdup_printf ("Raising a parent among %d windows",
+                                 n_windows);
+  report_time_per_operation (g_get_monotonic_time () - start_us, N_RAISES,
+                             "raise", description);
+
+  for (j = 0; j < parents->len; j++)
+    {
+      MetaWindow *parent = g_ptr_array_index (parents, j);
+
+      meta_window_raise (parent);
+      assert_transients_above (parent);
+    }
+
+  destroy_test_client (test_client);
+}
+
+static gboolean
+count_window (MetaWindow *window,
+              void       *user_data)
+{
+  int *n_windows = user_data;
+
+  (*n_windows)++;
+
+  return TRUE;
+}
+
+static void
+meta_test_workspace_switch (gconstpointer data)
+{
+  int n_windows = GPOINTER_TO_INT (data);
+  MetaDisplay *display = meta_context_get_display (test_context);
+  MetaWorkspaceManager *workspace_manager =
+    meta_display_get_workspace_manager (display);
+  MetaTestClient *test_client;
+  g_autoptr (GPtrArray) windows = NULL;
+  g_autofree char *description = NULL;
+  int64_t start_us;
+  unsigned int j;
+  int i;
+
+  while (meta_workspace_manager_get_n_workspaces (workspace_manager) <
+         N_WORKSPACES)
+    meta_workspace_manager_append_new_workspace (workspace_manager, FALSE,
+                                                 META_CURRENT_TIME);
+
+  test_client = create_test_client ();
+  windows = create_windows (test_client, n_windows, 0);
+
+  for (j = 0; j < windows->len; j++)
+    {
+      MetaWindow *window = g_ptr_array_index (windows, j);
+      MetaWorkspace *workspace;
+
+      workspace =
+        meta_workspace_manager_get_workspace_by_index (workspace_manager,
+                                                       j % N_WORKSPACES);
+      meta_window_change_workspace (window, workspace);
+    }
+
+  /* Switch workspaces the way a pager would, looking at the windows of
+   * the workspace that was switched to every time.
+   */
+  start_us = g_get_monotonic_time ();
+  for (i = 0; i < N_SWITCHES; i++)
+    {
+      MetaWorkspace *workspace;
+      g_autoptr (GList) workspace_windows = NULL;
+      int n_foreach_windows = 0;
+
+      workspace =
+        meta_workspace_manager_get_workspace_by_index (workspace_manager,
+                                                       (i + 1) % N_WORKSPACES);
+      meta_workspace_activate (workspace, META_CURRENT_TIME);
+
+      workspace_windows = meta_workspace_list_windows (workspace);
+      meta_workspace_foreach_window (workspace, count_window,
+                                     &n_foreach_windows);
+
+      g_assert_cmpint (g_list_length (workspace_windows), ==,
+                       n_windows / N_WORKSPACES);
+      g_assert_cmpint (n_foreach_windows, ==, n_windows / N_WORKSPACES);
+    }
+  description = g_strdup_printf ("Switching between %d workspaces with %d "
+                                 "windows",
+                                 N_WORKSPACES, n_windows);
+  report_time_per_operation (g_get_monotonic_time () - start_us, N_SWITCHES,
+                             "switch", description);
+
+  meta_workspace_activate (meta_workspace_manager_get_workspace_by_index (
+                             workspace_manager, 0),
+                           META_CURRENT_TIME);
+
+  destroy_test_client (test_client);
+}
+
+static void
+init_tests (void)
+{
+  g_test_add_data_func ("/core/stack/raise-transients/100-windows",
+                        GINT_TO_POINTER (100),
+                        meta_test_stack_raise_transients);
+  g_test_add_data_func ("/core/workspace/switch/240-windows",
+                        GINT_TO_POINTER (240),
+                        meta_test_workspace_switch);
+
+  if (g_test_perf ())
+    {
+      g_test_add_data_func ("/core/stack/raise-transients/1000-windows",
+                            GINT_TO_POINTER (1000),
+                            meta_test_stack_raise_transients);
+      g_test_add_data_func ("/core/workspace/switch/1200-windows",
+                            GINT_TO_POINTER (1200),
+                            meta_test_workspace_switch);
+    }
+}
+
+int
+main (int    argc,
+      char **argv)
+{
+  g_autoptr (MetaContext) context = NULL;
+
+  context = meta_create_test_context (META_CONTEXT_TEST_TYPE_HEADLESS,
+                                      META_CONTEXT_TEST_FLAG_TEST_CLIENT);
+  g_assert (meta_context_configure (context, &argc, &argv, NULL));
+
+  test_context = context;
+
+  init_tests ();
+
+  return meta_context_test_run_tests (META_CONTEXT_TEST (context),
+                                      META_TEST_RUN_FLAG_NONE);
+}
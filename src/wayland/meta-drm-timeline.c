@@ -0,0 +1,256 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * A MetaDrmTimeline wraps a DRM timeline syncobj, i.e. a syncobj whose
+ * state is a monotonically increasing sequence of sync points, each
+ * backed by a dma fence once submitted.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-drm-timeline.h"
+
+#include <errno.h>
+#include <fcntl.h>
+#include <gio/gio.h>
+#include <sys/eventfd.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+struct _MetaDrmTimeline
+{
+  GObject parent;
+
+  int drm_fd;
+  uint32_t drm_syncobj;
+};
+
+G_DEFINE_TYPE (MetaDrmTimeline, meta_drm_timeline, G_TYPE_OBJECT)
+
+/**
+ * meta_drm_timeline_import_syncobj:
+ * @drm_fd: A DRM device file descriptor
+ * @drm_syncobj_fd: A file descriptor referring to a timeline syncobj
+ * @error: Return location for error
+ *
+ * Imports the timeline syncobj @drm_syncobj_fd into the DRM device @drm_fd.
+ * The caller keeps ownership of both file descriptors.
+ *
+ * Returns: (transfer full): The new #MetaDrmTimeline, or %NULL on failure
+ */
+MetaDrmTimeline *
+meta_drm_timeline_import_syncobj (int      drm_fd,
+                                  int      drm_syncobj_fd,
+                                  GError **error)
+{
+  g_autoptr (MetaDrmTimeline) timeline = NULL;
+
+  timeline = g_object_new (META_TYPE_DRM_TIMELINE, NULL);
+
+  timeline->drm_fd = fcntl (drm_fd, F_DUPFD_CLOEXEC, 0);
+  if (timeline->drm_fd < 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to duplicate DRM fd: %s", g_strerror (errno));
+      return NULL;
+    }
+
+  if (drmSyncobjFDToHandle (timeline->drm_fd,
+                            drm_syncobj_fd,
+                            &timeline->drm_syncobj) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to import DRM syncobj: %s", g_strerror (errno));
+      return NULL;
+    }
+
+  return g_steal_pointer (&timeline);
+}
+
+/**
+ * meta_drm_timeline_get_eventfd:
+ * @timeline: A #MetaDrmTimeline
+ * @sync_point: The sync point to wait for
+ * @error: Return location for error
+ *
+ * Returns: (transfer full): An eventfd that becomes readable once
+ * @sync_point has been signaled, or -1 on failure
+ */
+int
+meta_drm_timeline_get_eventfd (MetaDrmTimeline  *timeline,
+                               uint64_t          sync_point,
+                               GError          **error)
+{
+  int fd;
+
+  fd = eventfd (0, EFD_CLOEXEC);
+  if (fd < 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to create eventfd: %s", g_strerror (errno));
+      return -1;
+    }
+
+  if (drmSyncobjEventfd (timeline->drm_fd, timeline->drm_syncobj,
+                         sync_point, fd, 0) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to register eventfd for sync point: %s",
+                   g_strerror (errno));
+      close (fd);
+      return -1;
+    }
+
+  return fd;
+}
+
+/**
+ * meta_drm_timeline_set_sync_point:
+ * @timeline: A #MetaDrmTimeline
+ * @sync_point: The sync point to set
+ * @sync_fd: A sync_file file descriptor
+ * @error: Return location for error
+ *
+ * Makes @sync_point signal when the fence of @sync_fd does. The caller keeps
+ * ownership of @sync_fd.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+meta_drm_timeline_set_sync_point (MetaDrmTimeline  *timeline,
+                                  uint64_t          sync_point,
+                                  int               sync_fd,
+                                  GError          **error)
+{
+  uint32_t tmp_syncobj;
+  gboolean ret = FALSE;
+
+  /* Sync files can only be imported into binary syncobjs, so go through a
+   * temporary one and transfer its fence to the timeline point */
+  if (drmSyncobjCreate (timeline->drm_fd, 0, &tmp_syncobj) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to create syncobj: %s", g_strerror (errno));
+      return FALSE;
+    }
+
+  if (drmSyncobjImportSyncFile (timeline->drm_fd, tmp_syncobj, sync_fd) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to import sync file: %s", g_strerror (errno));
+      goto out;
+    }
+
+  if (drmSyncobjTransfer (timeline->drm_fd,
+                          timeline->drm_syncobj, sync_point,
+                          tmp_syncobj, 0,
+                          0) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to transfer fence to sync point: %s",
+                   g_strerror (errno));
+      goto out;
+    }
+
+  ret = TRUE;
+
+out:
+  drmSyncobjDestroy (timeline->drm_fd, tmp_syncobj);
+  return ret;
+}
+
+/**
+ * meta_drm_timeline_signal:
+ * @timeline: A #MetaDrmTimeline
+ * @sync_point: The sync point to signal
+ * @error: Return location for error
+ *
+ * Signals @sync_point right away from the CPU.
+ *
+ * Returns: %TRUE on success
+ */
+gboolean
+meta_drm_timeline_signal (MetaDrmTimeline  *timeline,
+                          uint64_t          sync_point,
+                          GError          **error)
+{
+  if (drmSyncobjTimelineSignal (timeline->drm_fd,
+                                &timeline->drm_syncobj, &sync_point,
+                                1) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to signal sync point: %s", g_strerror (errno));
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+/**
+ * meta_drm_timeline_is_signaled:
+ * @timeline: A #MetaDrmTimeline
+ * @sync_point: The sync point to check
+ * @error: Return location for error
+ *
+ * Returns: %TRUE if @sync_point has been signaled already, %FALSE if not or
+ * on failure
+ */
+gboolean
+meta_drm_timeline_is_signaled (MetaDrmTimeline  *timeline,
+                               uint64_t          sync_point,
+                               GError          **error)
+{
+  uint64_t value;
+
+  if (drmSyncobjQuery (timeline->drm_fd, &timeline->drm_syncobj, &value,
+                       1) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to query syncobj: %s", g_strerror (errno));
+      return FALSE;
+    }
+
+  return value >= sync_point;
+}
+
+static void
+meta_drm_timeline_finalize (GObject *object)
+{
+  MetaDrmTimeline *timeline = META_DRM_TIMELINE (object);
+
+  if (timeline->drm_syncobj)
+    drmSyncobjDestroy (timeline->drm_fd, timeline->drm_syncobj);
+  if (timeline->drm_fd >= 0)
+    close (timeline->drm_fd);
+
+  G_OBJECT_CLASS (meta_drm_timeline_parent_class)->finalize (object);
+}
+
+static void
+meta_drm_timeline_init (MetaDrmTimeline *timeline)
+{
+  timeline->drm_fd = -1;
+}
+
+static void
+meta_drm_timeline_class_init (MetaDrmTimelineClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_drm_timeline_finalize;
+}
@@ -29,6 +29,7 @@
 #include "compositor/meta-window-actor-wayland.h"
 #include "compositor/region-utils.h"
 #include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-single-pixel-buffer.h"
 #include "wayland/meta-wayland-surface.h"
 #include "wayland/meta-window-wayland.h"
 
@@ -149,6 +150,13 @@ meta_wayland_actor_surface_emit_frame_callbacks (MetaWaylandActorSurface *actor_
 {
   MetaWaylandActorSurfacePrivate *priv =
     meta_wayland_actor_surface_get_instance_private (actor_surface);
+  MetaWaylandSurfaceRole *surface_role =
+    META_WAYLAND_SURFACE_ROLE (actor_surface);
+  MetaWaylandSurface *surface =
+    meta_wayland_surface_role_get_surface (surface_role);
+
+  if (!wl_list_empty (&priv->frame_callback_list))
+    surface->commit_latency.frame_callback_time_us = g_get_monotonic_time ();
 
   while (!wl_list_empty (&priv->frame_callback_list))
     {
@@ -193,6 +201,7 @@ meta_wayland_actor_surface_real_sync_actor_state (MetaWaylandActorSurface *actor
       CoglSnippet *snippet;
       gboolean is_y_inverted;
       CoglTexture *texture;
+      MetaWaylandSinglePixelBuffer *single_pixel_buffer;
 
       snippet = meta_wayland_buffer_create_snippet (buffer);
       is_y_inverted = meta_wayland_buffer_is_y_inverted (buffer);
@@ -203,10 +212,26 @@ meta_wayland_actor_surface_real_sync_actor_state (MetaWaylandActorSurface *actor
       meta_shaped_texture_set_is_y_inverted (stex, is_y_inverted);
       meta_shaped_texture_set_buffer_scale (stex, surface->scale);
       cogl_clear_object (&snippet);
+
+      single_pixel_buffer = buffer->single_pixel.single_pixel_buffer;
+      if (buffer->type == META_WAYLAND_BUFFER_TYPE_SINGLE_PIXEL &&
+          single_pixel_buffer)
+        {
+          CoglColor color;
+
+          meta_wayland_single_pixel_buffer_get_color (single_pixel_buffer,
+                                                      &color);
+          meta_shaped_texture_set_solid_color (stex, &color);
+        }
+      else
+        {
+          meta_shaped_texture_set_solid_color (stex, NULL);
+        }
     }
   else
     {
       meta_shaped_texture_set_texture (stex, NULL);
+      meta_shaped_texture_set_solid_color (stex, NULL);
     }
 
   surface_rect = (cairo_rectangle_int_t) {
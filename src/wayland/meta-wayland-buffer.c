@@ -64,6 +64,7 @@
 #include "backends/native/meta-kms-utils.h"
 #include "backends/native/meta-onscreen-native.h"
 #include "backends/native/meta-renderer-native.h"
+#include "wayland/meta-wayland-linux-drm-syncobj.h"
 #endif
 
 #ifndef DRM_FORMAT_MOD_INVALID
@@ -134,8 +135,8 @@ meta_wayland_buffer_is_realized (MetaWaylandBuffer *buffer)
   return buffer->type != META_WAYLAND_BUFFER_TYPE_UNKNOWN;
 }
 
-gboolean
-meta_wayland_buffer_realize (MetaWaylandBuffer *buffer)
+static gboolean
+realize_buffer_type (MetaWaylandBuffer *buffer)
 {
 #ifdef HAVE_WAYLAND_EGLSTREAM
   MetaWaylandEglStream *stream;
@@ -211,6 +212,61 @@ meta_wayland_buffer_realize (MetaWaylandBuffer *buffer)
   return FALSE;
 }
 
+static void
+account_buffer_memory (MetaWaylandBuffer *buffer)
+{
+  struct wl_client *client = wl_resource_get_client (buffer->resource);
+  MetaWaylandClientMemoryType memory_type;
+  uint64_t n_bytes;
+
+  if (buffer->client_usage.usage)
+    return;
+
+  switch (buffer->type)
+    {
+    case META_WAYLAND_BUFFER_TYPE_SHM:
+      {
+        struct wl_shm_buffer *shm_buffer;
+
+        shm_buffer = wl_shm_buffer_get (buffer->resource);
+        memory_type = META_WAYLAND_CLIENT_MEMORY_TYPE_SHM;
+        n_bytes = ((uint64_t) wl_shm_buffer_get_stride (shm_buffer) *
+                   wl_shm_buffer_get_height (shm_buffer));
+        break;
+      }
+    case META_WAYLAND_BUFFER_TYPE_EGL_IMAGE:
+    case META_WAYLAND_BUFFER_TYPE_DMA_BUF:
+      if (!buffer->dma_buf.dma_buf)
+        return;
+
+      memory_type = META_WAYLAND_CLIENT_MEMORY_TYPE_DMA_BUF;
+      n_bytes = meta_wayland_dma_buf_get_n_bytes (buffer->dma_buf.dma_buf);
+      break;
+    default:
+      return;
+    }
+
+  buffer->client_usage.usage =
+    meta_wayland_client_usage_ref (meta_wayland_client_usage_ensure (client));
+  buffer->client_usage.memory_type = memory_type;
+  buffer->client_usage.n_bytes = n_bytes;
+  meta_wayland_client_usage_add_memory (buffer->client_usage.usage,
+                                        memory_type, n_bytes);
+  meta_wayland_client_usage_enforce_limit (buffer->client_usage.usage,
+                                           buffer->compositor);
+}
+
+gboolean
+meta_wayland_buffer_realize (MetaWaylandBuffer *buffer)
+{
+  if (!realize_buffer_type (buffer))
+    return FALSE;
+
+  account_buffer_memory (buffer);
+
+  return TRUE;
+}
+
 static gboolean
 shm_format_to_cogl_pixel_format (enum wl_shm_format     shm_format,
                                  CoglPixelFormat       *format_out,
@@ -430,6 +486,18 @@ shm_buffer_attach (MetaWaylandBuffer  *buffer,
   if (!new_texture)
     return FALSE;
 
+  if (buffer->client_usage.usage)
+    {
+      uint64_t n_bytes;
+
+      n_bytes = ((uint64_t) width * height *
+                 cogl_pixel_format_get_bytes_per_pixel (format, 0));
+      meta_wayland_client_usage_track_texture (buffer->client_usage.usage,
+                                               new_texture, n_bytes);
+      meta_wayland_client_usage_enforce_limit (buffer->client_usage.usage,
+                                               buffer->compositor);
+    }
+
   *texture = new_texture;
   buffer->is_y_inverted = TRUE;
 
@@ -685,7 +753,14 @@ meta_wayland_buffer_dec_use_count (MetaWaylandBuffer *buffer)
 
   buffer->use_count--;
 
-  if (buffer->use_count == 0 && buffer->resource)
+  if (buffer->use_count > 0)
+    return;
+
+#ifdef HAVE_NATIVE_BACKEND
+  meta_wayland_drm_syncobj_release_buffer (buffer);
+#endif
+
+  if (buffer->resource)
     wl_buffer_send_release (buffer->resource);
 }
 
@@ -901,10 +976,20 @@ meta_wayland_buffer_finalize (GObject *object)
 #endif
   g_clear_pointer (&buffer->dma_buf.texture, cogl_object_unref);
   g_clear_object (&buffer->dma_buf.dma_buf);
+  g_clear_pointer (&buffer->drm_syncobj.release_points, g_ptr_array_unref);
   g_clear_pointer (&buffer->single_pixel.single_pixel_buffer,
                    meta_wayland_single_pixel_buffer_free);
   cogl_clear_object (&buffer->single_pixel.texture);
 
+  if (buffer->client_usage.usage)
+    {
+      meta_wayland_client_usage_add_memory (buffer->client_usage.usage,
+                                            buffer->client_usage.memory_type,
+                                            -(int64_t) buffer->client_usage.n_bytes);
+      g_clear_pointer (&buffer->client_usage.usage,
+                       meta_wayland_client_usage_unref);
+    }
+
   G_OBJECT_CLASS (meta_wayland_buffer_parent_class)->finalize (object);
 }
 
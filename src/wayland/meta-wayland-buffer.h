@@ -30,6 +30,7 @@
 
 #include "cogl/cogl.h"
 #include "wayland/meta-wayland-types.h"
+#include "wayland/meta-wayland-client-usage.h"
 #include "wayland/meta-wayland-egl-stream.h"
 #include "wayland/meta-wayland-dma-buf.h"
 #include "wayland/meta-wayland-single-pixel-buffer.h"
@@ -76,12 +77,22 @@ struct _MetaWaylandBuffer
     CoglTexture *texture;
   } dma_buf;
 
+  struct {
+    GPtrArray *release_points;
+  } drm_syncobj;
+
   struct {
     MetaWaylandSinglePixelBuffer *single_pixel_buffer;
     CoglTexture *texture;
   } single_pixel;
 
   GHashTable *tainted_scanout_onscreens;
+
+  struct {
+    MetaWaylandClientUsage *usage;
+    MetaWaylandClientMemoryType memory_type;
+    uint64_t n_bytes;
+  } client_usage;
 };
 
 #define META_TYPE_WAYLAND_BUFFER (meta_wayland_buffer_get_type ())
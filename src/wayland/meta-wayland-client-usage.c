@@ -0,0 +1,407 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Keeps track of the resources each Wayland client makes the compositor
+ * hold on to. Buffers and textures can outlive the client that created
+ * them, so they keep a reference to the usage they are accounted in.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-client-usage.h"
+
+#include "backends/meta-backend-private.h"
+#include "backends/meta-settings-private.h"
+#include "meta/util.h"
+#include "wayland/meta-wayland-private.h"
+
+#define META_WAYLAND_CLIENT_USAGE_DBUS_SERVICE "org.gnome.Mutter.WaylandClientUsage"
+#define META_WAYLAND_CLIENT_USAGE_DBUS_PATH "/org/gnome/Mutter/WaylandClientUsage"
+
+struct _MetaWaylandClientUsage
+{
+  struct wl_listener client_destroy_listener;
+  struct wl_client *client;
+
+  uint64_t memory[META_WAYLAND_CLIENT_N_MEMORY_TYPES];
+  unsigned int n_surfaces;
+  unsigned int n_pending_transactions;
+
+  gboolean is_disconnecting;
+};
+
+struct _MetaWaylandClientUsageService
+{
+  MetaDBusWaylandClientUsageSkeleton parent;
+
+  MetaWaylandCompositor *compositor;
+
+  guint dbus_name_id;
+};
+
+typedef struct _TextureUsage
+{
+  MetaWaylandClientUsage *usage;
+  uint64_t n_bytes;
+} TextureUsage;
+
+static CoglUserDataKey texture_usage_key;
+
+static void meta_wayland_client_usage_service_init_iface (MetaDBusWaylandClientUsageIface *iface);
+
+G_DEFINE_TYPE_WITH_CODE (MetaWaylandClientUsageService,
+                         meta_wayland_client_usage_service,
+                         META_DBUS_TYPE_WAYLAND_CLIENT_USAGE_SKELETON,
+                         G_IMPLEMENT_INTERFACE (META_DBUS_TYPE_WAYLAND_CLIENT_USAGE,
+                                                meta_wayland_client_usage_service_init_iface))
+
+static void
+client_destroyed (struct wl_listener *listener,
+                  void               *data)
+{
+  MetaWaylandClientUsage *usage =
+    wl_container_of (listener, usage, client_destroy_listener);
+
+  wl_list_remove (&usage->client_destroy_listener.link);
+  usage->client = NULL;
+  meta_wayland_client_usage_unref (usage);
+}
+
+MetaWaylandClientUsage *
+meta_wayland_client_usage_lookup (struct wl_client *client)
+{
+  MetaWaylandClientUsage *usage;
+  struct wl_listener *listener;
+
+  listener = wl_client_get_destroy_listener (client, client_destroyed);
+  if (!listener)
+    return NULL;
+
+  return wl_container_of (listener, usage, client_destroy_listener);
+}
+
+MetaWaylandClientUsage *
+meta_wayland_client_usage_ensure (struct wl_client *client)
+{
+  MetaWaylandClientUsage *usage;
+
+  usage = meta_wayland_client_usage_lookup (client);
+  if (usage)
+    return usage;
+
+  usage = g_rc_box_new0 (MetaWaylandClientUsage);
+  usage->client = client;
+  usage->client_destroy_listener.notify = client_destroyed;
+  wl_client_add_destroy_listener (client, &usage->client_destroy_listener);
+
+  return usage;
+}
+
+MetaWaylandClientUsage *
+meta_wayland_client_usage_ref (MetaWaylandClientUsage *usage)
+{
+  return g_rc_box_acquire (usage);
+}
+
+void
+meta_wayland_client_usage_unref (MetaWaylandClientUsage *usage)
+{
+  g_rc_box_release (usage);
+}
+
+void
+meta_wayland_client_usage_add_memory (MetaWaylandClientUsage      *usage,
+                                      MetaWaylandClientMemoryType  memory_type,
+                                      int64_t                      n_bytes)
+{
+  g_return_if_fail (n_bytes >= 0 ||
+                    usage->memory[memory_type] >= (uint64_t) -n_bytes);
+
+  usage->memory[memory_type] += n_bytes;
+}
+
+static void
+texture_usage_free (void *user_data)
+{
+  TextureUsage *texture_usage = user_data;
+
+  meta_wayland_client_usage_add_memory (texture_usage->usage,
+                                        META_WAYLAND_CLIENT_MEMORY_TYPE_TEXTURE,
+                                        -(int64_t) texture_usage->n_bytes);
+  meta_wayland_client_usage_unref (texture_usage->usage);
+  g_free (texture_usage);
+}
+
+/*
+ * Accounts @n_bytes of texture memory to @usage for as long as @texture is
+ * alive, which may be longer than the buffer it was uploaded from.
+ */
+void
+meta_wayland_client_usage_track_texture (MetaWaylandClientUsage *usage,
+                                         CoglTexture            *texture,
+                                         uint64_t                n_bytes)
+{
+  TextureUsage *texture_usage;
+
+  texture_usage = g_new0 (TextureUsage, 1);
+  texture_usage->usage = meta_wayland_client_usage_ref (usage);
+  texture_usage->n_bytes = n_bytes;
+
+  meta_wayland_client_usage_add_memory (usage,
+                                        META_WAYLAND_CLIENT_MEMORY_TYPE_TEXTURE,
+                                        n_bytes);
+  cogl_object_set_user_data (COGL_OBJECT (texture),
+                             &texture_usage_key,
+                             texture_usage,
+                             texture_usage_free);
+}
+
+void
+meta_wayland_client_usage_add_surfaces (MetaWaylandClientUsage *usage,
+                                        int                     n_surfaces)
+{
+  g_return_if_fail (n_surfaces >= 0 ||
+                    usage->n_surfaces >= (unsigned int) -n_surfaces);
+
+  usage->n_surfaces += n_surfaces;
+}
+
+void
+meta_wayland_client_usage_add_pending_transactions (MetaWaylandClientUsage *usage,
+                                                    int                     n_transactions)
+{
+  g_return_if_fail (n_transactions >= 0 ||
+                    usage->n_pending_transactions >= (unsigned int) -n_transactions);
+
+  usage->n_pending_transactions += n_transactions;
+}
+
+static uint64_t
+get_total_memory (MetaWaylandClientUsage *usage)
+{
+  uint64_t total = 0;
+  int i;
+
+  for (i = 0; i < META_WAYLAND_CLIENT_N_MEMORY_TYPES; i++)
+    total += usage->memory[i];
+
+  return total;
+}
+
+/**
+ * meta_wayland_client_usage_enforce_limit:
+ * @usage: A #MetaWaylandClientUsage
+ * @compositor: The #MetaWaylandCompositor
+ *
+ * Disconnects the client if it exceeds the configured memory limit.
+ *
+ * Returns: %FALSE if the client is being disconnected
+ */
+gboolean
+meta_wayland_client_usage_enforce_limit (MetaWaylandClientUsage *usage,
+                                         MetaWaylandCompositor  *compositor)
+{
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+  uint64_t limit;
+  uint64_t total;
+  pid_t pid = 0;
+
+  if (usage->is_disconnecting)
+    return FALSE;
+
+  if (!usage->client)
+    return TRUE;
+
+  limit = meta_settings_get_wayland_client_memory_limit (settings);
+  if (limit == 0)
+    return TRUE;
+
+  total = get_total_memory (usage);
+  if (total <= limit)
+    return TRUE;
+
+  wl_client_get_credentials (usage->client, &pid, NULL, NULL);
+  g_warning ("Disconnecting Wayland client (pid %d) using %" G_GUINT64_FORMAT
+             " bytes of memory, exceeding the limit of %" G_GUINT64_FORMAT
+             " bytes", (int) pid, total, limit);
+
+  usage->is_disconnecting = TRUE;
+  wl_client_post_no_memory (usage->client);
+  return FALSE;
+}
+
+uint64_t
+meta_wayland_client_usage_get_memory (MetaWaylandClientUsage      *usage,
+                                      MetaWaylandClientMemoryType  memory_type)
+{
+  return usage->memory[memory_type];
+}
+
+unsigned int
+meta_wayland_client_usage_get_n_surfaces (MetaWaylandClientUsage *usage)
+{
+  return usage->n_surfaces;
+}
+
+unsigned int
+meta_wayland_client_usage_get_n_pending_transactions (MetaWaylandClientUsage *usage)
+{
+  return usage->n_pending_transactions;
+}
+
+static GVariant *
+client_usage_to_variant (struct wl_client *client)
+{
+  MetaWaylandClientUsage *usage;
+  GVariantBuilder properties_builder;
+  pid_t pid = 0;
+
+  wl_client_get_credentials (client, &pid, NULL, NULL);
+
+  g_variant_builder_init (&properties_builder, G_VARIANT_TYPE ("a{sv}"));
+
+  usage = meta_wayland_client_usage_lookup (client);
+  if (usage)
+    {
+      g_variant_builder_add (&properties_builder, "{sv}",
+                             "shm-bytes",
+                             g_variant_new_uint64 (usage->memory[META_WAYLAND_CLIENT_MEMORY_TYPE_SHM]));
+      g_variant_builder_add (&properties_builder, "{sv}",
+                             "dma-buf-bytes",
+                             g_variant_new_uint64 (usage->memory[META_WAYLAND_CLIENT_MEMORY_TYPE_DMA_BUF]));
+      g_variant_builder_add (&properties_builder, "{sv}",
+                             "texture-bytes",
+                             g_variant_new_uint64 (usage->memory[META_WAYLAND_CLIENT_MEMORY_TYPE_TEXTURE]));
+      g_variant_builder_add (&properties_builder, "{sv}",
+                             "surfaces",
+                             g_variant_new_uint32 (usage->n_surfaces));
+      g_variant_builder_add (&properties_builder, "{sv}",
+                             "pending-transactions",
+                             g_variant_new_uint32 (usage->n_pending_transactions));
+    }
+
+  return g_variant_new ("(ia{sv})", (int32_t) pid, &properties_builder);
+}
+
+static gboolean
+handle_get_client_usage (MetaDBusWaylandClientUsage *skeleton,
+                         GDBusMethodInvocation      *invocation)
+{
+  MetaWaylandClientUsageService *service =
+    META_WAYLAND_CLIENT_USAGE_SERVICE (skeleton);
+  struct wl_list *client_list;
+  struct wl_client *client;
+  GVariantBuilder clients_builder;
+
+  g_variant_builder_init (&clients_builder, G_VARIANT_TYPE ("a(ia{sv})"));
+
+  client_list =
+    wl_display_get_client_list (service->compositor->wayland_display);
+  wl_client_for_each (client, client_list)
+    g_variant_builder_add_value (&clients_builder,
+                                 client_usage_to_variant (client));
+
+  meta_dbus_wayland_client_usage_complete_get_client_usage (
+    skeleton, invocation, g_variant_builder_end (&clients_builder));
+  return G_DBUS_METHOD_INVOCATION_HANDLED;
+}
+
+static void
+meta_wayland_client_usage_service_init_iface (MetaDBusWaylandClientUsageIface *iface)
+{
+  iface->handle_get_client_usage = handle_get_client_usage;
+}
+
+static void
+on_bus_acquired (GDBusConnection *connection,
+                 const char      *name,
+                 gpointer         user_data)
+{
+  MetaWaylandClientUsageService *service = user_data;
+  GDBusInterfaceSkeleton *interface_skeleton =
+    G_DBUS_INTERFACE_SKELETON (service);
+  g_autoptr (GError) error = NULL;
+
+  if (!g_dbus_interface_skeleton_export (interface_skeleton,
+                                         connection,
+                                         META_WAYLAND_CLIENT_USAGE_DBUS_PATH,
+                                         &error))
+    g_warning ("Failed to export client usage object: %s", error->message);
+}
+
+static void
+on_name_acquired (GDBusConnection *connection,
+                  const char      *name,
+                  gpointer         user_data)
+{
+  g_info ("Acquired name %s", name);
+}
+
+static void
+on_name_lost (GDBusConnection *connection,
+              const char      *name,
+              gpointer         user_data)
+{
+  g_warning ("Lost or failed to acquire name %s", name);
+}
+
+static void
+meta_wayland_client_usage_service_finalize (GObject *object)
+{
+  MetaWaylandClientUsageService *service =
+    META_WAYLAND_CLIENT_USAGE_SERVICE (object);
+
+  g_clear_handle_id (&service->dbus_name_id, g_bus_unown_name);
+
+  G_OBJECT_CLASS (meta_wayland_client_usage_service_parent_class)->finalize (object);
+}
+
+static void
+meta_wayland_client_usage_service_class_init (MetaWaylandClientUsageServiceClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_wayland_client_usage_service_finalize;
+}
+
+static void
+meta_wayland_client_usage_service_init (MetaWaylandClientUsageService *service)
+{
+}
+
+MetaWaylandClientUsageService *
+meta_wayland_client_usage_service_new (MetaWaylandCompositor *compositor)
+{
+  MetaWaylandClientUsageService *service;
+
+  service = g_object_new (META_TYPE_WAYLAND_CLIENT_USAGE_SERVICE, NULL);
+  service->compositor = compositor;
+  service->dbus_name_id =
+    g_bus_own_name (G_BUS_TYPE_SESSION,
+                    META_WAYLAND_CLIENT_USAGE_DBUS_SERVICE,
+                    G_BUS_NAME_OWNER_FLAGS_NONE,
+                    on_bus_acquired,
+                    on_name_acquired,
+                    on_name_lost,
+                    service,
+                    NULL);
+
+  return service;
+}
@@ -0,0 +1,87 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef META_WAYLAND_CLIENT_USAGE_H
+#define META_WAYLAND_CLIENT_USAGE_H
+
+#include <glib-object.h>
+#include <wayland-server-core.h>
+
+#include "cogl/cogl.h"
+#include "core/util-private.h"
+#include "meta-dbus-wayland-client-usage.h"
+#include "wayland/meta-wayland-types.h"
+
+typedef enum _MetaWaylandClientMemoryType
+{
+  META_WAYLAND_CLIENT_MEMORY_TYPE_SHM,
+  META_WAYLAND_CLIENT_MEMORY_TYPE_DMA_BUF,
+  META_WAYLAND_CLIENT_MEMORY_TYPE_TEXTURE,
+
+  META_WAYLAND_CLIENT_N_MEMORY_TYPES
+} MetaWaylandClientMemoryType;
+
+typedef struct _MetaWaylandClientUsage MetaWaylandClientUsage;
+
+#define META_TYPE_WAYLAND_CLIENT_USAGE_SERVICE (meta_wayland_client_usage_service_get_type ())
+G_DECLARE_FINAL_TYPE (MetaWaylandClientUsageService,
+                      meta_wayland_client_usage_service,
+                      META, WAYLAND_CLIENT_USAGE_SERVICE,
+                      MetaDBusWaylandClientUsageSkeleton)
+
+MetaWaylandClientUsage * meta_wayland_client_usage_ensure (struct wl_client *client);
+
+META_EXPORT_TEST
+MetaWaylandClientUsage * meta_wayland_client_usage_lookup (struct wl_client *client);
+
+MetaWaylandClientUsage * meta_wayland_client_usage_ref (MetaWaylandClientUsage *usage);
+
+void meta_wayland_client_usage_unref (MetaWaylandClientUsage *usage);
+
+void meta_wayland_client_usage_add_memory (MetaWaylandClientUsage      *usage,
+                                           MetaWaylandClientMemoryType  memory_type,
+                                           int64_t                      n_bytes);
+
+void meta_wayland_client_usage_track_texture (MetaWaylandClientUsage *usage,
+                                              CoglTexture            *texture,
+                                              uint64_t                n_bytes);
+
+void meta_wayland_client_usage_add_surfaces (MetaWaylandClientUsage *usage,
+                                             int                     n_surfaces);
+
+void meta_wayland_client_usage_add_pending_transactions (MetaWaylandClientUsage *usage,
+                                                         int                     n_transactions);
+
+gboolean meta_wayland_client_usage_enforce_limit (MetaWaylandClientUsage *usage,
+                                                  MetaWaylandCompositor  *compositor);
+
+META_EXPORT_TEST
+uint64_t meta_wayland_client_usage_get_memory (MetaWaylandClientUsage      *usage,
+                                               MetaWaylandClientMemoryType  memory_type);
+
+META_EXPORT_TEST
+unsigned int meta_wayland_client_usage_get_n_surfaces (MetaWaylandClientUsage *usage);
+
+META_EXPORT_TEST
+unsigned int meta_wayland_client_usage_get_n_pending_transactions (MetaWaylandClientUsage *usage);
+
+MetaWaylandClientUsageService * meta_wayland_client_usage_service_new (MetaWaylandCompositor *compositor);
+
+G_DEFINE_AUTOPTR_CLEANUP_FUNC (MetaWaylandClientUsage,
+                               meta_wayland_client_usage_unref)
+
+#endif /* META_WAYLAND_CLIENT_USAGE_H */
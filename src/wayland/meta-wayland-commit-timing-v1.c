@@ -0,0 +1,180 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-commit-timing-v1.h"
+
+#include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-surface.h"
+#include "wayland/meta-wayland-versions.h"
+
+#include "commit-timing-v1-server-protocol.h"
+
+#define NSEC_PER_USEC 1000
+#define NSEC_PER_SEC (G_USEC_PER_SEC * NSEC_PER_USEC)
+
+static void
+wp_commit_timer_destructor (struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+
+  surface = wl_resource_get_user_data (resource);
+  if (!surface)
+    return;
+
+  g_clear_signal_handler (&surface->commit_timer.destroy_handler_id,
+                          surface);
+  surface->commit_timer.resource = NULL;
+}
+
+static void
+on_surface_destroyed (MetaWaylandSurface *surface)
+{
+  wl_resource_set_user_data (surface->commit_timer.resource, NULL);
+}
+
+static void
+wp_commit_timer_set_timestamp (struct wl_client   *client,
+                               struct wl_resource *resource,
+                               uint32_t            tv_sec_hi,
+                               uint32_t            tv_sec_lo,
+                               uint32_t            tv_nsec)
+{
+  MetaWaylandSurface *surface;
+  MetaWaylandSurfaceState *pending;
+  uint64_t tv_sec;
+
+  surface = wl_resource_get_user_data (resource);
+  if (!surface)
+    {
+      wl_resource_post_error (resource,
+                              WP_COMMIT_TIMER_V1_ERROR_SURFACE_DESTROYED,
+                              "Surface of commit timer was destroyed");
+      return;
+    }
+
+  if (tv_nsec >= NSEC_PER_SEC)
+    {
+      wl_resource_post_error (resource,
+                              WP_COMMIT_TIMER_V1_ERROR_INVALID_TIMESTAMP,
+                              "Invalid timestamp, tv_nsec out of range");
+      return;
+    }
+
+  pending = meta_wayland_surface_get_pending_state (surface);
+  if (pending->target_presentation_time_us)
+    {
+      wl_resource_post_error (resource,
+                              WP_COMMIT_TIMER_V1_ERROR_TIMESTAMP_EXISTS,
+                              "Timestamp already set for this commit");
+      return;
+    }
+
+  /* Timestamps are in the presentation clock domain, CLOCK_MONOTONIC */
+  tv_sec = ((uint64_t) tv_sec_hi << 32) | tv_sec_lo;
+  pending->target_presentation_time_us =
+    MAX (1, (int64_t) (tv_sec * G_USEC_PER_SEC + tv_nsec / NSEC_PER_USEC));
+}
+
+static void
+wp_commit_timer_destroy (struct wl_client   *client,
+                         struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static const struct wp_commit_timer_v1_interface meta_wayland_commit_timer_interface = {
+  wp_commit_timer_set_timestamp,
+  wp_commit_timer_destroy,
+};
+
+static void
+wp_commit_timing_manager_destroy (struct wl_client   *client,
+                                  struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+wp_commit_timing_manager_get_timer (struct wl_client   *client,
+                                    struct wl_resource *resource,
+                                    uint32_t            id,
+                                    struct wl_resource *surface_resource)
+{
+  MetaWaylandSurface *surface;
+  struct wl_resource *commit_timer_resource;
+
+  surface = wl_resource_get_user_data (surface_resource);
+  if (surface->commit_timer.resource)
+    {
+      wl_resource_post_error (resource,
+                              WP_COMMIT_TIMING_MANAGER_V1_ERROR_COMMIT_TIMER_EXISTS,
+                              "Commit timer already exists for surface");
+      return;
+    }
+
+  commit_timer_resource = wl_resource_create (client,
+                                              &wp_commit_timer_v1_interface,
+                                              wl_resource_get_version (resource),
+                                              id);
+  wl_resource_set_implementation (commit_timer_resource,
+                                  &meta_wayland_commit_timer_interface,
+                                  surface,
+                                  wp_commit_timer_destructor);
+
+  surface->commit_timer.resource = commit_timer_resource;
+  surface->commit_timer.destroy_handler_id =
+    g_signal_connect (surface,
+                      "destroy",
+                      G_CALLBACK (on_surface_destroyed),
+                      NULL);
+}
+
+static const struct wp_commit_timing_manager_v1_interface meta_wayland_commit_timing_manager_interface = {
+  wp_commit_timing_manager_destroy,
+  wp_commit_timing_manager_get_timer,
+};
+
+static void
+wp_commit_timing_bind (struct wl_client *client,
+                       void             *data,
+                       uint32_t          version,
+                       uint32_t          id)
+{
+  struct wl_resource *resource;
+
+  resource = wl_resource_create (client,
+                                 &wp_commit_timing_manager_v1_interface,
+                                 version,
+                                 id);
+  wl_resource_set_implementation (resource,
+                                  &meta_wayland_commit_timing_manager_interface,
+                                  data,
+                                  NULL);
+}
+
+void
+meta_wayland_init_commit_timing_v1 (MetaWaylandCompositor *compositor)
+{
+  if (wl_global_create (compositor->wayland_display,
+                        &wp_commit_timing_manager_v1_interface,
+                        META_WP_COMMIT_TIMING_V1_VERSION,
+                        compositor,
+                        wp_commit_timing_bind) == NULL)
+    g_error ("Failed to register a global wp_commit_timing_manager_v1 object");
+}
@@ -0,0 +1,25 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef META_WAYLAND_COMMIT_TIMING_V1_H
+#define META_WAYLAND_COMMIT_TIMING_V1_H
+
+#include "wayland/meta-wayland-types.h"
+
+void meta_wayland_init_commit_timing_v1 (MetaWaylandCompositor *compositor);
+
+#endif /* META_WAYLAND_COMMIT_TIMING_V1_H */
@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Keeps track of how long each client takes from being sent a frame
+ * callback until the content it commits in response is ready to be
+ * shown, i.e. until the corresponding state is applied.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-commit-timing.h"
+
+#include "meta/util.h"
+
+#define N_SAMPLES 32
+#define MIN_SAMPLES_FOR_ESTIMATE 4
+
+/* Anything slower than this is a client that didn't draw right away,
+ * not one that took long to draw */
+#define MAX_COMMIT_TIME_US (G_USEC_PER_SEC / 10)
+
+struct _MetaWaylandCommitTiming
+{
+  struct wl_listener client_destroy_listener;
+
+  int64_t samples_us[N_SAMPLES];
+  int next_sample;
+
+  uint64_t n_samples;
+  int64_t total_commit_time_us;
+  int64_t max_commit_time_us;
+};
+
+static void
+client_destroyed (struct wl_listener *listener,
+                  void               *data)
+{
+  MetaWaylandCommitTiming *timing =
+    wl_container_of (listener, timing, client_destroy_listener);
+
+  if (timing->n_samples > 0)
+    {
+      meta_topic (META_DEBUG_WAYLAND,
+                  "Client %p commit timing: %" G_GUINT64_FORMAT " samples, "
+                  "average %" G_GINT64_FORMAT " us, "
+                  "max %" G_GINT64_FORMAT " us",
+                  data,
+                  timing->n_samples,
+                  meta_wayland_commit_timing_get_average (timing),
+                  timing->max_commit_time_us);
+    }
+
+  wl_list_remove (&timing->client_destroy_listener.link);
+  g_free (timing);
+}
+
+MetaWaylandCommitTiming *
+meta_wayland_commit_timing_lookup (struct wl_client *client)
+{
+  MetaWaylandCommitTiming *timing;
+  struct wl_listener *listener;
+
+  listener = wl_client_get_destroy_listener (client, client_destroyed);
+  if (!listener)
+    return NULL;
+
+  return wl_container_of (listener, timing, client_destroy_listener);
+}
+
+MetaWaylandCommitTiming *
+meta_wayland_commit_timing_ensure (struct wl_client *client)
+{
+  MetaWaylandCommitTiming *timing;
+
+  timing = meta_wayland_commit_timing_lookup (client);
+  if (timing)
+    return timing;
+
+  timing = g_new0 (MetaWaylandCommitTiming, 1);
+  timing->client_destroy_listener.notify = client_destroyed;
+  wl_client_add_destroy_listener (client, &timing->client_destroy_listener);
+
+  return timing;
+}
+
+void
+meta_wayland_commit_timing_record (MetaWaylandCommitTiming *timing,
+                                   int64_t                  commit_time_us)
+{
+  if (commit_time_us < 0 || commit_time_us > MAX_COMMIT_TIME_US)
+    return;
+
+  timing->samples_us[timing->next_sample] = commit_time_us;
+  timing->next_sample = (timing->next_sample + 1) % N_SAMPLES;
+
+  timing->n_samples++;
+  timing->total_commit_time_us += commit_time_us;
+  timing->max_commit_time_us = MAX (timing->max_commit_time_us,
+                                    commit_time_us);
+}
+
+/* Estimates the commit time conservatively, as the worst of the most
+ * recent samples, as being late costs a whole frame. */
+gboolean
+meta_wayland_commit_timing_get_estimate (MetaWaylandCommitTiming *timing,
+                                         int64_t                 *out_commit_time_us)
+{
+  int64_t estimate_us = 0;
+  int n_recent_samples;
+  int i;
+
+  if (timing->n_samples < MIN_SAMPLES_FOR_ESTIMATE)
+    return FALSE;
+
+  n_recent_samples = MIN (timing->n_samples, N_SAMPLES);
+  for (i = 0; i < n_recent_samples; i++)
+    estimate_us = MAX (estimate_us, timing->samples_us[i]);
+
+  *out_commit_time_us = estimate_us;
+  return TRUE;
+}
+
+uint64_t
+meta_wayland_commit_timing_get_n_samples (MetaWaylandCommitTiming *timing)
+{
+  return timing->n_samples;
+}
+
+int64_t
+meta_wayland_commit_timing_get_average (MetaWaylandCommitTiming *timing)
+{
+  if (timing->n_samples == 0)
+    return 0;
+
+  return timing->total_commit_time_us / (int64_t) timing->n_samples;
+}
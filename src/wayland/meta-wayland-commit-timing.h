@@ -0,0 +1,50 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef META_WAYLAND_COMMIT_TIMING_H
+#define META_WAYLAND_COMMIT_TIMING_H
+
+#include <glib.h>
+#include <wayland-server-core.h>
+
+#include "core/util-private.h"
+
+/* Margin for the frame callback handling and wake-up latency of clients
+ * getting predictive frame callbacks */
+#define PREDICTIVE_FRAME_CALLBACK_SLACK_US 1000
+
+typedef struct _MetaWaylandCommitTiming MetaWaylandCommitTiming;
+
+MetaWaylandCommitTiming * meta_wayland_commit_timing_ensure (struct wl_client *client);
+
+META_EXPORT_TEST
+MetaWaylandCommitTiming * meta_wayland_commit_timing_lookup (struct wl_client *client);
+
+void meta_wayland_commit_timing_record (MetaWaylandCommitTiming *timing,
+                                        int64_t                  commit_time_us);
+
+META_EXPORT_TEST
+gboolean meta_wayland_commit_timing_get_estimate (MetaWaylandCommitTiming *timing,
+                                                  int64_t                 *out_commit_time_us);
+
+META_EXPORT_TEST
+uint64_t meta_wayland_commit_timing_get_n_samples (MetaWaylandCommitTiming *timing);
+
+META_EXPORT_TEST
+int64_t meta_wayland_commit_timing_get_average (MetaWaylandCommitTiming *timing);
+
+#endif /* META_WAYLAND_COMMIT_TIMING_H */
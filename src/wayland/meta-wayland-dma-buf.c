@@ -40,7 +40,12 @@
 #include "wayland/meta-wayland-dma-buf.h"
 
 #include <drm_fourcc.h>
+#include <errno.h>
+#include <gio/gio.h>
 #include <glib/gstdio.h>
+#include <linux/dma-buf.h>
+#include <linux/sync_file.h>
+#include <sys/ioctl.h>
 #include <sys/stat.h>
 #include <sys/types.h>
 #include <unistd.h>
@@ -65,6 +70,18 @@
 
 #include "linux-dmabuf-unstable-v1-server-protocol.h"
 
+/* added in Linux 6.0 */
+#ifndef DMA_BUF_IOCTL_EXPORT_SYNC_FILE
+struct dma_buf_export_sync_file
+{
+  __u32 flags;
+  __s32 fd;
+};
+
+#define DMA_BUF_IOCTL_EXPORT_SYNC_FILE \
+  _IOWR (DMA_BUF_BASE, 2, struct dma_buf_export_sync_file)
+#endif
+
 #ifndef DRM_FORMAT_MOD_INVALID
 #define DRM_FORMAT_MOD_INVALID ((1ULL << 56) - 1)
 #endif
@@ -934,6 +951,143 @@ meta_wayland_dma_buf_create_source (MetaWaylandBuffer               *buffer,
   return &source->base;
 }
 
+static int
+merge_sync_files (int      fd1,
+                  int      fd2,
+                  GError **error)
+{
+  struct sync_merge_data merge_data = {
+    .name = "mutter dma-buf fences",
+    .fd2 = fd2,
+  };
+
+  if (ioctl (fd1, SYNC_IOC_MERGE, &merge_data) != 0)
+    {
+      g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                   "Failed to merge sync files: %s", g_strerror (errno));
+      return -1;
+    }
+
+  return merge_data.fence;
+}
+
+/**
+ * meta_wayland_dma_buf_get_n_bytes:
+ * @dma_buf: A #MetaWaylandDmaBufBuffer
+ *
+ * Returns: The size of the distinct dma-bufs backing the planes of @dma_buf
+ */
+uint64_t
+meta_wayland_dma_buf_get_n_bytes (MetaWaylandDmaBufBuffer *dma_buf)
+{
+  ino_t inodes[META_WAYLAND_DMA_BUF_MAX_FDS];
+  int n_inodes = 0;
+  uint64_t n_bytes = 0;
+  int i;
+
+  for (i = 0; i < META_WAYLAND_DMA_BUF_MAX_FDS; i++)
+    {
+      struct stat stat_buf;
+      off_t size;
+      int j;
+
+      if (dma_buf->fds[i] < 0)
+        continue;
+
+      /* Planes commonly share the same dma-buf */
+      if (fstat (dma_buf->fds[i], &stat_buf) != 0)
+        continue;
+
+      for (j = 0; j < n_inodes; j++)
+        {
+          if (inodes[j] == stat_buf.st_ino)
+            break;
+        }
+      if (j < n_inodes)
+        continue;
+
+      inodes[n_inodes++] = stat_buf.st_ino;
+
+      size = lseek (dma_buf->fds[i], 0, SEEK_END);
+      if (size > 0)
+        n_bytes += size;
+    }
+
+  return n_bytes;
+}
+
+/**
+ * meta_wayland_dma_buf_export_sync_file:
+ * @buffer: A #MetaWaylandBuffer object
+ * @error: Return location for error
+ *
+ * Exports the implicit fences of all dma-buf planes of the buffer that a
+ * writer would have to wait for, i.e. including those of pending reads.
+ *
+ * Returns: A sync_file file descriptor, or -1 on failure
+ */
+int
+meta_wayland_dma_buf_export_sync_file (MetaWaylandBuffer  *buffer,
+                                       GError            **error)
+{
+  MetaWaylandDmaBufBuffer *dma_buf;
+  int sync_fd = -1;
+  uint32_t i;
+
+  dma_buf = meta_wayland_dma_buf_from_buffer (buffer);
+  if (!dma_buf)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Not a dma-buf buffer");
+      return -1;
+    }
+
+  for (i = 0; i < META_WAYLAND_DMA_BUF_MAX_FDS; i++)
+    {
+      struct dma_buf_export_sync_file export_data = {
+        .flags = DMA_BUF_SYNC_WRITE,
+        .fd = -1,
+      };
+      int merged_fd;
+
+      if (dma_buf->fds[i] < 0)
+        break;
+
+      if (ioctl (dma_buf->fds[i], DMA_BUF_IOCTL_EXPORT_SYNC_FILE,
+                 &export_data) != 0)
+        {
+          g_set_error (error, G_IO_ERROR, g_io_error_from_errno (errno),
+                       "Failed to export dma-buf fences: %s",
+                       g_strerror (errno));
+          if (sync_fd >= 0)
+            close (sync_fd);
+          return -1;
+        }
+
+      if (sync_fd < 0)
+        {
+          sync_fd = export_data.fd;
+          continue;
+        }
+
+      merged_fd = merge_sync_files (sync_fd, export_data.fd, error);
+      close (sync_fd);
+      close (export_data.fd);
+      if (merged_fd < 0)
+        return -1;
+
+      sync_fd = merged_fd;
+    }
+
+  if (sync_fd < 0)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_FAILED,
+                   "Buffer has no dma-buf planes");
+    }
+
+  return sync_fd;
+}
+
 static void
 buffer_params_create_common (struct wl_client   *client,
                              struct wl_resource *params_resource,
@@ -65,6 +65,13 @@ meta_wayland_dma_buf_create_source (MetaWaylandBuffer               *buffer,
                                     MetaWaylandDmaBufSourceDispatch  dispatch,
                                     gpointer                         user_data);
 
+uint64_t
+meta_wayland_dma_buf_get_n_bytes (MetaWaylandDmaBufBuffer *dma_buf);
+
+int
+meta_wayland_dma_buf_export_sync_file (MetaWaylandBuffer  *buffer,
+                                       GError            **error);
+
 CoglScanout *
 meta_wayland_dma_buf_try_acquire_scanout (MetaWaylandDmaBufBuffer *dma_buf,
                                           CoglOnscreen            *onscreen);
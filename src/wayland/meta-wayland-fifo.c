@@ -0,0 +1,261 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-fifo.h"
+
+#include "compositor/meta-surface-actor-wayland.h"
+#include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-surface.h"
+#include "wayland/meta-wayland-versions.h"
+
+#include "fifo-v1-server-protocol.h"
+
+static void
+wp_fifo_destructor (struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+
+  surface = wl_resource_get_user_data (resource);
+  if (!surface)
+    return;
+
+  g_clear_signal_handler (&surface->fifo.destroy_handler_id, surface);
+  surface->fifo.resource = NULL;
+}
+
+static void
+on_surface_destroyed (MetaWaylandSurface *surface)
+{
+  wl_resource_set_user_data (surface->fifo.resource, NULL);
+}
+
+static MetaWaylandSurface *
+get_fifo_surface (struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+
+  surface = wl_resource_get_user_data (resource);
+  if (!surface)
+    {
+      wl_resource_post_error (resource,
+                              WP_FIFO_V1_ERROR_SURFACE_DESTROYED,
+                              "Surface of fifo object was destroyed");
+      return NULL;
+    }
+
+  return surface;
+}
+
+static void
+wp_fifo_set_barrier (struct wl_client   *client,
+                     struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+  MetaWaylandSurfaceState *pending;
+
+  surface = get_fifo_surface (resource);
+  if (!surface)
+    return;
+
+  pending = meta_wayland_surface_get_pending_state (surface);
+  pending->fifo_barrier = TRUE;
+}
+
+static void
+wp_fifo_wait_barrier (struct wl_client   *client,
+                      struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+  MetaWaylandSurfaceState *pending;
+
+  surface = get_fifo_surface (resource);
+  if (!surface)
+    return;
+
+  pending = meta_wayland_surface_get_pending_state (surface);
+  pending->fifo_wait = TRUE;
+}
+
+static void
+wp_fifo_destroy (struct wl_client   *client,
+                 struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static const struct wp_fifo_v1_interface meta_wayland_fifo_interface = {
+  wp_fifo_set_barrier,
+  wp_fifo_wait_barrier,
+  wp_fifo_destroy,
+};
+
+static void
+wp_fifo_manager_destroy (struct wl_client   *client,
+                         struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+wp_fifo_manager_get_fifo (struct wl_client   *client,
+                          struct wl_resource *resource,
+                          uint32_t            id,
+                          struct wl_resource *surface_resource)
+{
+  MetaWaylandSurface *surface;
+  struct wl_resource *fifo_resource;
+
+  surface = wl_resource_get_user_data (surface_resource);
+  if (surface->fifo.resource)
+    {
+      wl_resource_post_error (resource,
+                              WP_FIFO_MANAGER_V1_ERROR_ALREADY_EXISTS,
+                              "Fifo object already exists for surface");
+      return;
+    }
+
+  fifo_resource = wl_resource_create (client,
+                                      &wp_fifo_v1_interface,
+                                      wl_resource_get_version (resource),
+                                      id);
+  wl_resource_set_implementation (fifo_resource,
+                                  &meta_wayland_fifo_interface,
+                                  surface,
+                                  wp_fifo_destructor);
+
+  surface->fifo.resource = fifo_resource;
+  surface->fifo.destroy_handler_id =
+    g_signal_connect (surface,
+                      "destroy",
+                      G_CALLBACK (on_surface_destroyed),
+                      NULL);
+}
+
+static const struct wp_fifo_manager_v1_interface meta_wayland_fifo_manager_interface = {
+  wp_fifo_manager_destroy,
+  wp_fifo_manager_get_fifo,
+};
+
+static void
+wp_fifo_bind (struct wl_client *client,
+              void             *data,
+              uint32_t          version,
+              uint32_t          id)
+{
+  struct wl_resource *resource;
+
+  resource = wl_resource_create (client,
+                                 &wp_fifo_manager_v1_interface,
+                                 version,
+                                 id);
+  wl_resource_set_implementation (resource,
+                                  &meta_wayland_fifo_manager_interface,
+                                  data,
+                                  NULL);
+}
+
+void
+meta_wayland_init_fifo (MetaWaylandCompositor *compositor)
+{
+  if (wl_global_create (compositor->wayland_display,
+                        &wp_fifo_manager_v1_interface,
+                        META_WP_FIFO_V1_VERSION,
+                        compositor,
+                        wp_fifo_bind) == NULL)
+    g_error ("Failed to register a global wp_fifo_manager_v1 object");
+}
+
+void
+meta_wayland_fifo_set_barrier (MetaWaylandSurface *surface)
+{
+  MetaWaylandCompositor *compositor = surface->compositor;
+
+  if (surface->fifo.barrier_set)
+    return;
+
+  surface->fifo.barrier_set = TRUE;
+  compositor->deferred_transactions.fifo_barrier_surfaces =
+    g_list_prepend (compositor->deferred_transactions.fifo_barrier_surfaces,
+                    surface);
+}
+
+void
+meta_wayland_fifo_clear_barrier (MetaWaylandSurface *surface)
+{
+  MetaWaylandCompositor *compositor = surface->compositor;
+
+  if (!surface->fifo.barrier_set)
+    return;
+
+  surface->fifo.barrier_set = FALSE;
+  compositor->deferred_transactions.fifo_barrier_surfaces =
+    g_list_remove (compositor->deferred_transactions.fifo_barrier_surfaces,
+                   surface);
+}
+
+static gboolean
+is_barrier_picked_up (MetaWaylandSurface *surface,
+                      ClutterStageView   *stage_view)
+{
+  MetaSurfaceActor *actor;
+
+  if (!stage_view)
+    return TRUE;
+
+  /* Content nothing shows can't hold anything up */
+  actor = meta_wayland_surface_get_actor (surface);
+  if (!actor || meta_surface_actor_wayland_is_hidden (actor))
+    return TRUE;
+
+  return meta_surface_actor_wayland_is_view_primary (actor, stage_view);
+}
+
+/*
+ * Clears the barriers of the surfaces whose content has been picked up
+ * by an update of @stage_view, i.e. of those it is the primary view of,
+ * or of all surfaces if @stage_view is NULL. Returns whether any barrier
+ * was cleared.
+ */
+gboolean
+meta_wayland_fifo_clear_barriers (MetaWaylandCompositor *compositor,
+                                  ClutterStageView      *stage_view)
+{
+  GList *l;
+  gboolean cleared = FALSE;
+
+  l = compositor->deferred_transactions.fifo_barrier_surfaces;
+  while (l)
+    {
+      GList *l_cur = l;
+      MetaWaylandSurface *surface = l->data;
+
+      l = l->next;
+
+      if (!is_barrier_picked_up (surface, stage_view))
+        continue;
+
+      surface->fifo.barrier_set = FALSE;
+      compositor->deferred_transactions.fifo_barrier_surfaces =
+        g_list_delete_link (compositor->deferred_transactions.fifo_barrier_surfaces,
+                            l_cur);
+      cleared = TRUE;
+    }
+
+  return cleared;
+}
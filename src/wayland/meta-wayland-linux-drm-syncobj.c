@@ -0,0 +1,638 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+/*
+ * Explicit synchronization of Wayland buffers through DRM timeline syncobjs.
+ *
+ * A client attaching a buffer to a surface that has explicit sync enabled
+ * also provides an acquire point, signaled once the client is done
+ * rendering into the buffer, and a release point, which the compositor
+ * signals once it is done accessing the buffer. Content updates are held in
+ * their transaction until their acquire point is signaled, instead of
+ * waiting for the implicit fences of the dma-buf.
+ */
+
+#include "config.h"
+
+#include "wayland/meta-wayland-linux-drm-syncobj.h"
+
+#include <gio/gio.h>
+#include <unistd.h>
+#include <xf86drm.h>
+
+#include "backends/native/meta-device-pool.h"
+#include "backends/native/meta-renderer-native.h"
+#include "meta/util.h"
+#include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-private.h"
+#include "wayland/meta-wayland-surface.h"
+#include "wayland/meta-wayland-versions.h"
+
+#include "linux-drm-syncobj-v1-server-protocol.h"
+
+struct _MetaWaylandDrmSyncobjManager
+{
+  GObject parent;
+
+  MetaWaylandCompositor *compositor;
+  MetaDeviceFile *device_file;
+};
+
+G_DEFINE_TYPE (MetaWaylandDrmSyncobjManager, meta_wayland_drm_syncobj_manager,
+               G_TYPE_OBJECT)
+
+typedef struct _MetaWaylandDrmSyncobjSource
+{
+  GSource base;
+
+  MetaWaylandDmaBufSourceDispatch dispatch;
+  MetaWaylandBuffer *buffer;
+  gpointer user_data;
+
+  int fd;
+  gpointer fd_tag;
+} MetaWaylandDrmSyncobjSource;
+
+void
+meta_wayland_sync_point_free (MetaWaylandSyncPoint *sync_point)
+{
+  g_clear_object (&sync_point->timeline);
+  g_free (sync_point);
+}
+
+static void
+set_sync_point (MetaWaylandSyncPoint **sync_point_ptr,
+                struct wl_resource    *timeline_resource,
+                uint32_t               point_hi,
+                uint32_t               point_lo)
+{
+  MetaDrmTimeline *timeline = wl_resource_get_user_data (timeline_resource);
+  MetaWaylandSyncPoint *sync_point;
+
+  g_clear_pointer (sync_point_ptr, meta_wayland_sync_point_free);
+
+  sync_point = g_new0 (MetaWaylandSyncPoint, 1);
+  sync_point->timeline = g_object_ref (timeline);
+  sync_point->sync_point = (uint64_t) point_hi << 32 | point_lo;
+  *sync_point_ptr = sync_point;
+}
+
+static void
+drm_syncobj_timeline_destroy (struct wl_client   *client,
+                              struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static const struct wp_linux_drm_syncobj_timeline_v1_interface
+  drm_syncobj_timeline_implementation = {
+  drm_syncobj_timeline_destroy,
+};
+
+static void
+drm_syncobj_timeline_destructor (struct wl_resource *resource)
+{
+  MetaDrmTimeline *timeline = wl_resource_get_user_data (resource);
+
+  g_object_unref (timeline);
+}
+
+static void
+drm_syncobj_surface_destructor (struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+
+  surface = wl_resource_get_user_data (resource);
+  if (!surface)
+    return;
+
+  g_clear_signal_handler (&surface->drm_syncobj.destroy_handler_id, surface);
+  surface->drm_syncobj.resource = NULL;
+}
+
+static void
+on_surface_destroyed (MetaWaylandSurface *surface)
+{
+  wl_resource_set_user_data (surface->drm_syncobj.resource, NULL);
+}
+
+static MetaWaylandSurface *
+get_drm_syncobj_surface (struct wl_resource *resource)
+{
+  MetaWaylandSurface *surface;
+
+  surface = wl_resource_get_user_data (resource);
+  if (!surface)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_SURFACE,
+                              "Surface of syncobj surface object was destroyed");
+      return NULL;
+    }
+
+  return surface;
+}
+
+static void
+drm_syncobj_surface_destroy (struct wl_client   *client,
+                             struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+drm_syncobj_surface_set_acquire_point (struct wl_client   *client,
+                                       struct wl_resource *resource,
+                                       struct wl_resource *timeline_resource,
+                                       uint32_t            point_hi,
+                                       uint32_t            point_lo)
+{
+  MetaWaylandSurface *surface;
+  MetaWaylandSurfaceState *pending;
+
+  surface = get_drm_syncobj_surface (resource);
+  if (!surface)
+    return;
+
+  pending = meta_wayland_surface_get_pending_state (surface);
+  set_sync_point (&pending->drm_syncobj.acquire,
+                  timeline_resource, point_hi, point_lo);
+}
+
+static void
+drm_syncobj_surface_set_release_point (struct wl_client   *client,
+                                       struct wl_resource *resource,
+                                       struct wl_resource *timeline_resource,
+                                       uint32_t            point_hi,
+                                       uint32_t            point_lo)
+{
+  MetaWaylandSurface *surface;
+  MetaWaylandSurfaceState *pending;
+
+  surface = get_drm_syncobj_surface (resource);
+  if (!surface)
+    return;
+
+  pending = meta_wayland_surface_get_pending_state (surface);
+  set_sync_point (&pending->drm_syncobj.release,
+                  timeline_resource, point_hi, point_lo);
+}
+
+static const struct wp_linux_drm_syncobj_surface_v1_interface
+  drm_syncobj_surface_implementation = {
+  drm_syncobj_surface_destroy,
+  drm_syncobj_surface_set_acquire_point,
+  drm_syncobj_surface_set_release_point,
+};
+
+static void
+drm_syncobj_manager_destroy (struct wl_client   *client,
+                             struct wl_resource *resource)
+{
+  wl_resource_destroy (resource);
+}
+
+static void
+drm_syncobj_manager_get_surface (struct wl_client   *client,
+                                 struct wl_resource *resource,
+                                 uint32_t            id,
+                                 struct wl_resource *surface_resource)
+{
+  MetaWaylandSurface *surface = wl_resource_get_user_data (surface_resource);
+  struct wl_resource *syncobj_surface_resource;
+
+  if (surface->drm_syncobj.resource)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_MANAGER_V1_ERROR_SURFACE_EXISTS,
+                              "Surface already has a syncobj surface object");
+      return;
+    }
+
+  syncobj_surface_resource =
+    wl_resource_create (client,
+                        &wp_linux_drm_syncobj_surface_v1_interface,
+                        wl_resource_get_version (resource),
+                        id);
+  wl_resource_set_implementation (syncobj_surface_resource,
+                                  &drm_syncobj_surface_implementation,
+                                  surface,
+                                  drm_syncobj_surface_destructor);
+
+  surface->drm_syncobj.resource = syncobj_surface_resource;
+  surface->drm_syncobj.destroy_handler_id =
+    g_signal_connect (surface,
+                      "destroy",
+                      G_CALLBACK (on_surface_destroyed),
+                      NULL);
+}
+
+static void
+drm_syncobj_manager_import_timeline (struct wl_client   *client,
+                                     struct wl_resource *resource,
+                                     uint32_t            id,
+                                     int32_t             drm_syncobj_fd)
+{
+  MetaWaylandDrmSyncobjManager *manager = wl_resource_get_user_data (resource);
+  g_autoptr (GError) error = NULL;
+  MetaDrmTimeline *timeline;
+  struct wl_resource *timeline_resource;
+
+  timeline =
+    meta_drm_timeline_import_syncobj (meta_device_file_get_fd (manager->device_file),
+                                      drm_syncobj_fd,
+                                      &error);
+  close (drm_syncobj_fd);
+
+  if (!timeline)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_MANAGER_V1_ERROR_INVALID_TIMELINE,
+                              "Failed to import DRM syncobj: %s",
+                              error->message);
+      return;
+    }
+
+  timeline_resource =
+    wl_resource_create (client,
+                        &wp_linux_drm_syncobj_timeline_v1_interface,
+                        wl_resource_get_version (resource),
+                        id);
+  wl_resource_set_implementation (timeline_resource,
+                                  &drm_syncobj_timeline_implementation,
+                                  timeline,
+                                  drm_syncobj_timeline_destructor);
+}
+
+static const struct wp_linux_drm_syncobj_manager_v1_interface
+  drm_syncobj_manager_implementation = {
+  drm_syncobj_manager_destroy,
+  drm_syncobj_manager_get_surface,
+  drm_syncobj_manager_import_timeline,
+};
+
+static void
+drm_syncobj_manager_bind (struct wl_client *client,
+                          void             *user_data,
+                          uint32_t          version,
+                          uint32_t          id)
+{
+  MetaWaylandDrmSyncobjManager *manager = user_data;
+  struct wl_resource *resource;
+
+  resource = wl_resource_create (client,
+                                 &wp_linux_drm_syncobj_manager_v1_interface,
+                                 version,
+                                 id);
+  wl_resource_set_implementation (resource,
+                                  &drm_syncobj_manager_implementation,
+                                  manager,
+                                  NULL);
+}
+
+/*
+ * Validates the explicit synchronization state of a surface commit, as
+ * mandated by the protocol. Posts an error and returns FALSE if it is
+ * invalid.
+ */
+gboolean
+meta_wayland_surface_explicit_sync_validate (MetaWaylandSurface      *surface,
+                                             MetaWaylandSurfaceState *state)
+{
+  MetaWaylandSyncPoint *acquire = state->drm_syncobj.acquire;
+  MetaWaylandSyncPoint *release = state->drm_syncobj.release;
+  struct wl_resource *resource = surface->drm_syncobj.resource;
+
+  if (!resource)
+    return TRUE;
+
+  if (!state->buffer)
+    {
+      if (acquire || release)
+        {
+          wl_resource_post_error (resource,
+                                  WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_BUFFER,
+                                  "Sync points set without a buffer");
+          return FALSE;
+        }
+
+      return TRUE;
+    }
+
+  if (!acquire)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_ACQUIRE_POINT,
+                              "Buffer committed without an acquire point");
+      return FALSE;
+    }
+
+  if (!release)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_NO_RELEASE_POINT,
+                              "Buffer committed without a release point");
+      return FALSE;
+    }
+
+  if (acquire->timeline == release->timeline &&
+      acquire->sync_point >= release->sync_point)
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_CONFLICTING_POINTS,
+                              "Release point must be later than acquire point");
+      return FALSE;
+    }
+
+  if (!meta_wayland_dma_buf_from_buffer (state->buffer))
+    {
+      wl_resource_post_error (resource,
+                              WP_LINUX_DRM_SYNCOBJ_SURFACE_V1_ERROR_UNSUPPORTED_BUFFER,
+                              "Explicit sync is only supported for dma-buf buffers");
+      return FALSE;
+    }
+
+  return TRUE;
+}
+
+void
+meta_wayland_drm_syncobj_state_merge_into (MetaWaylandSurfaceState *from,
+                                           MetaWaylandSurfaceState *to)
+{
+  if (from->drm_syncobj.acquire)
+    {
+      g_clear_pointer (&to->drm_syncobj.acquire, meta_wayland_sync_point_free);
+      to->drm_syncobj.acquire = g_steal_pointer (&from->drm_syncobj.acquire);
+    }
+
+  if (from->drm_syncobj.release)
+    {
+      g_clear_pointer (&to->drm_syncobj.release, meta_wayland_sync_point_free);
+      to->drm_syncobj.release = g_steal_pointer (&from->drm_syncobj.release);
+    }
+}
+
+void
+meta_wayland_drm_syncobj_state_clear (MetaWaylandSurfaceState *state)
+{
+  g_clear_pointer (&state->drm_syncobj.acquire, meta_wayland_sync_point_free);
+  g_clear_pointer (&state->drm_syncobj.release, meta_wayland_sync_point_free);
+}
+
+/*
+ * Hands the release point of a committed state over to the buffer, which
+ * signals it once it is no longer in use. Doing so at commit time means the
+ * release point is signaled whether the content update ends up being
+ * applied or is dropped.
+ */
+void
+meta_wayland_drm_syncobj_attach_release_point (MetaWaylandBuffer       *buffer,
+                                               MetaWaylandSurfaceState *state)
+{
+  if (!state->drm_syncobj.release)
+    return;
+
+  if (!buffer->drm_syncobj.release_points)
+    {
+      buffer->drm_syncobj.release_points =
+        g_ptr_array_new_with_free_func ((GDestroyNotify) meta_wayland_sync_point_free);
+    }
+
+  g_ptr_array_add (buffer->drm_syncobj.release_points,
+                   g_steal_pointer (&state->drm_syncobj.release));
+}
+
+/*
+ * Signals the release points of a buffer that is no longer in use. The
+ * release points are tied to the implicit fences of pending accesses, e.g.
+ * GPU reads of a texture sampling it, if they can be exported, otherwise
+ * they are signaled right away.
+ */
+void
+meta_wayland_drm_syncobj_release_buffer (MetaWaylandBuffer *buffer)
+{
+  GPtrArray *release_points = buffer->drm_syncobj.release_points;
+  g_autoptr (GError) export_error = NULL;
+  int sync_fd;
+  unsigned int i;
+
+  if (!release_points || release_points->len == 0)
+    return;
+
+  sync_fd = meta_wayland_dma_buf_export_sync_file (buffer, &export_error);
+  if (sync_fd < 0)
+    {
+      meta_topic (META_DEBUG_WAYLAND,
+                  "Signaling release points without a fence: %s",
+                  export_error->message);
+    }
+
+  for (i = 0; i < release_points->len; i++)
+    {
+      MetaWaylandSyncPoint *release = g_ptr_array_index (release_points, i);
+      g_autoptr (GError) error = NULL;
+
+      if (sync_fd >= 0 &&
+          meta_drm_timeline_set_sync_point (release->timeline,
+                                            release->sync_point,
+                                            sync_fd,
+                                            &error))
+        continue;
+
+      if (error)
+        {
+          meta_topic (META_DEBUG_WAYLAND,
+                      "Failed to set release point, signaling it: %s",
+                      error->message);
+          g_clear_error (&error);
+        }
+
+      if (!meta_drm_timeline_signal (release->timeline,
+                                     release->sync_point,
+                                     &error))
+        g_warning ("Failed to signal release point: %s", error->message);
+    }
+
+  if (sync_fd >= 0)
+    close (sync_fd);
+
+  g_ptr_array_set_size (release_points, 0);
+}
+
+static gboolean
+meta_wayland_drm_syncobj_source_dispatch (GSource     *base,
+                                          GSourceFunc  callback,
+                                          gpointer     user_data)
+{
+  MetaWaylandDrmSyncobjSource *source = (MetaWaylandDrmSyncobjSource *) base;
+
+  source->dispatch (source->buffer, source->user_data);
+
+  return G_SOURCE_REMOVE;
+}
+
+static void
+meta_wayland_drm_syncobj_source_finalize (GSource *base)
+{
+  MetaWaylandDrmSyncobjSource *source = (MetaWaylandDrmSyncobjSource *) base;
+
+  if (source->fd_tag)
+    g_source_remove_unix_fd (&source->base, source->fd_tag);
+  close (source->fd);
+  g_clear_object (&source->buffer);
+}
+
+static GSourceFuncs meta_wayland_drm_syncobj_source_funcs = {
+  .dispatch = meta_wayland_drm_syncobj_source_dispatch,
+  .finalize = meta_wayland_drm_syncobj_source_finalize,
+};
+
+/**
+ * meta_wayland_drm_syncobj_create_source:
+ * @buffer: A #MetaWaylandBuffer object
+ * @acquire: The acquire point of the buffer
+ * @dispatch: Callback
+ * @user_data: User data for the callback
+ *
+ * Creates a GSource which will call the specified dispatch callback when the
+ * acquire point has been signaled.
+ *
+ * Returns: The new GSource (or %NULL if the acquire point was signaled
+ * already, or waiting for it failed)
+ */
+GSource *
+meta_wayland_drm_syncobj_create_source (MetaWaylandBuffer               *buffer,
+                                        MetaWaylandSyncPoint            *acquire,
+                                        MetaWaylandDmaBufSourceDispatch  dispatch,
+                                        gpointer                         user_data)
+{
+  MetaWaylandDrmSyncobjSource *source;
+  g_autoptr (GError) error = NULL;
+  int fd;
+
+  if (meta_drm_timeline_is_signaled (acquire->timeline,
+                                     acquire->sync_point,
+                                     NULL))
+    return NULL;
+
+  fd = meta_drm_timeline_get_eventfd (acquire->timeline,
+                                      acquire->sync_point,
+                                      &error);
+  if (fd < 0)
+    {
+      g_warning ("Failed to wait for acquire point: %s", error->message);
+      return NULL;
+    }
+
+  source =
+    (MetaWaylandDrmSyncobjSource *) g_source_new (&meta_wayland_drm_syncobj_source_funcs,
+                                                  sizeof (*source));
+  source->buffer = g_object_ref (buffer);
+  source->dispatch = dispatch;
+  source->user_data = user_data;
+  source->fd = fd;
+  source->fd_tag = g_source_add_unix_fd (&source->base, fd, G_IO_IN);
+
+  return &source->base;
+}
+
+static void
+meta_wayland_drm_syncobj_manager_finalize (GObject *object)
+{
+  MetaWaylandDrmSyncobjManager *manager =
+    META_WAYLAND_DRM_SYNCOBJ_MANAGER (object);
+
+  g_clear_pointer (&manager->device_file, meta_device_file_release);
+
+  G_OBJECT_CLASS (meta_wayland_drm_syncobj_manager_parent_class)->finalize (object);
+}
+
+static void
+meta_wayland_drm_syncobj_manager_init (MetaWaylandDrmSyncobjManager *manager)
+{
+}
+
+static void
+meta_wayland_drm_syncobj_manager_class_init (MetaWaylandDrmSyncobjManagerClass *klass)
+{
+  GObjectClass *object_class = G_OBJECT_CLASS (klass);
+
+  object_class->finalize = meta_wayland_drm_syncobj_manager_finalize;
+}
+
+/**
+ * meta_wayland_drm_syncobj_manager_new:
+ * @compositor: A #MetaWaylandCompositor
+ * @error: Return location for error
+ *
+ * Creates the wp_linux_drm_syncobj_manager_v1 global, if the primary render
+ * device supports timeline syncobjs.
+ *
+ * Returns: (transfer full): The new #MetaWaylandDrmSyncobjManager, or %NULL
+ * with a G_IO_ERROR_NOT_SUPPORTED error if explicit sync isn't supported
+ */
+MetaWaylandDrmSyncobjManager *
+meta_wayland_drm_syncobj_manager_new (MetaWaylandCompositor  *compositor,
+                                      GError                **error)
+{
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  MetaRenderer *renderer = meta_backend_get_renderer (backend);
+  MetaRendererNative *renderer_native;
+  MetaDeviceFile *device_file;
+  MetaWaylandDrmSyncobjManager *manager;
+  uint64_t timeline_supported = 0;
+  int drm_fd;
+
+  if (!META_IS_RENDERER_NATIVE (renderer))
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Only supported with the native backend");
+      return NULL;
+    }
+
+  renderer_native = META_RENDERER_NATIVE (renderer);
+  device_file = meta_renderer_native_get_primary_device_file (renderer_native);
+  if (!device_file)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "No primary render device");
+      return NULL;
+    }
+
+  drm_fd = meta_device_file_get_fd (device_file);
+  if (drmGetCap (drm_fd, DRM_CAP_SYNCOBJ_TIMELINE, &timeline_supported) != 0 ||
+      !timeline_supported)
+    {
+      g_set_error (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED,
+                   "Render device doesn't support timeline syncobjs");
+      return NULL;
+    }
+
+  manager = g_object_new (META_TYPE_WAYLAND_DRM_SYNCOBJ_MANAGER, NULL);
+  manager->compositor = compositor;
+  manager->device_file = meta_device_file_acquire (device_file);
+
+  if (!wl_global_create (compositor->wayland_display,
+                         &wp_linux_drm_syncobj_manager_v1_interface,
+                         META_WP_LINUX_DRM_SYNCOBJ_V1_VERSION,
+                         manager,
+                         drm_syncobj_manager_bind))
+    g_error ("Failed to register a global wp_linux_drm_syncobj_manager_v1 object");
+
+  return manager;
+}
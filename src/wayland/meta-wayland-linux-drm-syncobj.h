@@ -0,0 +1,62 @@
+/*
+ * Copyright (C) 2026 agent <agent@local>
+ *
+ * This program is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU General Public License as
+ * published by the Free Software Foundation; either version 2 of the
+ * License, or (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program; if not, see <http://www.gnu.org/licenses/>.
+ */
+
+#ifndef META_WAYLAND_LINUX_DRM_SYNCOBJ_H
+#define META_WAYLAND_LINUX_DRM_SYNCOBJ_H
+
+#include <glib-object.h>
+#include <stdint.h>
+
+#include "wayland/meta-drm-timeline.h"
+#include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-types.h"
+
+#define META_TYPE_WAYLAND_DRM_SYNCOBJ_MANAGER (meta_wayland_drm_syncobj_manager_get_type ())
+G_DECLARE_FINAL_TYPE (MetaWaylandDrmSyncobjManager,
+                      meta_wayland_drm_syncobj_manager,
+                      META, WAYLAND_DRM_SYNCOBJ_MANAGER, GObject)
+
+struct _MetaWaylandSyncPoint
+{
+  MetaDrmTimeline *timeline;
+  uint64_t sync_point;
+};
+
+MetaWaylandDrmSyncobjManager * meta_wayland_drm_syncobj_manager_new (MetaWaylandCompositor  *compositor,
+                                                                     GError                **error);
+
+void meta_wayland_sync_point_free (MetaWaylandSyncPoint *sync_point);
+
+gboolean meta_wayland_surface_explicit_sync_validate (MetaWaylandSurface      *surface,
+                                                      MetaWaylandSurfaceState *state);
+
+void meta_wayland_drm_syncobj_state_merge_into (MetaWaylandSurfaceState *from,
+                                                MetaWaylandSurfaceState *to);
+
+void meta_wayland_drm_syncobj_state_clear (MetaWaylandSurfaceState *state);
+
+void meta_wayland_drm_syncobj_attach_release_point (MetaWaylandBuffer       *buffer,
+                                                    MetaWaylandSurfaceState *state);
+
+void meta_wayland_drm_syncobj_release_buffer (MetaWaylandBuffer *buffer);
+
+GSource * meta_wayland_drm_syncobj_create_source (MetaWaylandBuffer               *buffer,
+                                                  MetaWaylandSyncPoint            *acquire,
+                                                  MetaWaylandDmaBufSourceDispatch  dispatch,
+                                                  gpointer                         user_data);
+
+#endif /* META_WAYLAND_LINUX_DRM_SYNCOBJ_H */
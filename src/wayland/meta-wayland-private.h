@@ -105,12 +105,27 @@ struct _MetaWaylandCompositor
 
   MetaWaylandPresentationTime presentation_time;
   MetaWaylandDmaBufManager *dma_buf_manager;
+  MetaWaylandDrmSyncobjManager *drm_syncobj_manager;
+  MetaWaylandClientUsageService *client_usage_service;
 
   /*
    * Queue of transactions which have been committed but not applied yet, in the
    * order they were committed.
    */
   GQueue committed_transactions;
+
+  /* Committed transactions with content timing constraints */
+  struct {
+    /* Latest presentation time content may currently be applied for */
+    int64_t presentation_time_us;
+    int64_t last_update_time_us;
+    guint timeout_id;
+    /* When timeout_id is due */
+    int64_t timeout_time_us;
+
+    /* Surfaces with a wp_fifo_v1 barrier set */
+    GList *fifo_barrier_surfaces;
+  } deferred_transactions;
 };
 
 #define META_TYPE_WAYLAND_COMPOSITOR (meta_wayland_compositor_get_type ())
@@ -164,6 +164,21 @@ meta_wayland_single_pixel_buffer_from_buffer (MetaWaylandBuffer *buffer)
   return NULL;
 }
 
+/*
+ * The color channels are premultiplied already, see the
+ * wp_single_pixel_buffer_manager_v1.create_u32_rgba_buffer request.
+ */
+void
+meta_wayland_single_pixel_buffer_get_color (MetaWaylandSinglePixelBuffer *single_pixel_buffer,
+                                            CoglColor                    *color)
+{
+  cogl_color_init_from_4f (color,
+                           (float) single_pixel_buffer->r / UINT32_MAX,
+                           (float) single_pixel_buffer->g / UINT32_MAX,
+                           (float) single_pixel_buffer->b / UINT32_MAX,
+                           (float) single_pixel_buffer->a / UINT32_MAX);
+}
+
 void
 meta_wayland_single_pixel_buffer_free (MetaWaylandSinglePixelBuffer *single_pixel_buffer)
 {
@@ -34,6 +34,9 @@ gboolean meta_wayland_single_pixel_buffer_attach (MetaWaylandBuffer  *buffer,
 
 MetaWaylandSinglePixelBuffer * meta_wayland_single_pixel_buffer_from_buffer (MetaWaylandBuffer *buffer);
 
+void meta_wayland_single_pixel_buffer_get_color (MetaWaylandSinglePixelBuffer *single_pixel_buffer,
+                                                 CoglColor                    *color);
+
 void meta_wayland_init_single_pixel_buffer_manager (MetaWaylandCompositor *compositor);
 
 void meta_wayland_single_pixel_buffer_free (MetaWaylandSinglePixelBuffer *single_pixel_buffer);
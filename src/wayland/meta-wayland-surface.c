@@ -38,7 +38,10 @@
 #include "core/window-private.h"
 #include "wayland/meta-wayland-actor-surface.h"
 #include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-client-usage.h"
+#include "wayland/meta-wayland-commit-timing.h"
 #include "wayland/meta-wayland-data-device.h"
+#include "wayland/meta-wayland-fifo.h"
 #include "wayland/meta-wayland-fractional-scale.h"
 #include "wayland/meta-wayland-gtk-shell.h"
 #include "wayland/meta-wayland-keyboard.h"
@@ -54,6 +57,10 @@
 #include "wayland/meta-wayland-xdg-shell.h"
 #include "wayland/meta-window-wayland.h"
 
+#ifdef HAVE_NATIVE_BACKEND
+#include "wayland/meta-wayland-linux-drm-syncobj.h"
+#endif
+
 #ifdef HAVE_XWAYLAND
 #include "wayland/meta-xwayland-private.h"
 #endif
@@ -421,6 +428,13 @@ meta_wayland_surface_state_set_default (MetaWaylandSurfaceState *state)
   wl_list_init (&state->presentation_feedback_list);
 
   state->xdg_popup_reposition_token = 0;
+
+  state->target_presentation_time_us = 0;
+  state->fifo_barrier = FALSE;
+  state->fifo_wait = FALSE;
+
+  state->drm_syncobj.acquire = NULL;
+  state->drm_syncobj.release = NULL;
 }
 
 static void
@@ -465,6 +479,10 @@ meta_wayland_surface_state_clear (MetaWaylandSurfaceState *state)
     g_slist_free_full (state->subsurface_placement_ops, g_free);
 
   meta_wayland_surface_state_discard_presentation_feedback (state);
+
+#ifdef HAVE_NATIVE_BACKEND
+  meta_wayland_drm_syncobj_state_clear (state);
+#endif
 }
 
 void
@@ -590,6 +608,19 @@ meta_wayland_surface_state_merge_into (MetaWaylandSurfaceState *from,
       from->subsurface_placement_ops = NULL;
     }
 
+  if (from->target_presentation_time_us)
+    to->target_presentation_time_us = from->target_presentation_time_us;
+
+  if (from->fifo_barrier)
+    to->fifo_barrier = TRUE;
+
+  if (from->fifo_wait)
+    to->fifo_wait = TRUE;
+
+#ifdef HAVE_NATIVE_BACKEND
+  meta_wayland_drm_syncobj_state_merge_into (from, to);
+#endif
+
   /*
    * A new commit indicates a new content update, so any previous
    * content update did not go on screen and needs to be discarded.
@@ -720,6 +751,21 @@ meta_wayland_surface_apply_state (MetaWaylandSurface      *surface,
         }
     }
 
+  if (state->newly_attached &&
+      state->buffer &&
+      surface->commit_latency.frame_callback_time_us)
+    {
+      MetaWaylandCommitTiming *timing;
+      struct wl_client *client;
+
+      client = wl_resource_get_client (surface->resource);
+      timing = meta_wayland_commit_timing_ensure (client);
+      meta_wayland_commit_timing_record (timing,
+                                         g_get_monotonic_time () -
+                                         surface->commit_latency.frame_callback_time_us);
+      surface->commit_latency.frame_callback_time_us = 0;
+    }
+
   if (state->newly_attached)
     {
       /* Always release any previously held buffer. If the buffer held is same
@@ -832,6 +878,9 @@ meta_wayland_surface_apply_state (MetaWaylandSurface      *surface,
         surface->input_region = NULL;
     }
 
+  if (state->fifo_barrier)
+    meta_wayland_fifo_set_barrier (surface);
+
   /*
    * A new commit indicates a new content update, so any previous
    * content update did not go on screen and needs to be discarded.
@@ -928,6 +977,11 @@ meta_wayland_surface_commit (MetaWaylandSurface *surface)
   COGL_TRACE_BEGIN_SCOPED (MetaWaylandSurfaceCommit,
                            "WaylandSurface (commit)");
 
+#ifdef HAVE_NATIVE_BACKEND
+  if (!meta_wayland_surface_explicit_sync_validate (surface, pending))
+    return;
+#endif
+
   if (buffer)
     {
       g_autoptr (GError) error = NULL;
@@ -955,6 +1009,10 @@ meta_wayland_surface_commit (MetaWaylandSurface *surface)
 
       g_object_ref (buffer);
       meta_wayland_buffer_inc_use_count (buffer);
+
+#ifdef HAVE_NATIVE_BACKEND
+      meta_wayland_drm_syncobj_attach_release_point (buffer, pending);
+#endif
     }
   else if (pending->newly_attached)
     {
@@ -1475,6 +1533,7 @@ meta_wayland_surface_finalize (GObject *object)
     cairo_region_destroy (surface->input_region);
 
   meta_wayland_compositor_remove_frame_callback_surface (compositor, surface);
+  meta_wayland_fifo_clear_barrier (surface);
   meta_wayland_compositor_remove_presentation_feedback_surface (compositor,
                                                                 surface);
 
@@ -1502,9 +1561,16 @@ wl_surface_destructor (struct wl_resource *resource)
 {
   MetaWaylandSurface *surface = wl_resource_get_user_data (resource);
   MetaWaylandSurface *subsurface_surface;
+  MetaWaylandClientUsage *client_usage;
 
   g_signal_emit (surface, surface_signals[SURFACE_DESTROY], 0);
 
+  /* Not found if the whole client is going away */
+  client_usage =
+    meta_wayland_client_usage_lookup (wl_resource_get_client (resource));
+  if (client_usage)
+    meta_wayland_client_usage_add_surfaces (client_usage, -1);
+
   g_clear_object (&surface->pending_state);
   g_clear_pointer (&surface->sub.transaction, meta_wayland_transaction_free);
 
@@ -1550,6 +1616,9 @@ meta_wayland_surface_create (MetaWaylandCompositor *compositor,
                                   surface,
                                   wl_surface_destructor);
 
+  meta_wayland_client_usage_add_surfaces (meta_wayland_client_usage_ensure (client),
+                                          1);
+
   wl_list_init (&surface->unassigned.pending_frame_callback_list);
 
   surface->outputs = g_hash_table_new (NULL, NULL);
@@ -137,6 +137,19 @@ struct _MetaWaylandSurfaceState
   /* xdg_popup */
   MetaWaylandXdgPositioner *xdg_positioner;
   uint32_t xdg_popup_reposition_token;
+
+  /* wp_commit_timer_v1 */
+  int64_t target_presentation_time_us;
+
+  /* wp_fifo_v1 */
+  gboolean fifo_barrier;
+  gboolean fifo_wait;
+
+  /* wp_linux_drm_syncobj_surface_v1 */
+  struct {
+    MetaWaylandSyncPoint *acquire;
+    MetaWaylandSyncPoint *release;
+  } drm_syncobj;
 };
 
 struct _MetaWaylandDragDestFuncs
@@ -241,6 +254,27 @@ struct _MetaWaylandSurface
     double scale;
   } fractional_scale;
 
+  /* wp_commit_timer_v1 */
+  struct {
+    struct wl_resource *resource;
+    gulong destroy_handler_id;
+  } commit_timer;
+
+  /* wp_fifo_v1 */
+  struct {
+    struct wl_resource *resource;
+    gulong destroy_handler_id;
+
+    /* Set when content with a barrier was applied, until it was shown */
+    gboolean barrier_set;
+  } fifo;
+
+  /* wp_linux_drm_syncobj_surface_v1 */
+  struct {
+    struct wl_resource *resource;
+    gulong destroy_handler_id;
+  } drm_syncobj;
+
   /* table of seats for which shortcuts are inhibited */
   GHashTable *shortcut_inhibited_seats;
 
@@ -263,6 +297,12 @@ struct _MetaWaylandSurface
   /* dma-buf feedback */
   MetaCrtc *scanout_candidate;
 
+  /* How long the client takes to commit after frame callbacks */
+  struct {
+    /* When frame callbacks were last sent, if no buffer was applied since */
+    int64_t frame_callback_time_us;
+  } commit_latency;
+
   /* Transactions */
   struct {
     /* First & last committed transaction which has an entry for this surface */
@@ -25,12 +25,27 @@
 
 #include <glib-unix.h>
 
+#include "meta/meta-backend.h"
 #include "wayland/meta-wayland.h"
 #include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-client-usage.h"
 #include "wayland/meta-wayland-dma-buf.h"
+#include "wayland/meta-wayland-fifo.h"
+#include "wayland/meta-wayland-private.h"
+
+#ifdef HAVE_NATIVE_BACKEND
+#include "wayland/meta-wayland-linux-drm-syncobj.h"
+#endif
 
 #define META_WAYLAND_TRANSACTION_NONE ((void *)(uintptr_t) G_MAXSIZE)
 
+/*
+ * How long before the targeted presentation time of deferred content the
+ * stage is woken up to apply it, and after how long without stage updates
+ * deferred content is applied regardless.
+ */
+#define DEFERRED_TRANSACTION_WAKEUP_US (G_USEC_PER_SEC / 30)
+
 struct _MetaWaylandTransaction
 {
   GList node;
@@ -46,6 +61,9 @@ struct _MetaWaylandTransaction
 
   /* Sources for buffers which are not ready yet */
   GHashTable *buf_sources;
+
+  /* Usage of the client that committed the transaction */
+  MetaWaylandClientUsage *client_usage;
 };
 
 struct _MetaWaylandTransactionEntry
@@ -228,21 +246,47 @@ free:
   meta_wayland_transaction_free (transaction);
 }
 
+static gboolean
+is_entry_deferred (MetaWaylandTransaction      *transaction,
+                   MetaWaylandSurface          *surface,
+                   MetaWaylandTransactionEntry *entry)
+{
+  MetaWaylandCompositor *compositor = transaction->compositor;
+  MetaWaylandSurfaceState *state = entry->state;
+
+  if (!state)
+    return FALSE;
+
+  if (state->fifo_wait && surface->fifo.barrier_set)
+    return TRUE;
+
+  if (state->target_presentation_time_us >
+      compositor->deferred_transactions.presentation_time_us)
+    return TRUE;
+
+  return FALSE;
+}
+
 static gboolean
 has_dependencies (MetaWaylandTransaction *transaction)
 {
   GHashTableIter iter;
   MetaWaylandSurface *surface;
+  MetaWaylandTransactionEntry *entry;
 
   if (transaction->buf_sources &&
       g_hash_table_size (transaction->buf_sources) > 0)
     return TRUE;
 
   g_hash_table_iter_init (&iter, transaction->entries);
-  while (g_hash_table_iter_next (&iter, (gpointer *) &surface, NULL))
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface, (gpointer *) &entry))
     {
       if (surface->transaction.first_committed != transaction)
         return TRUE;
+
+      if (is_entry_deferred (transaction, surface, entry))
+        return TRUE;
     }
 
   return FALSE;
@@ -276,6 +320,222 @@ meta_wayland_transaction_maybe_apply (MetaWaylandTransaction *transaction)
     }
 }
 
+static gboolean
+find_deferred_entries (MetaWaylandTransaction *transaction,
+                       int64_t                *inout_earliest_target_us,
+                       gboolean               *inout_has_fifo_waits)
+{
+  GHashTableIter iter;
+  MetaWaylandSurface *surface;
+  MetaWaylandTransactionEntry *entry;
+  gboolean has_deferred = FALSE;
+
+  g_hash_table_iter_init (&iter, transaction->entries);
+  while (g_hash_table_iter_next (&iter,
+                                 (gpointer *) &surface,
+                                 (gpointer *) &entry))
+    {
+      if (!is_entry_deferred (transaction, surface, entry))
+        continue;
+
+      has_deferred = TRUE;
+
+      if (entry->state->fifo_wait && surface->fifo.barrier_set)
+        *inout_has_fifo_waits = TRUE;
+      else
+        *inout_earliest_target_us =
+          MIN (*inout_earliest_target_us,
+               entry->state->target_presentation_time_us);
+    }
+
+  return has_deferred;
+}
+
+static gboolean
+find_deferred_transactions (MetaWaylandCompositor *compositor,
+                            int64_t               *out_earliest_target_us,
+                            gboolean              *out_has_fifo_waits)
+{
+  GQueue *committed_queue;
+  GList *l;
+  gboolean has_deferred = FALSE;
+
+  *out_earliest_target_us = G_MAXINT64;
+  *out_has_fifo_waits = FALSE;
+
+  committed_queue =
+    meta_wayland_compositor_get_committed_transactions (compositor);
+
+  for (l = committed_queue->head; l; l = l->next)
+    {
+      MetaWaylandTransaction *transaction = l->data;
+
+      if (find_deferred_entries (transaction,
+                                 out_earliest_target_us,
+                                 out_has_fifo_waits))
+        has_deferred = TRUE;
+    }
+
+  return has_deferred;
+}
+
+static gboolean deferred_transactions_timeout (gpointer user_data);
+
+/*
+ * Makes sure deferred content is looked at again in time for it to be
+ * applied. An already scheduled timeout that is due earlier is kept.
+ */
+static void
+schedule_deferred_transactions (MetaWaylandCompositor *compositor,
+                                int64_t                earliest_target_us,
+                                gboolean               has_fifo_waits)
+{
+  MetaBackend *backend = meta_context_get_backend (compositor->context);
+  ClutterActor *stage = meta_backend_get_stage (backend);
+  int64_t now_us;
+  int64_t timeout_us;
+
+  now_us = g_get_monotonic_time ();
+
+  /* Let the stage updates release the deferred content, as they know
+   * when it'll be presented */
+  if (has_fifo_waits ||
+      earliest_target_us - now_us < DEFERRED_TRANSACTION_WAKEUP_US)
+    {
+      clutter_stage_schedule_update (CLUTTER_STAGE (stage));
+      timeout_us = DEFERRED_TRANSACTION_WAKEUP_US;
+    }
+  else
+    {
+      timeout_us = earliest_target_us - now_us - DEFERRED_TRANSACTION_WAKEUP_US;
+      timeout_us = MAX (timeout_us, DEFERRED_TRANSACTION_WAKEUP_US);
+    }
+
+  if (compositor->deferred_transactions.timeout_id &&
+      compositor->deferred_transactions.timeout_time_us <= now_us + timeout_us)
+    return;
+
+  g_clear_handle_id (&compositor->deferred_transactions.timeout_id,
+                     g_source_remove);
+
+  compositor->deferred_transactions.timeout_time_us = now_us + timeout_us;
+  compositor->deferred_transactions.timeout_id =
+    g_timeout_add (timeout_us / 1000, deferred_transactions_timeout, compositor);
+  g_source_set_name_by_id (compositor->deferred_transactions.timeout_id,
+                           "[mutter] Deferred Wayland transactions");
+}
+
+static void
+maybe_schedule_deferred_transactions (MetaWaylandCompositor *compositor)
+{
+  int64_t earliest_target_us;
+  gboolean has_fifo_waits;
+
+  g_clear_handle_id (&compositor->deferred_transactions.timeout_id,
+                     g_source_remove);
+
+  if (!find_deferred_transactions (compositor,
+                                   &earliest_target_us,
+                                   &has_fifo_waits))
+    return;
+
+  schedule_deferred_transactions (compositor,
+                                  earliest_target_us,
+                                  has_fifo_waits);
+}
+
+static void
+apply_deferred_transactions (MetaWaylandCompositor *compositor)
+{
+  GQueue *committed_queue;
+  GList *l;
+  GList *prev = NULL;
+
+  committed_queue =
+    meta_wayland_compositor_get_committed_transactions (compositor);
+
+  l = committed_queue->head;
+  while (l)
+    {
+      MetaWaylandTransaction *transaction = l->data;
+
+      if (has_dependencies (transaction))
+        {
+          prev = l;
+          l = l->next;
+          continue;
+        }
+
+      /* Applying a transaction may apply and free later ones too, but not
+       * the ones before it, which are still waiting for something else */
+      meta_wayland_transaction_maybe_apply (transaction);
+      l = prev ? prev->next : committed_queue->head;
+    }
+
+  maybe_schedule_deferred_transactions (compositor);
+}
+
+static gboolean
+deferred_transactions_timeout (gpointer user_data)
+{
+  MetaWaylandCompositor *compositor = user_data;
+  int64_t now_us;
+
+  compositor->deferred_transactions.timeout_id = 0;
+
+  now_us = g_get_monotonic_time ();
+
+  /* The stage isn't being updated, e.g. because it is inhibited, so stop
+   * waiting for it and release what is due */
+  if (now_us - compositor->deferred_transactions.last_update_time_us >=
+      DEFERRED_TRANSACTION_WAKEUP_US)
+    {
+      compositor->deferred_transactions.presentation_time_us =
+        MAX (compositor->deferred_transactions.presentation_time_us, now_us);
+      meta_wayland_fifo_clear_barriers (compositor, NULL);
+    }
+
+  apply_deferred_transactions (compositor);
+
+  return G_SOURCE_REMOVE;
+}
+
+/*
+ * Called when a stage view is about to be updated for a frame that is
+ * expected to be presented at @presentation_time_us, to apply content
+ * that was waiting for that frame.
+ */
+void
+meta_wayland_transaction_update_presentation_time (MetaWaylandCompositor *compositor,
+                                                   int64_t                presentation_time_us)
+{
+  compositor->deferred_transactions.last_update_time_us =
+    g_get_monotonic_time ();
+
+  if (presentation_time_us <=
+      compositor->deferred_transactions.presentation_time_us)
+    return;
+
+  compositor->deferred_transactions.presentation_time_us =
+    presentation_time_us;
+
+  apply_deferred_transactions (compositor);
+}
+
+/*
+ * Called after @stage_view was updated, i.e. content with a FIFO barrier
+ * shown on it has been picked up, to apply content that was waiting for it.
+ */
+void
+meta_wayland_transaction_clear_fifo_barriers (MetaWaylandCompositor *compositor,
+                                              ClutterStageView      *stage_view)
+{
+  if (!meta_wayland_fifo_clear_barriers (compositor, stage_view))
+    return;
+
+  apply_deferred_transactions (compositor);
+}
+
 static void
 meta_wayland_transaction_dma_buf_dispatch (MetaWaylandBuffer *buffer,
                                            gpointer           user_data)
@@ -290,18 +550,35 @@ meta_wayland_transaction_dma_buf_dispatch (MetaWaylandBuffer *buffer,
 }
 
 static gboolean
-meta_wayland_transaction_add_dma_buf_source (MetaWaylandTransaction *transaction,
-                                             MetaWaylandBuffer      *buffer)
+meta_wayland_transaction_add_dma_buf_source (MetaWaylandTransaction  *transaction,
+                                             MetaWaylandSurfaceState *state)
 {
+  MetaWaylandBuffer *buffer = state->buffer;
   GSource *source;
 
   if (transaction->buf_sources &&
       g_hash_table_contains (transaction->buf_sources, buffer))
     return FALSE;
 
-  source = meta_wayland_dma_buf_create_source (buffer,
-                                               meta_wayland_transaction_dma_buf_dispatch,
-                                               transaction);
+#ifdef HAVE_NATIVE_BACKEND
+  /* With explicit sync, the acquire point replaces the implicit fences */
+  if (state->drm_syncobj.acquire)
+    {
+      source =
+        meta_wayland_drm_syncobj_create_source (buffer,
+                                                state->drm_syncobj.acquire,
+                                                meta_wayland_transaction_dma_buf_dispatch,
+                                                transaction);
+    }
+  else
+#endif
+    {
+      source =
+        meta_wayland_dma_buf_create_source (buffer,
+                                            meta_wayland_transaction_dma_buf_dispatch,
+                                            transaction);
+    }
+
   if (!source)
     return FALSE;
 
@@ -325,6 +602,8 @@ meta_wayland_transaction_commit (MetaWaylandTransaction *transaction)
   static uint64_t committed_sequence;
   GQueue *committed_queue;
   gboolean maybe_apply = TRUE;
+  int64_t earliest_target_us = G_MAXINT64;
+  gboolean has_fifo_waits = FALSE;
   GHashTableIter iter;
   MetaWaylandSurface *surface;
   MetaWaylandTransactionEntry *entry;
@@ -338,7 +617,8 @@ meta_wayland_transaction_commit (MetaWaylandTransaction *transaction)
           MetaWaylandBuffer *buffer = entry->state->buffer;
 
           if (buffer &&
-              meta_wayland_transaction_add_dma_buf_source (transaction, buffer))
+              meta_wayland_transaction_add_dma_buf_source (transaction,
+                                                           entry->state))
             maybe_apply = FALSE;
         }
     }
@@ -353,10 +633,18 @@ meta_wayland_transaction_commit (MetaWaylandTransaction *transaction)
   g_hash_table_iter_init (&iter, transaction->entries);
   while (g_hash_table_iter_next (&iter, (gpointer *) &surface, NULL))
     {
-      if (surface->transaction.first_committed)
+      if (!transaction->client_usage && surface->resource)
         {
-          MetaWaylandTransactionEntry *entry;
+          struct wl_client *client = wl_resource_get_client (surface->resource);
 
+          transaction->client_usage =
+            meta_wayland_client_usage_ref (meta_wayland_client_usage_ensure (client));
+          meta_wayland_client_usage_add_pending_transactions (transaction->client_usage,
+                                                              1);
+        }
+
+      if (surface->transaction.first_committed)
+        {
           entry = g_hash_table_lookup (surface->transaction.last_committed->entries,
                                        surface);
           entry->next_transaction = transaction;
@@ -370,8 +658,20 @@ meta_wayland_transaction_commit (MetaWaylandTransaction *transaction)
       surface->transaction.last_committed = transaction;
     }
 
-  if (maybe_apply)
-    meta_wayland_transaction_maybe_apply (transaction);
+  /* Transactions committed earlier were taken into account already, so
+   * only look at whether this one has to wait for its content to be due */
+  if (find_deferred_entries (transaction,
+                             &earliest_target_us,
+                             &has_fifo_waits))
+    {
+      schedule_deferred_transactions (transaction->compositor,
+                                      earliest_target_us,
+                                      has_fifo_waits);
+    }
+  else if (maybe_apply)
+    {
+      meta_wayland_transaction_maybe_apply (transaction);
+    }
 }
 
 MetaWaylandTransactionEntry *
@@ -584,6 +884,13 @@ meta_wayland_transaction_free (MetaWaylandTransaction *transaction)
       g_queue_unlink (committed_queue, &transaction->node);
     }
 
+  if (transaction->client_usage)
+    {
+      meta_wayland_client_usage_add_pending_transactions (transaction->client_usage,
+                                                          -1);
+      meta_wayland_client_usage_unref (transaction->client_usage);
+    }
+
   g_clear_pointer (&transaction->buf_sources, g_hash_table_destroy);
   g_hash_table_destroy (transaction->entries);
   g_free (transaction);
@@ -605,6 +912,11 @@ meta_wayland_transaction_finalize (MetaWaylandCompositor *compositor)
 
       meta_wayland_transaction_free (transaction);
     }
+
+  g_clear_handle_id (&compositor->deferred_transactions.timeout_id,
+                     g_source_remove);
+  g_clear_pointer (&compositor->deferred_transactions.fifo_barrier_surfaces,
+                   g_list_free);
 }
 
 void
@@ -52,6 +52,12 @@ MetaWaylandTransaction *meta_wayland_transaction_new (MetaWaylandCompositor *com
 
 void meta_wayland_transaction_free (MetaWaylandTransaction *transaction);
 
+void meta_wayland_transaction_update_presentation_time (MetaWaylandCompositor *compositor,
+                                                        int64_t                presentation_time_us);
+
+void meta_wayland_transaction_clear_fifo_barriers (MetaWaylandCompositor *compositor,
+                                                   ClutterStageView      *stage_view);
+
 void meta_wayland_transaction_finalize (MetaWaylandCompositor *compositor);
 
 void meta_wayland_transaction_init (MetaWaylandCompositor *compositor);
@@ -67,6 +67,12 @@ typedef struct _MetaWaylandActivation MetaWaylandActivation;
 
 typedef struct _MetaWaylandDmaBufManager MetaWaylandDmaBufManager;
 
+typedef struct _MetaWaylandDrmSyncobjManager MetaWaylandDrmSyncobjManager;
+
+typedef struct _MetaWaylandClientUsageService MetaWaylandClientUsageService;
+
+typedef struct _MetaWaylandSyncPoint MetaWaylandSyncPoint;
+
 typedef struct _MetaWaylandXdgPositioner MetaWaylandXdgPositioner;
 
 typedef struct _MetaXWaylandManager MetaXWaylandManager;
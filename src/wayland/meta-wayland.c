@@ -28,16 +28,23 @@
 #include <stdlib.h>
 #include <wayland-server.h>
 
+#include "backends/meta-backend-private.h"
+#include "backends/meta-settings-private.h"
 #include "clutter/clutter.h"
 #include "cogl/cogl-egl.h"
 #include "compositor/meta-surface-actor-wayland.h"
 #include "core/events.h"
 #include "core/meta-context-private.h"
+#include "meta/prefs.h"
 #include "wayland/meta-wayland-activation.h"
 #include "wayland/meta-wayland-buffer.h"
+#include "wayland/meta-wayland-client-usage.h"
+#include "wayland/meta-wayland-commit-timing.h"
+#include "wayland/meta-wayland-commit-timing-v1.h"
 #include "wayland/meta-wayland-data-device.h"
 #include "wayland/meta-wayland-dma-buf.h"
 #include "wayland/meta-wayland-egl-stream.h"
+#include "wayland/meta-wayland-fifo.h"
 #include "wayland/meta-wayland-filter-manager.h"
 #include "wayland/meta-wayland-inhibit-shortcuts-dialog.h"
 #include "wayland/meta-wayland-inhibit-shortcuts.h"
@@ -62,6 +69,7 @@
 #ifdef HAVE_NATIVE_BACKEND
 #include "backends/native/meta-frame-native.h"
 #include "backends/native/meta-renderer-native.h"
+#include "wayland/meta-wayland-linux-drm-syncobj.h"
 #endif
 
 enum
@@ -81,6 +89,7 @@ typedef struct _MetaWaylandCompositorPrivate
 
   MetaWaylandFilterManager *filter_manager;
   GHashTable *frame_callback_sources;
+  guint obscured_frame_callbacks_id;
 } MetaWaylandCompositorPrivate;
 
 G_DEFINE_TYPE_WITH_PRIVATE (MetaWaylandCompositor, meta_wayland_compositor,
@@ -99,6 +108,7 @@ typedef struct
   MetaWaylandCompositor *compositor;
   ClutterStageView *stage_view;
   int64_t target_presentation_time_us;
+  int64_t predicted_update_time_us;
 } FrameCallbackSource;
 
 static gboolean
@@ -154,12 +164,52 @@ wayland_event_source_new (struct wl_display *display)
   return &wayland_source->source;
 }
 
-static void
+static gboolean
+is_predictive_frame_callbacks_enabled (MetaWaylandCompositor *compositor)
+{
+  MetaContext *context = meta_wayland_compositor_get_context (compositor);
+  MetaBackend *backend = meta_context_get_backend (context);
+  MetaSettings *settings = meta_backend_get_settings (backend);
+
+  return meta_settings_is_experimental_feature_enabled (
+    settings, META_EXPERIMENTAL_FEATURE_PREDICTIVE_FRAME_CALLBACKS);
+}
+
+static gboolean
+get_predicted_commit_time (MetaWaylandSurface *surface,
+                           int64_t            *out_commit_time_us)
+{
+  MetaWaylandCommitTiming *timing;
+  MetaWindow *window;
+
+  window = meta_wayland_surface_get_toplevel_window (surface);
+  if (!window || !meta_window_appears_focused (window))
+    return FALSE;
+
+  timing = meta_wayland_commit_timing_lookup (
+    wl_resource_get_client (surface->resource));
+  if (!timing)
+    return FALSE;
+
+  return meta_wayland_commit_timing_get_estimate (timing, out_commit_time_us);
+}
+
+/*
+ * Emits the frame callbacks of the surfaces that @stage_view is primary
+ * for. If @predicted_update_time_us is non-zero, frame callbacks of
+ * focused surfaces are held back until just in time for their clients
+ * to commit before the stage view is updated again, instead of giving
+ * them a whole frame of latency. Returns the time at which the
+ * earliest held back frame callbacks are due, or -1 if none were.
+ */
+static int64_t
 emit_frame_callbacks_for_stage_view (MetaWaylandCompositor *compositor,
-                                     ClutterStageView      *stage_view)
+                                     ClutterStageView      *stage_view,
+                                     int64_t                predicted_update_time_us)
 {
   GList *l;
   int64_t now_us;
+  int64_t next_dispatch_time_us = -1;
 
   now_us = g_get_monotonic_time ();
 
@@ -181,6 +231,26 @@ emit_frame_callbacks_for_stage_view (MetaWaylandCompositor *compositor,
                                                        stage_view))
         continue;
 
+      if (predicted_update_time_us)
+        {
+          int64_t commit_time_us;
+
+          if (get_predicted_commit_time (surface, &commit_time_us))
+            {
+              int64_t dispatch_time_us;
+
+              dispatch_time_us = predicted_update_time_us - commit_time_us -
+                                 PREDICTIVE_FRAME_CALLBACK_SLACK_US;
+              if (dispatch_time_us > now_us)
+                {
+                  if (next_dispatch_time_us == -1 ||
+                      dispatch_time_us < next_dispatch_time_us)
+                    next_dispatch_time_us = dispatch_time_us;
+                  continue;
+                }
+            }
+        }
+
       actor_surface = META_WAYLAND_ACTOR_SURFACE (surface->role);
       meta_wayland_actor_surface_emit_frame_callbacks (actor_surface,
                                                        now_us / 1000);
@@ -188,6 +258,94 @@ emit_frame_callbacks_for_stage_view (MetaWaylandCompositor *compositor,
       compositor->frame_callback_surfaces =
         g_list_delete_link (compositor->frame_callback_surfaces, l_cur);
     }
+
+  return next_dispatch_time_us;
+}
+
+static gboolean
+emit_obscured_frame_callbacks (gpointer user_data)
+{
+  MetaWaylandCompositor *compositor = user_data;
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (compositor);
+  GList *l;
+  int64_t now_us;
+
+  now_us = g_get_monotonic_time ();
+
+  l = compositor->frame_callback_surfaces;
+  while (l)
+    {
+      GList *l_cur = l;
+      MetaWaylandSurface *surface = l->data;
+      MetaSurfaceActor *actor;
+      MetaWaylandActorSurface *actor_surface;
+
+      l = l->next;
+
+      actor = meta_wayland_surface_get_actor (surface);
+      if (!actor)
+        continue;
+
+      if (!meta_surface_actor_wayland_is_hidden (actor))
+        continue;
+
+      actor_surface = META_WAYLAND_ACTOR_SURFACE (surface->role);
+      meta_wayland_actor_surface_emit_frame_callbacks (actor_surface,
+                                                       now_us / 1000);
+
+      compositor->frame_callback_surfaces =
+        g_list_delete_link (compositor->frame_callback_surfaces, l_cur);
+    }
+
+  if (!compositor->frame_callback_surfaces)
+    {
+      priv->obscured_frame_callbacks_id = 0;
+      return G_SOURCE_REMOVE;
+    }
+
+  return G_SOURCE_CONTINUE;
+}
+
+/* Surfaces that no stage view is primary for never get their frame
+ * callbacks emitted after a stage update, so emit them from a slow
+ * timer instead, keeping clients that wait for them going without
+ * letting them draw at the display refresh rate. */
+static void
+maybe_schedule_obscured_frame_callbacks (MetaWaylandCompositor *compositor)
+{
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (compositor);
+  unsigned int interval_ms;
+
+  if (priv->obscured_frame_callbacks_id)
+    return;
+
+  interval_ms = meta_prefs_get_obscured_frame_callback_interval ();
+  if (interval_ms == 0)
+    return;
+
+  priv->obscured_frame_callbacks_id =
+    g_timeout_add (interval_ms, emit_obscured_frame_callbacks, compositor);
+  g_source_set_name_by_id (priv->obscured_frame_callbacks_id,
+                           "[mutter] Wayland frame callbacks for obscured surfaces");
+}
+
+static void
+prefs_changed_callback (MetaPreference pref,
+                        gpointer       user_data)
+{
+  MetaWaylandCompositor *compositor = user_data;
+  MetaWaylandCompositorPrivate *priv =
+    meta_wayland_compositor_get_instance_private (compositor);
+
+  if (pref != META_PREF_OBSCURED_FRAME_CALLBACK_INTERVAL)
+    return;
+
+  g_clear_handle_id (&priv->obscured_frame_callbacks_id, g_source_remove);
+
+  if (compositor->frame_callback_surfaces)
+    maybe_schedule_obscured_frame_callbacks (compositor);
 }
 
 static gboolean
@@ -198,9 +356,12 @@ frame_callback_source_dispatch (GSource     *source,
   FrameCallbackSource *frame_callback_source = (FrameCallbackSource *) source;
   MetaWaylandCompositor *compositor = frame_callback_source->compositor;
   ClutterStageView *stage_view = frame_callback_source->stage_view;
+  int64_t next_dispatch_time_us;
 
-  emit_frame_callbacks_for_stage_view (compositor, stage_view);
-  g_source_set_ready_time (source, -1);
+  next_dispatch_time_us =
+    emit_frame_callbacks_for_stage_view (compositor, stage_view,
+                                         frame_callback_source->predicted_update_time_us);
+  g_source_set_ready_time (source, next_dispatch_time_us);
 
   return G_SOURCE_CONTINUE;
 }
@@ -281,6 +442,68 @@ ensure_source_for_stage_view (MetaWaylandCompositor *compositor,
   return source;
 }
 
+static void
+on_before_update (ClutterStage          *stage,
+                  ClutterStageView      *stage_view,
+                  ClutterFrame          *frame,
+                  MetaWaylandCompositor *compositor)
+{
+  ClutterFrameClock *frame_clock;
+  int64_t presentation_time_us;
+  int64_t refresh_interval_us;
+
+  if (!clutter_frame_get_target_presentation_time (frame,
+                                                   &presentation_time_us))
+    presentation_time_us = g_get_monotonic_time ();
+
+  /* Content targeting a presentation time is shown in the frame presented
+   * closest to it */
+  frame_clock = clutter_stage_view_get_frame_clock (stage_view);
+  refresh_interval_us =
+    (int64_t) (0.5 + G_USEC_PER_SEC /
+               clutter_frame_clock_get_refresh_rate (frame_clock));
+
+  meta_wayland_transaction_update_presentation_time (compositor,
+                                                     presentation_time_us +
+                                                     refresh_interval_us / 2);
+}
+
+/*
+ * Emits the frame callbacks of @stage_view right after it was updated.
+ * With predictive frame callbacks, those of focused surfaces are held
+ * back until just in time for the update following @frame.
+ */
+static void
+emit_frame_callbacks_after_update (MetaWaylandCompositor *compositor,
+                                   ClutterStageView      *stage_view,
+                                   ClutterFrame          *frame)
+{
+  FrameCallbackSource *frame_callback_source;
+  GSource *source;
+  int64_t predicted_update_time_us = 0;
+  int64_t next_dispatch_time_us;
+
+  source = ensure_source_for_stage_view (compositor, stage_view);
+  frame_callback_source = (FrameCallbackSource *) source;
+
+  if (is_predictive_frame_callbacks_enabled (compositor))
+    {
+      ClutterFrameClock *frame_clock =
+        clutter_stage_view_get_frame_clock (stage_view);
+
+      if (!clutter_frame_clock_predict_next_update_time (frame_clock,
+                                                         frame,
+                                                         &predicted_update_time_us))
+        predicted_update_time_us = 0;
+    }
+
+  frame_callback_source->predicted_update_time_us = predicted_update_time_us;
+  next_dispatch_time_us =
+    emit_frame_callbacks_for_stage_view (compositor, stage_view,
+                                         predicted_update_time_us);
+  g_source_set_ready_time (source, next_dispatch_time_us);
+}
+
 static void
 on_after_update (ClutterStage          *stage,
                  ClutterStageView      *stage_view,
@@ -295,29 +518,31 @@ on_after_update (ClutterStage          *stage,
   GSource *source;
   int64_t min_render_time_allowed_us;
 
+  meta_wayland_transaction_clear_fifo_barriers (compositor, stage_view);
+
   if (!META_IS_BACKEND_NATIVE (backend))
     {
-      emit_frame_callbacks_for_stage_view (compositor, stage_view);
+      emit_frame_callbacks_after_update (compositor, stage_view, frame);
       return;
     }
 
   frame_native = meta_frame_native_from_frame (frame);
 
-  source = ensure_source_for_stage_view (compositor, stage_view);
-  frame_callback_source = (FrameCallbackSource *) source;
-
   if (meta_frame_native_had_kms_update (frame_native) ||
       !clutter_frame_get_min_render_time_allowed (frame,
                                                   &min_render_time_allowed_us))
     {
-      g_source_set_ready_time (source, -1);
-      emit_frame_callbacks_for_stage_view (compositor, stage_view);
+      emit_frame_callbacks_after_update (compositor, stage_view, frame);
     }
   else
     {
       int64_t target_presentation_time_us;
       int64_t source_ready_time_us;
 
+      source = ensure_source_for_stage_view (compositor, stage_view);
+      frame_callback_source = (FrameCallbackSource *) source;
+      frame_callback_source->predicted_update_time_us = 0;
+
       if (!clutter_frame_get_target_presentation_time (frame,
                                                        &target_presentation_time_us))
         target_presentation_time_us = 0;
@@ -325,7 +550,7 @@ on_after_update (ClutterStage          *stage,
       if (g_source_get_ready_time (source) != -1 &&
           frame_callback_source->target_presentation_time_us <
           target_presentation_time_us)
-        emit_frame_callbacks_for_stage_view (compositor, stage_view);
+        emit_frame_callbacks_for_stage_view (compositor, stage_view, 0);
 
       source_ready_time_us = target_presentation_time_us -
                              min_render_time_allowed_us;
@@ -333,7 +558,7 @@ on_after_update (ClutterStage          *stage,
       if (source_ready_time_us <= g_get_monotonic_time ())
         {
           g_source_set_ready_time (source, -1);
-          emit_frame_callbacks_for_stage_view (compositor, stage_view);
+          emit_frame_callbacks_for_stage_view (compositor, stage_view, 0);
         }
       else
         {
@@ -343,7 +568,9 @@ on_after_update (ClutterStage          *stage,
         }
     }
 #else
-  emit_frame_callbacks_for_stage_view (compositor, stage_view);
+  meta_wayland_transaction_clear_fifo_barriers (compositor, stage_view);
+
+  emit_frame_callbacks_after_update (compositor, stage_view, frame);
 #endif
 }
 
@@ -515,6 +742,8 @@ meta_wayland_compositor_add_frame_callback_surface (MetaWaylandCompositor *compo
 
   compositor->frame_callback_surfaces =
     g_list_prepend (compositor->frame_callback_surfaces, surface);
+
+  maybe_schedule_obscured_frame_callbacks (compositor);
 }
 
 void
@@ -551,30 +780,19 @@ meta_wayland_compositor_get_committed_transactions (MetaWaylandCompositor *compo
 }
 
 static void
-set_gnome_env (const char *name,
-	       const char *value)
+on_gnome_env_set (GObject      *source_object,
+                  GAsyncResult *result,
+                  gpointer      user_data)
 {
-  GDBusConnection *session_bus;
-  GError *error = NULL;
-  g_autoptr (GVariant) result = NULL;
-
-  setenv (name, value, TRUE);
-
-  session_bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
-  g_assert (session_bus);
+  g_autofree char *name = user_data;
+  g_autoptr (GVariant) ret = NULL;
+  g_autoptr (GError) error = NULL;
 
-  result = g_dbus_connection_call_sync (session_bus,
-			       "org.gnome.SessionManager",
-			       "/org/gnome/SessionManager",
-			       "org.gnome.SessionManager",
-			       "Setenv",
-			       g_variant_new ("(ss)", name, value),
-			       NULL,
-			       G_DBUS_CALL_FLAGS_NO_AUTO_START,
-			       -1, NULL, &error);
+  ret = g_dbus_connection_call_finish (G_DBUS_CONNECTION (source_object),
+                                       result, &error);
   if (error)
     {
-      char *remote_error;
+      g_autofree char *remote_error = NULL;
 
       remote_error = g_dbus_error_get_remote_error (error);
       if (g_strcmp0 (remote_error, "org.gnome.SessionManager.NotInInitialization") != 0)
@@ -582,12 +800,36 @@ set_gnome_env (const char *name,
           meta_warning ("Failed to set environment variable %s for gnome-session: %s",
                         name, error->message);
         }
-
-      g_free (remote_error);
-      g_error_free (error);
     }
 }
 
+static void
+set_gnome_env (const char *name,
+               const char *value)
+{
+  GDBusConnection *session_bus;
+
+  setenv (name, value, TRUE);
+
+  session_bus = g_bus_get_sync (G_BUS_TYPE_SESSION, NULL, NULL);
+  g_assert (session_bus);
+
+  /* Calls on the same connection are delivered in order, so there is no need
+   * to block startup on the session manager handling them.
+   */
+  g_dbus_connection_call (session_bus,
+                          "org.gnome.SessionManager",
+                          "/org/gnome/SessionManager",
+                          "org.gnome.SessionManager",
+                          "Setenv",
+                          g_variant_new ("(ss)", name, value),
+                          NULL,
+                          G_DBUS_CALL_FLAGS_NO_AUTO_START,
+                          -1, NULL,
+                          on_gnome_env_set,
+                          g_strdup (name));
+}
+
 static void meta_wayland_log_func (const char *, va_list) G_GNUC_PRINTF (1, 0);
 
 static void
@@ -626,15 +868,20 @@ meta_wayland_compositor_finalize (GObject *object)
 
   g_signal_handlers_disconnect_by_func (stage, on_after_update, compositor);
   g_signal_handlers_disconnect_by_func (stage, on_presented, compositor);
+  g_signal_handlers_disconnect_by_func (stage, on_before_update, compositor);
 
   meta_wayland_transaction_finalize (compositor);
 
+  g_clear_object (&compositor->client_usage_service);
+  g_clear_object (&compositor->drm_syncobj_manager);
   g_clear_object (&compositor->dma_buf_manager);
 
   g_clear_pointer (&compositor->seat, meta_wayland_seat_free);
 
   g_clear_pointer (&priv->filter_manager, meta_wayland_filter_manager_free);
   g_clear_pointer (&priv->frame_callback_sources, g_hash_table_destroy);
+  g_clear_handle_id (&priv->obscured_frame_callbacks_id, g_source_remove);
+  meta_prefs_remove_listener (prefs_changed_callback, compositor);
 
   g_clear_pointer (&compositor->display_name, g_free);
   g_clear_pointer (&compositor->wayland_display, wl_display_destroy);
@@ -661,6 +908,8 @@ meta_wayland_compositor_init (MetaWaylandCompositor *compositor)
   priv->frame_callback_sources =
     g_hash_table_new_full (NULL, NULL, NULL,
                            (GDestroyNotify) g_source_destroy);
+
+  meta_prefs_add_listener (prefs_changed_callback, compositor);
 }
 
 static void
@@ -744,6 +993,31 @@ init_dma_buf_support (MetaWaylandCompositor *compositor)
     }
 }
 
+static void
+init_explicit_sync_support (MetaWaylandCompositor *compositor)
+{
+#ifdef HAVE_NATIVE_BACKEND
+  g_autoptr (GError) error = NULL;
+
+  compositor->drm_syncobj_manager =
+    meta_wayland_drm_syncobj_manager_new (compositor, &error);
+  if (!compositor->drm_syncobj_manager)
+    {
+      if (g_error_matches (error, G_IO_ERROR, G_IO_ERROR_NOT_SUPPORTED))
+        {
+          meta_topic (META_DEBUG_WAYLAND,
+                      "Wayland explicit sync support not enabled: %s",
+                      error->message);
+        }
+      else
+        {
+          g_warning ("Wayland explicit sync support not enabled: %s",
+                     error->message);
+        }
+    }
+#endif
+}
+
 MetaWaylandCompositor *
 meta_wayland_compositor_new (MetaContext *context)
 {
@@ -771,6 +1045,8 @@ meta_wayland_compositor_new (MetaContext *context)
   compositor->source = wayland_event_source;
   g_source_unref (wayland_event_source);
 
+  g_signal_connect (stage, "before-update",
+                    G_CALLBACK (on_before_update), compositor);
   g_signal_connect (stage, "after-update",
                     G_CALLBACK (on_after_update), compositor);
   g_signal_connect (stage, "presented",
@@ -798,6 +1074,7 @@ meta_wayland_compositor_new (MetaContext *context)
   meta_wayland_xdg_foreign_init (compositor);
   meta_wayland_legacy_xdg_foreign_init (compositor);
   init_dma_buf_support (compositor);
+  init_explicit_sync_support (compositor);
   meta_wayland_init_single_pixel_buffer_manager (compositor);
   meta_wayland_keyboard_shortcuts_inhibit_init (compositor);
   meta_wayland_surface_inhibit_shortcuts_dialog_init ();
@@ -805,6 +1082,14 @@ meta_wayland_compositor_new (MetaContext *context)
   meta_wayland_init_presentation_time (compositor);
   meta_wayland_activation_init (compositor);
   meta_wayland_transaction_init (compositor);
+  meta_wayland_init_commit_timing_v1 (compositor);
+  meta_wayland_init_fifo (compositor);
+
+  if (g_strcmp0 (g_getenv ("MUTTER_DEBUG_WAYLAND_CLIENT_USAGE"), "1") == 0)
+    {
+      compositor->client_usage_service =
+        meta_wayland_client_usage_service_new (compositor);
+    }
 
 #ifdef HAVE_WAYLAND_EGLSTREAM
   {
@@ -76,6 +76,10 @@ struct _MetaWindowWayland
 
   MetaWaylandWindowConfiguration *last_acked_configuration;
 
+  gboolean is_awaiting_resize_ack;
+  uint32_t awaiting_resize_serial;
+  guint resize_ack_timeout_id;
+
   gboolean has_been_shown;
 };
 
@@ -190,14 +194,91 @@ meta_window_wayland_focus (MetaWindow *window,
     }
 }
 
+static MetaWindowDrag *
+get_interactive_resize_drag (MetaWindow *window)
+{
+  MetaWindowDrag *window_drag;
+
+  window_drag =
+    meta_compositor_get_current_window_drag (window->display->compositor);
+
+  if (window_drag &&
+      meta_window_drag_get_window (window_drag) == window &&
+      meta_grab_op_is_resizing (meta_window_drag_get_grab_op (window_drag)))
+    return window_drag;
+  else
+    return NULL;
+}
+
+static gboolean
+resize_ack_timeout (gpointer user_data)
+{
+  MetaWindowWayland *wl_window = user_data;
+  MetaWindow *window = META_WINDOW (wl_window);
+  MetaWindowDrag *window_drag;
+
+  wl_window->resize_ack_timeout_id = 0;
+
+  /* The client did not get around to ack and commit the last resize within
+   * a second; stop waiting for it and keep following the pointer. */
+  meta_topic (META_DEBUG_GEOMETRY,
+              "Window %s did not commit resize configuration %u in time",
+              window->desc, wl_window->awaiting_resize_serial);
+  wl_window->is_awaiting_resize_ack = FALSE;
+
+  window_drag = get_interactive_resize_drag (window);
+  if (window_drag)
+    meta_window_drag_update_resize (window_drag);
+
+  return G_SOURCE_REMOVE;
+}
+
 static void
 meta_window_wayland_configure (MetaWindowWayland              *wl_window,
                                MetaWaylandWindowConfiguration *configuration)
 {
+  MetaWindow *window = META_WINDOW (wl_window);
+
   meta_wayland_surface_configure_notify (wl_window->surface, configuration);
 
   wl_window->pending_configurations =
     g_list_prepend (wl_window->pending_configurations, configuration);
+
+  /* During interactive resizing, only keep one resizing configuration in
+   * flight, similar to _NET_WM_SYNC_REQUEST on X11. Pointer motion meanwhile
+   * is coalesced by the window drag and applied once the client caught up. */
+  if (configuration->is_resizing && get_interactive_resize_drag (window))
+    {
+      wl_window->is_awaiting_resize_ack = TRUE;
+      wl_window->awaiting_resize_serial = configuration->serial;
+
+      g_clear_handle_id (&wl_window->resize_ack_timeout_id, g_source_remove);
+      wl_window->resize_ack_timeout_id = g_timeout_add (1000,
+                                                        resize_ack_timeout,
+                                                        wl_window);
+      g_source_set_name_by_id (wl_window->resize_ack_timeout_id,
+                               "[mutter] resize_ack_timeout");
+    }
+}
+
+static void
+clear_awaiting_resize_ack (MetaWindowWayland *wl_window)
+{
+  wl_window->is_awaiting_resize_ack = FALSE;
+  g_clear_handle_id (&wl_window->resize_ack_timeout_id, g_source_remove);
+}
+
+/**
+ * meta_window_wayland_is_awaiting_resize_ack:
+ * @wl_window: A #MetaWindowWayland
+ *
+ * Returns: %TRUE if a configuration sent during an interactive resize has
+ * not yet been acked and committed by the client
+ */
+gboolean
+meta_window_wayland_is_awaiting_resize_ack (MetaWindowWayland *wl_window)
+{
+  return wl_window->is_awaiting_resize_ack;
 }
 
 static void
@@ -246,7 +327,10 @@ meta_window_wayland_grab_op_ended (MetaWindow *window,
                                    MetaGrabOp  op)
 {
   if (meta_grab_op_is_resizing (op))
-    surface_state_changed (window);
+    {
+      clear_awaiting_resize_ack (META_WINDOW_WAYLAND (window));
+      surface_state_changed (window);
+    }
 
   META_WINDOW_CLASS (meta_window_wayland_parent_class)->grab_op_ended (window, op);
 }
@@ -833,6 +917,7 @@ meta_window_wayland_finalize (GObject *object)
 {
   MetaWindowWayland *wl_window = META_WINDOW_WAYLAND (object);
 
+  g_clear_handle_id (&wl_window->resize_ack_timeout_id, g_source_remove);
   g_clear_pointer (&wl_window->last_acked_configuration,
                    meta_wayland_window_configuration_free);
   g_list_free_full (wl_window->pending_configurations,
@@ -1125,6 +1210,7 @@ meta_window_wayland_finish_move_resize (MetaWindow              *window,
   MetaWaylandWindowConfiguration *acked_configuration;
   gboolean is_window_being_resized;
   gboolean is_client_resize;
+  gboolean has_caught_up_with_resize = FALSE;
   MetaWindowDrag *window_drag;
 
   /* new_geom is in the logical pixel coordinate space, but MetaWindow wants its
@@ -1135,6 +1221,14 @@ meta_window_wayland_finish_move_resize (MetaWindow              *window,
   acked_configuration = acquire_acked_configuration (wl_window, pending,
                                                      &is_client_resize);
 
+  if (wl_window->is_awaiting_resize_ack &&
+      pending->has_acked_configure_serial &&
+      pending->acked_configure_serial >= wl_window->awaiting_resize_serial)
+    {
+      clear_awaiting_resize_ack (wl_window);
+      has_caught_up_with_resize = TRUE;
+    }
+
   if (acked_configuration)
     geometry_scale = acked_configuration->scale;
   else
@@ -1240,6 +1334,11 @@ meta_window_wayland_finish_move_resize (MetaWindow              *window,
   else
     gravity = META_GRAVITY_STATIC;
   meta_window_move_resize_internal (window, flags, gravity, rect);
+
+  /* The client is done with the previous resize; catch up with where the
+   * pointer moved in the meantime. */
+  if (has_caught_up_with_resize && is_window_being_resized)
+    meta_window_drag_update_resize (window_drag);
 }
 
 void
@@ -77,6 +77,8 @@ gboolean meta_window_wayland_is_resize (MetaWindowWayland *wl_window,
                                         int                width,
                                         int                height);
 
+gboolean meta_window_wayland_is_awaiting_resize_ack (MetaWindowWayland *wl_window);
+
 META_EXPORT_TEST
 gboolean meta_window_wayland_is_acked_fullscreen (MetaWindowWayland *wl_window);
 